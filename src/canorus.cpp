@@ -230,7 +230,7 @@ void CACanorus::initFonts()
  */
 int CACanorus::fetaCodepoint(const QString& name)
 {
-    return _fetaMap[name];
+    return _fetaMap.value(name);
 }
 
 void CACanorus::initHelp()
@@ -338,14 +338,15 @@ int CACanorus::mainWinCount(CADocument* doc)
 
 /*!
 	Rebuilds main windows with the given \a document and its views showing the given \a sheet.
+	If \a timeStart is given, only the music from \a timeStart on is repositioned (see CAScoreView::rebuild(int, int)).
 
 	\sa rebuildUI(CADocument*), CAMainWin::rebuildUI()
 */
-void CACanorus::rebuildUI(CADocument* document, CASheet* sheet)
+void CACanorus::rebuildUI(CADocument* document, CASheet* sheet, int timeStart, int timeEnd)
 {
     for (int i = 0; i < mainWinList().size(); i++)
         if (mainWinList()[i]->document() == document)
-            mainWinList()[i]->rebuildUI(sheet);
+            mainWinList()[i]->rebuildUI(sheet, true, timeStart, timeEnd);
 }
 
 /*!
@@ -87,7 +87,7 @@ public:
 
     inline static CAHelpCtl* help() { return _help; }
 
-    static void rebuildUI(CADocument* document, CASheet* sheet);
+    static void rebuildUI(CADocument* document, CASheet* sheet, int timeStart = -1, int timeEnd = -1);
     static void rebuildUI(CADocument* document = nullptr);
     static void repaintUI();
 
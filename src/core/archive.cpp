@@ -8,7 +8,6 @@
 #include <QByteArray>
 #include <QRegExp>
 #include <QString>
-#include <QTemporaryFile>
 #include <zlib.h>
 
 #ifdef Q_OS_WIN
@@ -25,6 +24,10 @@
 	This class allows read/write operations on tar.gz archives.
 	\warning This is not a CATar subclass as it does not represent a tar file, but a gzipped file. The uncompressed content is a tar file. 
 
+	The archive is read in a single pass: each inflated chunk is passed directly to the tar parser,
+	which keeps the files in memory (see CATar::spillThreshold()). When writing, the tar is generated
+	chunk by chunk from memory and deflated into the destination device.
+
 	See RFC 1952 for the GZIP specification.
 */
 
@@ -46,6 +49,7 @@ CAArchive::CAArchive()
 CAArchive::CAArchive(QIODevice& arch)
     : _err(false)
 {
+    _tar = new CATar();
     parse(arch);
 }
 
@@ -65,13 +69,11 @@ void CAArchive::parse(QIODevice& arch)
     bool close = false;
     int ret;
     z_stream strm;
-    QTemporaryFile tar;
     QBuffer in, out;
     gz_header header = gz_header();
 
     in.buffer().resize(CHUNK);
     out.buffer().resize(CHUNK);
-    tar.open();
 
     if (!arch.isOpen()) {
         if (!arch.open(QIODevice::ReadOnly)) {
@@ -96,6 +98,7 @@ void CAArchive::parse(QIODevice& arch)
     ret = (ret == Z_OK) ? inflateGetHeader(&strm, &header) : ret;
     if (ret != Z_OK) //clean up, set error and return
     {
+        _err = true;
         delete[] header.comment;
         inflateEnd(&strm);
         if (close)
@@ -117,15 +120,15 @@ void CAArchive::parse(QIODevice& arch)
             // For strings it would only work with ASCII code nothing else
             strm.next_out = reinterpret_cast<Bytef*>(out.buffer().data());
             ret = inflate(&strm, Z_NO_FLUSH);
-            if ((ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) || // buffer error is not fatal
-                tar.write(out.buffer().data(), CHUNK - strm.avail_out) != CHUNK - strm.avail_out) {
-
+            if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) { // buffer error is not fatal
                 _err = true;
                 break;
             }
+            _tar->parseChunk(out.buffer().constData(), CHUNK - strm.avail_out);
         } while (strm.avail_out == 0);
     } while (ret != Z_STREAM_END && !_err);
     inflateEnd(&strm);
+    _tar->parseFinish();
 
     if (ret != Z_STREAM_END)
         _err = true;
@@ -139,9 +142,6 @@ void CAArchive::parse(QIODevice& arch)
         else {
             _err = true;
         }
-
-        tar.reset();
-        _tar = new CATar(tar);
     }
 
     delete[] header.comment;
@@ -42,6 +42,10 @@ public:
         if (!error())
             _tar->removeFile(filename);
     }
+    inline bool contains(const QString& filename)
+    {
+        return !error() && _tar->contains(filename);
+    }
     inline CAIOPtr file(const QString& filename)
     {
         if (!error())
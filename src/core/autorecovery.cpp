@@ -8,12 +8,15 @@
 #include "core/autorecovery.h"
 
 #include "canorus.h"
+#include "core/journal.h"
 #include "core/settings.h"
+#include "core/undocommand.h"
 #include "export/canorusmlexport.h"
 #include "import/canorusmlimport.h"
+#include <QDir>
 #include <QFile>
 #include <QMessageBox>
-#include <QSet>
+#include <QSaveFile>
 #include <QTimer>
 
 /*!
@@ -37,7 +40,19 @@
 	manually deleted.
 
 	Call saveRecovery() to save the currently opened documents to recovery files. The
-	autosave timer's signal is connected to this slot.
+	autosave timer's signal is connected to this slot. It only clones each modified document
+	in the GUI thread. The clone is then exported in the export thread to a temporary file which
+	replaces the recovery file when finished, so an existing recovery file is never missing or
+	half-written. Documents which haven't changed since their last recovery file was written
+	(see CADocument::revision()) are skipped.
+
+	Changes made between the recovery files are stored in a journal next to each recovery file
+	(see CAJournal) by journalCommand() which is called by CAUndo for each change. openRecovery()
+	replays the journal on top of the recovery file. As long as the changes can be journaled, a new
+	recovery file is only written when the journal grows over CAJournal::MAX_SIZE. This includes
+	the inserted, removed and moved music elements. Otherwise, eg. after creating a tuplet, it is
+	written a few seconds after the change and the changes made in these few seconds are not
+	recovered.
 
 	Settings class should already be initialized when creating instance of this class.
 */
@@ -51,12 +66,23 @@ CAAutoRecovery::CAAutoRecovery()
     _autoRecoveryTimer = new QTimer(this);
     _autoRecoveryTimer->setSingleShot(false);
     connect(_autoRecoveryTimer, SIGNAL(timeout()), this, SLOT(saveRecovery()));
+
+    _snapshotTimer = new QTimer(this);
+    _snapshotTimer->setSingleShot(true);
+    _snapshotTimer->setInterval(5000);
+    connect(_snapshotTimer, SIGNAL(timeout()), this, SLOT(saveRecovery()));
+
     updateTimer(); // reads interval from settings and starts the timer
 }
 
 CAAutoRecovery::~CAAutoRecovery()
 {
+    while (!_jobs.isEmpty()) {
+        finishJob(_jobs.begin().key(), false);
+    }
+    qDeleteAll(_journals);
     delete _autoRecoveryTimer;
+    delete _snapshotTimer;
 }
 
 /*!
@@ -72,40 +98,190 @@ void CAAutoRecovery::updateTimer()
 
 /*!
 	Saves the currently opened documents into settings folder named recovery0, recovery1 etc.
+	The documents are exported in background, see the class description.
 */
 void CAAutoRecovery::saveRecovery()
 {
-    cleanupRecovery();
+    if (!_jobs.isEmpty()) {
+        return; // previous recovery still being written
+    }
+
+    QList<CADocument*> documents;
+    for (int i = 0; i < CACanorus::mainWinList().size(); i++) {
+        if (CACanorus::mainWinList()[i]->document() && !documents.contains(CACanorus::mainWinList()[i]->document()))
+            documents << CACanorus::mainWinList()[i]->document();
+    }
+
+    // remove recovery files and journals of the closed documents
+    for (int i = documents.size(); i < _journals.size(); i++) {
+        if (_journals[i]) {
+            _journals[i]->remove();
+            delete _journals[i];
+        }
+    }
+    for (int i = documents.size(); QFile::exists(recoveryFileName(i)); i++) {
+        removeRecoveryFile(i);
+    }
+    _journals.resize(documents.size());
+    _revisions.resize(documents.size());
+
+    for (int c = 0; c < documents.size(); c++) {
+        if (!_journals[c]) {
+            _journals[c] = new CAJournal(journalFileName(c));
+        }
+
+        if (_revisions[c] == documents[c]->revision() && _journals[c]->size() < CAJournal::MAX_SIZE) {
+            continue; // recovery file and its journal are up to date
+        }
+
+        QSaveFile* file = new QSaveFile(recoveryFileName(c));
+        if (!file->open(QIODevice::WriteOnly)) {
+            delete file;
+            continue;
+        }
+
+        if (_revisions[c] != documents[c]->revision() && _journals[c]->size()) {
+            _journals[c]->appendBarrier(); // the journal doesn't lead to the current document
+        }
+        _revisions[c] = documents[c]->revision();
+
+        CARecoveryJob job;
+        job.snapshot = documents[c]->clone();
+        job.file = file;
+        job.index = c;
+        job.journalOffset = _journals[c]->size();
+
+        CACanorusMLExport* save = new CACanorusMLExport();
+        save->setStreamToDevice(file);
+        save->setFileName(recoveryFileName(c)); // attached resources are copied next to it
+        _jobs[save] = job;
+        connect(save, SIGNAL(exportDone(int)), this, SLOT(recoveryExported(int)));
+        save->exportDocument(job.snapshot);
+    }
+}
+
+/*!
+	Stores the change made by the undo \a command to the \a document in the journal of its
+	recovery file. \a oldRevision is the revision of the document before the change and \a undo
+	tells whether the command was undone.
+
+	If the document has no recovery file yet or the change can't be journaled, a new recovery file
+	is written soon.
+*/
+void CAAutoRecovery::journalCommand(CADocument* document, unsigned int oldRevision, CAUndoCommand* command, bool undo)
+{
+    if (!CACanorus::settings()->autoRecoveryInterval()) {
+        return;
+    }
+
+    int c = _revisions.indexOf(oldRevision);
+    if (c == -1 || !_journals[c]) {
+        if (!_snapshotTimer->isActive())
+            _snapshotTimer->start();
+        return;
+    }
+
+    if (!command->isJournaled()) {
+        _journals[c]->appendBarrier();
+        _revisions[c] = 0;
+        if (!_snapshotTimer->isActive())
+            _snapshotTimer->start();
+        return;
+    }
 
-    QSet<CADocument*> documents;
-    for (int i = 0; i < CACanorus::mainWinList().size(); i++)
-        documents << CACanorus::mainWinList()[i]->document();
+    _journals[c]->append(command->deltaList(), undo);
+    _revisions[c] = document->revision();
+}
 
-    int c = 0;
-    for (QSet<CADocument*>::const_iterator i = documents.constBegin(); i != documents.constEnd(); i++, c++) {
-        CACanorusMLExport save;
-        save.setStreamToFile(CASettings::defaultSettingsPath() + "/recovery" + QString::number(c));
-        save.exportDocument(*i);
-        save.wait();
+/*!
+	Called when the recovery file export is finished.
+	Replaces the recovery file with the new one, if the export was successful.
+*/
+void CAAutoRecovery::recoveryExported(int status)
+{
+    CACanorusMLExport* save = static_cast<CACanorusMLExport*>(sender());
+    if (_jobs.contains(save)) {
+        finishJob(save, status == 0);
     }
 }
 
+/*!
+	Waits for the export \a save to finish and cleans up its snapshot.
+	If \a commit is True, the written file replaces the recovery file, otherwise it is discarded.
+*/
+void CAAutoRecovery::finishJob(CACanorusMLExport* save, bool commit)
+{
+    CARecoveryJob job = _jobs.take(save);
+    save->wait();
+    delete save;
+
+    if (commit && job.file->commit()) {
+        // the journal records up to the snapshot are in the recovery file now
+        if (job.index < _journals.size() && _journals[job.index])
+            _journals[job.index]->compact(job.journalOffset);
+    } else {
+        job.file->cancelWriting();
+    }
+    delete job.file;
+
+    // resources are shared with the original document
+    while (!job.snapshot->resourceList().isEmpty()) {
+        job.snapshot->removeResource(job.snapshot->resourceList().first());
+    }
+    delete job.snapshot;
+}
+
+/*!
+	Returns the absolute file name of the recovery file with the given \a index.
+*/
+QString CAAutoRecovery::recoveryFileName(int index)
+{
+    return CASettings::defaultSettingsPath() + "/recovery" + QString::number(index);
+}
+
+/*!
+	Returns the absolute file name of the journal of the recovery file with the given \a index.
+*/
+QString CAAutoRecovery::journalFileName(int index)
+{
+    return recoveryFileName(index) + ".journal";
+}
+
 /*!
 	Deletes recovery files.
 	This method is usually called when successfully quiting Canorus.
 */
 void CAAutoRecovery::cleanupRecovery()
 {
-    for (int i = 0; QFile::exists(CASettings::defaultSettingsPath() + "/recovery" + QString::number(i)); i++) {
-        QString fileName = CASettings::defaultSettingsPath() + "/recovery" + QString::number(i);
-        QFile::remove(fileName);
-        if (QDir(fileName + " files").exists()) {
-            foreach (QString entry, QDir(fileName + " files").entryList(QDir::Files)) {
-                QFile::remove(fileName + " files/" + entry);
-            }
-            QDir().rmdir(fileName + " files");
+    while (!_jobs.isEmpty()) {
+        finishJob(_jobs.begin().key(), false);
+    }
+    for (int i = 0; i < _journals.size(); i++) {
+        if (_journals[i]) {
+            _journals[i]->remove();
+            delete _journals[i];
         }
     }
+    _journals.clear();
+    _revisions.clear();
+
+    for (int i = 0; QFile::exists(recoveryFileName(i)); i++) {
+        removeRecoveryFile(i);
+    }
+}
+
+/*!
+	Deletes the recovery file with the given \a index, its journal and its attached resources.
+*/
+void CAAutoRecovery::removeRecoveryFile(int index)
+{
+    QString fileName = recoveryFileName(index);
+    QFile::remove(fileName);
+    QFile::remove(journalFileName(index));
+    QDir resources(fileName + " files");
+    if (resources.exists()) {
+        resources.removeRecursively();
+    }
 }
 
 /*!
@@ -115,12 +291,13 @@ void CAAutoRecovery::cleanupRecovery()
 void CAAutoRecovery::openRecovery()
 {
     QString documents;
-    for (int i = 0; QFile::exists(CASettings::defaultSettingsPath() + "/recovery" + QString::number(i)); i++) {
+    for (int i = 0; QFile::exists(recoveryFileName(i)); i++) {
         CACanorusMLImport open;
-        open.setStreamFromFile(CASettings::defaultSettingsPath() + "/recovery" + QString::number(i));
+        open.setStreamFromFile(recoveryFileName(i));
         open.importDocument();
         open.wait(_recoveryTimeout);
         if (open.importedDocument()) {
+            CAJournal::replay(journalFileName(i), open.importedDocument());
             open.importedDocument()->setModified(true); // warn that the file is unsaved, if closing
             open.importedDocument()->setFileName("");
 
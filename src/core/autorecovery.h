@@ -8,9 +8,16 @@
 #ifndef AUTOSAVE_H_
 #define AUTOSAVE_H_
 
+#include <QHash>
 #include <QObject>
+#include <QVector>
 
 class QTimer;
+class QSaveFile;
+class CADocument;
+class CACanorusMLExport;
+class CAJournal;
+class CAUndoCommand;
 
 class CAAutoRecovery : public QObject {
     Q_OBJECT
@@ -20,14 +27,35 @@ public:
     ~CAAutoRecovery();
     void updateTimer();
     void openRecovery();
+    void journalCommand(CADocument* document, unsigned int oldRevision, CAUndoCommand* command, bool undo);
 
 public slots:
     void cleanupRecovery();
     void saveRecovery();
 
+private slots:
+    void recoveryExported(int status);
+
 private:
+    struct CARecoveryJob {
+        CADocument* snapshot; // clone of the document being exported
+        QSaveFile* file;
+        int index; // number of the recovery file
+        qint64 journalOffset; // journal size when the snapshot was taken
+    };
+
+    static QString recoveryFileName(int index);
+    static QString journalFileName(int index);
+    static void removeRecoveryFile(int index);
+    void finishJob(CACanorusMLExport* save, bool commit);
+
     QTimer* _autoRecoveryTimer;
     QTimer* _saveAfterRecoveryTimer;
+    QTimer* _snapshotTimer; // saves the recovery soon after a change which couldn't be journaled
+
+    QHash<CACanorusMLExport*, CARecoveryJob> _jobs; // running exports
+    QVector<CAJournal*> _journals; // journal of each recovery file
+    QVector<unsigned int> _revisions; // document revision of each recovery file with its journal applied, 0 if unknown
 
     const int _recoveryTimeout = 120000;
 };
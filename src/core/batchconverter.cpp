@@ -0,0 +1,328 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QObject>
+#include <QThread>
+#include <QThreadPool>
+
+#include <iostream>
+
+#include "core/batchconverter.h"
+
+#include "export/canexport.h"
+#include "export/canorusmlexport.h"
+#include "export/lilypondexport.h"
+#include "export/midiexport.h"
+#include "export/musicxmlexport.h"
+#include "import/canimport.h"
+#include "import/canorusmlimport.h"
+#include "import/midiimport.h"
+#include "import/musicxmlimport.h"
+#include "import/mxlimport.h"
+#include "score/document.h"
+#include "score/sheet.h"
+
+/*!
+	\class CABatchConverter
+	\brief Converts files between the supported formats without the user interface
+
+	Canorus runs in the batch mode when started with one of the following switches:
+	\code
+	canorus --convert input.can output.ly [--convert input2.mid output2.xml ...]
+	canorus --batch directory ly [--output-dir directory] [--jobs n]
+	\endcode
+
+	The input and the output formats are determined by the file name extensions. --batch
+	converts every supported file in the directory to the given format. The main window and
+	the rest of the GUI are never created.
+
+	Each conversion imports the document, exports it and deletes it again in a thread of a
+	thread pool. By default, the number of threads is the number of processor cores. The time
+	of each conversion and the total throughput are printed to the standard output.
+
+	Formats which only store a single sheet (LilyPond, MusicXML) get a file for each sheet of
+	the document. The files of the second and the later sheets have the sheet number appended
+	to their names.
+*/
+
+namespace {
+bool isSheetFormat(const QString& fileName)
+{
+    QString suffix = QFileInfo(fileName).suffix().toLower();
+    return suffix == "ly" || suffix == "musicxml";
+}
+}
+
+CABatchConverter::CABatchConverter()
+    : _maxThreads(qMax(1, QThread::idealThreadCount()))
+    , _failed(0)
+    , _bytes(0)
+{
+}
+
+/*!
+	Returns True, if the command line arguments request a conversion without the user interface.
+*/
+bool CABatchConverter::isBatchMode(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        if (QString(argv[i]) == "--convert" || QString(argv[i]) == "--batch") {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*!
+	Adds the conversions requested by the command line arguments \a args.
+	Prints the usage and returns False, if the arguments are invalid.
+*/
+bool CABatchConverter::parseArguments(const QStringList& args)
+{
+    QList<QPair<QString, QString>> directories;
+    QString outputDir;
+    bool ok = true;
+
+    for (int i = 1; ok && i < args.size(); i++) {
+        if (args[i] == "--convert" && i + 2 < args.size()) {
+            addConversion(args[i + 1], args[i + 2]);
+            i += 2;
+        } else if (args[i] == "--batch" && i + 2 < args.size()) {
+            directories << QPair<QString, QString>(args[i + 1], args[i + 2]);
+            i += 2;
+        } else if (args[i] == "--output-dir" && i + 1 < args.size()) {
+            outputDir = args[++i];
+        } else if (args[i] == "--jobs" && i + 1 < args.size()) {
+            setMaxThreads(qMax(1, args[++i].toInt(&ok)));
+        } else {
+            ok = false;
+        }
+    }
+
+    if (!ok) {
+        std::cerr << "Usage: canorus --convert <input> <output> [--convert <input> <output> ...] [--jobs <n>]" << std::endl
+                  << "       canorus --batch <directory> <format> [--output-dir <directory>] [--jobs <n>]" << std::endl;
+        return false;
+    }
+
+    for (int i = 0; i < directories.size(); i++) {
+        if (!addDirectory(directories[i].first, directories[i].second, outputDir)) {
+            std::cerr << qPrintable(QObject::tr("No files to convert in %1.").arg(directories[i].first)) << std::endl;
+        }
+    }
+
+    return true;
+}
+
+/*!
+	Adds the conversion of the \a input file to the \a output file.
+*/
+void CABatchConverter::addConversion(const QString& input, const QString& output)
+{
+    _conversions << QPair<QString, QString>(input, output);
+}
+
+/*!
+	Adds the conversions of all the supported files in \a dir to the given \a format (file
+	extension). The output files are written to \a outputDir or next to the input files.
+
+	Returns the number of added conversions.
+*/
+int CABatchConverter::addDirectory(const QString& dir, const QString& format, const QString& outputDir)
+{
+    QDir output(outputDir.isEmpty() ? dir : outputDir);
+    QFileInfoList files = QDir(dir).entryInfoList(QDir::Files | QDir::Readable, QDir::Name);
+
+    int count = 0;
+    for (int i = 0; i < files.size(); i++) {
+        if (files[i].suffix().compare(format, Qt::CaseInsensitive) == 0) {
+            continue;
+        }
+
+        CAImport* import = createImport(files[i].fileName());
+        if (import) {
+            delete import;
+            addConversion(files[i].filePath(), output.filePath(files[i].completeBaseName() + "." + format));
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/*!
+	Runs all the conversions and waits until they are finished.
+	Returns 0, if all the conversions succeeded, and 1 otherwise.
+*/
+int CABatchConverter::run()
+{
+    QThreadPool pool;
+    pool.setMaxThreadCount(maxThreads());
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < _conversions.size(); i++) {
+        pool.start(new CAConversionJob(this, _conversions[i].first, _conversions[i].second));
+    }
+    pool.waitForDone();
+
+    double sec = qMax<qint64>(1, timer.elapsed()) / 1000.0;
+    std::cout << qPrintable(QObject::tr("%1 files converted, %2 failed in %3 s using %4 threads (%5 files/s, %6 MiB/s)")
+                                .arg(_conversions.size() - _failed.load())
+                                .arg(_failed.load())
+                                .arg(sec, 0, 'f', 2)
+                                .arg(maxThreads())
+                                .arg(_conversions.size() / sec, 0, 'f', 1)
+                                .arg(_bytes / sec / (1024 * 1024), 0, 'f', 2))
+              << std::endl;
+
+    return _failed.load() ? 1 : 0;
+}
+
+/*!
+	Returns a new import filter for the file \a fileName based on its extension or nullptr, if
+	the format isn't supported.
+*/
+CAImport* CABatchConverter::createImport(const QString& fileName)
+{
+    QString suffix = QFileInfo(fileName).suffix().toLower();
+    if (suffix == "can") {
+        return new CACanImport();
+    } else if (suffix == "xml") {
+        return new CACanorusMLImport();
+    } else if (suffix == "musicxml") {
+        return new CAMusicXmlImport();
+    } else if (suffix == "mxl") {
+        return new CAMXLImport();
+    } else if (suffix == "mid" || suffix == "midi") {
+        return new CAMidiImport();
+    }
+
+    return nullptr;
+}
+
+/*!
+	Returns a new export filter for the file \a fileName based on its extension or nullptr, if
+	the format isn't supported.
+*/
+CAExport* CABatchConverter::createExport(const QString& fileName)
+{
+    QString suffix = QFileInfo(fileName).suffix().toLower();
+    if (suffix == "can") {
+        return new CACanExport();
+    } else if (suffix == "xml") {
+        return new CACanorusMLExport();
+    } else if (suffix == "musicxml") {
+        return new CAMusicXmlExport();
+    } else if (suffix == "ly") {
+        return new CALilyPondExport();
+    } else if (suffix == "mid" || suffix == "midi") {
+        CAMidiExport* midi = new CAMidiExport();
+        midi->setExportAllSheets(true);
+        return midi;
+    }
+
+    return nullptr;
+}
+
+/*!
+	Prints the result of a single conversion and updates the totals.
+*/
+void CABatchConverter::report(const QString& input, const QString& output, const QString& error, qint64 bytes, qint64 nsec)
+{
+    QMutexLocker locker(&_reportMutex);
+
+    if (error.isEmpty()) {
+        _bytes += bytes;
+        std::cout << qPrintable(QString("%1 -> %2: %3 ms").arg(input, output).arg(nsec / 1000000.0, 0, 'f', 1)) << std::endl;
+    } else {
+        _failed.ref();
+        std::cerr << qPrintable(QString("%1 -> %2: ").arg(input, output) + error) << std::endl;
+    }
+}
+
+CABatchConverter::CAConversionJob::CAConversionJob(CABatchConverter* converter, const QString& input, const QString& output)
+    : _converter(converter)
+    , _input(input)
+    , _output(output)
+{
+}
+
+void CABatchConverter::CAConversionJob::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+    QString error = convert();
+    _converter->report(_input, _output, error, QFileInfo(_input).size(), timer.nsecsElapsed());
+}
+
+/*!
+	Imports the input file and exports it to the output file.
+	Returns an empty string on success or the error description.
+*/
+QString CABatchConverter::CAConversionJob::convert()
+{
+    if (!QFileInfo(_input).isReadable()) {
+        return QObject::tr("Cannot read the file.");
+    }
+
+    CAImport* import = createImport(_input);
+    if (!import) {
+        return QObject::tr("Unsupported input format.");
+    }
+
+    CAExport* exp = createExport(_output);
+    if (!exp) {
+        delete import;
+        return QObject::tr("Unsupported output format.");
+    }
+    delete exp;
+
+    import->setStreamFromFile(_input);
+    import->importDocument(false); // already in a worker thread
+
+    CADocument* doc = import->importedDocument();
+    if (import->status() != 0 || !doc) {
+        QString error = QObject::tr("Import failed: %1").arg(import->readableStatus());
+        delete import;
+        delete doc;
+        return error;
+    }
+    delete import;
+
+    QString error;
+    if (!isSheetFormat(_output)) {
+        exp = createExport(_output);
+        exp->setStreamToFile(_output);
+        exp->exportDocument(doc, false); // already in a worker thread
+        if (exp->status() != 0) {
+            error = QObject::tr("Export failed: %1").arg(exp->readableStatus());
+        }
+        delete exp;
+    } else {
+        QFileInfo output(_output);
+        for (int i = 0; i < doc->sheetList().size() && error.isEmpty(); i++) {
+            QString fileName = i ? output.dir().filePath(QString("%1-%2.%3").arg(output.completeBaseName()).arg(i + 1).arg(output.suffix())) : _output;
+
+            exp = createExport(fileName);
+            exp->setStreamToFile(fileName);
+            exp->exportSheet(doc->sheetList()[i], false);
+            if (exp->status() != 0) {
+                error = QObject::tr("Export failed: %1").arg(exp->readableStatus());
+            }
+            delete exp;
+        }
+    }
+
+    delete doc;
+    return error;
+}
@@ -0,0 +1,63 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#ifndef BATCHCONVERTER_H_
+#define BATCHCONVERTER_H_
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QRunnable>
+#include <QString>
+#include <QStringList>
+
+class CAImport;
+class CAExport;
+
+class CABatchConverter {
+public:
+    CABatchConverter();
+
+    static bool isBatchMode(int argc, char* argv[]);
+    bool parseArguments(const QStringList& args);
+
+    void addConversion(const QString& input, const QString& output);
+    int addDirectory(const QString& dir, const QString& format, const QString& outputDir = QString());
+    inline void setMaxThreads(int threads) { _maxThreads = threads; }
+    inline int maxThreads() { return _maxThreads; }
+
+    int run();
+
+    static CAImport* createImport(const QString& fileName);
+    static CAExport* createExport(const QString& fileName);
+
+private:
+    class CAConversionJob : public QRunnable {
+    public:
+        CAConversionJob(CABatchConverter* converter, const QString& input, const QString& output);
+        void run();
+
+    private:
+        QString convert();
+
+        CABatchConverter* _converter;
+        QString _input;
+        QString _output;
+    };
+
+    void report(const QString& input, const QString& output, const QString& error, qint64 bytes, qint64 nsec);
+
+    QList<QPair<QString, QString>> _conversions; // input and output file names
+    int _maxThreads;
+
+    QMutex _reportMutex; // one report line at a time
+    QAtomicInt _failed;
+    qint64 _bytes; // total size of the converted input files
+};
+
+#endif /* BATCHCONVERTER_H_ */
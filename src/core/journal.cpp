@@ -0,0 +1,247 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QDataStream>
+#include <QSaveFile>
+
+#include "core/journal.h"
+#include "core/undodelta.h"
+
+/*!
+	\class CAJournal
+	\brief Append-only log of the document changes since its last recovery file
+
+	Each change made by a delta undo command (see CAUndo::createDeltaUndoCommand()) or undoing
+	and redoing it is appended to the journal as a single record containing its deltas. Records
+	are small and written with one write() each, so the journal can be updated after every change.
+	Each record is prefixed by its size, so a record cut off when crashing is recognized.
+
+	The changed values of the existing structures (note pitches, stem directions, names) and the
+	music elements inserted to and removed from the staves (see CAMusElementsDelta) are
+	serialized. Commands which aren't journaled (see CAUndoCommand::isJournaled()) are written as
+	a barrier. These are the snapshot undo commands and the commands which copied a context by
+	CAContextDelta, eg. when creating ties, slurs and tuplets or changing lyrics. Replaying stops
+	at the first barrier, so CAAutoRecovery writes a new recovery file soon after. Until then,
+	the barrier and all the changes made after it are lost when Canorus crashes.
+
+	When a new recovery file is written, the records it already contains are removed from the
+	beginning of the journal by compact(). Inserting and removing the elements by their positions
+	can't be repeated safely, so if compacting fails, a snapshot record is appended instead and
+	replay() skips the records before its offset.
+
+	\sa CAAutoRecovery, CAUndoDelta
+*/
+
+/*!
+	Journal size in bytes after which CAAutoRecovery writes a new recovery file.
+*/
+const qint64 CAJournal::MAX_SIZE = 1024 * 1024;
+
+/*!
+	Creates an empty journal in the file \a fileName. An existing file is truncated.
+*/
+CAJournal::CAJournal(const QString& fileName)
+    : _file(fileName)
+    , _size(0)
+{
+    _file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+}
+
+CAJournal::~CAJournal()
+{
+    _file.close();
+}
+
+/*!
+	Appends a record of the given \a deltas. If \a undo is True, the deltas were undone.
+*/
+void CAJournal::append(const QList<CAUndoDelta*>& deltas, bool undo)
+{
+    QByteArray record;
+    QDataStream out(&record, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << static_cast<quint8>(undo ? Undo : Redo) << static_cast<quint32>(deltas.size());
+    for (int i = 0; i < deltas.size(); i++) {
+        deltas[i]->write(out);
+    }
+
+    write(record);
+}
+
+/*!
+	Appends a barrier marking a change which isn't stored in the journal.
+*/
+void CAJournal::appendBarrier()
+{
+    QByteArray record;
+    QDataStream out(&record, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << static_cast<quint8>(Barrier) << static_cast<quint32>(0);
+
+    write(record);
+}
+
+/*!
+	Appends a record telling that the records before \a offset are contained in the recovery file.
+*/
+void CAJournal::appendSnapshot(qint64 offset)
+{
+    QByteArray record;
+    QDataStream out(&record, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << static_cast<quint8>(Snapshot) << static_cast<quint32>(0) << offset;
+
+    write(record);
+}
+
+void CAJournal::write(const QByteArray& record)
+{
+    if (!_file.isOpen()) {
+        return;
+    }
+
+    QByteArray sized;
+    QDataStream out(&sized, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << record;
+
+    _size += _file.write(sized);
+    _file.flush();
+}
+
+/*!
+	Removes the first \a offset bytes from the journal.
+	This is called when a recovery file containing these changes was written.
+*/
+void CAJournal::compact(qint64 offset)
+{
+    if (!_file.isOpen() || offset <= 0) {
+        return;
+    }
+
+    QByteArray rest;
+    QFile in(_file.fileName());
+    if (in.open(QIODevice::ReadOnly) && in.seek(offset)) {
+        rest = in.readAll();
+    }
+    in.close();
+
+    QSaveFile out(_file.fileName());
+    if (!out.open(QIODevice::WriteOnly)) {
+        appendSnapshot(offset);
+        return;
+    }
+    out.write(rest);
+    if (!out.commit()) {
+        appendSnapshot(offset); // the records must not be replayed again
+        return;
+    }
+
+    // the file was replaced, reopen it
+    _file.close();
+    _file.open(QIODevice::WriteOnly | QIODevice::Append);
+    _size = rest.size();
+}
+
+/*!
+	Closes and deletes the journal file.
+*/
+void CAJournal::remove()
+{
+    _file.close();
+    _file.remove();
+    _size = 0;
+}
+
+/*!
+	Applies the records of the journal stored in \a fileName to the given \a document.
+	Skips the records before the last snapshot record and stops at the first barrier after them
+	or an incomplete record written when crashing. Returns the number of applied records.
+*/
+int CAJournal::replay(const QString& fileName, CADocument* document)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    // find the records not contained in the recovery file first
+    QList<QByteArray> records;
+    QList<qint64> offsets;
+    while (!in.atEnd()) {
+        qint64 offset = file.pos();
+        QByteArray record;
+        in >> record;
+        if (in.status() != QDataStream::Ok) {
+            break;
+        }
+
+        QDataStream header(record);
+        header.setVersion(QDataStream::Qt_5_0);
+        quint8 type;
+        quint32 count;
+        qint64 snapshotOffset = 0;
+        header >> type >> count;
+        if (type == Snapshot) {
+            header >> snapshotOffset;
+            while (!offsets.isEmpty() && offsets.first() < snapshotOffset) {
+                offsets.removeFirst();
+                records.removeFirst();
+            }
+            continue;
+        }
+
+        records << record;
+        offsets << offset;
+    }
+
+    int applied = 0;
+    for (int r = 0; r < records.size(); r++) {
+        QDataStream record(records[r]);
+        record.setVersion(QDataStream::Qt_5_0);
+        quint8 type;
+        quint32 count;
+        record >> type >> count;
+        if (record.status() != QDataStream::Ok || (type != Redo && type != Undo)) {
+            break;
+        }
+
+        QList<CAUndoDelta*> deltas;
+        bool complete = true;
+        for (quint32 i = 0; i < count; i++) {
+            CAUndoDelta* delta = CAUndoDelta::read(record);
+            if (!delta) {
+                complete = false;
+                break;
+            }
+            deltas << delta;
+        }
+
+        if (complete) {
+            if (type == Undo) {
+                for (int i = deltas.size() - 1; i >= 0; i--) {
+                    deltas[i]->undo(document);
+                }
+            } else {
+                for (int i = 0; i < deltas.size(); i++) {
+                    deltas[i]->redo(document);
+                }
+            }
+            applied++;
+        }
+
+        qDeleteAll(deltas);
+        if (!complete) {
+            break;
+        }
+    }
+
+    return applied;
+}
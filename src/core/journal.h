@@ -0,0 +1,49 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include <QFile>
+#include <QList>
+#include <QString>
+
+class CADocument;
+class CAUndoDelta;
+
+class CAJournal {
+public:
+    CAJournal(const QString& fileName);
+    ~CAJournal();
+
+    void append(const QList<CAUndoDelta*>& deltas, bool undo);
+    void appendBarrier();
+    void appendSnapshot(qint64 offset);
+    void compact(qint64 offset);
+    void remove();
+
+    inline qint64 size() { return _size; }
+
+    static int replay(const QString& fileName, CADocument* document);
+
+    static const qint64 MAX_SIZE;
+
+private:
+    enum CARecordType {
+        Redo,
+        Undo,
+        Barrier,
+        Snapshot
+    };
+
+    void write(const QByteArray& record);
+
+    QFile _file;
+    qint64 _size;
+};
+
+#endif /* JOURNAL_H_ */
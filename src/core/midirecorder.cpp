@@ -61,7 +61,7 @@ void CAMidiRecorder::startRecording(int)
         _timer->start();
         // the default time signature is a 4 quarters measure
         _midiExport->sendMetaEvent(0, CAMidiDevice::Meta_Timesig, 4, 4, 0);
-        _midiExport->sendMetaEvent(0, CAMidiDevice::Meta_Tempo, 120, 0, 0);
+        _midiExport->sendMetaEvent(0, CAMidiDevice::Meta_Tempo, 0, 0, 60000000 / 120); // 120 quarters per minute
     } else {
         _paused = false;
     }
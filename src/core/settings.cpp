@@ -32,6 +32,8 @@ const int CASettings::DEFAULT_MAX_RECENT_DOCUMENTS = 15;
 const bool CASettings::DEFAULT_LOCK_SCROLL_PLAYBACK = true; // scroll while playing
 const bool CASettings::DEFAULT_ANIMATED_SCROLL = true;
 const bool CASettings::DEFAULT_ANTIALIASING = true;
+const double CASettings::DEFAULT_REDUCED_DETAIL_ZOOM = 0.5;
+const double CASettings::DEFAULT_OUTLINE_DETAIL_ZOOM = 0.25;
 const bool CASettings::DEFAULT_SHOW_RULER = true;
 const QColor CASettings::DEFAULT_BACKGROUND_COLOR = QColor(255, 255, 240);
 const QColor CASettings::DEFAULT_FOREGROUND_COLOR = Qt::black;
@@ -150,6 +152,8 @@ void CASettings::writeSettings()
     setValue("appearance/lockscrollplayback", lockScrollPlayback());
     setValue("appearance/animatedscroll", animatedScroll());
     setValue("appearance/antialiasing", antiAliasing());
+    setValue("appearance/reduceddetailzoom", reducedDetailZoom());
+    setValue("appearance/outlinedetailzoom", outlineDetailZoom());
     setValue("appearance/backgroundcolor", backgroundColor());
     setValue("appearance/foregroundcolor", foregroundColor());
     setValue("appearance/selectioncolor", selectionColor());
@@ -251,6 +255,19 @@ int CASettings::readSettings()
     else
         setAntiAliasing(DEFAULT_ANTIALIASING);
 
+    if (contains("appearance/reduceddetailzoom"))
+        setReducedDetailZoom(value("appearance/reduceddetailzoom").toDouble());
+    else
+        setReducedDetailZoom(DEFAULT_REDUCED_DETAIL_ZOOM);
+
+    if (contains("appearance/outlinedetailzoom"))
+        setOutlineDetailZoom(value("appearance/outlinedetailzoom").toDouble());
+    else
+        setOutlineDetailZoom(DEFAULT_OUTLINE_DETAIL_ZOOM);
+
+    if (outlineDetailZoom() >= reducedDetailZoom()) // the outline must be the lower level of detail
+        setOutlineDetailZoom(reducedDetailZoom() * DEFAULT_OUTLINE_DETAIL_ZOOM / DEFAULT_REDUCED_DETAIL_ZOOM);
+
     if (contains("appearance/backgroundcolor"))
         setBackgroundColor(value("appearance/backgroundcolor").value<QColor>());
     else
@@ -84,6 +84,12 @@ public:
     inline bool antiAliasing() { return _antiAliasing; }
     inline void setAntiAliasing(bool a) { _antiAliasing = a; }
     static const bool DEFAULT_ANTIALIASING;
+    inline double reducedDetailZoom() { return _reducedDetailZoom; }
+    inline void setReducedDetailZoom(double z) { _reducedDetailZoom = z; }
+    static const double DEFAULT_REDUCED_DETAIL_ZOOM;
+    inline double outlineDetailZoom() { return _outlineDetailZoom; }
+    inline void setOutlineDetailZoom(double z) { _outlineDetailZoom = z; }
+    static const double DEFAULT_OUTLINE_DETAIL_ZOOM;
     inline bool showRuler() { return _showRuler; }
     inline void setShowRuler(bool b) { _showRuler = b; }
     static const bool DEFAULT_SHOW_RULER;
@@ -201,6 +207,8 @@ private:
     bool _lockScrollPlayback;
     bool _animatedScroll;
     bool _antiAliasing;
+    double _reducedDetailZoom; // zoom level below which the score is drawn with less detail, see CADrawable::detailLevel()
+    double _outlineDetailZoom; // zoom level below which only the outline of the score is drawn
     bool _showRuler;
     QColor _backgroundColor;
     QColor _foregroundColor;
@@ -29,11 +29,20 @@
 
 const int CATar::CHUNK = 16384;
 
+/*!
+	Files larger than this number of bytes are kept in temporary files instead of memory.
+	Default is 64 MiB.
+*/
+qint64 CATar::_spillThreshold = 64 * 1024 * 1024;
+
 /*!
 	Creates an empty tar file
 */
 CATar::CATar()
     : _ok(true)
+    , _parseState(ParseHeader)
+    , _parseFile(nullptr)
+    , _parseRemaining(0)
 {
     /* An empty file is a valid tar */
 }
@@ -47,6 +56,10 @@ CATar::~CATar()
         delete t->data; // deletes temp file from disk
         delete t;
     }
+    if (_parseFile) {
+        delete _parseFile->data;
+        delete _parseFile;
+    }
 }
 
 /*!
@@ -54,6 +67,9 @@ CATar::~CATar()
 */
 CATar::CATar(QIODevice& data)
     : _ok(true)
+    , _parseState(ParseHeader)
+    , _parseFile(nullptr)
+    , _parseRemaining(0)
 {
     parse(data);
 }
@@ -67,7 +83,6 @@ CATar::CATar(QIODevice& data)
 void CATar::parse(QIODevice& tar)
 {
     bool wasOpen = true;
-    int pad;
 
     if (!tar.isOpen()) {
         tar.open(QIODevice::ReadOnly);
@@ -75,80 +90,179 @@ void CATar::parse(QIODevice& tar)
     }
 
     while (!tar.atEnd()) {
-        QByteArray hdrba = tar.read(512);
-        CATarFile* file;
-        QTemporaryFile* tempfile;
-        int chksum, chkchksum = 0;
+        QByteArray chunk = tar.read(CHUNK);
+        if (chunk.isEmpty())
+            break;
+        parseChunk(chunk.constData(), chunk.size());
+    }
+    parseFinish();
+
+    if (!wasOpen)
+        tar.close();
+}
+
+/*!
+	Parses the next \a size bytes of the tar file.
 
-        if (hdrba.size() < 512) {
-            _ok = false;
+	This way the tar can be read in a single pass while it is being decompressed (see CAArchive)
+	without storing the whole tar first. Call parseFinish() after the last chunk.
+*/
+void CATar::parseChunk(const char* data, qint64 size)
+{
+    while (size > 0 && _parseState != ParseStopped) {
+        switch (_parseState) {
+        case ParseHeader: {
+            int len = static_cast<int>(qMin(static_cast<qint64>(512 - _parseBuffer.size()), size));
+            _parseBuffer.append(data, len);
+            data += len;
+            size -= len;
+            if (_parseBuffer.size() == 512) {
+                parseHeader(_parseBuffer);
+                _parseBuffer.clear();
+            }
             break;
         }
-
-        // Check magic first
-        QByteArray magic = hdrba.mid(257, 6);
-        QByteArray version = hdrba.mid(263, 2);
-        if (magic != QString::fromLatin1("ustar") || version[0] != '0' || version[1] != '0') {
-            _ok = false;
-            continue;
+        case ParseData: {
+            qint64 len = static_cast<qint64>(qMin(_parseRemaining, static_cast<quint64>(size)));
+            _parseFile->data->write(data, len);
+            data += len;
+            size -= len;
+            _parseRemaining -= static_cast<quint64>(len);
+            if (!_parseRemaining)
+                finishParsedFile();
+            break;
+        }
+        case ParsePadding: {
+            qint64 len = static_cast<qint64>(qMin(_parseRemaining, static_cast<quint64>(size)));
+            data += len;
+            size -= len;
+            _parseRemaining -= static_cast<quint64>(len);
+            if (!_parseRemaining)
+                _parseState = ParseHeader;
+            break;
+        }
+        case ParseStopped:
+            break;
         }
-        QBuffer header(&hdrba);
-
-        header.open(QIODevice::ReadOnly);
-        file = new CATarFile;
-        bufncpy(file->hdr.name, header.read(100).data(), 100);
-        file->hdr.mode = header.read(8).toUInt(&_ok, 8);
-        if (!_ok)
-            return;
+    }
+}
+
+/*!
+	Finishes parsing the tar file given by parseChunk().
+	A truncated header is an error. A truncated last file is kept.
+*/
+void CATar::parseFinish()
+{
+    if (_parseState == ParseHeader && !_parseBuffer.isEmpty())
+        _ok = false;
+    if (_parseState == ParseData)
+        finishParsedFile();
+
+    _parseBuffer.clear();
+    _parseState = ParseHeader;
+}
+
+/*!
+	Reads the 512 bytes header block \a hdrba and starts reading the file data.
+*/
+void CATar::parseHeader(const QByteArray& hdrba)
+{
+    CATarFile* file;
+    int chksum = 0, chkchksum = 0;
+
+    // Blocks of NULs mark the end of the archive
+    if (hdrba.count('\0') == hdrba.size())
+        return;
+
+    // Check magic first
+    QByteArray magic = hdrba.mid(257, 6);
+    QByteArray version = hdrba.mid(263, 2);
+    if (magic != QString::fromLatin1("ustar") || version[0] != '0' || version[1] != '0') {
+        _ok = false;
+        return;
+    }
+    QBuffer header;
+    header.setData(hdrba);
+
+    header.open(QIODevice::ReadOnly);
+    file = new CATarFile;
+    file->data = nullptr;
+    bufncpy(file->hdr.name, header.read(100).data(), 100);
+    file->hdr.mode = header.read(8).toUInt(&_ok, 8);
+    if (_ok)
         file->hdr.uid = header.read(8).toUInt(&_ok, 8);
-        if (!_ok)
-            return;
+    if (_ok)
         file->hdr.gid = header.read(8).toUInt(&_ok, 8);
-        if (!_ok)
-            return;
+    if (_ok)
         file->hdr.size = header.read(12).toULongLong(&_ok, 8);
-        if (!_ok)
-            return;
+    if (_ok)
         file->hdr.mtime = header.read(12).toUInt(&_ok, 8);
-        if (!_ok)
-            return;
+    if (_ok)
         chksum = header.read(8).toInt(&_ok, 8); // recorded checksum
-        if (!_ok)
-            return;
-        file->hdr.typeflag = header.read(1)[0];
-        bufncpy(file->hdr.linkname, header.read(100).data(), 100);
-        header.read(6 + 2); //magic+header
-        bufncpy(file->hdr.uname, header.read(32).data(), 32);
-        bufncpy(file->hdr.gname, header.read(32).data(), 32);
-        header.read(16); // nulls (devmajor, devminor)
-        bufncpy(file->hdr.prefix, header.read(155).data(), 155);
-
-        // get real checksum
-        for (int i = 0; i < 148; i++)
-            chkchksum += hdrba[i];
-        chkchksum += int(' ') * 8;
-        for (int i = 156; i < 512; i++)
-            chkchksum += hdrba[i];
-
-        if (chkchksum != chksum) {
-            delete file;
-            continue;
-        }
+    if (!_ok) {
+        delete file;
+        _parseState = ParseStopped;
+        return;
+    }
+    file->hdr.typeflag = header.read(1)[0];
+    bufncpy(file->hdr.linkname, header.read(100).data(), 100);
+    header.read(6 + 2); //magic+header
+    bufncpy(file->hdr.uname, header.read(32).data(), 32);
+    bufncpy(file->hdr.gname, header.read(32).data(), 32);
+    header.read(16); // nulls (devmajor, devminor)
+    bufncpy(file->hdr.prefix, header.read(155).data(), 155);
+
+    // get real checksum
+    for (int i = 0; i < 148; i++)
+        chkchksum += hdrba[i];
+    chkchksum += int(' ') * 8;
+    for (int i = 156; i < 512; i++)
+        chkchksum += hdrba[i];
+
+    if (chkchksum != chksum) {
+        delete file;
+        return;
+    }
+
+    file->data = createData(static_cast<qint64>(file->hdr.size));
+    _parseFile = file;
+    _parseRemaining = file->hdr.size;
+    if (_parseRemaining)
+        _parseState = ParseData;
+    else
+        finishParsedFile();
+}
 
-        tempfile = new QTemporaryFile;
+/*!
+	Adds the file which data has been read to the archive and skips the padding.
+*/
+void CATar::finishParsedFile()
+{
+    _parseFile->data->reset();
+    _files << _parseFile;
+
+    int pad = _parseFile->hdr.size % 512;
+    _parseFile = nullptr;
+    _parseRemaining = (pad > 0) ? static_cast<quint64>(512 - pad) : 0;
+    _parseState = (_parseRemaining) ? ParsePadding : ParseHeader;
+}
+
+/*!
+	Returns a new opened device for storing the data of a file of the given \a size.
+	Files up to spillThreshold() bytes are kept in memory, larger ones in temporary files.
+*/
+QIODevice* CATar::createData(qint64 size)
+{
+    if (size > _spillThreshold) {
+        QTemporaryFile* tempfile = new QTemporaryFile;
         tempfile->open();
-        file->data = tempfile;
-        for (unsigned int i = 0; i < file->hdr.size / CHUNK; i++)
-            file->data->write(tar.read(CHUNK));
-        file->data->write(tar.read(file->hdr.size % CHUNK));
-        file->data->flush();
-        pad = file->hdr.size % 512;
-        if (pad > 0)
-            tar.read(512 - pad);
-        _files << file;
+        return tempfile;
     }
-    if (!wasOpen)
-        tar.close();
+
+    QBuffer* buffer = new QBuffer;
+    buffer->buffer().reserve(static_cast<int>(size));
+    buffer->open(QIODevice::ReadWrite);
+    return buffer;
 }
 
 /** 
@@ -203,9 +317,19 @@ bool CATar::addFile(const QString& filename, QIODevice& data, bool replace /* =
 
     /* if there's need for larger file names with many nested directories, put the directory path (or part of it?) in prefix */
     bufncpy(file->hdr.prefix, nullptr, 0, 155);
-    QTemporaryFile* tempfile = new QTemporaryFile;
-    tempfile->open();
-    file->data = tempfile;
+
+    QBuffer* buffer = qobject_cast<QBuffer*>(&data);
+    if (buffer && buffer->size() <= _spillThreshold) {
+        // Share the (implicitly shared) byte array of the buffer instead of copying it.
+        QBuffer* shared = new QBuffer;
+        shared->setData(buffer->data());
+        shared->open(QIODevice::ReadOnly);
+        file->data = shared;
+        _files << file;
+        return true;
+    }
+
+    file->data = createData(data.size());
 
     bool wasOpen = true;
     if (!data.isOpen()) {
@@ -213,10 +337,10 @@ bool CATar::addFile(const QString& filename, QIODevice& data, bool replace /* =
         wasOpen = false;
     }
     data.reset(); //seek to the beginning.
-    // Save the uncompressed data in a temporary file.
+    // Copy the uncompressed data.
     while (!data.atEnd())
         file->data->write(data.read(CHUNK));
-    file->data->flush();
+    file->data->reset();
     if (!wasOpen)
         data.close();
     _files << file;
@@ -225,6 +349,7 @@ bool CATar::addFile(const QString& filename, QIODevice& data, bool replace /* =
 
 /*
 	A convenience method to add a file from a byte array.
+	The byte array is shared, not copied.
 */
 bool CATar::addFile(const QString& filename, QByteArray data, bool replace)
 {
@@ -237,10 +362,10 @@ bool CATar::addFile(const QString& filename, QByteArray data, bool replace)
 */
 void CATar::removeFile(const QString& filename)
 {
-    for (CATarFile* t : _files) {
-        if (filename == t->hdr.name) {
-            delete t;
-            _files.removeAll(t);
+    for (int i = _files.size() - 1; i >= 0; i--) {
+        if (filename == _files[i]->hdr.name) {
+            delete _files[i]->data;
+            delete _files.takeAt(i);
         }
     }
 }
@@ -250,6 +375,8 @@ void CATar::removeFile(const QString& filename)
 	If the file is not found, an empty buffer is returned.
 	The function returns a smart (auto) pointer to a QIODevice.
 
+	Files kept in memory are returned as a QBuffer sharing the data, larger files as a QFile.
+
 	\param filename	The file name (including its path if needed).
 */
 CAIOPtr CATar::file(const QString& filename)
@@ -258,7 +385,15 @@ CAIOPtr CATar::file(const QString& filename)
         return CAIOPtr(new QBuffer());
     for (CATarFile* t : _files) {
         if (filename == t->hdr.name) {
-            QFile* f = new QFile(t->data->fileName());
+            QBuffer* buffer = qobject_cast<QBuffer*>(t->data);
+            if (buffer) {
+                QBuffer* b = new QBuffer();
+                b->setData(buffer->data());
+                b->open(QIODevice::ReadOnly);
+                return CAIOPtr(b);
+            }
+
+            QFile* f = new QFile(static_cast<QFile*>(t->data)->fileName());
             f->open(QIODevice::ReadWrite);
             return CAIOPtr(f);
         }
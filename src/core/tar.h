@@ -27,8 +27,10 @@ public:
     bool addFile(const QString& filename, QIODevice& data, bool replace = true);
     bool addFile(const QString& filename, QByteArray data, bool replace = true);
     void removeFile(const QString& filename);
-    inline bool contains(const QString& filename);
+    bool contains(const QString& filename);
     CAIOPtr file(const QString& filename);
+    void parseChunk(const char* data, qint64 size);
+    void parseFinish();
     qint64 write(QIODevice& dest, qint64 chunk);
     qint64 write(QIODevice& dest);
     inline bool open(QIODevice& dest)
@@ -43,8 +45,12 @@ public:
     bool eof(QIODevice& dest);
     inline bool error() { return !_ok; }
 
+    static inline qint64 spillThreshold() { return _spillThreshold; }
+    static inline void setSpillThreshold(qint64 bytes) { _spillThreshold = bytes; }
+
 protected:
     static const int CHUNK;
+    static qint64 _spillThreshold;
     typedef struct { /* size in bytes (ASCII) */
         char name[101]; /* 100 */
         quint32 mode; /* 8   */
@@ -65,11 +71,26 @@ protected:
     } CATarHeader;
     typedef struct {
         CATarHeader hdr;
-        QFile* data;
+        QIODevice* data; // QBuffer or QTemporaryFile for files larger than spillThreshold()
     } CATarFile;
     QList<CATarFile*> _files;
     void parse(QIODevice& data);
+    void parseHeader(const QByteArray& hdrba);
+    void finishParsedFile();
+    static QIODevice* createData(qint64 size);
     bool _ok;
+
+    // incremental parser state
+    enum CAParseState {
+        ParseHeader,
+        ParseData,
+        ParsePadding,
+        ParseStopped
+    };
+    CAParseState _parseState;
+    QByteArray _parseBuffer; // incomplete header block
+    CATarFile* _parseFile; // file which data is being read
+    quint64 _parseRemaining; // bytes of data or padding left to read
     typedef struct {
         qint64 pos;
         qint32 file;
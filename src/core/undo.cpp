@@ -6,8 +6,15 @@
 */
 
 #include "core/undo.h"
+#include "canorus.h"
+#include "core/autorecovery.h"
 #include "core/undocommand.h"
+#include "core/undodelta.h"
 #include "score/document.h" // needed for setting the modified flag
+#include "score/lyricscontext.h"
+#include "score/sheet.h"
+#include "score/staff.h"
+#include "widgets/tilecache.h"
 #include <iostream>
 
 /*!
@@ -40,12 +47,28 @@
 	   calling CAUndo::deleteUndoStack(). This is not done automatically because CADocument is part of the
 	   data model and CAUndo part of the controller.
 
+    Cloning the whole document for each action is expensive on big scores. Actions which know exactly
+    what they changed should call CAUndo::createDeltaUndoCommand() in step 2 instead and report each
+    change by CAUndo::addDelta() right after making it. Such commands only store the deltas and are
+    applied to the document in place. Insertion, removal and moving of music elements call
+    CAUndo::createContextUndoCommand() with the contexts they are about to change. It records the
+    elements inserted to and removed from the staves and only copies the other contexts.
+    Whole-document snapshots remain the fallback for other actions. The oldest
+    commands are removed when the undo stack takes more than MAX_COST bytes.
+
     If the user already created its own instance of the new document without calling CAUndo::createUndoCommand()
     (e.g. when parsing the source-view of the whole document), he should use CAUndo::replaceDocument().
 
 	\sa CAUndoCommand
 */
 
+/*!
+	Memory budget in bytes of a single undo stack. The cost of each command is estimated from
+	the number of music elements it keeps (see CAUndoCommand::cost()). The oldest commands are
+	removed when exceeded.
+*/
+const int CAUndo::MAX_COST = 64 * 1024 * 1024;
+
 CAUndo::CAUndo()
 {
     _undoCommand = nullptr;
@@ -72,8 +95,15 @@ void CAUndo::createUndoStack(CADocument* doc)
 void CAUndo::undo(CADocument* doc)
 {
     if (_undoStack[doc] && canUndo(doc)) {
-        _undoStack[doc]->at(undoIndex(doc))->undo();
+        clearUndoCommand(); // a pending command must not record the changes made by undo
+        CAUndoCommand* command = _undoStack[doc]->at(undoIndex(doc));
+        unsigned int revision = doc->revision();
+        CATileCache::cancelAll(); // score views must not render the document while it changes
+        command->undo();
         undoIndex(doc)--;
+
+        if (CACanorus::autoRecovery())
+            CACanorus::autoRecovery()->journalCommand(doc, revision, command, true);
     }
 }
 
@@ -84,8 +114,15 @@ void CAUndo::undo(CADocument* doc)
 void CAUndo::redo(CADocument* doc)
 {
     if (_undoStack[doc] && canRedo(doc)) {
-        _undoStack[doc]->at(undoIndex(doc) + 1)->redo();
+        clearUndoCommand();
+        CAUndoCommand* command = _undoStack[doc]->at(undoIndex(doc) + 1);
+        unsigned int revision = doc->revision();
+        CATileCache::cancelAll();
+        command->redo();
         undoIndex(doc)++;
+
+        if (CACanorus::autoRecovery())
+            CACanorus::autoRecovery()->journalCommand(doc, revision, command, false);
     }
 }
 
@@ -121,30 +158,73 @@ void CAUndo::pushUndoCommand()
     if (!_undoCommand || !_undoCommand->getRedoDocument() || !_undoCommand->getUndoDocument())
         return;
 
+    _undoCommand->finish();
+
+    if (!_undoCommand->isSnapshot() && _undoCommand->deltaList().isEmpty()) {
+        clearUndoCommand(); // nothing has changed
+        return;
+    }
+
     CADocument* d = _undoCommand->getRedoDocument();
+    CAUndoCommand* command = _undoCommand;
+    unsigned int revision = d->revision();
 
     _undoCommand->getUndoDocument()->setModified(true);
     _undoCommand->getRedoDocument()->setModified(true);
 
     QList<CAUndoCommand*>* s = _undoStack[d];
-    CAUndoCommand* prevUndoCommand = (undoIndex(d) < s->size() && undoIndex(d) >= 0 ? s->at(undoIndex(d)) : nullptr);
 
     // delete undo commands after the new one, if any (eg. 3x changes, 2x undo, 1x change => removes last 2 undos when making a change)
     for (int i = undoIndex(d) + 1; i < s->size();) {
-        _undoStack.remove(s->at(i)->getRedoDocument());
+        if (s->at(i)->getRedoDocument() != d) // undone delta commands still point to the current document
+            _undoStack.remove(s->at(i)->getRedoDocument());
         delete s->at(i);
         s->removeAt(i);
     }
 
-    if (prevUndoCommand) {
-        if (_undoCommand->getRedoDocument() && prevUndoCommand->getRedoDocument())
-            prevUndoCommand->setRedoDocument(_undoCommand->getUndoDocument());
+    // relink the previous commands to the new command's undo document
+    // delta commands are applied in place, so the whole sequence of them up to the last snapshot needs updating
+    for (int i = undoIndex(d); i >= 0 && i < s->size(); i--) {
+        CAUndoCommand* prevUndoCommand = s->at(i);
+        prevUndoCommand->setRedoDocument(_undoCommand->getUndoDocument());
+        if (prevUndoCommand->isSnapshot())
+            break;
+        prevUndoCommand->setUndoDocument(_undoCommand->getUndoDocument());
     }
 
     s->append(_undoCommand); // push the command on stack
     _undoStack[_undoCommand->getUndoDocument()] = s;
     undoIndex(d) = _undoStack[d]->size() - 1;
     _undoCommand = nullptr;
+
+    trimUndoStack(d);
+
+    if (CACanorus::autoRecovery())
+        CACanorus::autoRecovery()->journalCommand(d, revision, command, false);
+}
+
+/*!
+	Removes the oldest commands from the undo stack of the document \a d until the commands
+	take at most MAX_COST bytes. The last command is always kept.
+*/
+void CAUndo::trimUndoStack(CADocument* d)
+{
+    QList<CAUndoCommand*>* s = _undoStack[d];
+
+    qint64 cost = 0;
+    for (int i = 0; i < s->size(); i++) {
+        cost += s->at(i)->cost();
+    }
+
+    while (cost > MAX_COST && undoIndex(d) > 0) {
+        CAUndoCommand* c = s->takeFirst();
+        undoIndex(d)--;
+        cost -= c->cost();
+
+        if (c->isSnapshot() && c->getUndoDocument() != d)
+            _undoStack.remove(c->getUndoDocument());
+        delete c;
+    }
 }
 
 /*!
@@ -196,10 +276,95 @@ void CAUndo::clearUndoCommand()
 */
 void CAUndo::createUndoCommand(CADocument* d, QString text)
 {
+    CATileCache::cancelAll(); // the document is about to change, stop the score views rendering it
     clearUndoCommand();
     _undoCommand = new CAUndoCommand(d, text);
 }
 
+/*!
+	Creates an undo command which doesn't clone the document \a d. The action should report its
+	changes by addDelta() and then call pushUndoCommand() as usual.
+
+	\sa createUndoCommand(), CAUndoDelta
+*/
+void CAUndo::createDeltaUndoCommand(CADocument* d, QString text)
+{
+    CATileCache::cancelAll();
+    clearUndoCommand();
+    _undoCommand = new CAUndoCommand(d, text, false);
+}
+
+/*!
+	Creates an undo command which only copies the given \a contexts of the document \a d instead
+	of the whole document. Call it right before inserting, removing or moving music elements in
+	the contexts and then call pushUndoCommand() as usual. If \a contexts is empty, the whole
+	document is cloned as by createUndoCommand().
+
+	If \a recordElements is True, the elements inserted to and removed from the staves are
+	recorded by CAMusElementsDelta instead of copying the staves. Pass False for the actions
+	creating ties, slurs, tuplets or marks, as the delta would copy the staff anyway.
+
+	Changing a staff also repositions the syllables of its lyrics contexts and the function marks,
+	figured bass marks and chord names of the sheet, so these contexts are copied as well.
+
+	\sa CAContextDelta
+*/
+void CAUndo::createContextUndoCommand(CADocument* d, QList<CAContext*> contexts, QString text, bool recordElements)
+{
+    if (contexts.isEmpty()) {
+        createUndoCommand(d, text);
+        return;
+    }
+
+    QList<CAContext*> changed;
+    for (int i = 0; i < contexts.size(); i++) {
+        if (!contexts[i] || changed.contains(contexts[i]))
+            continue;
+
+        changed << contexts[i];
+        if (contexts[i]->contextType() != CAContext::Staff)
+            continue;
+
+        CAStaff* staff = static_cast<CAStaff*>(contexts[i]);
+        for (int j = 0; j < staff->voiceList().size(); j++) {
+            for (int k = 0; k < staff->voiceList()[j]->lyricsContextList().size(); k++) {
+                if (!changed.contains(staff->voiceList()[j]->lyricsContextList()[k]))
+                    changed << staff->voiceList()[j]->lyricsContextList()[k];
+            }
+        }
+
+        if (staff->sheet()) {
+            for (int j = 0; j < staff->sheet()->contextList().size(); j++) {
+                CAContext* c = staff->sheet()->contextList()[j];
+                if ((c->contextType() == CAContext::FunctionMarkContext || c->contextType() == CAContext::FiguredBassContext || c->contextType() == CAContext::ChordNameContext) && !changed.contains(c))
+                    changed << c;
+            }
+        }
+    }
+
+    createDeltaUndoCommand(d, text);
+    for (int i = 0; i < changed.size(); i++) {
+        if (recordElements && changed[i]->contextType() == CAContext::Staff && !static_cast<CAStaff*>(changed[i])->recorder()) {
+            _undoCommand->addDelta(new CAMusElementsDelta(static_cast<CAStaff*>(changed[i])));
+        } else {
+            _undoCommand->addDelta(new CAContextDelta(changed[i]));
+        }
+    }
+}
+
+/*!
+	Adds the \a delta describing the change just made to the current undo command.
+	The ownership of the delta is passed to the undo command.
+*/
+void CAUndo::addDelta(CAUndoDelta* delta)
+{
+    if (_undoCommand && !_undoCommand->isSnapshot()) {
+        _undoCommand->addDelta(delta);
+    } else {
+        delete delta;
+    }
+}
+
 /*!
     Replace the document pointer to an undo stack.
     This function is called when the document is rebuilt, e.g. when a CanorusML
@@ -207,6 +372,7 @@ void CAUndo::createUndoCommand(CADocument* d, QString text)
 */
 void CAUndo::replaceDocument(CADocument* oldDoc, CADocument* newDoc)
 {
+    CATileCache::cancelAll();
     clearUndoCommand();
     QList<CAUndoCommand*>* stack = _undoStack[oldDoc];
 
@@ -233,10 +399,11 @@ QList<CADocument*> CAUndo::getAllDocuments(CADocument* d)
 
     if (undoCommands && undoCommands->size()) {
         for (int i = 0; i < undoCommands->size(); i++) {
-            documents << undoCommands->at(i)->getUndoDocument();
+            if (!documents.contains(undoCommands->at(i)->getUndoDocument())) // delta commands share the document
+                documents << undoCommands->at(i)->getUndoDocument();
         }
 
-        if (undoCommands->size() > 0) {
+        if (undoCommands->size() > 0 && !documents.contains(undoCommands->at(undoCommands->size() - 1)->getRedoDocument())) {
             documents << undoCommands->at(undoCommands->size() - 1)->getRedoDocument();
         }
     } else {
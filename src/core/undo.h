@@ -9,7 +9,9 @@
 #define UNDO_H_
 
 class CAUndoCommand;
+class CAUndoDelta;
 class CADocument;
+class CAContext;
 
 #include <QHash>
 #include <QList>
@@ -30,6 +32,9 @@ public:
     inline void removeUndoStack(CADocument* d) { _undoStack.remove(d); }
     void deleteUndoStack(CADocument* doc);
     void createUndoCommand(CADocument* d, QString text);
+    void createDeltaUndoCommand(CADocument* d, QString text);
+    void createContextUndoCommand(CADocument* d, QList<CAContext*> contexts, QString text, bool recordElements = true);
+    void addDelta(CAUndoDelta* delta);
     void pushUndoCommand();
     CAUndoCommand* undoCommand(CADocument* d);
     CAUndoCommand* redoCommand(CADocument* d);
@@ -37,8 +42,11 @@ public:
     void replaceDocument(CADocument*, CADocument*);
     QList<CADocument*> getAllDocuments(CADocument* d);
 
+    static const int MAX_COST;
+
 private:
     void clearUndoCommand();
+    void trimUndoStack(CADocument* d);
     CAUndoCommand* _undoCommand; // current undo command created to be put on the undo stack
 
     QHash<CADocument*, QList<CAUndoCommand*>*> _undoStack;
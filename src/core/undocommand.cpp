@@ -8,10 +8,15 @@
 #include "core/undocommand.h"
 #include "canorus.h"
 #include "core/undo.h"
+#include "core/undodelta.h"
+#include "score/chordnamecontext.h"
 #include "score/document.h"
+#include "score/figuredbasscontext.h"
+#include "score/functionmarkcontext.h"
 #include "score/lyricscontext.h"
 #include "score/resource.h"
 #include "score/sheet.h"
+#include "score/staff.h"
 #include "score/voice.h"
 #include "widgets/scoreview.h"
 #include "widgets/sourceview.h"
@@ -22,6 +27,10 @@
 
 	This class implements undo and redo action.
 
+	A snapshot command keeps a clone of the whole document before the change. A delta command
+	keeps a list of CAUndoDelta objects describing the individual changes instead and is
+	applied to the current document in place.
+
 	It inherits QUndoCommand and is usually stored inside QUndoStack or a list.
 
 	Create this object by passing it a pointer to a document which the state should be saved for
@@ -34,32 +43,140 @@
 	\sa CAUndo
 */
 
+/*!
+	Approximate memory in bytes taken by a single music element kept in the undo history.
+	Used to estimate the cost() of document snapshots and deltas.
+*/
+const int CAUndoCommand::ELEMENT_COST = 256;
+
 /*!
 	Creates a new undo command.
-	Internally, it clones the given document and sets it as an undo document.
+	If \a snapshot is True, it internally clones the given document and sets it as an undo document.
 	The redo document is directly the passed document.
 	When having multiple undo commands, you should take care of relinking the previous undo commmand's redo
 	document to next command's undo document. This is usually done when pushing the command onto the stack.
+
+	If \a snapshot is False, the document is not cloned and the undo and redo documents are both the passed
+	document. The action should then record its changes by addDelta() which are reverted on undo().
 */
-CAUndoCommand::CAUndoCommand(CADocument* document, QString text)
+CAUndoCommand::CAUndoCommand(CADocument* document, QString text, bool snapshot)
     : QUndoCommand(text)
+    , _snapshot(snapshot)
+    , _cost(0)
 {
-    setUndoDocument(document->clone());
+    setUndoDocument(snapshot ? document->clone() : document);
     setRedoDocument(document);
+
+    if (snapshot) {
+        for (int i = 0; i < document->sheetList().size(); i++) {
+            for (int j = 0; j < document->sheetList()[i]->contextList().size(); j++) {
+                _cost += cost(document->sheetList()[i]->contextList()[j]);
+            }
+        }
+    }
 }
 
 CAUndoCommand::~CAUndoCommand()
 {
-    if (getUndoDocument() && (!CACanorus::mainWinCount(getUndoDocument())))
+    // delta commands share the document with the neighbouring commands and only delete it, when the last on the stack
+    if (isSnapshot() && getUndoDocument() && (!CACanorus::mainWinCount(getUndoDocument())))
         delete getUndoDocument();
 
     // delete also redoDocument, if the last on the stack
     if (getRedoDocument() && !CACanorus::mainWinCount(getRedoDocument()) && CACanorus::undo()->undoStack(getRedoDocument()) && CACanorus::undo()->undoStack(getRedoDocument())->indexOf(this) == CACanorus::undo()->undoStack(getRedoDocument())->count() - 1)
         delete getRedoDocument();
+
+    for (int i = 0; i < _deltaList.size(); i++) {
+        delete _deltaList[i];
+    }
+}
+
+/*!
+	Adds the \a delta describing a change of the document.
+	The ownership of the delta is passed to the command.
+*/
+void CAUndoCommand::addDelta(CAUndoDelta* delta)
+{
+    _deltaList << delta;
+    _cost += delta->cost();
+}
+
+/*!
+	Finishes recording of the deltas, which observe the document while the action changes it
+	(see CAMusElementsDelta). Called when the command is pushed on the undo stack.
+	The cost of the command is updated afterwards, as the deltas grew meanwhile.
+*/
+void CAUndoCommand::finish()
+{
+    if (isSnapshot())
+        return;
+
+    _cost = 0;
+    for (int i = 0; i < _deltaList.size(); i++) {
+        _deltaList[i]->finish();
+        _cost += _deltaList[i]->cost();
+    }
+}
+
+/*!
+	Returns True, if all the changes made by the command can be written to the edit journal.
+
+	\sa CAUndoDelta::isJournaled(), CAJournal
+*/
+bool CAUndoCommand::isJournaled()
+{
+    if (isSnapshot())
+        return false;
+
+    for (int i = 0; i < _deltaList.size(); i++) {
+        if (!_deltaList[i]->isJournaled())
+            return false;
+    }
+
+    return true;
+}
+
+/*!
+	Returns the approximate memory in bytes taken by the music elements of the \a context.
+*/
+int CAUndoCommand::cost(CAContext* context)
+{
+    int elements = 0;
+    switch (context->contextType()) {
+    case CAContext::Staff: {
+        CAStaff* staff = static_cast<CAStaff*>(context);
+        for (int i = 0; i < staff->voiceList().size(); i++) {
+            elements += staff->voiceList()[i]->musElementList().size();
+        }
+        break;
+    }
+    case CAContext::LyricsContext:
+        elements = static_cast<CALyricsContext*>(context)->syllableList().size();
+        break;
+    case CAContext::FunctionMarkContext:
+        elements = static_cast<CAFunctionMarkContext*>(context)->functionMarkList().size();
+        break;
+    case CAContext::FiguredBassContext:
+        elements = static_cast<CAFiguredBassContext*>(context)->figuredBassMarkList().size();
+        break;
+    case CAContext::ChordNameContext:
+        elements = static_cast<CAChordNameContext*>(context)->chordNameList().size();
+        break;
+    }
+
+    return (elements + 1) * ELEMENT_COST;
 }
 
 void CAUndoCommand::undo()
 {
+    if (!isSnapshot()) {
+        for (int i = _deltaList.size() - 1; i >= 0; i--) {
+            _deltaList[i]->undo(getUndoDocument());
+        }
+        getUndoDocument()->setModified(true); // changed in place, update its revision
+        return;
+    }
+
     getUndoDocument()->setTimeEdited(getRedoDocument()->timeEdited()); // time edited might get lost when saving the document and undoing right after
     getUndoDocument()->setFileName(getRedoDocument()->fileName());
     CAUndoCommand::undoDocument(getRedoDocument(), getUndoDocument());
@@ -67,6 +184,14 @@ void CAUndoCommand::undo()
 
 void CAUndoCommand::redo()
 {
+    if (!isSnapshot()) {
+        for (int i = 0; i < _deltaList.size(); i++) {
+            _deltaList[i]->redo(getRedoDocument());
+        }
+        getRedoDocument()->setModified(true); // changed in place, update its revision
+        return;
+    }
+
     getRedoDocument()->setTimeEdited(getUndoDocument()->timeEdited()); // time edited might get lost when saving the document and redoing right after
     getRedoDocument()->setFileName(getUndoDocument()->fileName());
     CAUndoCommand::undoDocument(getUndoDocument(), getRedoDocument());
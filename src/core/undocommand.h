@@ -8,14 +8,17 @@
 #ifndef UNDOCOMMAND_H_
 #define UNDOCOMMAND_H_
 
+#include <QList>
 #include <QUndoCommand>
 
 class CASheet;
+class CAContext;
 class CADocument;
+class CAUndoDelta;
 
 class CAUndoCommand : public QUndoCommand {
 public:
-    CAUndoCommand(CADocument* document, QString text);
+    CAUndoCommand(CADocument* document, QString text, bool snapshot = true);
     virtual ~CAUndoCommand();
     virtual void undo();
     virtual void redo();
@@ -27,9 +30,23 @@ public:
     inline CADocument* getRedoDocument() { return _redoDocument; }
     inline void setRedoDocument(CADocument* doc) { _redoDocument = doc; }
 
+    inline bool isSnapshot() { return _snapshot; }
+    bool isJournaled();
+    inline const QList<CAUndoDelta*>& deltaList() { return _deltaList; }
+    void addDelta(CAUndoDelta* delta);
+    void finish();
+
+    inline int cost() { return _cost; }
+    static int cost(CAContext* context);
+
+    static const int ELEMENT_COST;
+
 private:
     CADocument* _undoDocument;
     CADocument* _redoDocument;
+    bool _snapshot; // the undo document is a clone of the document before the change
+    QList<CAUndoDelta*> _deltaList; // changes made to the document, if not a snapshot
+    int _cost; // approximate memory in bytes held by the command
 };
 
 #endif /* UNDOCOMMAND_H_ */
@@ -0,0 +1,1069 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QPair>
+#include <QSet>
+
+#include <QTextStream>
+
+#include "core/undodelta.h"
+#include "core/undocommand.h"
+#include "export/canorusmlexport.h"
+#include "import/canorusmlimport.h"
+#include "score/context.h"
+#include "score/document.h"
+#include "score/lyricscontext.h"
+#include "score/mark.h"
+#include "score/muselement.h"
+#include "score/notecheckererror.h"
+#include "score/playable.h"
+#include "score/sheet.h"
+#include "score/staff.h"
+#include "score/syllable.h"
+#include "score/voice.h"
+
+/*!
+	\class CAUndoDelta
+	\brief A single reversible change of the document
+
+	Undo commands created by CAUndo::createDeltaUndoCommand() don't clone the whole document.
+	Instead, the action stores a delta for each score structure it changed by calling
+	CAUndo::addDelta() right after the change. A delta only holds the location of the changed
+	structure (see CAPath) and its old and new values, so its size doesn't depend on the size
+	of the score.
+
+	undo() and redo() get the document the command is applied to. This may be a clone of the
+	document the delta was recorded on, if a snapshot command above it was undone meanwhile.
+
+	\sa CAUndo, CAUndoCommand
+*/
+
+CAUndoDelta::~CAUndoDelta()
+{
+}
+
+/*!
+	Returns the approximate memory in bytes held by the delta.
+	Used by CAUndo to keep the undo history within its memory budget.
+*/
+int CAUndoDelta::cost()
+{
+    return CAUndoCommand::ELEMENT_COST;
+}
+
+/*!
+	\fn CAUndoDelta::isJournaled()
+	Returns True, if the delta can be written to the edit journal by write().
+	Changes of deltas which are not journaled are recovered by writing a new recovery file.
+*/
+
+/*!
+	Writes the type and the data of the delta to \a out.
+	Deltas are stored in the edit journal used for the crash recovery (see CAJournal).
+*/
+void CAUndoDelta::write(QDataStream& out)
+{
+    out << static_cast<qint8>(deltaType());
+    writeData(out);
+}
+
+/*!
+	Reads a delta written by write() from \a in.
+	Returns a new delta or nullptr, if the stream is corrupted.
+*/
+CAUndoDelta* CAUndoDelta::read(QDataStream& in)
+{
+    qint8 type = -1;
+    in >> type;
+
+    CAUndoDelta* delta = nullptr;
+    switch (type) {
+    case NotePitch:
+        delta = new CANotePitchDelta();
+        break;
+    case NoteStemDirection:
+        delta = new CANoteStemDirectionDelta();
+        break;
+    case VoiceStemDirection:
+        delta = new CAVoiceStemDirectionDelta();
+        break;
+    case Name:
+        delta = new CANameDelta();
+        break;
+    case MusElements:
+        delta = new CAMusElementsDelta();
+        break;
+    default:
+        return nullptr;
+    }
+
+    delta->readData(in);
+    if (in.status() != QDataStream::Ok) {
+        delete delta;
+        return nullptr;
+    }
+
+    return delta;
+}
+
+CAUndoDelta::CAPath::CAPath()
+    : _sheet(-1)
+    , _context(-1)
+    , _voice(-1)
+    , _element(-1)
+{
+}
+
+CAUndoDelta::CAPath::CAPath(CASheet* sheet)
+    : CAPath()
+{
+    if (sheet && sheet->document()) {
+        _sheet = sheet->document()->sheetList().indexOf(sheet);
+    }
+}
+
+CAUndoDelta::CAPath::CAPath(CAContext* context)
+    : CAPath(context ? context->sheet() : nullptr)
+{
+    if (context && context->sheet()) {
+        _context = context->sheet()->contextList().indexOf(context);
+    }
+}
+
+CAUndoDelta::CAPath::CAPath(CAVoice* voice)
+    : CAPath(voice ? static_cast<CAContext*>(voice->staff()) : nullptr)
+{
+    if (voice && voice->staff()) {
+        _voice = voice->staff()->voiceList().indexOf(voice);
+    }
+}
+
+/*!
+	Creates a path to the playable music element \a elt through its voice.
+*/
+CAUndoDelta::CAPath::CAPath(CAMusElement* elt)
+    : CAPath((elt && elt->isPlayable()) ? static_cast<CAPlayable*>(elt)->voice() : nullptr)
+{
+    if (elt && elt->isPlayable() && static_cast<CAPlayable*>(elt)->voice()) {
+        _element = static_cast<CAPlayable*>(elt)->voice()->musElementIndex(elt);
+    }
+}
+
+void CAUndoDelta::CAPath::write(QDataStream& out) const
+{
+    out << static_cast<qint32>(_sheet) << static_cast<qint32>(_context) << static_cast<qint32>(_voice) << static_cast<qint32>(_element);
+}
+
+void CAUndoDelta::CAPath::read(QDataStream& in)
+{
+    qint32 sheet, context, voice, element;
+    in >> sheet >> context >> voice >> element;
+    _sheet = sheet;
+    _context = context;
+    _voice = voice;
+    _element = element;
+}
+
+CASheet* CAUndoDelta::CAPath::sheet(CADocument* document) const
+{
+    if (!document || _sheet < 0 || _sheet >= document->sheetList().size()) {
+        return nullptr;
+    }
+
+    return document->sheetList()[_sheet];
+}
+
+CAContext* CAUndoDelta::CAPath::context(CADocument* document) const
+{
+    CASheet* s = sheet(document);
+    if (!s || _context < 0 || _context >= s->contextList().size()) {
+        return nullptr;
+    }
+
+    return s->contextList()[_context];
+}
+
+CAVoice* CAUndoDelta::CAPath::voice(CADocument* document) const
+{
+    CAContext* c = context(document);
+    if (!c || c->contextType() != CAContext::Staff) {
+        return nullptr;
+    }
+
+    CAStaff* staff = static_cast<CAStaff*>(c);
+    if (_voice < 0 || _voice >= staff->voiceList().size()) {
+        return nullptr;
+    }
+
+    return staff->voiceList()[_voice];
+}
+
+CAMusElement* CAUndoDelta::CAPath::musElement(CADocument* document) const
+{
+    CAVoice* v = voice(document);
+    if (!v || _element < 0 || _element >= v->musElementList().size()) {
+        return nullptr;
+    }
+
+    return v->musElementList()[_element];
+}
+
+/*!
+	\class CANotePitchDelta
+	\brief Change of the note pitch
+
+	Create it after setting the new pitch of the \a note and pass the \a oldPitch.
+*/
+CANotePitchDelta::CANotePitchDelta(CANote* note, CADiatonicPitch oldPitch)
+    : _note(note)
+    , _oldPitch(oldPitch)
+    , _newPitch(note->diatonicPitch())
+{
+}
+
+void CANotePitchDelta::undo(CADocument* document)
+{
+    CAMusElement* elt = _note.musElement(document);
+    if (elt && elt->musElementType() == CAMusElement::Note) {
+        static_cast<CANote*>(elt)->setDiatonicPitch(_oldPitch);
+    }
+}
+
+void CANotePitchDelta::redo(CADocument* document)
+{
+    CAMusElement* elt = _note.musElement(document);
+    if (elt && elt->musElementType() == CAMusElement::Note) {
+        static_cast<CANote*>(elt)->setDiatonicPitch(_newPitch);
+    }
+}
+
+void CANotePitchDelta::writeData(QDataStream& out)
+{
+    _note.write(out);
+    out << static_cast<qint32>(_oldPitch.noteName()) << static_cast<qint8>(_oldPitch.accs());
+    out << static_cast<qint32>(_newPitch.noteName()) << static_cast<qint8>(_newPitch.accs());
+}
+
+void CANotePitchDelta::readData(QDataStream& in)
+{
+    qint32 oldNoteName, newNoteName;
+    qint8 oldAccs, newAccs;
+    _note.read(in);
+    in >> oldNoteName >> oldAccs >> newNoteName >> newAccs;
+    _oldPitch = CADiatonicPitch(oldNoteName, oldAccs);
+    _newPitch = CADiatonicPitch(newNoteName, newAccs);
+}
+
+/*!
+	\class CANoteStemDirectionDelta
+	\brief Change of the note stem direction
+*/
+CANoteStemDirectionDelta::CANoteStemDirectionDelta(CANote* note, CANote::CAStemDirection oldDirection)
+    : _note(note)
+    , _oldDirection(oldDirection)
+    , _newDirection(note->stemDirection())
+{
+}
+
+void CANoteStemDirectionDelta::undo(CADocument* document)
+{
+    CAMusElement* elt = _note.musElement(document);
+    if (elt && elt->musElementType() == CAMusElement::Note) {
+        static_cast<CANote*>(elt)->setStemDirection(_oldDirection);
+    }
+}
+
+void CANoteStemDirectionDelta::redo(CADocument* document)
+{
+    CAMusElement* elt = _note.musElement(document);
+    if (elt && elt->musElementType() == CAMusElement::Note) {
+        static_cast<CANote*>(elt)->setStemDirection(_newDirection);
+    }
+}
+
+void CANoteStemDirectionDelta::writeData(QDataStream& out)
+{
+    _note.write(out);
+    out << static_cast<qint8>(_oldDirection) << static_cast<qint8>(_newDirection);
+}
+
+void CANoteStemDirectionDelta::readData(QDataStream& in)
+{
+    qint8 oldDirection, newDirection;
+    _note.read(in);
+    in >> oldDirection >> newDirection;
+    _oldDirection = static_cast<CANote::CAStemDirection>(oldDirection);
+    _newDirection = static_cast<CANote::CAStemDirection>(newDirection);
+}
+
+/*!
+	\class CAVoiceStemDirectionDelta
+	\brief Change of the voice stem direction
+*/
+CAVoiceStemDirectionDelta::CAVoiceStemDirectionDelta(CAVoice* voice, CANote::CAStemDirection oldDirection)
+    : _voice(voice)
+    , _oldDirection(oldDirection)
+    , _newDirection(voice->stemDirection())
+{
+}
+
+void CAVoiceStemDirectionDelta::undo(CADocument* document)
+{
+    CAVoice* voice = _voice.voice(document);
+    if (voice) {
+        voice->setStemDirection(_oldDirection);
+    }
+}
+
+void CAVoiceStemDirectionDelta::redo(CADocument* document)
+{
+    CAVoice* voice = _voice.voice(document);
+    if (voice) {
+        voice->setStemDirection(_newDirection);
+    }
+}
+
+void CAVoiceStemDirectionDelta::writeData(QDataStream& out)
+{
+    _voice.write(out);
+    out << static_cast<qint8>(_oldDirection) << static_cast<qint8>(_newDirection);
+}
+
+void CAVoiceStemDirectionDelta::readData(QDataStream& in)
+{
+    qint8 oldDirection, newDirection;
+    _voice.read(in);
+    in >> oldDirection >> newDirection;
+    _oldDirection = static_cast<CANote::CAStemDirection>(oldDirection);
+    _newDirection = static_cast<CANote::CAStemDirection>(newDirection);
+}
+
+/*!
+	\class CANameDelta
+	\brief Change of the sheet, context or voice name
+*/
+CANameDelta::CANameDelta(CASheet* sheet, const QString oldName)
+    : _target(Sheet)
+    , _path(sheet)
+    , _oldName(oldName)
+    , _newName(sheet->name())
+{
+}
+
+CANameDelta::CANameDelta(CAContext* context, const QString oldName)
+    : _target(Context)
+    , _path(context)
+    , _oldName(oldName)
+    , _newName(context->name())
+{
+}
+
+CANameDelta::CANameDelta(CAVoice* voice, const QString oldName)
+    : _target(Voice)
+    , _path(voice)
+    , _oldName(oldName)
+    , _newName(voice->name())
+{
+}
+
+void CANameDelta::undo(CADocument* document)
+{
+    setName(document, _oldName);
+}
+
+void CANameDelta::redo(CADocument* document)
+{
+    setName(document, _newName);
+}
+
+void CANameDelta::setName(CADocument* document, const QString name)
+{
+    switch (_target) {
+    case Sheet:
+        if (_path.sheet(document))
+            _path.sheet(document)->setName(name);
+        break;
+    case Context:
+        if (_path.context(document))
+            _path.context(document)->setName(name);
+        break;
+    case Voice:
+        if (_path.voice(document))
+            _path.voice(document)->setName(name);
+        break;
+    }
+}
+
+void CANameDelta::writeData(QDataStream& out)
+{
+    out << static_cast<qint8>(_target);
+    _path.write(out);
+    out << _oldName << _newName;
+}
+
+void CANameDelta::readData(QDataStream& in)
+{
+    qint8 target;
+    in >> target;
+    _target = static_cast<CATarget>(target);
+    _path.read(in);
+    in >> _oldName >> _newName;
+}
+
+/*!
+	\class CAContextDelta
+	\brief Change of the music elements in a context
+
+	Used for insertion, removal and moving of music elements, where the change is too complex
+	to be described element by element (rests are merged, voices synchronized, barlines
+	placed automatically, syllables and function marks repositioned etc.). Create it \em before
+	changing the \a context. It keeps a detached copy of the context contents, so only the changed
+	context is cloned instead of the whole document.
+
+	undo() and redo() exchange the contents of the copy and the context in the document (see
+	CAContext::swapContents()), so the context and its voices keep their identity.
+
+	The delta is not written to the edit journal, its command is written as a barrier instead
+	(see CAJournal).
+
+	Staves are usually recorded by CAMusElementsDelta, which only falls back to this delta when
+	the ties, slurs, tuplets or marks are changed.
+
+	\sa CAUndo::createContextUndoCommand()
+*/
+CAContextDelta::CAContextDelta(CAContext* context)
+    : _context(context)
+{
+    switch (context->contextType()) {
+    case CAContext::Staff: {
+        CAStaff* staff = static_cast<CAStaff*>(context)->clone(nullptr);
+        for (int i = 0; i < staff->voiceList().size(); i++) {
+            staff->voiceList()[i]->setLyricsContexts(QList<CALyricsContext*>()); // deleting the copy shouldn't detach the lyrics
+        }
+        _contents = staff;
+        break;
+    }
+    case CAContext::LyricsContext: {
+        // CALyricsContext::clone() would associate the copy with the voice
+        CALyricsContext* lc = static_cast<CALyricsContext*>(context);
+        CALyricsContext* copy = new CALyricsContext(lc->name(), lc->stanzaNumber(), static_cast<CASheet*>(nullptr));
+        for (int i = 0; i < lc->syllableList().size(); i++) {
+            copy->addSyllable(lc->syllableList()[i]->clone(copy));
+        }
+        _contents = copy;
+        break;
+    }
+    default:
+        _contents = context->clone(nullptr);
+        break;
+    }
+}
+
+CAContextDelta::~CAContextDelta()
+{
+    delete _contents;
+}
+
+void CAContextDelta::undo(CADocument* document)
+{
+    swap(document);
+}
+
+void CAContextDelta::redo(CADocument* document)
+{
+    swap(document);
+}
+
+void CAContextDelta::swap(CADocument* document)
+{
+    CAContext* context = _context.context(document);
+    if (context && context->contextType() == _contents->contextType()) {
+        context->swapContents(_contents);
+    }
+}
+
+int CAContextDelta::cost()
+{
+    return CAUndoCommand::cost(_contents);
+}
+
+/*!
+	\class CAMusElementsDelta
+	\brief Insertion and removal of music elements in a staff
+
+	Records the music elements inserted to and removed from the voices of the \a staff, the shifts
+	of the times and the time starts changed by CAStaff::synchronizeVoices(). The delta observes
+	the staff as its CAVoiceRecorder, so create it \em before changing the staff. Recording stops
+	by finish(), when the command is pushed on the undo stack. Only the inserted and removed
+	elements are kept, so the cost of the delta doesn't depend on the size of the staff.
+
+	undo() and redo() repeat the recorded operations backwards or forwards by the positions in
+	the voices. The removed notes and rests are copied right before they are removed, as the
+	action usually changes or destroys them afterwards. The rests inserted and removed while
+	synchronizing the voices are recorded the same way. A shared sign is stored once and
+	inserted to each of the voices it was removed from.
+
+	Ties, slurs, tuplets and shared marks are not recorded. When the action is about to change
+	them (see linksChanging()), the operations recorded so far are reverted, the staff is copied by
+	CAContextDelta and the operations are repeated. The delta then behaves as the context delta.
+
+	The delta is written to the edit journal with each inserted and removed element stored as
+	a small CanorusML document (see exportElement()), unless it fell back to the staff copy.
+
+	\sa CAUndo::createContextUndoCommand()
+*/
+CAMusElementsDelta::CAOperation::CAOperation(CAOperationType type, int voice, int index)
+    : type(type)
+    , voice(voice)
+    , index(index)
+    , element(-1)
+    , time(0)
+    , oldTime(0)
+    , signsToo(false)
+{
+}
+
+CAMusElementsDelta::CAMusElementsDelta(CAStaff* staff)
+    : _staff(staff)
+    , _undone(false)
+    , _fallback(nullptr)
+    , _recordedStaff(staff)
+{
+    staff->setRecorder(this);
+}
+
+CAMusElementsDelta::CAMusElementsDelta()
+    : _undone(false)
+    , _fallback(nullptr)
+    , _recordedStaff(nullptr)
+{
+}
+
+CAMusElementsDelta::~CAMusElementsDelta()
+{
+    finish();
+    deleteHeldElements();
+    delete _fallback;
+}
+
+void CAMusElementsDelta::undo(CADocument* document)
+{
+    if (_fallback) {
+        _fallback->undo(document);
+        return;
+    }
+
+    CAContext* context = _staff.context(document);
+    if (context && context->contextType() == CAContext::Staff) {
+        apply(static_cast<CAStaff*>(context), true);
+    }
+}
+
+void CAMusElementsDelta::redo(CADocument* document)
+{
+    if (_fallback) {
+        _fallback->redo(document);
+        return;
+    }
+
+    CAContext* context = _staff.context(document);
+    if (context && context->contextType() == CAContext::Staff) {
+        apply(static_cast<CAStaff*>(context), false);
+    }
+}
+
+/*!
+	Stops recording the changes of the staff.
+	The removed signs which are not part of the staff anymore are replaced by their copies, as
+	the action may destroy them later.
+*/
+void CAMusElementsDelta::finish()
+{
+    if (!_recordedStaff) {
+        return;
+    }
+
+    for (QHash<int, CAMusElement*>::const_iterator i = _signCopies.constBegin(); i != _signCopies.constEnd(); i++) {
+        if (containsElement(_recordedStaff, _elements[i.key()])) {
+            deleteElement(i.value());
+        } else {
+            _elements[i.key()] = i.value();
+        }
+    }
+    _signCopies.clear();
+
+    stopRecording();
+}
+
+int CAMusElementsDelta::cost()
+{
+    if (_fallback) {
+        return _fallback->cost();
+    }
+
+    return (_elements.size() + 1) * CAUndoCommand::ELEMENT_COST + _operations.size() * static_cast<int>(sizeof(CAOperation));
+}
+
+void CAMusElementsDelta::musElementInserted(CAVoice* voice, int idx)
+{
+    CAOperation op(Insert, _recordedStaff->voiceList().indexOf(voice), idx);
+    if (op.voice == -1) {
+        return;
+    }
+
+    // the new element may reuse the address of a destroyed one
+    for (QHash<CAMusElement*, CAMusElement*>::const_iterator i = _deleting.constBegin(); i != _deleting.constEnd(); i++) {
+        _ids.remove(i.key());
+        if (i.value()) {
+            deleteElement(i.value());
+        }
+    }
+    _deleting.clear();
+
+    CAMusElement* elt = voice->musElementList()[idx];
+    op.element = elementId(elt);
+    op.time = elt->timeStart();
+    _operations << op;
+}
+
+void CAMusElementsDelta::musElementRemoving(CAVoice* voice, int idx)
+{
+    CAOperation op(Remove, _recordedStaff->voiceList().indexOf(voice), idx);
+    if (op.voice == -1) {
+        return;
+    }
+
+    CAMusElement* elt = voice->musElementList()[idx];
+    op.element = elementId(elt);
+    op.time = elt->timeStart();
+
+    if (elt->isPlayable()) {
+        // the action usually changes or destroys the removed element
+        CAMusElement* copy = _deleting.value(elt);
+        if (copy) {
+            _deleting[elt] = nullptr;
+        } else {
+            copy = static_cast<CAPlayable*>(elt)->clone(voice);
+        }
+        _elements[op.element] = copy;
+        _ids.remove(elt);
+    } else if (!_deleting.contains(elt) && !_signCopies.contains(op.element)) {
+        _signCopies[op.element] = elt->clone(_recordedStaff);
+    }
+
+    _operations << op;
+}
+
+void CAMusElementsDelta::timesUpdated(CAVoice* voice, int idx, int length, bool signsToo)
+{
+    CAOperation op(Shift, _recordedStaff->voiceList().indexOf(voice), idx);
+    if (op.voice == -1) {
+        return;
+    }
+
+    op.time = length;
+    op.signsToo = signsToo;
+    _operations << op;
+}
+
+void CAMusElementsDelta::timeStartChanged(CAVoice* voice, int idx, int oldTimeStart)
+{
+    CAOperation op(SetTimeStart, _recordedStaff->voiceList().indexOf(voice), idx);
+    if (op.voice == -1) {
+        return;
+    }
+
+    op.time = voice->musElementList()[idx]->timeStart();
+    op.oldTime = oldTimeStart;
+    _operations << op;
+}
+
+/*!
+	Copies the note, rest or sign \a elt destroyed while it is still intact.
+	The copy of a playable element is used, when its destructor removes it from the voice.
+*/
+void CAMusElementsDelta::musElementDeleting(CAMusElement* elt)
+{
+    if (elt->isPlayable()) {
+        CAPlayable* p = static_cast<CAPlayable*>(elt);
+        if (!p->voice() || p->voice()->musElementIndex(p) == -1) {
+            return; // copied when removed
+        }
+
+        if (hasLinks(elt)) {
+            linksChanging(elt);
+            return;
+        }
+
+        _deleting[elt] = p->clone(p->voice());
+    } else if (containsElement(_recordedStaff, elt) || _ids.contains(elt)) {
+        int id = elementId(elt);
+        CAMusElement* copy = _signCopies.take(id);
+        _elements[id] = copy ? copy : elt->clone(_recordedStaff);
+        _deleting[elt] = nullptr;
+    }
+}
+
+/*!
+	Switches to copying the staff by CAContextDelta, before the ties, slurs, tuplets or marks
+	of \a elt are changed.
+*/
+void CAMusElementsDelta::linksChanging(CAMusElement* elt)
+{
+    if (_deleting.contains(elt)) {
+        return; // the element is already copied
+    }
+
+    CAStaff* staff = _recordedStaff;
+    finish();
+
+    apply(staff, true);
+    _fallback = new CAContextDelta(staff);
+    apply(staff, false);
+
+    deleteHeldElements();
+    _operations.clear();
+    _elements.clear();
+}
+
+void CAMusElementsDelta::staffDeleting()
+{
+    finish();
+    deleteHeldElements();
+    _operations.clear();
+    _elements.clear();
+}
+
+void CAMusElementsDelta::apply(CAStaff* staff, bool undo)
+{
+    for (int n = 0; n < _operations.size(); n++) {
+        const CAOperation& op = _operations[undo ? _operations.size() - 1 - n : n];
+        if (op.voice >= staff->voiceList().size()) {
+            continue;
+        }
+
+        CAVoice* voice = staff->voiceList()[op.voice];
+        switch (op.type) {
+        case Insert:
+            if (undo) {
+                takeElement(voice, op);
+            } else {
+                putElement(voice, op);
+            }
+            break;
+        case Remove:
+            if (undo) {
+                putElement(voice, op);
+            } else {
+                takeElement(voice, op);
+            }
+            break;
+        case Shift:
+            voice->updateTimes(op.index, undo ? -op.time : op.time, op.signsToo);
+            break;
+        case SetTimeStart:
+            if (op.index < voice->musElementList().size()) {
+                voice->setMusElementTimeStart(op.index, undo ? op.oldTime : op.time);
+            }
+            break;
+        }
+    }
+
+    _undone = undo;
+}
+
+void CAMusElementsDelta::putElement(CAVoice* voice, const CAOperation& op)
+{
+    CAMusElement* elt = _elements[op.element];
+    if (!elt || op.index > voice->musElementList().size()) {
+        return;
+    }
+
+    // the delta may be applied to a clone of the document
+    if (elt->isPlayable()) {
+        static_cast<CAPlayable*>(elt)->setVoice(voice);
+    } else {
+        elt->setContext(voice->staff());
+    }
+    for (int i = 0; i < elt->markList().size(); i++) {
+        elt->markList()[i]->setContext(voice->staff());
+    }
+
+    voice->insertMusElementAt(op.index, elt);
+    elt->setTimeStart(op.time);
+    if (elt->musElementType() == CAMusElement::Note) {
+        static_cast<CANote*>(elt)->setDiatonicPitch(static_cast<CANote*>(elt)->diatonicPitch()); // updates the note position by the clef of the voice
+    }
+    updateStaff(voice, elt, op.index + 1);
+}
+
+void CAMusElementsDelta::takeElement(CAVoice* voice, const CAOperation& op)
+{
+    if (op.index >= voice->musElementList().size()) {
+        return;
+    }
+
+    CAMusElement* elt = voice->musElementList()[op.index];
+    voice->removeMusElementAt(op.index);
+
+    // the element read from the journal is replaced by the one in the document
+    CAMusElement* read = _elements[op.element];
+    if (read && read != elt && !containsElement(voice->staff(), read)) {
+        deleteElement(read);
+    }
+    _elements[op.element] = elt;
+
+    while (!elt->noteCheckerErrorList().isEmpty()) {
+        delete elt->noteCheckerErrorList().first();
+    }
+    updateStaff(voice, elt, op.index);
+}
+
+/*!
+	Updates the references of the signs in the staff after the sign \a elt was inserted to or
+	removed from the \a voice. Inserting or removing a clef also changes the positions of the
+	notes from position \a idx on.
+*/
+void CAMusElementsDelta::updateStaff(CAVoice* voice, CAMusElement* elt, int idx)
+{
+    CAStaff* staff = voice->staff();
+    QList<CAMusElement*>* refs = nullptr;
+    switch (elt->musElementType()) {
+    case CAMusElement::Clef:
+        refs = &staff->clefRefs();
+        break;
+    case CAMusElement::KeySignature:
+        refs = &staff->keySignatureRefs();
+        break;
+    case CAMusElement::TimeSignature:
+        refs = &staff->timeSignatureRefs();
+        break;
+    case CAMusElement::Barline:
+        refs = &staff->barlineRefs();
+        break;
+    default:
+        return;
+    }
+
+    if (!containsElement(staff, elt)) {
+        refs->removeAll(elt);
+    } else if (!refs->contains(elt)) {
+        int i = refs->indexOf(voice->nextByType(elt->musElementType(), elt));
+        refs->insert((i == -1) ? refs->size() : i, elt);
+    }
+
+    if (elt->musElementType() == CAMusElement::Clef) {
+        for (int i = idx; i < voice->musElementList().size(); i++) {
+            if (voice->musElementList()[i]->musElementType() == CAMusElement::Note) {
+                CANote* note = static_cast<CANote*>(voice->musElementList()[i]);
+                note->setDiatonicPitch(note->diatonicPitch());
+            }
+        }
+    }
+}
+
+bool CAMusElementsDelta::containsElement(CAStaff* staff, CAMusElement* elt)
+{
+    for (int i = 0; i < staff->voiceList().size(); i++) {
+        if (staff->voiceList()[i]->musElementIndex(elt) != -1) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*!
+	Returns the index of \a elt in _elements and adds it, if needed.
+*/
+int CAMusElementsDelta::elementId(CAMusElement* elt)
+{
+    QHash<CAMusElement*, int>::const_iterator i = _ids.constFind(elt);
+    if (i != _ids.constEnd()) {
+        return i.value();
+    }
+
+    _elements << elt;
+    _ids.insert(elt, _elements.size() - 1);
+    return _elements.size() - 1;
+}
+
+void CAMusElementsDelta::stopRecording()
+{
+    if (_recordedStaff->recorder() == this) {
+        _recordedStaff->setRecorder(nullptr);
+    }
+    _recordedStaff = nullptr;
+
+    for (QHash<CAMusElement*, CAMusElement*>::const_iterator i = _deleting.constBegin(); i != _deleting.constEnd(); i++) {
+        if (i.value()) {
+            deleteElement(i.value());
+        }
+    }
+    _deleting.clear();
+    _ids.clear();
+}
+
+/*!
+	Destroys the elements held by the delta, which are not part of the document.
+	An element is part of the document, if the last operation applied in any of the voices
+	inserted it.
+*/
+void CAMusElementsDelta::deleteHeldElements()
+{
+    QHash<QPair<int, int>, bool> inserted; // by voice and element
+    for (int n = 0; n < _operations.size(); n++) {
+        const CAOperation& op = _operations[_undone ? _operations.size() - 1 - n : n];
+        if (op.type == Insert || op.type == Remove) {
+            inserted[qMakePair(op.voice, op.element)] = ((op.type == Insert) != _undone);
+        }
+    }
+
+    QSet<CAMusElement*> inDocument;
+    for (QHash<QPair<int, int>, bool>::const_iterator i = inserted.constBegin(); i != inserted.constEnd(); i++) {
+        if (i.value()) {
+            inDocument << _elements[i.key().second];
+        }
+    }
+
+    QSet<CAMusElement*> held;
+    for (int i = 0; i < _elements.size(); i++) {
+        if (_elements[i] && !inDocument.contains(_elements[i])) {
+            held << _elements[i];
+        }
+    }
+
+    for (QSet<CAMusElement*>::const_iterator i = held.constBegin(); i != held.constEnd(); i++) {
+        deleteElement(*i);
+    }
+    _elements.clear();
+}
+
+/*!
+	Destroys the music element \a elt not part of any voice.
+	It is detached first, as its staff may be destroyed already.
+*/
+void CAMusElementsDelta::deleteElement(CAMusElement* elt)
+{
+    for (int i = 0; i < elt->markList().size(); i++) {
+        elt->markList()[i]->setContext(nullptr);
+    }
+
+    if (elt->isPlayable()) {
+        static_cast<CAPlayable*>(elt)->setVoice(nullptr);
+    } else {
+        elt->setContext(nullptr);
+    }
+
+    delete elt;
+}
+
+void CAMusElementsDelta::writeData(QDataStream& out)
+{
+    _staff.write(out);
+
+    out << static_cast<quint32>(_elements.size());
+    for (int i = 0; i < _elements.size(); i++) {
+        out << exportElement(_elements[i]);
+    }
+
+    out << static_cast<quint32>(_operations.size());
+    for (int i = 0; i < _operations.size(); i++) {
+        const CAOperation& op = _operations[i];
+        out << static_cast<qint8>(op.type) << static_cast<qint32>(op.voice) << static_cast<qint32>(op.index) << static_cast<qint32>(op.element);
+        out << static_cast<qint32>(op.time) << static_cast<qint32>(op.oldTime) << op.signsToo;
+    }
+}
+
+void CAMusElementsDelta::readData(QDataStream& in)
+{
+    _staff.read(in);
+
+    quint32 elements = 0;
+    in >> elements;
+    for (quint32 i = 0; i < elements && in.status() == QDataStream::Ok; i++) {
+        QByteArray data;
+        in >> data;
+        _elements << importElement(data);
+    }
+
+    quint32 operations = 0;
+    in >> operations;
+    for (quint32 i = 0; i < operations && in.status() == QDataStream::Ok; i++) {
+        qint8 type;
+        qint32 voice, index, element, time, oldTime;
+        bool signsToo;
+        in >> type >> voice >> index >> element >> time >> oldTime >> signsToo;
+
+        CAOperation op(static_cast<CAOperationType>(type), voice, index);
+        op.element = element;
+        op.time = time;
+        op.oldTime = oldTime;
+        op.signsToo = signsToo;
+        if ((op.type == Insert || op.type == Remove) && (op.element < 0 || op.element >= _elements.size())) {
+            in.setStatus(QDataStream::ReadCorruptData);
+            break;
+        }
+        _operations << op;
+    }
+}
+
+/*!
+	Returns the compressed CanorusML document containing a copy of the music element \a elt
+	alone in the first voice.
+*/
+QByteArray CAMusElementsDelta::exportElement(CAMusElement* elt)
+{
+    if (!elt) {
+        return QByteArray();
+    }
+
+    CADocument document;
+    CAStaff* staff = document.addSheet()->addStaff();
+    CAVoice* voice = staff->voiceList()[0];
+    voice->insertMusElementAt(0, elt->isPlayable() ? static_cast<CAPlayable*>(elt)->clone(voice) : elt->clone(staff));
+
+    QString xml;
+    QTextStream stream(&xml);
+    CACanorusMLExport save(&stream);
+    save.exportDocument(&document, false);
+    stream.flush();
+
+    return qCompress(xml.toUtf8());
+}
+
+/*!
+	Returns a new detached music element read from the \a data written by exportElement() or
+	nullptr, if the data is corrupted.
+*/
+CAMusElement* CAMusElementsDelta::importElement(const QByteArray& data)
+{
+    if (data.isEmpty()) {
+        return nullptr;
+    }
+
+    CACanorusMLImport open(QString::fromUtf8(qUncompress(data)));
+    open.importDocument(false);
+    CADocument* document = open.importedDocument();
+    if (!document) {
+        return nullptr;
+    }
+
+    CAMusElement* elt = nullptr;
+    QList<CAStaff*> staves = document->sheetList().isEmpty() ? QList<CAStaff*>() : document->sheetList()[0]->staffList();
+    if (!staves.isEmpty() && !staves[0]->voiceList().isEmpty() && !staves[0]->voiceList()[0]->musElementList().isEmpty()) {
+        CAMusElement* imported = staves[0]->voiceList()[0]->musElementList()[0];
+        if (imported->isPlayable()) {
+            elt = static_cast<CAPlayable*>(imported)->clone(static_cast<CAVoice*>(nullptr));
+        } else {
+            elt = imported->clone(nullptr);
+        }
+    }
+
+    delete document;
+    return elt;
+}
@@ -0,0 +1,269 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#ifndef UNDODELTA_H_
+#define UNDODELTA_H_
+
+#include <QDataStream>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+#include "score/diatonicpitch.h"
+#include "score/note.h"
+#include "score/voicerecorder.h"
+
+class CADocument;
+class CASheet;
+class CAContext;
+class CAStaff;
+class CAVoice;
+class CAMusElement;
+
+class CAUndoDelta {
+public:
+    enum CADeltaType {
+        NotePitch,
+        NoteStemDirection,
+        VoiceStemDirection,
+        Name,
+        ContextContents,
+        MusElements
+    };
+
+    virtual ~CAUndoDelta();
+
+    virtual void undo(CADocument* document) = 0;
+    virtual void redo(CADocument* document) = 0;
+
+    virtual CADeltaType deltaType() = 0;
+    virtual void finish() {}
+    virtual bool isJournaled() { return true; }
+    virtual int cost();
+    void write(QDataStream& out);
+    static CAUndoDelta* read(QDataStream& in);
+
+protected:
+    virtual void writeData(QDataStream& out) = 0;
+    virtual void readData(QDataStream& in) = 0;
+
+    /*!
+		Location of a sheet, context, voice or music element by indices.
+		Undo commands may be applied to a clone of the document the change was recorded on,
+		so the deltas never store the pointers to the score structures.
+	*/
+    class CAPath {
+    public:
+        CAPath();
+        CAPath(CASheet* sheet);
+        CAPath(CAContext* context);
+        CAPath(CAVoice* voice);
+        CAPath(CAMusElement* elt);
+
+        CASheet* sheet(CADocument* document) const;
+        CAContext* context(CADocument* document) const;
+        CAVoice* voice(CADocument* document) const;
+        CAMusElement* musElement(CADocument* document) const;
+
+        void write(QDataStream& out) const;
+        void read(QDataStream& in);
+
+    private:
+        int _sheet;
+        int _context;
+        int _voice;
+        int _element;
+    };
+};
+
+class CANotePitchDelta : public CAUndoDelta {
+public:
+    CANotePitchDelta(CANote* note, CADiatonicPitch oldPitch);
+    CANotePitchDelta() {} // used by read()
+
+    void undo(CADocument* document);
+    void redo(CADocument* document);
+    CADeltaType deltaType() { return NotePitch; }
+
+private:
+    void writeData(QDataStream& out);
+    void readData(QDataStream& in);
+
+    CAPath _note;
+    CADiatonicPitch _oldPitch;
+    CADiatonicPitch _newPitch;
+};
+
+class CANoteStemDirectionDelta : public CAUndoDelta {
+public:
+    CANoteStemDirectionDelta(CANote* note, CANote::CAStemDirection oldDirection);
+    CANoteStemDirectionDelta() // used by read()
+        : _oldDirection(CANote::StemUndefined)
+        , _newDirection(CANote::StemUndefined)
+    {
+    }
+
+    void undo(CADocument* document);
+    void redo(CADocument* document);
+    CADeltaType deltaType() { return NoteStemDirection; }
+
+private:
+    void writeData(QDataStream& out);
+    void readData(QDataStream& in);
+
+    CAPath _note;
+    CANote::CAStemDirection _oldDirection;
+    CANote::CAStemDirection _newDirection;
+};
+
+class CAVoiceStemDirectionDelta : public CAUndoDelta {
+public:
+    CAVoiceStemDirectionDelta(CAVoice* voice, CANote::CAStemDirection oldDirection);
+    CAVoiceStemDirectionDelta() // used by read()
+        : _oldDirection(CANote::StemUndefined)
+        , _newDirection(CANote::StemUndefined)
+    {
+    }
+
+    void undo(CADocument* document);
+    void redo(CADocument* document);
+    CADeltaType deltaType() { return VoiceStemDirection; }
+
+private:
+    void writeData(QDataStream& out);
+    void readData(QDataStream& in);
+
+    CAPath _voice;
+    CANote::CAStemDirection _oldDirection;
+    CANote::CAStemDirection _newDirection;
+};
+
+class CANameDelta : public CAUndoDelta {
+public:
+    CANameDelta(CASheet* sheet, const QString oldName);
+    CANameDelta(CAContext* context, const QString oldName);
+    CANameDelta(CAVoice* voice, const QString oldName);
+    CANameDelta() // used by read()
+        : _target(Sheet)
+    {
+    }
+
+    void undo(CADocument* document);
+    void redo(CADocument* document);
+    CADeltaType deltaType() { return Name; }
+
+private:
+    void writeData(QDataStream& out);
+    void readData(QDataStream& in);
+
+    enum CATarget {
+        Sheet,
+        Context,
+        Voice
+    };
+
+    void setName(CADocument* document, const QString name);
+
+    CATarget _target;
+    CAPath _path;
+    QString _oldName;
+    QString _newName;
+};
+
+class CAContextDelta : public CAUndoDelta {
+public:
+    CAContextDelta(CAContext* context);
+    ~CAContextDelta();
+
+    void undo(CADocument* document);
+    void redo(CADocument* document);
+    CADeltaType deltaType() { return ContextContents; }
+    bool isJournaled() { return false; }
+    int cost();
+
+private:
+    void writeData(QDataStream&) {}
+    void readData(QDataStream&) {}
+
+    void swap(CADocument* document);
+
+    CAPath _context;
+    CAContext* _contents; // detached copy of the context, holds the elements not in the document
+};
+
+class CAMusElementsDelta : public CAUndoDelta, public CAVoiceRecorder {
+public:
+    CAMusElementsDelta(CAStaff* staff);
+    CAMusElementsDelta(); // used by read()
+    ~CAMusElementsDelta();
+
+    void undo(CADocument* document);
+    void redo(CADocument* document);
+    void finish();
+    CADeltaType deltaType() { return MusElements; }
+    bool isJournaled() { return !_fallback; }
+    int cost();
+
+    void musElementInserted(CAVoice* voice, int idx);
+    void musElementRemoving(CAVoice* voice, int idx);
+    void timesUpdated(CAVoice* voice, int idx, int length, bool signsToo);
+    void timeStartChanged(CAVoice* voice, int idx, int oldTimeStart);
+    void musElementDeleting(CAMusElement* elt);
+    void linksChanging(CAMusElement* elt);
+    void staffDeleting();
+
+private:
+    void writeData(QDataStream& out);
+    void readData(QDataStream& in);
+
+    enum CAOperationType {
+        Insert,
+        Remove,
+        Shift,
+        SetTimeStart
+    };
+
+    class CAOperation {
+    public:
+        CAOperation(CAOperationType type = Insert, int voice = -1, int index = -1);
+
+        CAOperationType type;
+        int voice;
+        int index;
+        int element; // index in _elements of the inserted or removed element
+        int time; // time start of the inserted or removed element, new time start or shift length
+        int oldTime; // time start before SetTimeStart
+        bool signsToo; // Shift also moves the shared signs
+    };
+
+    void apply(CAStaff* staff, bool undo);
+    void putElement(CAVoice* voice, const CAOperation& op);
+    void takeElement(CAVoice* voice, const CAOperation& op);
+    static void updateStaff(CAVoice* voice, CAMusElement* elt, int idx);
+    static bool containsElement(CAStaff* staff, CAMusElement* elt);
+
+    int elementId(CAMusElement* elt);
+    void stopRecording();
+    void deleteHeldElements();
+    static void deleteElement(CAMusElement* elt);
+    static QByteArray exportElement(CAMusElement* elt);
+    static CAMusElement* importElement(const QByteArray& data);
+
+    CAPath _staff;
+    QList<CAOperation> _operations;
+    QList<CAMusElement*> _elements; // inserted and removed elements, the ones not in the document are owned
+    bool _undone;
+    CAContextDelta* _fallback; // copy of the staff, if the change couldn't be recorded
+
+    // used while recording
+    CAStaff* _recordedStaff;
+    QHash<CAMusElement*, int> _ids; // elements in _elements by their address
+    QHash<int, CAMusElement*> _signCopies; // copies of the removed shared signs, see finish()
+    QHash<CAMusElement*, CAMusElement*> _deleting; // elements being destroyed and their copies
+};
+
+#endif /* UNDODELTA_H_ */
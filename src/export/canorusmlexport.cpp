@@ -7,10 +7,10 @@
 
 #include <QDebug>
 #include <QDir>
-#include <QDomDocument>
 #include <QString>
 #include <QTextStream>
 #include <QVariant>
+#include <QXmlStreamWriter>
 
 #include "export/canorusmlexport.h"
 
@@ -55,6 +55,7 @@
 
 CACanorusMLExport::CACanorusMLExport(QTextStream* stream)
     : CAExport(stream)
+    , _xml(nullptr)
 {
 }
 
@@ -64,62 +65,80 @@ CACanorusMLExport::~CACanorusMLExport()
 
 /*!
 	Saves the document to CanorusML XML format.
-	It uses DOM object internally for writing the XML output.
+
+	The XML is written element by element by QXmlStreamWriter directly to the device or the
+	string of the stream, so no document tree of the whole score is built in memory. Elements are
+	indented by one space per level in the same way QDomDocument::toString() did it.
+
+	The output of the same document is byte-identical between runs. It differs from the files
+	written by the former DOM exporter in two ways, which don't change the parsed values:
+	- attributes are written in the order of the code below, while QDom wrote them in the
+	  (randomized) order of its hash table.
+	- QXmlStreamWriter escapes newlines, tabs and carriage returns in attribute values as
+	  decimal character references (eg. "&#10;") instead of hexadecimal ones ("&#xa;") and
+	  escapes every ">" in text and attribute values as "&gt;".
 */
 void CACanorusMLExport::exportDocumentImpl(CADocument* doc)
 {
-    //int depth = 0;
-
     out().setCodec("UTF-8");
+    out().flush(); // QXmlStreamWriter writes past the stream's buffer
+
+    if (out().device()) {
+        _xml = new QXmlStreamWriter(out().device());
+        _xml->setCodec("UTF-8");
+    } else if (out().string()) {
+        _xml = new QXmlStreamWriter(out().string());
+    } else {
+        setStatus(-1);
+        return;
+    }
+    _hasChildren.clear();
 
-    // CADocument
-    QDomDocument dDoc("canorusml");
-
-    // Add encoding
-    dDoc.appendChild(dDoc.createProcessingInstruction("xml", "version=\"1.0\" encoding=\"UTF-8\" "));
+    // Add encoding and document type
+    _xml->writeProcessingInstruction("xml", "version=\"1.0\" encoding=\"UTF-8\" ");
+    _xml->writeCharacters("\n");
+    _xml->writeDTD("<!DOCTYPE canorusml>");
+    _xml->writeCharacters("\n");
 
     // Root node - <canorus-document>
-    QDomElement dCanorusDocument = dDoc.createElement("canorus-document");
-    dDoc.appendChild(dCanorusDocument);
+    writeStartElement("canorus-document");
     // Add program version
-    QDomElement dCanorusVersion = dDoc.createElement("canorus-version");
-    dCanorusDocument.appendChild(dCanorusVersion);
-    dCanorusVersion.appendChild(dDoc.createTextNode(CANORUS_VERSION));
+    writeStartElement("canorus-version");
+    _xml->writeCharacters(CANORUS_VERSION);
+    writeEndElement();
 
     // Document content node - <document>
-    QDomElement dDocument = dDoc.createElement("document");
-    dCanorusDocument.appendChild(dDocument);
+    writeStartElement("document");
 
     if (!doc->title().isEmpty())
-        dDocument.setAttribute("title", doc->title());
+        writeAttribute("title", doc->title());
     if (!doc->subtitle().isEmpty())
-        dDocument.setAttribute("subtitle", doc->subtitle());
+        writeAttribute("subtitle", doc->subtitle());
     if (!doc->composer().isEmpty())
-        dDocument.setAttribute("composer", doc->composer());
+        writeAttribute("composer", doc->composer());
     if (!doc->arranger().isEmpty())
-        dDocument.setAttribute("arranger", doc->arranger());
+        writeAttribute("arranger", doc->arranger());
     if (!doc->poet().isEmpty())
-        dDocument.setAttribute("poet", doc->poet());
+        writeAttribute("poet", doc->poet());
     if (!doc->textTranslator().isEmpty())
-        dDocument.setAttribute("text-translator", doc->textTranslator());
+        writeAttribute("text-translator", doc->textTranslator());
     if (!doc->dedication().isEmpty())
-        dDocument.setAttribute("dedication", doc->dedication());
+        writeAttribute("dedication", doc->dedication());
     if (!doc->copyright().isEmpty())
-        dDocument.setAttribute("copyright", doc->copyright());
+        writeAttribute("copyright", doc->copyright());
     if (!doc->comments().isEmpty())
-        dDocument.setAttribute("comments", doc->comments());
+        writeAttribute("comments", doc->comments());
 
-    dDocument.setAttribute("date-created", doc->dateCreated().toString(Qt::ISODate));
-    dDocument.setAttribute("date-last-modified", doc->dateLastModified().toString(Qt::ISODate));
-    dDocument.setAttribute("time-edited", doc->timeEdited());
+    writeAttribute("date-created", doc->dateCreated().toString(Qt::ISODate));
+    writeAttribute("date-last-modified", doc->dateLastModified().toString(Qt::ISODate));
+    writeAttribute("time-edited", doc->timeEdited());
 
     for (int sheetIdx = 0; sheetIdx < doc->sheetList().size(); sheetIdx++) {
         setProgress(qRound((static_cast<float>(sheetIdx) / doc->sheetList().size()) * 100));
 
         // CASheet
-        QDomElement dSheet = dDoc.createElement("sheet");
-        dDocument.appendChild(dSheet);
-        dSheet.setAttribute("name", doc->sheetList()[sheetIdx]->name());
+        writeStartElement("sheet");
+        writeAttribute("name", doc->sheetList()[sheetIdx]->name());
 
         for (int contextIdx = 0; contextIdx < doc->sheetList()[sheetIdx]->contextList().size(); contextIdx++) {
             // (CAContext)
@@ -129,327 +148,366 @@ void CACanorusMLExport::exportDocumentImpl(CADocument* doc)
             case CAContext::Staff: {
                 // CAStaff
                 CAStaff* staff = static_cast<CAStaff*>(c);
-                QDomElement dStaff = dDoc.createElement("staff");
-                dSheet.appendChild(dStaff);
-                dStaff.setAttribute("name", staff->name());
-                dStaff.setAttribute("number-of-lines", staff->numberOfLines());
+                writeStartElement("staff");
+                writeAttribute("name", staff->name());
+                writeAttribute("number-of-lines", staff->numberOfLines());
 
                 for (int voiceIdx = 0; voiceIdx < staff->voiceList().size(); voiceIdx++) {
                     // CAVoice
                     CAVoice* v = staff->voiceList()[voiceIdx];
-                    QDomElement dVoice = dDoc.createElement("voice");
-                    dStaff.appendChild(dVoice);
-                    dVoice.setAttribute("name", v->name());
-                    dVoice.setAttribute("midi-channel", v->midiChannel());
-                    dVoice.setAttribute("midi-program", v->midiProgram());
-                    dVoice.setAttribute("midi-pitch-offset", v->midiPitchOffset());
-                    dVoice.setAttribute("stem-direction", CANote::stemDirectionToString(v->stemDirection()));
-
-                    exportVoiceImpl(v, dVoice); // writes notes, clefs etc.
+                    writeStartElement("voice");
+                    writeAttribute("name", v->name());
+                    writeAttribute("midi-channel", v->midiChannel());
+                    writeAttribute("midi-program", v->midiProgram());
+                    writeAttribute("midi-pitch-offset", v->midiPitchOffset());
+                    writeAttribute("stem-direction", CANote::stemDirectionToString(v->stemDirection()));
+
+                    exportMusElements(v); // writes notes, clefs etc.
+                    writeEndElement();
                 }
 
+                writeEndElement();
                 break;
             }
             case CAContext::LyricsContext: {
                 // CALyricsContext
                 CALyricsContext* lc = static_cast<CALyricsContext*>(c);
-                QDomElement dlc = dDoc.createElement("lyrics-context");
-                dSheet.appendChild(dlc);
-                dlc.setAttribute("name", lc->name());
-                dlc.setAttribute("stanza-number", lc->stanzaNumber());
-                dlc.setAttribute("associated-voice-idx", doc->sheetList()[sheetIdx]->voiceList().indexOf(lc->associatedVoice()));
+                writeStartElement("lyrics-context");
+                writeAttribute("name", lc->name());
+                writeAttribute("stanza-number", lc->stanzaNumber());
+                writeAttribute("associated-voice-idx", doc->sheetList()[sheetIdx]->voiceList().indexOf(lc->associatedVoice()));
 
                 QList<CASyllable*> syllables = lc->syllableList();
                 for (int i = 0; i < syllables.size(); i++) {
-                    QDomElement s = dDoc.createElement("syllable");
-                    dlc.appendChild(s);
-                    s.setAttribute("time-start", syllables[i]->timeStart());
-                    s.setAttribute("time-length", syllables[i]->timeLength());
-                    s.setAttribute("text", syllables[i]->text());
-                    s.setAttribute("hyphen", syllables[i]->hyphenStart());
-                    s.setAttribute("melisma", syllables[i]->melismaStart());
+                    writeStartElement("syllable");
+                    writeAttribute("time-start", syllables[i]->timeStart());
+                    writeAttribute("time-length", syllables[i]->timeLength());
+                    writeAttribute("text", syllables[i]->text());
+                    writeAttribute("hyphen", syllables[i]->hyphenStart());
+                    writeAttribute("melisma", syllables[i]->melismaStart());
 
                     if (syllables[i]->associatedVoice() && doc->sheetList()[sheetIdx]->voiceList().contains(syllables[i]->associatedVoice())) {
-                        s.setAttribute("associated-voice-idx", doc->sheetList()[sheetIdx]->voiceList().indexOf(syllables[i]->associatedVoice()));
+                        writeAttribute("associated-voice-idx", doc->sheetList()[sheetIdx]->voiceList().indexOf(syllables[i]->associatedVoice()));
                     }
+                    writeEndElement();
                 }
 
+                writeEndElement();
                 break;
             }
             case CAContext::FiguredBassContext: {
-                exportFiguredBass(static_cast<CAFiguredBassContext*>(c), dSheet);
+                exportFiguredBass(static_cast<CAFiguredBassContext*>(c));
                 break;
             }
             case CAContext::FunctionMarkContext: {
                 // CAFunctionMarkContext
                 CAFunctionMarkContext* fmc = static_cast<CAFunctionMarkContext*>(c);
-                QDomElement dFmc = dDoc.createElement("function-mark-context");
-                dSheet.appendChild(dFmc);
-                dFmc.setAttribute("name", fmc->name());
+                writeStartElement("function-mark-context");
+                writeAttribute("name", fmc->name());
 
                 QList<CAFunctionMark*> elts = fmc->functionMarkList();
                 for (int i = 0; i < elts.size(); i++) {
-                    QDomElement dFm = dDoc.createElement("function-mark");
-                    dFmc.appendChild(dFm);
-                    dFm.setAttribute("time-start", elts[i]->timeStart());
-                    dFm.setAttribute("time-length", elts[i]->timeLength());
-                    dFm.setAttribute("function", CAFunctionMark::functionTypeToString(elts[i]->function()));
-                    dFm.setAttribute("minor", elts[i]->isMinor());
-                    dFm.setAttribute("chord-area", CAFunctionMark::functionTypeToString(elts[i]->chordArea()));
-                    dFm.setAttribute("chord-area-minor", elts[i]->isChordAreaMinor());
-                    dFm.setAttribute("tonic-degree", CAFunctionMark::functionTypeToString(elts[i]->tonicDegree()));
-                    dFm.setAttribute("tonic-degree-minor", elts[i]->isTonicDegreeMinor());
-                    exportDiatonicKey(elts[i]->key(), dFm);
-                    //dFm.setAttribute( "altered-degrees", elts[i]->alteredDegrees() );
-                    //dFm.setAttribute( "added-degrees", elts[i]->addedDegrees() );
-                    dFm.setAttribute("ellipse", elts[i]->isPartOfEllipse());
+                    writeStartElement("function-mark");
+                    writeAttribute("time-start", elts[i]->timeStart());
+                    writeAttribute("time-length", elts[i]->timeLength());
+                    writeAttribute("function", CAFunctionMark::functionTypeToString(elts[i]->function()));
+                    writeAttribute("minor", elts[i]->isMinor());
+                    writeAttribute("chord-area", CAFunctionMark::functionTypeToString(elts[i]->chordArea()));
+                    writeAttribute("chord-area-minor", elts[i]->isChordAreaMinor());
+                    writeAttribute("tonic-degree", CAFunctionMark::functionTypeToString(elts[i]->tonicDegree()));
+                    writeAttribute("tonic-degree-minor", elts[i]->isTonicDegreeMinor());
+                    //writeAttribute( "altered-degrees", elts[i]->alteredDegrees() );
+                    //writeAttribute( "added-degrees", elts[i]->addedDegrees() );
+                    writeAttribute("ellipse", elts[i]->isPartOfEllipse());
+                    exportDiatonicKey(elts[i]->key());
+                    writeEndElement();
                 }
+
+                writeEndElement();
                 break;
             }
             case CAContext::ChordNameContext: {
                 // CAChordNameContext
                 CAChordNameContext* cnc = static_cast<CAChordNameContext*>(c);
-                QDomElement dCnc = dDoc.createElement("chord-name-context");
-                dSheet.appendChild(dCnc);
-                dCnc.setAttribute("name", cnc->name());
+                writeStartElement("chord-name-context");
+                writeAttribute("name", cnc->name());
 
                 QList<CAChordName*> elts = cnc->chordNameList();
                 for (int i = 0; i < elts.size(); i++) {
-                    QDomElement dCn = dDoc.createElement("chord-name");
-                    dCnc.appendChild(dCn);
-                    dCn.setAttribute("time-start", elts[i]->timeStart());
-                    dCn.setAttribute("time-length", elts[i]->timeLength());
-                    exportDiatonicPitch(elts[i]->diatonicPitch(), dCn);
-                    dCn.setAttribute("quality-modifier", elts[i]->qualityModifier());
+                    writeStartElement("chord-name");
+                    writeAttribute("time-start", elts[i]->timeStart());
+                    writeAttribute("time-length", elts[i]->timeLength());
+                    writeAttribute("quality-modifier", elts[i]->qualityModifier());
+                    exportDiatonicPitch(elts[i]->diatonicPitch());
+                    writeEndElement();
                 }
+
+                writeEndElement();
                 break;
             }
             }
         }
+
+        writeEndElement(); // sheet
     }
 
-    exportResources(doc, dCanorusDocument);
+    writeEndElement(); // document
+
+    exportResources(doc);
+
+    writeEndElement(); // canorus-document
 
-    out() << dDoc.toString();
+    delete _xml;
+    _xml = nullptr;
 }
 
 /*!
-	Used for writing the voice node in XML output.
-	It uses DOM object internally for writing the XML output.
-	This method is usually called by saveDocument().
+	Writes the music elements of the given \a voice.
+	This method is usually called by exportDocumentImpl() inside the voice node.
+
+	The elements of a tuplet are written inside the tuplet node. Any other elements placed in
+	between the tuplet elements are written right after the tuplet node.
 
 	\sa exportDocumentImpl()
 */
-void CACanorusMLExport::exportVoiceImpl(CAVoice* voice, QDomElement& dVoice)
+void CACanorusMLExport::exportMusElements(CAVoice* voice)
 {
-    QDomDocument dDoc = dVoice.ownerDocument();
-    for (int i = 0; i < voice->musElementList().size(); i++) {
-        CAMusElement* curElt = voice->musElementList()[i];
-        QDomElement dElt;
-        switch (curElt->musElementType()) {
-        case CAMusElement::Note: {
-            CANote* note = static_cast<CANote*>(curElt);
-
-            if (note->isFirstInTuplet()) {
-                _dTuplet = dDoc.createElement("tuplet");
-                _dTuplet.setAttribute("number", note->tuplet()->number());
-                _dTuplet.setAttribute("actual-number", note->tuplet()->actualNumber());
-                dVoice.appendChild(_dTuplet);
-            }
-
-            dElt = dDoc.createElement("note");
-            if (note->tuplet()) {
-                _dTuplet.appendChild(dElt);
-            } else {
-                dVoice.appendChild(dElt);
-            }
-
-            if (note->stemDirection() != CANote::StemPreferred)
-                dElt.setAttribute("stem-direction", CANote::stemDirectionToString(note->stemDirection()));
-
-            exportPlayableLength(note->playableLength(), dElt);
-            exportDiatonicPitch(note->diatonicPitch(), dElt);
-
-            if (note->tieStart()) {
-                QDomElement dTie = dDoc.createElement("tie");
-                dElt.appendChild(dTie);
-                dTie.setAttribute("slur-style", CASlur::slurStyleToString(note->tieStart()->slurStyle()));
-                dTie.setAttribute("slur-direction", CASlur::slurDirectionToString(note->tieStart()->slurDirection()));
-            }
-            if (note->slurStart()) {
-                QDomElement dSlur = dDoc.createElement("slur-start");
-                dElt.appendChild(dSlur);
-                dSlur.setAttribute("slur-style", CASlur::slurStyleToString(note->slurStart()->slurStyle()));
-                dSlur.setAttribute("slur-direction", CASlur::slurDirectionToString(note->slurStart()->slurDirection()));
-            }
-            if (note->slurEnd()) {
-                QDomElement dSlur = dDoc.createElement("slur-end");
-                dElt.appendChild(dSlur);
-            }
-            if (note->phrasingSlurStart()) {
-                QDomElement dPhrasingSlur = dDoc.createElement("phrasing-slur-start");
-                dElt.appendChild(dPhrasingSlur);
-                dPhrasingSlur.setAttribute("slur-style", CASlur::slurStyleToString(note->phrasingSlurStart()->slurStyle()));
-                dPhrasingSlur.setAttribute("slur-direction", CASlur::slurDirectionToString(note->phrasingSlurStart()->slurDirection()));
-            }
-            if (note->phrasingSlurEnd()) {
-                QDomElement dPhrasingSlur = dDoc.createElement("phrasing-slur-end");
-                dElt.appendChild(dPhrasingSlur);
-            }
-
-            break;
+    const QList<CAMusElement*>& musElementList = voice->musElementList();
+    bool tupletOpen = false;
+    bool tupletComplete = false;
+    QList<CAMusElement*> deferred; // non-tuplet elements in the middle of the open tuplet
+
+    for (int i = 0; i < musElementList.size(); i++) {
+        CAMusElement* curElt = musElementList[i];
+        CAPlayable* playable = curElt->isPlayable() ? static_cast<CAPlayable*>(curElt) : nullptr;
+        bool inTuplet = playable && playable->tuplet();
+
+        if (tupletOpen && ((inTuplet && playable->isFirstInTuplet()) || (!inTuplet && tupletComplete))) {
+            writeEndElement(); // tuplet
+            tupletOpen = false;
+            for (int j = 0; j < deferred.size(); j++) {
+                exportMusElement(deferred[j]);
+            }
+            deferred.clear();
         }
-        case CAMusElement::Rest: {
-            CARest* rest = static_cast<CARest*>(curElt);
-
-            if (rest->isFirstInTuplet()) {
-                _dTuplet = dDoc.createElement("tuplet");
-                _dTuplet.setAttribute("number", rest->tuplet()->number());
-                _dTuplet.setAttribute("actual-number", rest->tuplet()->actualNumber());
-                dVoice.appendChild(_dTuplet);
-            }
 
-            dElt = dDoc.createElement("rest");
-            if (rest->tuplet()) {
-                _dTuplet.appendChild(dElt);
-            } else {
-                dVoice.appendChild(dElt);
-            }
+        if (inTuplet && playable->isFirstInTuplet()) {
+            writeStartElement("tuplet");
+            writeAttribute("number", playable->tuplet()->number());
+            writeAttribute("actual-number", playable->tuplet()->actualNumber());
+            tupletOpen = true;
+            tupletComplete = false;
+        }
 
-            dElt.setAttribute("rest-type", CARest::restTypeToString(rest->restType()));
+        if (tupletOpen && !inTuplet) {
+            deferred << curElt;
+            continue;
+        }
 
-            exportPlayableLength(rest->playableLength(), dElt);
+        exportMusElement(curElt);
 
-            break;
+        if (tupletOpen && playable->isLastInTuplet()) {
+            tupletComplete = true;
         }
-        case CAMusElement::Clef: {
-            CAClef* clef = static_cast<CAClef*>(curElt);
-            dElt = dDoc.createElement("clef");
-            dVoice.appendChild(dElt);
-            dElt.setAttribute("clef-type", CAClef::clefTypeToString(clef->clefType()));
-            dElt.setAttribute("c1", clef->c1());
-            dElt.setAttribute("offset", clef->offset());
-
-            break;
+    }
+
+    if (tupletOpen) {
+        writeEndElement(); // tuplet
+        for (int j = 0; j < deferred.size(); j++) {
+            exportMusElement(deferred[j]);
         }
-        case CAMusElement::KeySignature: {
-            CAKeySignature* key = static_cast<CAKeySignature*>(curElt);
-            dElt = dDoc.createElement("key-signature");
-            dVoice.appendChild(dElt);
-            dElt.setAttribute("key-signature-type", CAKeySignature::keySignatureTypeToString(key->keySignatureType()));
-
-            if (key->keySignatureType() == CAKeySignature::MajorMinor) {
-                exportDiatonicKey(key->diatonicKey(), dElt);
-            } else if (key->keySignatureType() == CAKeySignature::Modus) {
-                dElt.setAttribute("modus", CAKeySignature::modusToString(key->modus()));
-            }
-            //! \todo Custom accidentals in key signature saving -Matevz
-            // exportDiatonicPitch( key->diatonicKey().diatonicPitch(), dKey );
+    }
+}
 
-            break;
+/*!
+	Writes the node of a single music element of the voice including its marks.
+*/
+void CACanorusMLExport::exportMusElement(CAMusElement* curElt)
+{
+    switch (curElt->musElementType()) {
+    case CAMusElement::Note: {
+        CANote* note = static_cast<CANote*>(curElt);
+        writeStartElement("note");
+        exportTime(curElt);
+        exportColor(curElt);
+
+        if (note->stemDirection() != CANote::StemPreferred)
+            writeAttribute("stem-direction", CANote::stemDirectionToString(note->stemDirection()));
+
+        exportPlayableLength(note->playableLength());
+        exportDiatonicPitch(note->diatonicPitch());
+
+        if (note->tieStart()) {
+            writeStartElement("tie");
+            writeAttribute("slur-style", CASlur::slurStyleToString(note->tieStart()->slurStyle()));
+            writeAttribute("slur-direction", CASlur::slurDirectionToString(note->tieStart()->slurDirection()));
+            writeEndElement();
         }
-        case CAMusElement::TimeSignature: {
-            CATimeSignature* time = static_cast<CATimeSignature*>(curElt);
-            dElt = dDoc.createElement("time-signature");
-            dVoice.appendChild(dElt);
-            dElt.setAttribute("time-signature-type", CATimeSignature::timeSignatureTypeToString(time->timeSignatureType()));
-            dElt.setAttribute("beats", time->beats());
-            dElt.setAttribute("beat", time->beat());
-
-            break;
+        if (note->slurStart()) {
+            writeStartElement("slur-start");
+            writeAttribute("slur-style", CASlur::slurStyleToString(note->slurStart()->slurStyle()));
+            writeAttribute("slur-direction", CASlur::slurDirectionToString(note->slurStart()->slurDirection()));
+            writeEndElement();
         }
-        case CAMusElement::Barline: {
-            CABarline* barline = static_cast<CABarline*>(curElt);
-            dElt = dDoc.createElement("barline");
-            dVoice.appendChild(dElt);
-            dElt.setAttribute("barline-type", CABarline::barlineTypeToString(barline->barlineType()));
-
-            break;
+        if (note->slurEnd()) {
+            writeStartElement("slur-end");
+            writeEndElement();
+        }
+        if (note->phrasingSlurStart()) {
+            writeStartElement("phrasing-slur-start");
+            writeAttribute("slur-style", CASlur::slurStyleToString(note->phrasingSlurStart()->slurStyle()));
+            writeAttribute("slur-direction", CASlur::slurDirectionToString(note->phrasingSlurStart()->slurDirection()));
+            writeEndElement();
         }
-        case CAMusElement::MidiNote:
-        case CAMusElement::Slur:
-        case CAMusElement::Tuplet:
-        case CAMusElement::Syllable:
-        case CAMusElement::FunctionMark:
-        case CAMusElement::FiguredBassMark:
-        case CAMusElement::Mark:
-        case CAMusElement::ChordName:
-        case CAMusElement::Undefined:
-            qDebug() << "Error: Element" << curElt << "should not be member of the voice. musElementType:" << curElt->musElementType();
-            break;
+        if (note->phrasingSlurEnd()) {
+            writeStartElement("phrasing-slur-end");
+            writeEndElement();
         }
 
-        exportTime(curElt, dElt);
-        exportColor(curElt, dElt);
+        break;
+    }
+    case CAMusElement::Rest: {
+        CARest* rest = static_cast<CARest*>(curElt);
+        writeStartElement("rest");
+        exportTime(curElt);
+        exportColor(curElt);
+        writeAttribute("rest-type", CARest::restTypeToString(rest->restType()));
 
-        exportMarks(curElt, dElt);
+        exportPlayableLength(rest->playableLength());
+
+        break;
+    }
+    case CAMusElement::Clef: {
+        CAClef* clef = static_cast<CAClef*>(curElt);
+        writeStartElement("clef");
+        exportTime(curElt);
+        exportColor(curElt);
+        writeAttribute("clef-type", CAClef::clefTypeToString(clef->clefType()));
+        writeAttribute("c1", clef->c1());
+        writeAttribute("offset", clef->offset());
+
+        break;
+    }
+    case CAMusElement::KeySignature: {
+        CAKeySignature* key = static_cast<CAKeySignature*>(curElt);
+        writeStartElement("key-signature");
+        exportTime(curElt);
+        exportColor(curElt);
+        writeAttribute("key-signature-type", CAKeySignature::keySignatureTypeToString(key->keySignatureType()));
+
+        if (key->keySignatureType() == CAKeySignature::MajorMinor) {
+            exportDiatonicKey(key->diatonicKey());
+        } else if (key->keySignatureType() == CAKeySignature::Modus) {
+            writeAttribute("modus", CAKeySignature::modusToString(key->modus()));
+        }
+        //! \todo Custom accidentals in key signature saving -Matevz
+        // exportDiatonicPitch( key->diatonicKey().diatonicPitch() );
+
+        break;
+    }
+    case CAMusElement::TimeSignature: {
+        CATimeSignature* time = static_cast<CATimeSignature*>(curElt);
+        writeStartElement("time-signature");
+        exportTime(curElt);
+        exportColor(curElt);
+        writeAttribute("time-signature-type", CATimeSignature::timeSignatureTypeToString(time->timeSignatureType()));
+        writeAttribute("beats", time->beats());
+        writeAttribute("beat", time->beat());
+
+        break;
     }
+    case CAMusElement::Barline: {
+        CABarline* barline = static_cast<CABarline*>(curElt);
+        writeStartElement("barline");
+        exportTime(curElt);
+        exportColor(curElt);
+        writeAttribute("barline-type", CABarline::barlineTypeToString(barline->barlineType()));
+
+        break;
+    }
+    case CAMusElement::MidiNote:
+    case CAMusElement::Slur:
+    case CAMusElement::Tuplet:
+    case CAMusElement::Syllable:
+    case CAMusElement::FunctionMark:
+    case CAMusElement::FiguredBassMark:
+    case CAMusElement::Mark:
+    case CAMusElement::ChordName:
+    case CAMusElement::Undefined:
+        qDebug() << "Error: Element" << curElt << "should not be member of the voice. musElementType:" << curElt->musElementType();
+        return;
+    }
+
+    exportMarks(curElt);
+
+    writeEndElement();
 }
 
-void CACanorusMLExport::exportFiguredBass(CAFiguredBassContext* fbc, QDomElement& dSheet)
+void CACanorusMLExport::exportFiguredBass(CAFiguredBassContext* fbc)
 {
-    QDomElement dFbc = dSheet.ownerDocument().createElement("figured-bass-context");
-    dSheet.appendChild(dFbc);
-    dFbc.setAttribute("name", fbc->name());
+    writeStartElement("figured-bass-context");
+    writeAttribute("name", fbc->name());
 
     QList<CAFiguredBassMark*> elts = fbc->figuredBassMarkList();
     for (int i = 0; i < elts.size(); i++) {
-        QDomElement dFbm = dSheet.ownerDocument().createElement("figured-bass-mark");
-        dFbc.appendChild(dFbm);
-        dFbm.setAttribute("time-start", elts[i]->timeStart());
-        dFbm.setAttribute("time-length", elts[i]->timeLength());
-        exportColor(elts[i], dFbm);
+        writeStartElement("figured-bass-mark");
+        writeAttribute("time-start", elts[i]->timeStart());
+        writeAttribute("time-length", elts[i]->timeLength());
+        exportColor(elts[i]);
 
         for (int j = 0; j < elts[i]->numbers().size(); j++) {
-            QDomElement dFbn = dSheet.ownerDocument().createElement("figured-bass-number");
-            dFbm.appendChild(dFbn);
-            dFbn.setAttribute("number", elts[i]->numbers()[j]);
+            writeStartElement("figured-bass-number");
+            writeAttribute("number", elts[i]->numbers()[j]);
             if (elts[i]->accs().contains(elts[i]->numbers()[j])) {
-                dFbn.setAttribute("accs", elts[i]->accs()[elts[i]->numbers()[j]]);
+                writeAttribute("accs", elts[i]->accs()[elts[i]->numbers()[j]]);
             }
+            writeEndElement();
         }
+        writeEndElement();
     }
+
+    writeEndElement();
 }
 
-void CACanorusMLExport::exportMarks(CAMusElement* elt, QDomElement& domElt)
+void CACanorusMLExport::exportMarks(CAMusElement* elt)
 {
     for (int i = 0; i < elt->markList().size(); i++) {
         CAMark* mark = elt->markList()[i];
         if (!mark->isCommon() || elt->musElementType() != CAMusElement::Note || (elt->musElementType() == CAMusElement::Note && static_cast<CANote*>(elt)->isFirstInChord())) {
-            QDomElement dMark = domElt.ownerDocument().createElement("mark");
-            domElt.appendChild(dMark);
-            dMark.setAttribute("time-start", mark->timeStart());
-            dMark.setAttribute("time-length", mark->timeLength());
-            dMark.setAttribute("mark-type", CAMark::markTypeToString(mark->markType()));
+            writeStartElement("mark");
+            writeAttribute("time-start", mark->timeStart());
+            writeAttribute("time-length", mark->timeLength());
+            writeAttribute("mark-type", CAMark::markTypeToString(mark->markType()));
+            exportColor(mark);
 
             switch (mark->markType()) {
             case CAMark::Text: {
                 CAText* text = static_cast<CAText*>(mark);
-                dMark.setAttribute("text", text->text());
+                writeAttribute("text", text->text());
                 break;
             }
             case CAMark::Tempo: {
                 CATempo* tempo = static_cast<CATempo*>(mark);
-                dMark.setAttribute("bpm", tempo->bpm());
-                exportPlayableLength(tempo->beat(), dMark);
+                writeAttribute("bpm", tempo->bpm());
+                exportPlayableLength(tempo->beat());
                 break;
             }
             case CAMark::Ritardando: {
                 CARitardando* rit = static_cast<CARitardando*>(mark);
-                dMark.setAttribute("ritardando-type", CARitardando::ritardandoTypeToString(rit->ritardandoType()));
-                dMark.setAttribute("final-tempo", rit->finalTempo());
+                writeAttribute("ritardando-type", CARitardando::ritardandoTypeToString(rit->ritardandoType()));
+                writeAttribute("final-tempo", rit->finalTempo());
                 break;
             }
             case CAMark::Dynamic: {
                 CADynamic* dyn = static_cast<CADynamic*>(mark);
-                dMark.setAttribute("volume", dyn->volume());
-                dMark.setAttribute("text", dyn->text());
+                writeAttribute("volume", dyn->volume());
+                writeAttribute("text", dyn->text());
                 break;
             }
             case CAMark::Crescendo: {
                 CACrescendo* cresc = static_cast<CACrescendo*>(mark);
-                dMark.setAttribute("final-volume", cresc->finalVolume());
-                dMark.setAttribute("crescendo-type", CACrescendo::crescendoTypeToString(cresc->crescendoType()));
+                writeAttribute("final-volume", cresc->finalVolume());
+                writeAttribute("crescendo-type", CACrescendo::crescendoTypeToString(cresc->crescendoType()));
                 break;
             }
             case CAMark::Pedal: {
@@ -458,12 +516,12 @@ void CACanorusMLExport::exportMarks(CAMusElement* elt, QDomElement& domElt)
             }
             case CAMark::InstrumentChange: {
                 CAInstrumentChange* ic = static_cast<CAInstrumentChange*>(mark);
-                dMark.setAttribute("instrument", ic->instrument());
+                writeAttribute("instrument", ic->instrument());
                 break;
             }
             case CAMark::BookMark: {
                 CABookMark* b = static_cast<CABookMark*>(mark);
-                dMark.setAttribute("text", b->text());
+                writeAttribute("text", b->text());
                 break;
             }
             case CAMark::RehersalMark: {
@@ -472,76 +530,76 @@ void CACanorusMLExport::exportMarks(CAMusElement* elt, QDomElement& domElt)
             }
             case CAMark::Fermata: {
                 CAFermata* f = static_cast<CAFermata*>(mark);
-                dMark.setAttribute("fermata-type", CAFermata::fermataTypeToString(f->fermataType()));
+                writeAttribute("fermata-type", CAFermata::fermataTypeToString(f->fermataType()));
                 break;
             }
             case CAMark::RepeatMark: {
                 CARepeatMark* r = static_cast<CARepeatMark*>(mark);
-                dMark.setAttribute("repeat-mark-type", CARepeatMark::repeatMarkTypeToString(r->repeatMarkType()));
+                writeAttribute("repeat-mark-type", CARepeatMark::repeatMarkTypeToString(r->repeatMarkType()));
                 if (r->repeatMarkType() == CARepeatMark::Volta) {
-                    dMark.setAttribute("volta-number", r->voltaNumber());
+                    writeAttribute("volta-number", r->voltaNumber());
                 }
                 break;
             }
             case CAMark::Articulation: {
                 CAArticulation* a = static_cast<CAArticulation*>(mark);
-                dMark.setAttribute("articulation-type", CAArticulation::articulationTypeToString(a->articulationType()));
+                writeAttribute("articulation-type", CAArticulation::articulationTypeToString(a->articulationType()));
                 break;
             }
             case CAMark::Fingering: {
                 CAFingering* f = static_cast<CAFingering*>(mark);
-                dMark.setAttribute("original", f->isOriginal());
+                writeAttribute("original", f->isOriginal());
                 for (int i = 0; i < f->fingerList().size(); i++)
-                    dMark.setAttribute(QString("finger%1").arg(i), CAFingering::fingerNumberToString(f->fingerList()[i]));
+                    writeAttribute(QString("finger%1").arg(i), CAFingering::fingerNumberToString(f->fingerList()[i]));
                 break;
             }
             case CAMark::Undefined:
                 break;
             }
 
-            exportColor(mark, dMark);
+            writeEndElement();
         }
     }
 }
 
-void CACanorusMLExport::exportColor(CAMusElement* elt, QDomElement& domParent)
+void CACanorusMLExport::exportColor(CAMusElement* elt)
 {
     if (elt->color().isValid()) {
-        domParent.setAttribute("color", QVariant(elt->color()).toString());
+        writeAttribute("color", QVariant(elt->color()).toString());
     }
 }
 
-void CACanorusMLExport::exportTime(CAMusElement* elt, QDomElement& domParent)
+void CACanorusMLExport::exportTime(CAMusElement* elt)
 {
-    domParent.setAttribute("time-start", elt->timeStart());
+    writeAttribute("time-start", elt->timeStart());
 
     if (elt->isPlayable()) {
-        domParent.setAttribute("time-length", elt->timeLength());
+        writeAttribute("time-length", elt->timeLength());
     }
 }
 
-void CACanorusMLExport::exportPlayableLength(CAPlayableLength l, QDomElement& domParent)
+void CACanorusMLExport::exportPlayableLength(CAPlayableLength l)
 {
-    QDomElement dl = domParent.ownerDocument().createElement("playable-length");
-    domParent.appendChild(dl);
-    dl.setAttribute("music-length", CAPlayableLength::musicLengthToString(l.musicLength()));
-    dl.setAttribute("dotted", l.dotted());
+    writeStartElement("playable-length");
+    writeAttribute("music-length", CAPlayableLength::musicLengthToString(l.musicLength()));
+    writeAttribute("dotted", l.dotted());
+    writeEndElement();
 }
 
-void CACanorusMLExport::exportDiatonicPitch(CADiatonicPitch p, QDomElement& domParent)
+void CACanorusMLExport::exportDiatonicPitch(CADiatonicPitch p)
 {
-    QDomElement dp = domParent.ownerDocument().createElement("diatonic-pitch");
-    domParent.appendChild(dp);
-    dp.setAttribute("note-name", p.noteName());
-    dp.setAttribute("accs", p.accs());
+    writeStartElement("diatonic-pitch");
+    writeAttribute("note-name", p.noteName());
+    writeAttribute("accs", p.accs());
+    writeEndElement();
 }
 
-void CACanorusMLExport::exportDiatonicKey(CADiatonicKey k, QDomElement& domParent)
+void CACanorusMLExport::exportDiatonicKey(CADiatonicKey k)
 {
-    QDomElement dk = domParent.ownerDocument().createElement("diatonic-key");
-    domParent.appendChild(dk);
-    dk.setAttribute("gender", CADiatonicKey::genderToString(k.gender()));
-    exportDiatonicPitch(k.diatonicPitch(), dk);
+    writeStartElement("diatonic-key");
+    writeAttribute("gender", CADiatonicKey::genderToString(k.gender()));
+    exportDiatonicPitch(k.diatonicPitch());
+    writeEndElement();
 }
 
 /*!
@@ -556,27 +614,32 @@ void CACanorusMLExport::exportDiatonicKey(CADiatonicKey k, QDomElement& domParen
 	3) Attached resource:
 	   Resource is copied from the tmp/ directory to the directory where the document
 	   is being saved + "filename files/". eg. "content.xml files/myImageXXXX.png"
+
+	The document is saved to file() or, when exporting to another device, to the file name set
+	by setFileName().
  */
-void CACanorusMLExport::exportResources(CADocument* doc, QDomElement& dCanorusDocument)
+void CACanorusMLExport::exportResources(CADocument* doc)
 {
+    QString fileName = file() ? file()->fileName() : _fileName;
+
     for (int i = 0; i < doc->resourceList().size(); i++) {
         CAResource* r = doc->resourceList()[i];
         QUrl url;
 
         if (r->isLinked()) {
             // linked resource, calculate relative path of the resource to the document where it's being saved
-            if (r->url().scheme() == "file" && file()) {
+            if (r->url().scheme() == "file" && !fileName.isEmpty()) {
                 // local file
-                QDir outDir(QFileInfo(*file()).absolutePath());
+                QDir outDir(QFileInfo(fileName).absolutePath());
                 url = QUrl::fromLocalFile(outDir.relativeFilePath(r->url().toLocalFile()));
             } else {
                 // remote file
                 url = r->url();
             }
-        } else if (file()) {
+        } else if (!fileName.isEmpty()) {
             // attached resource, copy the resource to "filename files/" directory
-            QString targetDir = QFileInfo(*file()).absolutePath();
-            QString targetFileName = QFileInfo(*file()).fileName();
+            QString targetDir = QFileInfo(fileName).absolutePath();
+            QString targetFileName = QFileInfo(fileName).fileName();
 
             // create directory if it doesn't exist
             if (!QDir(targetDir + "/" + targetFileName + " files").exists()) {
@@ -594,14 +657,56 @@ void CACanorusMLExport::exportResources(CADocument* doc, QDomElement& dCanorusDo
             url = QUrl::fromLocalFile(QString("content.xml files/") + QFileInfo(r->url().toLocalFile()).fileName());
         }
 
-        QDomElement dResource = dCanorusDocument.ownerDocument().createElement("resource");
+        writeStartElement("resource");
+        writeAttribute("name", r->name());
+        writeAttribute("description", r->description());
+        writeAttribute("linked", r->isLinked());
+        writeAttribute("resource-type", CAResource::resourceTypeToString(r->resourceType()));
+        writeAttribute("url", url.toString());
+        writeEndElement();
+    }
+}
 
-        dResource.setAttribute("name", r->name());
-        dResource.setAttribute("description", r->description());
-        dResource.setAttribute("linked", r->isLinked());
-        dResource.setAttribute("resource-type", CAResource::resourceTypeToString(r->resourceType()));
-        dResource.setAttribute("url", url.toString());
+/*!
+	Writes the start tag of the element \a name indented by its depth.
+	The start tag of the parent is closed and followed by a new line at its first child.
+*/
+void CACanorusMLExport::writeStartElement(const QString& name)
+{
+    if (!_hasChildren.isEmpty()) {
+        if (!_hasChildren.last()) {
+            _xml->writeCharacters("\n");
+            _hasChildren.last() = true;
+        }
+        _xml->writeCharacters(QString(_hasChildren.size(), ' '));
+    }
 
-        dCanorusDocument.appendChild(dResource);
+    _xml->writeStartElement(name);
+    _hasChildren << false;
+}
+
+/*!
+	Writes the end tag of the last opened element followed by a new line.
+	Elements without children are closed with "/>".
+*/
+void CACanorusMLExport::writeEndElement()
+{
+    bool hasChildren = _hasChildren.last();
+    _hasChildren.removeLast();
+    if (hasChildren && !_hasChildren.isEmpty()) {
+        _xml->writeCharacters(QString(_hasChildren.size(), ' '));
     }
+
+    _xml->writeEndElement();
+    _xml->writeCharacters("\n");
+}
+
+void CACanorusMLExport::writeAttribute(const QString& name, const QString& value)
+{
+    _xml->writeAttribute(name, value);
+}
+
+void CACanorusMLExport::writeAttribute(const QString& name, qlonglong value)
+{
+    _xml->writeAttribute(name, QString::number(value));
 }
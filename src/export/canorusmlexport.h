@@ -9,13 +9,14 @@
 #define CANORUSMLEXPORT_H_
 
 #include <QColor>
-#include <QDomElement>
+#include <QVector>
 
 #include "export/export.h"
 #include "score/diatonickey.h"
 #include "score/diatonicpitch.h"
 #include "score/playablelength.h"
 
+class QXmlStreamWriter;
 class CAMusElement;
 class CAFiguredBassContext;
 
@@ -26,20 +27,29 @@ public:
 
     void exportDocumentImpl(CADocument* doc);
 
+    inline void setFileName(const QString fileName) { _fileName = fileName; }
+
 private:
-    using CAExport::exportVoiceImpl;
-    void exportVoiceImpl(CAVoice* voice, QDomElement& dVoice);
-    void exportFiguredBass(CAFiguredBassContext* c, QDomElement& domParent);
-    void exportMarks(CAMusElement* associatedElt, QDomElement& domParent);
-    void exportPlayableLength(CAPlayableLength l, QDomElement& domParent);
-    void exportDiatonicPitch(CADiatonicPitch p, QDomElement& domParent);
-    void exportDiatonicKey(CADiatonicKey k, QDomElement& domParent);
-    void exportColor(CAMusElement* elt, QDomElement& domParent);
-    void exportTime(CAMusElement* elt, QDomElement& domParent);
-    void exportResources(CADocument*, QDomElement&);
-
-    QDomElement _dTuplet;
+    void exportMusElements(CAVoice* voice);
+    void exportMusElement(CAMusElement* elt);
+    void exportFiguredBass(CAFiguredBassContext* c);
+    void exportMarks(CAMusElement* associatedElt);
+    void exportPlayableLength(CAPlayableLength l);
+    void exportDiatonicPitch(CADiatonicPitch p);
+    void exportDiatonicKey(CADiatonicKey k);
+    void exportColor(CAMusElement* elt);
+    void exportTime(CAMusElement* elt);
+    void exportResources(CADocument*);
+
+    void writeStartElement(const QString& name);
+    void writeEndElement();
+    void writeAttribute(const QString& name, const QString& value);
+    void writeAttribute(const QString& name, qlonglong value);
+
+    QXmlStreamWriter* _xml;
+    QVector<bool> _hasChildren; // for each open element, whether any child elements were written
     QColor _color; // foreground color of elements
+    QString _fileName; // file written to by a device other than QFile, eg. QSaveFile
 };
 
 #endif /* CANORUSMLEXPORT_H_ */
@@ -116,11 +116,14 @@ void CAExport::exportDocument(CADocument* doc, bool bStartThread)
     }
 }
 
-void CAExport::exportSheet(CASheet* sheet)
+void CAExport::exportSheet(CASheet* sheet, bool bStartThread)
 {
     setExportedSheet(sheet);
     setStatus(1); // process started
-    start();
+    if (bStartThread)
+        start();
+    else
+        run();
 }
 
 void CAExport::exportStaff(CAStaff* staff)
@@ -29,7 +29,7 @@ public:
 
     virtual const QString readableStatus();
     void exportDocument(CADocument*, bool bStartThread = true);
-    void exportSheet(CASheet*);
+    void exportSheet(CASheet*, bool bStartThread = true);
     void exportStaff(CAStaff*);
     void exportVoice(CAVoice*);
     void exportLyricsContext(CALyricsContext*);
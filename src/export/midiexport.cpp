@@ -5,18 +5,16 @@
 	Licensed under the GNU GENERAL PUBLIC LICENSE. See LICENSE.GPL for details.
 */
 
-#include <QFileInfo>
-#include <QRegExp>
+#include <QHash>
+#include <QIODevice>
 #include <QTextStream>
-#include <iomanip>
-#include <iostream>
-#include <stdio.h>
 
 #include "export/midiexport.h"
 
 #include "interface/mididevice.h"
-#include "interface/playback.h"
+#include "interface/playbacktimeline.h"
 #include "score/document.h"
+#include "score/playablelength.h"
 #include "score/sheet.h"
 #include "score/staff.h"
 #include "score/voice.h"
@@ -34,6 +32,18 @@ class CACanorus;
 
 	\a textStream is usually the file stream.
 
+	The sheet is compiled into a flat list of events (see CAPlaybackTimeline) and written as a
+	standard MIDI file of type 1: the first track holds the tempo, time and key signature meta
+	events, followed by a track for each voice. Each track is built in its own preallocated
+	buffer and written to the device at once.
+
+	exportSheet() writes the given sheet. exportDocument() writes the first sheet only, unless
+	setExportAllSheets() is set. In that case, the sheets are written one after another and each
+	sheet gets its own tracks and a marker with the sheet name in the first track.
+
+	The class is also a MIDI device, so CAMidiRecorder can send() the recorded events to it
+	directly. These are written to a single music track by writeFile().
+
 	\sa CAMidiImport
 */
 
@@ -44,183 +54,223 @@ class CACanorus;
 CAMidiExport::CAMidiExport(QTextStream* out)
     : CAExport(out)
     , CAMidiDevice()
+    , _exportAllSheets(false)
+    , _curVoice(nullptr)
+    , _curSheet(nullptr)
 {
     _midiDeviceType = MidiExportDevice;
     setRealTime(false);
-    _trackTime = 0;
+    clearTracks();
 }
 
 /*!
-	Compute the time offset for a new event and update the current track time.
+	Appends the MIDI \a message at the given \a time to the recorded track.
 */
-int CAMidiExport::timeIncrement(int time)
-{
-    int offset = 0;
-    if (time > _trackTime) {
-        offset = time - _trackTime;
-    }
-    _trackTime = time;
-    return offset;
-}
-
 void CAMidiExport::send(QVector<unsigned char> message, int time)
 {
-    if (message.size())
-        trackChunk.append(writeTime(timeIncrement(time)));
-    char q;
-    for (int i = 0; i < message.size(); i++) {
-        q = static_cast<char>(message[i]);
-        trackChunk.append(q);
+    if (message.isEmpty()) {
+        return;
     }
-    for (int i = 0; i < message.size(); i++) {
-        q = static_cast<char>(message[i]);
+
+    if (trackChunks.size() < 2) {
+        addTrack(QString());
     }
+    appendMessage(1, time, message.constData(), message.size());
 }
 
-void CAMidiExport::sendMetaEvent(int time, char event, char a, char b, int)
+/*!
+	Appends the meta \a event (tempo, time or key signature) at the given \a time to the control track.
+	The tempo is given by \a c in microseconds per quarter note.
+*/
+void CAMidiExport::sendMetaEvent(int time, char event, char a, char b, int c)
 {
-    // We don't do a time check on time, and we compute
-    // only the time increment when we really send an event out.
-    QByteArray tc;
-    if (event == CAMidiDevice::Meta_Keysig) {
-        tc.append(writeTime(timeIncrement(time)));
-        tc.append(static_cast<char>(CAMidiDevice::Midi_Ctl_Event));
-        tc.append(event);
-        tc.append(variableLengthValue(2));
-        tc.append(a);
-        tc.append(b);
-        trackChunk.append(tc);
-    } else if (event == CAMidiDevice::Meta_Timesig) {
-        char lbBeat = 0;
-        for (; lbBeat < 5; lbBeat++) { // natural logarithm, smallest is 128th
-            if (1 << lbBeat >= b)
-                break;
-        }
-        tc.append(writeTime(timeIncrement(time)));
-        tc.append(static_cast<char>(CAMidiDevice::Midi_Ctl_Event));
-        tc.append(event);
-        tc.append(variableLengthValue(4));
-        tc.append(a);
-        tc.append(lbBeat);
-        tc.append(18);
-        tc.append(8);
-        trackChunk.append(tc);
-    } else if (event == CAMidiDevice::Meta_Tempo) {
-        int usPerQuarter = 60000000 / a;
-        tc.append(writeTime(timeIncrement(time)));
-        tc.append(static_cast<char>(CAMidiDevice::Midi_Ctl_Event));
-        tc.append(event);
-        tc.append(variableLengthValue(3));
-        char q;
-        q = char(usPerQuarter >> 16);
-        tc.append(q);
-        q = char(usPerQuarter >> 8);
-        tc.append(q);
-        q = char(usPerQuarter >> 0);
-        tc.append(q);
-        trackChunk.append(tc);
-    }
+    appendMetaEvent(0, time, event, a, b, c);
 }
 
-/// \todo: replace with enum midiCommands
-#define META_TEXT 0x01
-#define META_TIMESIG 0x58
-#define META_KEYSIG 0x59
-#define META_TEMPO 0x51
-#define META_TRACK_END 0x2f
-
-#define MIDI_CTL_EVENT 0xff
-#define MIDI_CTL_REVERB 0x5b
-#define MIDI_CTL_CHORUS 0x5d
-#define MIDI_CTL_PAN 0x0a
-#define MIDI_CTL_VOLUME 0x07
-#define MIDI_CTL_SUSTAIN 0x40
-
-QByteArray CAMidiExport::word16(char x)
+/*!
+	Removes all the tracks and starts a new control track.
+*/
+void CAMidiExport::clearTracks()
 {
-    QByteArray ba;
-    ba.append(x >> 8);
-    ba.append(x);
-    return ba;
+    trackChunks.clear();
+    trackTimes.clear();
+    addTrack(QString());
+    appendTextEvent(0, 0, CAMidiDevice::Meta_Text, QString("Canorus Version ") + CANORUS_VERSION + " generated.");
 }
 
-QByteArray CAMidiExport::variableLengthValue(int value)
+/*!
+	Adds a new track chunk and returns its index.
+	The track gets a track name meta event, if \a name is not empty. \a reserve is the expected
+	number of bytes of the track events, so the chunk is only allocated once.
+*/
+int CAMidiExport::addTrack(const QString& name, int reserve)
 {
-
     QByteArray chunk;
-    char b;
-    bool byteswritten = false;
-    b = (value >> 3 * 7) & 0x7f;
-    if (b) {
-        chunk.append(0x80 | b);
-        byteswritten = true;
+    chunk.reserve(8 + reserve + 4 + (name.isEmpty() ? 0 : 8 + 3 * name.size())); // header, events, track end and name
+    chunk.append("MTrk\0\0\0\0", 8); // header and space for length
+    trackChunks << chunk;
+    trackTimes << 0;
+
+    if (!name.isEmpty()) {
+        appendTextEvent(trackChunks.size() - 1, 0, CAMidiDevice::Meta_SeqTrkName, name);
     }
-    b = (value >> 2 * 7) & 0x7f;
-    if (b || byteswritten) {
-        chunk.append(0x80 | b);
-        byteswritten = true;
+
+    return trackChunks.size() - 1;
+}
+
+/*!
+	Compiles the given \a sheet and adds a track for each of its voices.
+	Meta events are added to the control track. All events are shifted by \a timeOffset.
+
+	Returns the time of the end of the sheet including the offset.
+*/
+int CAMidiExport::exportSheetTracks(CASheet* sheet, int timeOffset)
+{
+    CAPlaybackTimeline timeline;
+    timeline.compile(sheet);
+    const QVector<CAPlaybackTimeline::CAEvent>& events = timeline.events();
+
+    // count the messages of each voice to preallocate the tracks
+    QHash<CAVoice*, int> messageCount;
+    int metaCount = 0;
+    for (int i = 0; i < events.size(); i++) {
+        if (events[i].type == CAPlaybackTimeline::Message) {
+            messageCount[events[i].voice]++;
+        } else if (events[i].type == CAPlaybackTimeline::Meta) {
+            metaCount++;
+        }
     }
-    b = (value >> 7) & 0x7f;
-    if (b || byteswritten) {
-        chunk.append(0x80 | b);
-        byteswritten = true;
+    trackChunks[0].reserve(trackChunks[0].size() + metaCount * 11 + 4); // delta time and the longest meta event
+
+    QHash<CAVoice*, int> voiceTrack;
+    for (int i = 0; i < sheet->contextList().size(); i++) {
+        if (sheet->contextList()[i]->contextType() != CAContext::Staff) {
+            continue;
+        }
+
+        CAStaff* staff = static_cast<CAStaff*>(sheet->contextList()[i]);
+        for (int j = 0; j < staff->voiceList().size(); j++) {
+            CAVoice* voice = staff->voiceList()[j];
+            setCurVoice(voice);
+            voiceTrack[voice] = addTrack(voice->name().isEmpty() ? staff->name() : voice->name(), messageCount.value(voice) * 7); // delta time and the message
+        }
     }
-    b = value & 0x7f;
-    chunk.append(b);
-    return chunk;
+
+    // each voice generates its own time and key signatures, write them only once
+    int lastMetaTime = -1;
+    QVector<quint64> lastMetas;
+
+    for (int i = 0; i < events.size(); i++) {
+        const CAPlaybackTimeline::CAEvent& e = events[i];
+        int time = timeOffset + e.time;
+
+        switch (e.type) {
+        case CAPlaybackTimeline::Message:
+            if (voiceTrack.contains(e.voice)) {
+                appendMessage(voiceTrack[e.voice], time, e.data, e.size);
+            }
+            break;
+        case CAPlaybackTimeline::Meta: {
+            quint64 meta = (static_cast<quint64>((e.data[0] << 16) | (e.data[1] << 8) | e.data[2]) << 32) | static_cast<quint32>(e.value);
+            if (time != lastMetaTime) {
+                lastMetaTime = time;
+                lastMetas.clear();
+            } else if (lastMetas.contains(meta)) {
+                break;
+            }
+            lastMetas << meta;
+            appendMetaEvent(0, time, static_cast<char>(e.data[0]), static_cast<char>(e.data[1]), static_cast<char>(e.data[2]), e.value);
+            break;
+        }
+        case CAPlaybackTimeline::PlayableOn:
+        case CAPlaybackTimeline::PlayableOff:
+            break;
+        }
+    }
+
+    return timeOffset + (events.isEmpty() ? 0 : events.last().time);
 }
 
-QByteArray CAMidiExport::writeTime(int time)
+/*!
+	Appends the delta time of the event at the given absolute \a time to the \a track.
+*/
+void CAMidiExport::appendDeltaTime(int track, int time)
 {
-    char b;
-    bool byteswritten = false;
-    QByteArray ba;
-
-    b = (time >> 3 * 7) & 0x7f;
-    if (b) {
-        ba.append(0x80 | b);
-        byteswritten = true;
+    int delta = 0;
+    if (time > trackTimes[track]) {
+        delta = time - trackTimes[track];
+        trackTimes[track] = time;
     }
-    b = (time >> 2 * 7) & 0x7f;
-    if (b || byteswritten) {
-        ba.append(0x80 | b);
-        byteswritten = true;
-    }
-    b = (time >> 7) & 0x7f;
-    if (b || byteswritten) {
-        ba.append(0x80 | b);
-        byteswritten = true;
+    appendVariableLengthValue(trackChunks[track], static_cast<quint32>(delta));
+}
+
+void CAMidiExport::appendMessage(int track, int time, const unsigned char* data, int size)
+{
+    appendDeltaTime(track, time);
+    trackChunks[track].append(reinterpret_cast<const char*>(data), size);
+}
+
+/*!
+	Appends the meta \a event at the given \a time to the \a track. Key and time signatures
+	are given by \a a and \a b, the tempo by \a value in microseconds per quarter note.
+*/
+void CAMidiExport::appendMetaEvent(int track, int time, char event, char a, char b, int value)
+{
+    QByteArray& chunk = trackChunks[track];
+
+    if (event == CAMidiDevice::Meta_Keysig) {
+        const char keysig[] = { static_cast<char>(CAMidiDevice::Midi_Ctl_Event), event, 2, a, b };
+        appendDeltaTime(track, time);
+        chunk.append(keysig, sizeof(keysig));
+    } else if (event == CAMidiDevice::Meta_Timesig) {
+        char lbBeat = 0;
+        for (; lbBeat < 5; lbBeat++) { // natural logarithm, smallest is 128th
+            if (1 << lbBeat >= b)
+                break;
+        }
+        const char timesig[] = { static_cast<char>(CAMidiDevice::Midi_Ctl_Event), event, 4, a, lbBeat, 18, 8 };
+        appendDeltaTime(track, time);
+        chunk.append(timesig, sizeof(timesig));
+    } else if (event == CAMidiDevice::Meta_Tempo) {
+        if (value <= 0) {
+            return;
+        }
+        int usPerQuarter = qMin(value, 0xFFFFFF); // 3 bytes
+        const char tempo[] = { static_cast<char>(CAMidiDevice::Midi_Ctl_Event), event, 3, static_cast<char>(usPerQuarter >> 16), static_cast<char>(usPerQuarter >> 8), static_cast<char>(usPerQuarter) };
+        appendDeltaTime(track, time);
+        chunk.append(tempo, sizeof(tempo));
     }
-    b = time & 0x7f;
-    ba.append(b);
-    return ba;
 }
 
-QByteArray CAMidiExport::trackEnd(void)
+/*!
+	Appends the text meta \a event (text, track name, marker etc.) with the given \a text.
+*/
+void CAMidiExport::appendTextEvent(int track, int time, char event, const QString& text)
 {
-    QByteArray tc;
-    tc.append(writeTime(0));
-    /// \todo replace with enum
-    tc.append(static_cast<char>(MIDI_CTL_EVENT));
-    tc.append(META_TRACK_END);
-    tc.append(static_cast<char>(0));
-    return tc;
+    QByteArray bytes = text.toUtf8();
+    appendDeltaTime(track, time);
+    trackChunks[track].append(static_cast<char>(CAMidiDevice::Midi_Ctl_Event));
+    trackChunks[track].append(event);
+    appendVariableLengthValue(trackChunks[track], static_cast<quint32>(bytes.size()));
+    trackChunks[track].append(bytes);
 }
 
-QByteArray CAMidiExport::textEvent(int time, QString s)
+/*!
+	Appends the \a value in the MIDI variable length quantity format to the \a chunk.
+*/
+void CAMidiExport::appendVariableLengthValue(QByteArray& chunk, quint32 value)
 {
-    QByteArray tc;
-    tc.append(writeTime(time));
-    /// \todo replace with enum
-    tc.append(static_cast<char>(MIDI_CTL_EVENT));
-    tc.append(META_TEXT);
-    tc.append(variableLengthValue(s.length()));
-    tc.append(s);
-    return tc;
+    char buffer[5];
+    int i = sizeof(buffer);
+    buffer[--i] = static_cast<char>(value & 0x7f);
+    while (value >>= 7) {
+        buffer[--i] = static_cast<char>(0x80 | (value & 0x7f));
+    }
+    chunk.append(buffer + i, static_cast<int>(sizeof(buffer)) - i);
 }
 
 /*!
-	Exports the current document to Lilypond syntax as a complete .ly file.
+	Exports the first sheet of the document or all the sheets, if exportAllSheets() is set.
 */
 void CAMidiExport::exportDocumentImpl(CADocument* doc)
 {
@@ -229,37 +279,17 @@ void CAMidiExport::exportDocumentImpl(CADocument* doc)
         return;
     }
 
-    // In the header chunk we need to know the count of tracks.
-    // We export every non empty voice as separate track.
-    // For now we export only the first sheet.
-    CASheet* sheet = doc->sheetList()[0];
-    setCurSheet(sheet);
-    trackChunk.clear();
-
-    // Let's playback this sheet and dump that into a file,
-    // and for this we have our own midi driver.
-    CAPlayback* _playback = new CAPlayback(sheet, this);
-    _playback->run();
-
-    int count = 0;
-    for (int c = 0; c < doc->sheetList()[0]->contextList().size(); ++c) {
-        switch (sheet->contextList()[c]->contextType()) {
-        case CAContext::Staff: {
-            // exportStaffVoices( static_cast<CAStaff*>(sheet->contextList()[c]) );
-            CAStaff* staff = static_cast<CAStaff*>(sheet->contextList()[c]);
-            for (int v = 0; v < staff->voiceList().size(); ++v) {
-                setCurVoice(staff->voiceList()[v]);
-                count++;
-                //std::cout << "Hallo  " << c << " " << v << "\n" << std::endl;
-            }
-            break;
-        }
-        case CAContext::ChordNameContext:
-            break; // TODO
-        case CAContext::LyricsContext:
-        case CAContext::FunctionMarkContext:
-        case CAContext::FiguredBassContext:
-            break;
+    clearTracks();
+    if (!exportAllSheets()) {
+        setCurSheet(doc->sheetList()[0]);
+        exportSheetTracks(doc->sheetList()[0], 0);
+    } else {
+        int time = 0;
+        for (int i = 0; i < doc->sheetList().size(); i++) {
+            CASheet* sheet = doc->sheetList()[i];
+            setCurSheet(sheet);
+            appendTextEvent(0, time, CAMidiDevice::Meta_Marker, sheet->name());
+            time = exportSheetTracks(sheet, time);
         }
     }
 
@@ -267,103 +297,48 @@ void CAMidiExport::exportDocumentImpl(CADocument* doc)
 }
 
 /*!
-	Exports the current document to Lilypond syntax as a complete .ly file.
+	Exports the given \a sheet.
 */
 void CAMidiExport::exportSheetImpl(CASheet* sheet)
 {
-    /*
-	if ( doc->sheetList().size() < 1 ) {
-		//TODO: no sheets, raise an error
-		return;
-	}
-
-
-	// In the header chunk we need to know the count of tracks.
-	// We export every non empty voice as separate track.
-	// For now we export only the first sheet.
-	CASheet *sheet = doc->sheetList()[ 0 ];
-*/
+    clearTracks();
     setCurSheet(sheet);
-    trackChunk.clear();
-
-    // Let's playback this sheet and dump that into a file,
-    // and for this we have our own midi driver.
-    CAPlayback* _playback = new CAPlayback(sheet, this);
-    _playback->run();
-
-    int count = 0;
-    for (int c = 0; c < sheet->contextList().size(); ++c) {
-        switch (sheet->contextList()[c]->contextType()) {
-        case CAContext::Staff: {
-            // exportStaffVoices( static_cast<CAStaff*>(sheet->contextList()[c]) );
-            CAStaff* staff = static_cast<CAStaff*>(sheet->contextList()[c]);
-            for (int v = 0; v < staff->voiceList().size(); ++v) {
-                setCurVoice(staff->voiceList()[v]);
-                count++;
-                //std::cout << "Hallo  " << c << " " << v << "\n" << std::endl;
-            }
-            break;
-        }
-        case CAContext::LyricsContext:
-        case CAContext::FunctionMarkContext:
-        case CAContext::FiguredBassContext:
-        case CAContext::ChordNameContext:
-            break;
-        }
-    }
+    exportSheetTracks(sheet, 0);
 
     writeFile();
 }
 
+/*!
+	Writes the header chunk and all the tracks to the device of the stream.
+*/
 void CAMidiExport::writeFile()
 {
+    QIODevice* device = stream() ? out().device() : nullptr;
+    if (!device) {
+        return;
+    }
 
-    QByteArray headerChunk;
-    headerChunk.append("MThd...."); // header and space for length
-    headerChunk.append(word16(1)); // Midi-Format version
-    headerChunk.append(word16(2)); // number of tracks, a control track and a music track for a trying out ...
-    /// \todo QByteArray does not support char values > 0x7f
-    headerChunk.append(word16(static_cast<char>(CAPlayableLength::playableLengthToTimeLength(CAPlayableLength::Quarter)))); // time division ticks per quarter
-    setChunkLength(&headerChunk);
-    streamQByteArray(headerChunk);
-
-    QByteArray controlTrackChunk;
-    controlTrackChunk.append("MTrk....");
-    controlTrackChunk.append(textEvent(0, QString("Canorus Version ") + CANORUS_VERSION + " generated. "));
-    controlTrackChunk.append(textEvent(0, "It's still a work in progress."));
-    controlTrackChunk.append(trackEnd());
-    setChunkLength(&controlTrackChunk);
-    streamQByteArray(controlTrackChunk);
-
-    // trackChunk is already filled with midi data,
-    // let's add chunk header, in reverse, ...
-    trackChunk.prepend("MTrk....");
-    // ... and add the tail:
-    trackChunk.append(trackEnd());
-    setChunkLength(&trackChunk);
-    streamQByteArray(trackChunk);
-}
-
-void CAMidiExport::setChunkLength(QByteArray* x)
-{
-    /// \todo QByteArray does not support char values > 0x7f
-    qint32 l = (*x).size() - 8; // subtract header length
-    for (int i = 0; i < 4; i++) {
-        (*x)[7 - i] = static_cast<char>((l >> (8 * i)));
+    int division = CAPlayableLength::playableLengthToTimeLength(CAPlayableLength::Quarter); // time division ticks per quarter
+    const char header[] = {
+        'M', 'T', 'h', 'd', 0, 0, 0, 6,
+        0, 1, // Midi-Format version
+        static_cast<char>(trackChunks.size() >> 8), static_cast<char>(trackChunks.size()), // number of tracks
+        static_cast<char>(division >> 8), static_cast<char>(division)
+    };
+    device->write(header, sizeof(header));
+
+    const char trackEnd[] = { 0, static_cast<char>(CAMidiDevice::Midi_Ctl_Event), CAMidiDevice::Meta_Track_End, 0 };
+    for (int i = 0; i < trackChunks.size(); i++) {
+        trackChunks[i].append(trackEnd, sizeof(trackEnd));
+        setChunkLength(trackChunks[i]);
+        device->write(trackChunks[i]);
     }
 }
 
-void CAMidiExport::streamQByteArray(QByteArray x)
+void CAMidiExport::setChunkLength(QByteArray& chunk)
 {
-    for (int i = 0; i < x.size(); i++) // here we pass binary data through QTextStream
-        out().device()->putChar(x[i]);
-
-#ifdef QT_DEBUG
-    for (int i = 0; i < x.size(); i++) {
-        printf(" %02x", 0x0ff & x.at(i));
+    qint32 l = chunk.size() - 8; // subtract header length
+    for (int i = 0; i < 4; i++) {
+        chunk[7 - i] = static_cast<char>((l >> (8 * i)));
     }
-    printf("\n");
-#endif
-
-    return; // when no debugging
 }
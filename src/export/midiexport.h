@@ -55,24 +55,26 @@ public:
 	// Setter methods are private!
 */
 
+    inline void setExportAllSheets(bool all) { _exportAllSheets = all; }
+    inline bool exportAllSheets() { return _exportAllSheets; }
+
 private:
-    QByteArray writeTime(int time);
     void exportDocumentImpl(CADocument* doc);
     void exportSheetImpl(CASheet* sheet);
-    int midiTrackCount;
-    QByteArray trackChunk; // for the time beeing we build one big track
-    int timeIncrement(int time);
-    int _trackTime; // which this is the time line for
-    QVector<QByteArray> trackChunks; // for the future
-    QVector<int> trackTimes;
-    void streamQByteArray(QByteArray x); // streaming binary data to midi file, possibly with print for debugging
-    QByteArray variableLengthValue(int value);
-    QByteArray word16(char x);
-    QByteArray textEvent(int time, QString s);
-    QByteArray trackEnd(void);
-    QByteArray timeSignature(void);
-    QByteArray keySignature(void);
-    void setChunkLength(QByteArray* x);
+    int exportSheetTracks(CASheet* sheet, int timeOffset);
+
+    int addTrack(const QString& name, int reserve = 0);
+    void appendMessage(int track, int time, const unsigned char* data, int size);
+    void appendMetaEvent(int track, int time, char event, char a, char b, int value = 0);
+    void appendTextEvent(int track, int time, char event, const QString& text);
+    void appendDeltaTime(int track, int time);
+    static void appendVariableLengthValue(QByteArray& chunk, quint32 value);
+    static void setChunkLength(QByteArray& chunk);
+    void clearTracks();
+
+    QVector<QByteArray> trackChunks; // control track first, then a track per voice
+    QVector<int> trackTimes; // time of the last event in each track
+    bool _exportAllSheets;
 
     /*
 
@@ -34,8 +34,7 @@ CADocument* CACanImport::importDocumentImpl()
         // Read the score
         CAIOPtr filePtr = arc->file("content.xml");
         CACanorusMLImport* content = new CACanorusMLImport(new QTextStream(&*filePtr));
-        content->importDocument();
-        content->wait();
+        content->importDocument(false); // already in the import thread
         CADocument* doc = content->importedDocument();
         delete content;
 
@@ -49,11 +48,11 @@ CADocument* CACanImport::importDocumentImpl()
             CAResource* r = doc->resourceList()[i];
             if (!r->isLinked()) {
                 // attached file - copy to /tmp
-                CAIOPtr rPtr = arc->file(r->url().toLocalFile()); // chop the two leading slashes
-                if (!dynamic_cast<QFile*>(&*rPtr)) {
+                if (!arc->contains(r->url().toLocalFile())) {
                     qCritical() << "CACanImport: Resource \"" << r->url().toLocalFile() << "\" not found in the file.";
                     continue;
                 }
+                CAIOPtr rPtr = arc->file(r->url().toLocalFile()); // chop the two leading slashes
 
                 QTemporaryFile* f = new QTemporaryFile(QDir::tempPath() + "/" + r->name());
                 f->open();
@@ -61,7 +60,12 @@ CADocument* CACanImport::importDocumentImpl()
                 f->close();
                 delete f;
 
-                static_cast<QFile*>(&*rPtr)->copy(targetFile);
+                QFile target(targetFile);
+                if (target.open(QIODevice::WriteOnly)) {
+                    while (!rPtr->atEnd())
+                        target.write(rPtr->read(16384));
+                    target.close();
+                }
                 r->setUrl(QUrl::fromLocalFile(targetFile));
             } else if (r->url().scheme() == "file" && file()) {
                 // linked local file - convert the relative path to absolute
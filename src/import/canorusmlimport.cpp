@@ -594,7 +594,7 @@ bool CACanorusMLImport::endElement(const QString&, const QString&, const QString
         CAMusElement* sign = nullptr;
         for (int i = 0; i < foundElts.size(); i++) {
             if (!foundElts[i]->compare(_curClef)) // element has exactly the same properties
-                if (!_curVoice->musElementList().contains(foundElts[i])) { // if such an element already exists, it means there are two different with the same timestart
+                if (_curVoice->musElementIndex(foundElts[i]) == -1) { // if such an element already exists, it means there are two different with the same timestart
                     sign = foundElts[i];
                     break;
                 }
@@ -629,7 +629,7 @@ bool CACanorusMLImport::endElement(const QString&, const QString&, const QString
         CAMusElement* sign = nullptr;
         for (int i = 0; i < foundElts.size(); i++) {
             if (!foundElts[i]->compare(_curKeySig)) // element has exactly the same properties
-                if (!_curVoice->musElementList().contains(foundElts[i])) { // if such an element already exists, it means there are two different with the same timestart
+                if (_curVoice->musElementIndex(foundElts[i]) == -1) { // if such an element already exists, it means there are two different with the same timestart
                     sign = foundElts[i];
                     break;
                 }
@@ -655,7 +655,7 @@ bool CACanorusMLImport::endElement(const QString&, const QString&, const QString
         CAMusElement* sign = nullptr;
         for (int i = 0; i < foundElts.size(); i++) {
             if (!foundElts[i]->compare(_curTimeSig)) // element has exactly the same properties
-                if (!_curVoice->musElementList().contains(foundElts[i])) { // if such an element already exists, it means there are two different with the same timestart
+                if (_curVoice->musElementIndex(foundElts[i]) == -1) { // if such an element already exists, it means there are two different with the same timestart
                     sign = foundElts[i];
                     break;
                 }
@@ -681,7 +681,7 @@ bool CACanorusMLImport::endElement(const QString&, const QString&, const QString
         CAMusElement* sign = nullptr;
         for (int i = 0; i < foundElts.size(); i++) {
             if (!foundElts[i]->compare(_curBarline)) // element has exactly the same properties
-                if (!_curVoice->musElementList().contains(foundElts[i])) { // if such an element already exists, it means there are two different with the same timestart
+                if (_curVoice->musElementIndex(foundElts[i]) == -1) { // if such an element already exists, it means there are two different with the same timestart
                     sign = foundElts[i];
                     break;
                 }
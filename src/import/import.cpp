@@ -88,7 +88,7 @@ CAImport::~CAImport()
 
 /*!
 	Extends CAFile::setStreamFromFile by storing the filename in a public variable
-	for use in the pmidi midi file parser.
+	for use in the MIDI file parser (see CAMidiFileParser).
 */
 void CAImport::setStreamFromFile(const QString filename)
 {
@@ -161,11 +161,18 @@ void CAImport::run()
     emit importDone(status());
 }
 
-void CAImport::importDocument()
+/*!
+	Imports the document in a new thread. If \a bStartThread is False, the document is imported
+	in the calling thread instead, eg. when already running in a worker thread.
+*/
+void CAImport::importDocument(bool bStartThread)
 {
     setImportPart(Document);
     setStatus(1); // process started
-    start();
+    if (bStartThread)
+        start();
+    else
+        run();
 }
 
 void CAImport::importSheet()
@@ -30,7 +30,7 @@ public:
     QString fileName();
 
     virtual const QString readableStatus();
-    void importDocument();
+    void importDocument(bool bStartThread = true);
     void importSheet();
     void importStaff();
     void importVoice();
@@ -17,27 +17,6 @@
 #include "score/sheet.h"
 #include "score/slur.h"
 
-/*!
-	Delimiters which separate various music elements in LilyPond syntax. These are new lines, tabs, blanks etc.
-
-	\sa nextElement(), parseNextElement()
-*/
-const QRegExp CALilyPondImport::WHITESPACE_DELIMITERS = QRegExp("[\\s]");
-
-/*!
-	Delimiters which separate various music elements in LilyPond syntax, but are specific for LilyPond syntax.
-	They are reported as its own element when parsing the next element.
-
-	\sa nextElement(), parseNextElement()
-*/
-const QRegExp CALilyPondImport::SYNTAX_DELIMITERS = QRegExp("[<>{}]");
-
-/*!
-	Combined WHITESPACE_DELIMITERS and SYNTAX_DELIMITERS.
-*/
-const QRegExp CALilyPondImport::DELIMITERS = QRegExp(
-    CALilyPondImport::WHITESPACE_DELIMITERS.pattern().left(CALilyPondImport::WHITESPACE_DELIMITERS.pattern().size() - 1) + CALilyPondImport::SYNTAX_DELIMITERS.pattern().mid(1));
-
 CALilyPondImport::CALilyPondImport(const QString in)
     : CAImport(in)
 {
@@ -64,6 +43,9 @@ CALilyPondImport::~CALilyPondImport()
 void CALilyPondImport::initLilyPondImport()
 {
     _curLine = _curChar = 0;
+    _pos = 0;
+    _line = 1;
+    _lineStart = 0;
     _curSlur = nullptr;
     _curPhrasingSlur = nullptr;
     _templateVoice = nullptr;
@@ -98,7 +80,7 @@ CASheet* CALilyPondImport::importSheetImpl()
     bool changed = false;
 
     for (QString curElt = parseNextElement();
-         (!in().isEmpty());
+         (!atEnd());
          curElt = ((curElt.size() && changed) ? curElt : parseNextElement())) { // go to next element, if current one is empty or not changed
         if (curElt.startsWith("\\header")) {
             std::cout << "lilyimport header" << std::endl;
@@ -125,7 +107,7 @@ CAVoice* CALilyPondImport::importVoiceImpl()
     bool changed = false;
 
     for (QString curElt = parseNextElement();
-         (!in().isEmpty());
+         (!atEnd());
          curElt = ((curElt.size() && changed) ? curElt : parseNextElement())) { // go to next element, if current one is empty or not changed
         changed = true; // changed is default to true and false, if none of if clauses were found
         if (curElt.startsWith("\\relative")) {
@@ -354,7 +336,7 @@ CALyricsContext* CALilyPondImport::importLyricsContextImpl()
 
     CASyllable* lastSyllable = nullptr;
     int timeSDummy = 0; // dummy timestart to keep the order of inserted syllables. Real timeStarts are sets when repositSyllables() is called
-    for (QString curElt = parseNextElement(); (!in().isEmpty() || !curElt.isEmpty()); curElt = parseNextElement(), timeSDummy++) {
+    for (QString curElt = parseNextElement(); (!atEnd() || !curElt.isEmpty()); curElt = parseNextElement(), timeSDummy++) {
         QString text = curElt;
         if (curElt == "_")
             text = "";
@@ -384,87 +366,103 @@ CALyricsContext* CALilyPondImport::importLyricsContextImpl()
 }
 
 /*!
-	Returns the first element in input stream ended with one of the delimiters and shorten input stream for the element.
+	Returns the next element in the input and moves the lexer after it.
+
+	Elements are separated by whitespace. Syntax delimiters (<, >, { and }) are elements on their
+	own. Comments are skipped. The input is never modified. The lexer only keeps the position in
+	the input, so parsing the whole input takes linear time. The line and the column of the
+	returned element are stored in curLine() and curChar() for the error reports.
 
 	\todo Only one-character syntax delimiters are supported so far.
 	\sa peekNextElement()
 */
 const QString CALilyPondImport::parseNextElement()
 {
-    // find the first non-whitespace character
-    int start = in().indexOf(QRegExp("\\S"));
-    if (start == -1) {
-        start = 0;
-    } else if (in().mid(start, 1) == "%") {
-        // handle comments
-        start = in().indexOf(QRegExp("[\n\r]"), start);
-        if (start == -1) {
-            start = in().size();
-        } else {
-            start = in().indexOf(QRegExp("\\S"), start);
-            if (start == -1) {
-                start = in().size();
-            }
-        }
-    }
-
-    int i = in().indexOf(DELIMITERS, start);
-    if (i == -1) {
-        i = in().size();
-    }
-
-    QString ret;
-    if (i == start) {
-        // syntax delimiter only
-        ret = in().mid(start, 1); /// \todo Support for syntax delimiters longer than 1 character
-        in().remove(0, start + 1);
-    } else {
-        // ordinary whitespace/syntax delimiter
-        ret = in().mid(start, i - start);
-        in().remove(0, i);
-    }
-
-    return ret;
+    int line = _line;
+    int lineStart = _lineStart;
+    int start = skipWhitespace(_pos, line, lineStart);
+    int end = elementEnd(start);
+
+    _curLine = line;
+    _curChar = start - lineStart + 1;
+    _line = line;
+    _lineStart = lineStart;
+    _pos = end;
+
+    return in().mid(start, end - start);
 }
 
 /*!
-	Returns the first element in input stream ended with one of the delimiters but don't shorten the stream.
+	Returns the next element in the input but doesn't move the lexer.
 
 	\sa parseNextElement()
 */
 const QString CALilyPondImport::peekNextElement()
 {
-    // find the first non-whitespace character
-    int start = in().indexOf(QRegExp("\\S"));
-    if (start == -1) {
-        start = 0;
-    } else if (in().mid(start, 1) == "%") {
-        // handle comments
-        start = in().indexOf(QRegExp("[\n\r]"), start);
-        if (start == -1) {
-            start = in().size();
-        } else {
-            start = in().indexOf(QRegExp("\\S"), start);
-            if (start == -1) {
-                start = in().size();
+    int line = _line;
+    int lineStart = _lineStart;
+    int start = skipWhitespace(_pos, line, lineStart);
+
+    return in().mid(start, elementEnd(start) - start);
+}
+
+/*!
+	Returns the position of the first character after the whitespace and comments starting at
+	\a pos. Increases \a line for each skipped new line and sets \a lineStart to the position
+	of the first character of the last line.
+*/
+int CALilyPondImport::skipWhitespace(int pos, int& line, int& lineStart)
+{
+    const QString& input = in();
+    const int size = input.size();
+
+    while (pos < size) {
+        QChar c = input.at(pos);
+        if (c == '\n') {
+            line++;
+            lineStart = ++pos;
+        } else if (c.isSpace()) {
+            pos++;
+        } else if (c == '%' && pos + 1 < size && input.at(pos + 1) == '{') {
+            // block comment until %}
+            for (pos += 2; pos < size && !(input.at(pos) == '}' && input.at(pos - 1) == '%'); pos++) {
+                if (input.at(pos) == '\n') {
+                    line++;
+                    lineStart = pos + 1;
+                }
+            }
+            pos++;
+        } else if (c == '%') {
+            // line comment, the new line is counted above
+            while (pos < size && input.at(pos) != '\n' && input.at(pos) != '\r') {
+                pos++;
             }
+        } else {
+            break;
         }
     }
 
-    int i = in().indexOf(DELIMITERS, start);
-    if (i == -1)
-        i = in().size();
-
-    QString ret;
-    if (i == start) {
-        // syntax delimiter only
-        ret = in().left(1); /// \todo
-    } else {
-        // ordinary whitespace/syntax delimiter
-        ret = in().mid(start, i - start);
+    return qMin(pos, size);
+}
+
+/*!
+	Returns the position after the end of the element starting at \a start.
+*/
+int CALilyPondImport::elementEnd(int start)
+{
+    const QString& input = in();
+    const int size = input.size();
+
+    if (start < size && isSyntaxDelimiter(input.at(start))) {
+        return start + 1; /// \todo Support for syntax delimiters longer than 1 character
+    }
+
+    int end = start;
+    while (end < size && !input.at(end).isSpace() && !isSyntaxDelimiter(input.at(end))) {
+        end++;
     }
 
-    return ret;
+    return end;
 }
 
 /*!
@@ -491,7 +489,7 @@ CAMusElement* CALilyPondImport::findSharedElement(CAMusElement* elt)
     // compare gathered music elements properties
     for (int i = 0; i < foundElts.size(); i++)
         if (!foundElts[i]->compare(elt)) // element has exactly the same properties
-            if (!curVoice()->musElementList().contains(foundElts[i])) // element isn't present in the voice yet
+            if (curVoice()->musElementIndex(foundElts[i]) == -1) // element isn't present in the voice yet
                 return foundElts[i];
 
     return nullptr;
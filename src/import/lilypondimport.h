@@ -47,9 +47,7 @@ public:
 private:
     void initLilyPondImport();
 
-    static const QRegExp WHITESPACE_DELIMITERS;
-    static const QRegExp SYNTAX_DELIMITERS;
-    static const QRegExp DELIMITERS;
+    static inline bool isSyntaxDelimiter(QChar c) { return c == '<' || c == '>' || c == '{' || c == '}'; }
 
     // Internal time signature
     struct CATime {
@@ -73,6 +71,9 @@ private:
 
     const QString parseNextElement();
     const QString peekNextElement();
+    int skipWhitespace(int pos, int& line, int& lineStart);
+    int elementEnd(int start);
+    inline bool atEnd() { return _pos >= in().size(); }
     void addError(QString description, int lineError = 0, int charError = 0);
 
     //////////////////////
@@ -107,7 +108,9 @@ private:
     CASlur* _curSlur;
     CASlur* _curPhrasingSlur;
     QStack<CALilyPondDepth> _depth; // which block is currently processed
-    int _curLine, _curChar;
+    int _curLine, _curChar; // location of the last parsed element
+    int _pos; // position of the lexer in the input
+    int _line, _lineStart; // line number at _pos and the position of its first character
     QList<QString> _errors;
     QList<QString> _warnings;
 
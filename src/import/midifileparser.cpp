@@ -0,0 +1,286 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QFile>
+#include <QIODevice>
+#include <QObject>
+
+#include <algorithm>
+
+#include "import/midifileparser.h"
+
+/*!
+	\class CAMidiFileParser
+	\brief Standard MIDI file parser
+
+	Reads a standard MIDI file (format 0, 1 or 2) from memory and generates a single array of
+	events of all the tracks sorted by their time. Note on and note off messages are paired into
+	a single Note event with the length of the note, the same way pmidi did: a note off finishes
+	the last started note with the same pitch on the same channel and the notes still sounding
+	at the end of the track are finished there.
+
+	All the state is kept in the parser object, so several files can be parsed at the same time
+	from different threads, each with its own parser. Files are memory mapped when possible
+	(see parse(QIODevice*)), so the file isn't copied before parsing.
+
+	Only the events the MIDI import uses are stored. Text, SysEx, key pressure and channel
+	pressure events are skipped.
+
+	\sa CAMidiImport
+*/
+
+CAMidiFileParser::CAMidiFileParser()
+{
+    clear();
+}
+
+/*!
+	Removes all the events and resets the file properties.
+*/
+void CAMidiFileParser::clear()
+{
+    _events.clear();
+    _pendingNotes.clear();
+    _format = 0;
+    _tracks = 0;
+    _timeBase = 0;
+    _errorString.clear();
+}
+
+/*!
+	Opens the file \a fileName and parses it.
+	Returns True on success. Otherwise, see errorString().
+*/
+bool CAMidiFileParser::parseFile(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        clear();
+        return setError(QObject::tr("Cannot open file %1: %2").arg(fileName).arg(file.errorString()));
+    }
+
+    return parse(&file);
+}
+
+/*!
+	Parses the MIDI file from the opened \a device.
+	Files are memory mapped, other devices are read in a single block.
+*/
+bool CAMidiFileParser::parse(QIODevice* device)
+{
+    QFile* file = qobject_cast<QFile*>(device);
+    if (file && file->isOpen() && file->size() > 0) {
+        uchar* data = file->map(0, file->size());
+        if (data) {
+            bool ok = parse(data, file->size());
+            file->unmap(data);
+            return ok;
+        }
+    }
+
+    QByteArray data = device->readAll();
+    return parse(reinterpret_cast<const unsigned char*>(data.constData()), data.size());
+}
+
+/*!
+	Parses the MIDI file in the buffer \a data of the given \a size.
+	Returns True on success. Otherwise, see errorString().
+*/
+bool CAMidiFileParser::parse(const unsigned char* data, qint64 size)
+{
+    clear();
+
+    if (size < 14 || qstrncmp(reinterpret_cast<const char*>(data), "MThd", 4)) {
+        return setError(QObject::tr("Not a standard MIDI file."));
+    }
+
+    qint64 headerLength = (static_cast<qint64>(data[4]) << 24) | (data[5] << 16) | (data[6] << 8) | data[7];
+    if (headerLength < 6 || 8 + headerLength > size) {
+        return setError(QObject::tr("Corrupted MIDI file header."));
+    }
+
+    _format = (data[8] << 8) | data[9];
+    _tracks = (data[10] << 8) | data[11];
+    int division = (data[12] << 8) | data[13];
+    if (division & 0x8000) {
+        // SMPTE frames per second and ticks per frame, take it as a quarter at 120 bpm
+        _timeBase = qMax(1, (-static_cast<signed char>(division >> 8)) * (division & 0xff) / 2);
+    } else {
+        _timeBase = qMax(1, division);
+    }
+
+    _events.reserve(static_cast<int>(size / 4)); // a channel event takes at least 3 bytes plus the delta time
+
+    qint64 pos = 8 + headerLength;
+    while (pos + 8 <= size) {
+        const unsigned char* chunk = data + pos;
+        qint64 length = (static_cast<qint64>(chunk[4]) << 24) | (chunk[5] << 16) | (chunk[6] << 8) | chunk[7];
+        length = qMin(length, size - pos - 8); // be tolerant to truncated files
+
+        if (!qstrncmp(reinterpret_cast<const char*>(chunk), "MTrk", 4)) {
+            if (!parseTrack(chunk + 8, length)) {
+                return false;
+            }
+        }
+
+        pos += 8 + length;
+    }
+
+    // merge the tracks, events at the same time keep the order of the tracks
+    std::stable_sort(_events.begin(), _events.end(), [](const CAMidiEvent& a, const CAMidiEvent& b) { return a.time < b.time; });
+
+    return true;
+}
+
+/*!
+	Parses the track chunk \a data of the given \a size and appends its events.
+*/
+bool CAMidiFileParser::parseTrack(const unsigned char* data, qint64 size)
+{
+    qint64 pos = 0;
+    int time = 0;
+    unsigned char runningStatus = 0;
+    _pendingNotes.clear();
+
+    while (pos < size) {
+        qint64 delta = readVariableLength(data, size, pos);
+        if (delta < 0 || pos >= size) {
+            break;
+        }
+        time += static_cast<int>(delta);
+
+        unsigned char status = data[pos];
+        if (status & 0x80) {
+            pos++;
+        } else if (runningStatus) {
+            status = runningStatus;
+        } else {
+            return setError(QObject::tr("Corrupted MIDI track: data byte without status."));
+        }
+
+        if (status == 0xff) { // meta event
+            if (pos >= size) {
+                break;
+            }
+            unsigned char type = data[pos++];
+            qint64 length = readVariableLength(data, size, pos);
+            if (length < 0 || pos + length > size) {
+                break;
+            }
+            const unsigned char* meta = data + pos;
+            pos += length;
+
+            if (type == 0x2f) { // end of track
+                break;
+            } else if (type == 0x51 && length >= 3) {
+                addEvent(Tempo, time, 0, 0, 0, (meta[0] << 16) | (meta[1] << 8) | meta[2]);
+            } else if (type == 0x58 && length >= 2) {
+                addEvent(TimeSignature, time, 0, meta[0], static_cast<unsigned char>(1 << qMin(static_cast<int>(meta[1]), 7)));
+            } else if (type == 0x59 && length >= 2) {
+                addEvent(KeySignature, time, 0, meta[0], meta[1] ? 1 : 0);
+            }
+        } else if (status == 0xf0 || status == 0xf7) { // SysEx
+            qint64 length = readVariableLength(data, size, pos);
+            if (length < 0 || pos + length > size) {
+                break;
+            }
+            pos += length;
+        } else if (status >= 0xf0) {
+            return setError(QObject::tr("Corrupted MIDI track: unknown status %1.").arg(static_cast<int>(status), 0, 16));
+        } else { // channel message
+            runningStatus = status;
+            unsigned char channel = status & 0x0f;
+            int dataLength = ((status & 0xf0) == 0xc0 || (status & 0xf0) == 0xd0) ? 1 : 2;
+            if (pos + dataLength > size) {
+                break;
+            }
+            unsigned char data1 = data[pos] & 0x7f;
+            unsigned char data2 = dataLength == 2 ? data[pos + 1] & 0x7f : 0;
+            pos += dataLength;
+
+            switch (status & 0xf0) {
+            case 0x80:
+                finishNote(time, channel, data1);
+                break;
+            case 0x90:
+                if (data2) {
+                    addEvent(Note, time, channel, data1, data2);
+                    _pendingNotes << _events.size() - 1;
+                } else {
+                    finishNote(time, channel, data1);
+                }
+                break;
+            case 0xb0:
+                addEvent(Control, time, channel, data1, data2);
+                break;
+            case 0xc0:
+                addEvent(Program, time, channel, data1, 0);
+                break;
+            case 0xe0:
+                addEvent(PitchBend, time, channel, 0, 0, ((data2 << 7) | data1) - 8192);
+                break;
+            default: // key and channel pressure
+                break;
+            }
+        }
+    }
+
+    // finish the notes still sounding at the end of the track
+    while (!_pendingNotes.isEmpty()) {
+        const CAMidiEvent& note = _events[_pendingNotes.last()];
+        finishNote(time, note.channel, note.data1);
+    }
+
+    return true;
+}
+
+/*!
+	Reads the variable length value at \a pos of the \a data and moves \a pos after it.
+	Returns -1 at the end of the data.
+*/
+qint64 CAMidiFileParser::readVariableLength(const unsigned char* data, qint64 size, qint64& pos)
+{
+    qint64 value = 0;
+    for (int i = 0; i < 4; i++) {
+        if (pos >= size) {
+            return -1;
+        }
+        unsigned char b = data[pos++];
+        value = (value << 7) | (b & 0x7f);
+        if (!(b & 0x80)) {
+            break;
+        }
+    }
+    return value;
+}
+
+void CAMidiFileParser::addEvent(CAMidiEventType type, int time, unsigned char channel, unsigned char data1, unsigned char data2, int value)
+{
+    CAMidiEvent e = { time, 0, value, static_cast<unsigned char>(type), channel, data1, data2 };
+    _events << e;
+}
+
+/*!
+	Sets the length of the last started note with the given \a pitch on the \a channel.
+*/
+void CAMidiFileParser::finishNote(int time, unsigned char channel, unsigned char pitch)
+{
+    for (int i = _pendingNotes.size() - 1; i >= 0; i--) {
+        CAMidiEvent& note = _events[_pendingNotes[i]];
+        if (note.channel == channel && note.data1 == pitch) {
+            note.length = qMax(0, time - note.time);
+            _pendingNotes.remove(i);
+            return;
+        }
+    }
+}
+
+bool CAMidiFileParser::setError(const QString& error)
+{
+    _errorString = error;
+    return false;
+}
@@ -0,0 +1,66 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#ifndef MIDIFILEPARSER_H_
+#define MIDIFILEPARSER_H_
+
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+class CAMidiFileParser {
+public:
+    enum CAMidiEventType {
+        Note, // data1 is the pitch, data2 the velocity, length in ticks
+        Control, // data1 is the controller number, data2 the value
+        Program, // data1 is the program number
+        PitchBend, // value is the pitch bend from -8192 to 8191
+        Tempo, // value is the number of microseconds per quarter
+        TimeSignature, // data1 is the numerator, data2 the denominator
+        KeySignature // data1 is the number of accidentals (signed), data2 is 1 for minor keys
+    };
+
+    struct CAMidiEvent {
+        int time; // in ticks, see timeBase()
+        int length;
+        int value;
+        unsigned char type;
+        unsigned char channel;
+        unsigned char data1;
+        unsigned char data2;
+    };
+
+    CAMidiFileParser();
+
+    bool parse(const unsigned char* data, qint64 size);
+    bool parse(QIODevice* device);
+    bool parseFile(const QString& fileName);
+    void clear();
+
+    inline const QVector<CAMidiEvent>& events() const { return _events; }
+    inline int format() const { return _format; }
+    inline int tracks() const { return _tracks; }
+    inline int timeBase() const { return _timeBase; }
+    inline const QString& errorString() const { return _errorString; }
+
+private:
+    bool parseTrack(const unsigned char* data, qint64 size);
+    static qint64 readVariableLength(const unsigned char* data, qint64 size, qint64& pos);
+    void addEvent(CAMidiEventType type, int time, unsigned char channel, unsigned char data1, unsigned char data2, int value = 0);
+    void finishNote(int time, unsigned char channel, unsigned char pitch);
+    bool setError(const QString& error);
+
+    QVector<CAMidiEvent> _events;
+    QVector<int> _pendingNotes; // indices of the notes waiting for their note off
+    int _format;
+    int _tracks;
+    int _timeBase;
+    QString _errorString;
+};
+
+#endif /* MIDIFILEPARSER_H_ */
@@ -8,6 +8,7 @@
 #include <QTextStream>
 //#include <QRegExp>
 #include <QFileInfo>
+#include <QIODevice>
 
 #include <iomanip>
 #include <iostream> // DEBUG
@@ -26,7 +27,7 @@
 #include "score/tempo.h"
 #include "score/timesignature.h"
 
-#include "import/pmidi/wrapper.h"
+#include "import/midifileparser.h"
 
 // Note Reinhard Padding Size with 3 bytes to alignment boundary due to "bool" member
 class CAMidiImportEvent {
@@ -112,10 +113,12 @@ CADocument* CAMidiImport::importDocumentImpl()
 CASheet* CAMidiImport::importSheetImpl()
 {
     CASheet* sheet = new CASheet(tr("Midi imported sheet"), _document);
-    sheet = importSheetImplPmidiParser(sheet);
+    sheet = importSheetImplMidiParser(sheet);
     // Show filename as sheet name. The tr() string above should only be changed after a release.
-    QFileInfo fi(fileName());
-    sheet->setName(fi.baseName());
+    if (!fileName().isEmpty()) {
+        QFileInfo fi(fileName());
+        sheet->setName(fi.baseName());
+    }
     return sheet;
 }
 
@@ -157,11 +160,10 @@ QList<QList<CAMidiNote*>> CAMidiImport::importMidiNotes()
 }
 
 /*!
-	The midi file is opened by calling the pmidi wrapper function \a pmidi_open_midi_file(), then,
-	in a polling loop, the wrapper function pmidi_parse_midi_file() brings out the relevant midi events
-	which are stored in the array _allChannelsEvents[].
+	The midi file is read from the device of the stream (usually a memory mapped file) and parsed
+	by CAMidiFileParser into a time sorted list of events, which are then
+	stored in the array _allChannelsEvents[].
 	All time signatures are stored in the array _allChannelsTimeSignatures[].
-	The work of pmidi and the wrapper is done then.
 
 	All time values are scaled here to canorus' own music time scale.
 
@@ -169,97 +171,84 @@ QList<QList<CAMidiNote*>> CAMidiImport::importMidiNotes()
 */
 void CAMidiImport::importMidiEvents()
 {
-    QByteArray s;
-    s.append(fileName());
-    pmidi_open_midi_file(s.constData());
+    // parse the device of the stream, the file name is only known when imported by setStreamFromFile()
+    CAMidiFileParser parser;
+    QIODevice* device = stream() ? stream()->device() : nullptr;
+    if (!(device ? parser.parse(device) : parser.parseFile(fileName()))) {
+        addError(parser.errorString());
+        return;
+    }
+
     int voiceIndex;
-    int res = PMIDI_STATUS_DUMMY;
     const int quarterLength = CAPlayableLength::playableLengthToTimeLength(CAPlayableLength::Quarter);
     int programCache[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    int microTempo = 60000000 / 120; // default tempo
     CADiatonicKey dk;
     bool leftOverNote;
     bool chordNote;
     bool timeSigAlreadyThere;
 
     setStatus(2);
-    for (; res != PMIDI_STATUS_END;) {
-
-        res = pmidi_parse_midi_file();
+    const QVector<CAMidiFileParser::CAMidiEvent>& events = parser.events();
+    for (int e = 0; e < events.size(); e++) {
+        const CAMidiFileParser::CAMidiEvent& event = events[e];
 
         // Scale music time properly
-        pmidi_out.time = (pmidi_out.time * quarterLength) / pmidi_out.time_base;
-        pmidi_out.length = (pmidi_out.length * quarterLength) / pmidi_out.time_base;
+        int time = static_cast<int>((static_cast<qint64>(event.time) * quarterLength) / parser.timeBase());
+        int length = static_cast<int>((static_cast<qint64>(event.length) * quarterLength) / parser.timeBase());
+        int chan = event.channel;
 
         //
         // Quantization on hundredtwentyeighths of time starts and lengths by zeroing the msbits, quant being always a power of two
         //
         const int quant = CAPlayableLength::playableLengthToTimeLength(CAPlayableLength::HundredTwentyEighth /* CAPlayableLength::SixtyFourth */);
-        int lengthEnd = pmidi_out.time + pmidi_out.length;
-        pmidi_out.time += quant / 2; // rounding
-        pmidi_out.time &= ~(quant - 1); // quant is power of two
+        int lengthEnd = time + length;
+        time += quant / 2; // rounding
+        time &= ~(quant - 1); // quant is power of two
         lengthEnd += quant / 2;
         lengthEnd &= ~(quant - 1);
-        pmidi_out.length = lengthEnd - pmidi_out.time;
-
-        switch (res) {
-        case PMIDI_STATUS_END:
-        case PMIDI_STATUS_VERSION:
-            break;
-        case PMIDI_STATUS_TEXT:
-            //			std::cout<<" at "<<pmidi_out.time<<" type "<<pmidi_out.type<<" ("<<pmidi_out.name<<")         "<< pmidi_out.text<<std::endl;
-            break;
-        case PMIDI_STATUS_TIMESIG:
-            //			std::cout<<" Timesig "<<pmidi_out.top
-            //					<<"/"<<pmidi_out.bottom
-            //					<<" at "<<pmidi_out.time
-            //					<<std::endl;
+        length = lengthEnd - time;
 
+        switch (event.type) {
+        case CAMidiFileParser::TimeSignature:
             // We build the list of time signatures. We assume they are ordered in time.
             // We don't allow doublets to sneak in.
             timeSigAlreadyThere = false;
             for (int i = 0; i < _allChannelsTimeSignatures.size(); i++) {
-                if (_allChannelsTimeSignatures[i]->_time == pmidi_out.time && _allChannelsTimeSignatures[i]->_top == pmidi_out.top && _allChannelsTimeSignatures[i]->_bottom == pmidi_out.bottom)
+                if (_allChannelsTimeSignatures[i]->_time == time && _allChannelsTimeSignatures[i]->_top == event.data1 && _allChannelsTimeSignatures[i]->_bottom == event.data2)
                     timeSigAlreadyThere = true;
             }
             if (timeSigAlreadyThere)
                 break;
             // If at the same last time another signature comes in the latter one wins.
-            if (!_allChannelsTimeSignatures.size() || _allChannelsTimeSignatures[_allChannelsTimeSignatures.size() - 1]->_time != pmidi_out.time) {
+            if (!_allChannelsTimeSignatures.size() || _allChannelsTimeSignatures[_allChannelsTimeSignatures.size() - 1]->_time != time) {
                 // Normal detection of time signature, store it.
-                _allChannelsTimeSignatures << new CAMidiImportEvent(true, 0, 0, 0, pmidi_out.time, 0, 0);
-                _allChannelsTimeSignatures[_allChannelsTimeSignatures.size() - 1]->_top = pmidi_out.top;
-                _allChannelsTimeSignatures[_allChannelsTimeSignatures.size() - 1]->_bottom = pmidi_out.bottom;
+                _allChannelsTimeSignatures << new CAMidiImportEvent(true, 0, 0, 0, time, 0, 0);
+                _allChannelsTimeSignatures[_allChannelsTimeSignatures.size() - 1]->_top = event.data1;
+                _allChannelsTimeSignatures[_allChannelsTimeSignatures.size() - 1]->_bottom = event.data2;
             } else {
                 // overwrite the last one with new values
-                _allChannelsTimeSignatures[_allChannelsTimeSignatures.size() - 1]->_top = pmidi_out.top;
-                _allChannelsTimeSignatures[_allChannelsTimeSignatures.size() - 1]->_bottom = pmidi_out.bottom;
+                _allChannelsTimeSignatures[_allChannelsTimeSignatures.size() - 1]->_top = event.data1;
+                _allChannelsTimeSignatures[_allChannelsTimeSignatures.size() - 1]->_bottom = event.data2;
             }
             break;
-        case PMIDI_STATUS_TEMPO:
-            //			std::cout<<" Tempo "<<pmidi_out.micro_tempo
-            //				<<"  at "<<pmidi_out.time
-            //				<<std::endl;
+        case CAMidiFileParser::Tempo:
+            if (event.value > 0) {
+                microTempo = event.value;
+            }
             break;
-        case PMIDI_STATUS_NOTE:
-            /*
-			std::cout<<" at "<<pmidi_out.time
-				<<"  chan "<<pmidi_out.chan
-				<<" note "<<pmidi_out.note
-				<<" vel "<<pmidi_out.vel
-				<<" len "<<pmidi_out.length<<std::endl;
-			*/
-
+        case CAMidiFileParser::Note:
             // Deal with unfinished notes. This is a note that get's keyed when the old same pitch note is not yet expired.
-            // Pmidi does a printf message with those. We adjust the length and next time of the original note according
-            // the new event, and we don't create a new note in our list.
+            // We adjust the length and next time of the original note according the new event, and we don't create
+            // a new note in our list.
             leftOverNote = false;
-            for (voiceIndex = 0; !leftOverNote && voiceIndex < _allChannelsEvents[pmidi_out.chan]->size(); voiceIndex++) {
+            for (voiceIndex = 0; !leftOverNote && voiceIndex < _allChannelsEvents[chan]->size(); voiceIndex++) {
 
-                if (_allChannelsEvents[pmidi_out.chan]->at(voiceIndex)->size()) {
-                    if (pmidi_out.time < _allChannelsEvents[pmidi_out.chan]->at(voiceIndex)->back()->_nextTime && _allChannelsEvents[pmidi_out.chan]->at(voiceIndex)->back()->_pitchList.indexOf(pmidi_out.note) >= 0) {
+                if (_allChannelsEvents[chan]->at(voiceIndex)->size()) {
+                    if (time < _allChannelsEvents[chan]->at(voiceIndex)->back()->_nextTime && _allChannelsEvents[chan]->at(voiceIndex)->back()->_pitchList.indexOf(event.data1) >= 0) {
 
-                        _allChannelsEvents[pmidi_out.chan]->at(voiceIndex)->back()->_length = pmidi_out.time - _allChannelsEvents[pmidi_out.chan]->at(voiceIndex)->back()->_time + pmidi_out.length;
-                        _allChannelsEvents[pmidi_out.chan]->at(voiceIndex)->back()->_nextTime = _allChannelsEvents[pmidi_out.chan]->at(voiceIndex)->back()->_time + _allChannelsEvents[pmidi_out.chan]->at(voiceIndex)->back()->_length;
+                        _allChannelsEvents[chan]->at(voiceIndex)->back()->_length = time - _allChannelsEvents[chan]->at(voiceIndex)->back()->_time + length;
+                        _allChannelsEvents[chan]->at(voiceIndex)->back()->_nextTime = _allChannelsEvents[chan]->at(voiceIndex)->back()->_time + _allChannelsEvents[chan]->at(voiceIndex)->back()->_length;
                         leftOverNote = true;
                     }
                 }
@@ -267,14 +256,14 @@ void CAMidiImport::importMidiEvents()
 
             // Check for building a chord
             chordNote = false;
-            for (voiceIndex = 0; !leftOverNote && !chordNote && voiceIndex < _allChannelsEvents[pmidi_out.chan]->size(); voiceIndex++) {
-                for (int i = _allChannelsEvents[pmidi_out.chan]->at(voiceIndex)->size() - 1; i >= 0; i--) {
+            for (voiceIndex = 0; !leftOverNote && !chordNote && voiceIndex < _allChannelsEvents[chan]->size(); voiceIndex++) {
+                for (int i = _allChannelsEvents[chan]->at(voiceIndex)->size() - 1; i >= 0; i--) {
                     // finish chord search when start is too early
-                    if (_allChannelsEvents[pmidi_out.chan]->at(voiceIndex)->at(i)->_time < pmidi_out.time)
+                    if (_allChannelsEvents[chan]->at(voiceIndex)->at(i)->_time < time)
                         break;
-                    if (_allChannelsEvents[pmidi_out.chan]->at(voiceIndex)->at(i)->_time == pmidi_out.time && _allChannelsEvents[pmidi_out.chan]->at(voiceIndex)->at(i)->_length == pmidi_out.length) {
+                    if (_allChannelsEvents[chan]->at(voiceIndex)->at(i)->_time == time && _allChannelsEvents[chan]->at(voiceIndex)->at(i)->_length == length) {
 
-                        _allChannelsEvents[pmidi_out.chan]->at(voiceIndex)->at(i)->_pitchList << pmidi_out.note;
+                        _allChannelsEvents[chan]->at(voiceIndex)->at(i)->_pitchList << event.data1;
                         chordNote = true;
                     }
                 }
@@ -283,67 +272,42 @@ void CAMidiImport::importMidiEvents()
             // Get note to the right voice
             for (voiceIndex = 0; !leftOverNote && !chordNote && voiceIndex < 30; voiceIndex++) { // we can't imagine that so many voices ar needed in any case so let's put a limit
                 // if another voice is needed and not yet there we create it
-                if (voiceIndex >= _allChannelsEvents[pmidi_out.chan]->size()) {
-                    _allChannelsEvents[pmidi_out.chan]->append(new QList<CAMidiImportEvent*>);
+                if (voiceIndex >= _allChannelsEvents[chan]->size()) {
+                    _allChannelsEvents[chan]->append(new QList<CAMidiImportEvent*>);
                 }
-                if (_allChannelsEvents[pmidi_out.chan]->at(voiceIndex)->size() == 0 || _allChannelsEvents[pmidi_out.chan]->at(voiceIndex)->last()->_nextTime <= pmidi_out.time) {
+                if (_allChannelsEvents[chan]->at(voiceIndex)->size() == 0 || _allChannelsEvents[chan]->at(voiceIndex)->last()->_nextTime <= time) {
                     // the note can be added
-                    _allChannelsEvents[pmidi_out.chan]->at(voiceIndex)->append(new CAMidiImportEvent(true, pmidi_out.chan, pmidi_out.note, pmidi_out.vel, pmidi_out.time, pmidi_out.length, 60000000 / pmidi_out.micro_tempo));
+                    _allChannelsEvents[chan]->at(voiceIndex)->append(new CAMidiImportEvent(true, chan, event.data1, event.data2, time, length, 60000000 / microTempo));
                     // attach the right program to the event
-                    _allChannelsEvents[pmidi_out.chan]->at(voiceIndex)->at(_allChannelsEvents[pmidi_out.chan]->at(voiceIndex)->size() - 1)->_program = programCache[pmidi_out.chan];
+                    _allChannelsEvents[chan]->at(voiceIndex)->at(_allChannelsEvents[chan]->at(voiceIndex)->size() - 1)->_program = programCache[chan];
                     break;
                 }
             }
             break;
-        case PMIDI_STATUS_DUMMY:
-        case PMIDI_STATUS_ROOT:
-            //			std::cout<<" Midi-Format: "<<pmidi_out.format
-            //				<<"  Tracks: "<<pmidi_out.tracks
-            //				<<"  Time Base: "<<pmidi_out.time_base<<std::endl;
-            break;
-        case PMIDI_STATUS_CONTROL:
-            break;
-        case PMIDI_STATUS_PROGRAM:
-            //			std::cout<<" Program: "<<pmidi_out.program
-            //				<<"  Channel: "<<pmidi_out.chan
-            //				<<std::endl;
-            programCache[pmidi_out.chan] = pmidi_out.program;
+        case CAMidiFileParser::Program:
+            programCache[chan] = event.data1;
 
             // store the first instrument in the channel to _midiProgramList variable
-            if (_midiProgramList[pmidi_out.chan] == -1) {
-                _midiProgramList[pmidi_out.chan] = pmidi_out.program;
+            if (_midiProgramList[chan] == -1) {
+                _midiProgramList[chan] = event.data1;
             }
 
             break;
-        case PMIDI_STATUS_PITCH:
-        case PMIDI_STATUS_PRESSURE:
-        case PMIDI_STATUS_KEYTOUCH:
-        case PMIDI_STATUS_SYSEX:
-            break;
-        case PMIDI_STATUS_KEYSIG:
-
-            //			std::cout<<" Keys: "<<pmidi_out.key
-            //				<<"  Minor: "<<pmidi_out.minor<<std::endl;
-            dk = CADiatonicKey(pmidi_out.key, pmidi_out.minor ? CADiatonicKey::Minor : CADiatonicKey::Major);
+        case CAMidiFileParser::KeySignature:
+            dk = CADiatonicKey(static_cast<signed char>(event.data1), event.data2 ? CADiatonicKey::Minor : CADiatonicKey::Major);
             // After the first key signature only changes are imported
             if (!_allChannelsKeySignatures.size() || _allChannelsKeySignatures.last()->diatonicKey() != dk)
-                _allChannelsKeySignatures << new CAKeySignature(dk, nullptr, pmidi_out.time);
+                _allChannelsKeySignatures << new CAKeySignature(dk, nullptr, time);
 
             break;
-        case PMIDI_STATUS_SMPTEOFFS:
-            /*
-			std::cout<<"  Stunden "<<pmidi_out.hours
-				<<" Minuten "<<pmidi_out.minutes
-				<<" Sekunden "<<pmidi_out.seconds
-				<<" Frames "<<pmidi_out.frames
-				<<" Subframes "<<pmidi_out.subframes<<std::endl;
-			*/
+        case CAMidiFileParser::Control:
+        case CAMidiFileParser::PitchBend:
             break;
         }
     }
 }
 
-CASheet* CAMidiImport::importSheetImplPmidiParser(CASheet* sheet)
+CASheet* CAMidiImport::importSheetImplMidiParser(CASheet* sheet)
 {
     importMidiEvents();
     writeMidiFileEventsToScore_New(sheet);
@@ -376,7 +340,7 @@ void CAMidiImport::writeMidiFileEventsToScore_New(CASheet* sheet)
     }
 
     // Calculate the medium pitch for every staff for the key selection later
-    _numberOfAllVoices = 2; // plus one for preprocessing, thats calling pmidi, and one for postprocessing
+    _numberOfAllVoices = 2; // plus one for preprocessing, thats parsing the file, and one for postprocessing
     for (int chanIndex = 0; chanIndex < 16; chanIndex++) {
         int n = 0;
         for (voiceIndex = 0; voiceIndex < _allChannelsEvents[chanIndex]->size(); voiceIndex++) {
@@ -430,7 +394,7 @@ void CAMidiImport::writeMidiFileEventsToScore_New(CASheet* sheet)
         _allChannelsTimeSignatures[_allChannelsTimeSignatures.size() - 1]->_bottom = 4;
     }
 
-    int nImportedVoices = 1; // one because preprocessing, ie calling pmidi, is already done
+    int nImportedVoices = 1; // one because preprocessing, ie parsing the file, is already done
     setProgress(_numberOfAllVoices ? nImportedVoices * 100 / _numberOfAllVoices : 50);
 
     for (unsigned char ch = 0; ch < 16; ch++) {
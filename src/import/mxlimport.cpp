@@ -8,6 +8,7 @@
 #include "import/mxlimport.h"
 #include <QDebug>
 #include <QDir>
+#include <QTemporaryDir>
 #include <iostream> // debug
 
 CAMXLImport::CAMXLImport(QTextStream* stream)
@@ -26,24 +27,29 @@ CAMXLImport::~CAMXLImport()
 
 CADocument* CAMXLImport::importDocumentImpl()
 {
-    int arg = 2;
+    int extracted = 0; // number of extracted files, local as several archives may be extracted at once
     _zipArchivePath = fileName();
-    // Extract whole archive to temp folder
-    zip_extract(fileName().toLatin1().constData(), QDir::tempPath().toLatin1().constData(), [](const char* filename, void* arg) {
-        static int i = 0;
-        int n = *static_cast<int*>(arg);
-        qDebug().noquote() << "Extracted: " << filename << "(" << ++i << " of " << n << ")\n";
-
+    // Extract whole archive to its own temp folder, so several archives can be imported at once
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        return nullptr;
+    }
+    zip_extract(fileName().toLatin1().constData(), tempDir.path().toLatin1().constData(), [](const char*, void* arg) {
+        ++*static_cast<int*>(arg);
         return 0;
     },
-        &arg);
+        &extracted);
+    if (!extracted) {
+        qDebug() << "Failed to extract " << fileName();
+        return nullptr;
+    }
 
-    QFileInfo containerInfo(QDir::tempPath() + QString("/META-INF/container.xml"));
+    QFileInfo containerInfo(tempDir.path() + QString("/META-INF/container.xml"));
     QString musicXMLFileName;
     bool eocRes = openContainer(containerInfo);
     if (eocRes) {
         eocRes = readContainerInfo(musicXMLFileName);
-        QFileInfo musicXMLFileInfo(QDir::tempPath() + "/" + musicXMLFileName);
+        QFileInfo musicXMLFileInfo(tempDir.path() + "/" + musicXMLFileName);
         if (musicXMLFileInfo.exists()) {
             setStreamFromFile(musicXMLFileInfo.filePath());
             return CAMusicXmlImport::importDocumentImpl();
@@ -141,11 +141,11 @@ void CAKeybdInput::midiInEventToScore(CAScoreView* v, QVector<unsigned char> m)
 
         // we create undo only for chords as a whole
         if (!appendToChord)
-            CACanorus::undo()->createUndoCommand(_mw->document(), QObject::tr("insert midi note", "undo"));
+            CACanorus::undo()->createContextUndoCommand(_mw->document(), QList<CAContext*>() << voice->staff(), QObject::tr("insert midi note", "undo"), false); // the chord notes are added after the command is pushed
 
         // If we are still in the processing of a tuplet, check if it's still there.
         // Possibly editing on the GUI could have moved it around or away, and no crash please.
-        if (_tupPla && (!voice->musElementList().contains(_tupPla) || _tupPla->tuplet() != _tup))
+        if (_tupPla && (voice->musElementIndex(_tupPla) == -1 || _tupPla->tuplet() != _tup))
             _tupPla = nullptr;
 
         // Where to put the note? When in a tuplet, do a chord in the tuplet or the nex not in the tuplet.
@@ -81,7 +81,7 @@ public:
     virtual void closeOutputPort() = 0;
     virtual void closeInputPort() = 0;
     virtual void send(QVector<unsigned char> message, int time) = 0; // message and absolute canorus time (independent of tempo)
-    virtual void sendMetaEvent(int time, char event, char a, char b, int c) = 0; // absolute time of the meta event which is meant only for midi file export
+    virtual void sendMetaEvent(int time, char event, char a, char b, int c) = 0; // absolute time of the meta event which is meant only for midi file export, c is the tempo in microseconds per quarter
 
 #ifndef SWIG
 signals:
@@ -13,17 +13,8 @@
 
 #include "interface/mididevice.h"
 #include "interface/playback.h"
-#include "score/barline.h"
-#include "score/context.h"
-#include "score/dynamic.h"
-#include "score/instrumentchange.h"
-#include "score/keysignature.h"
-#include "score/mark.h"
 #include "score/note.h"
-#include "score/sheet.h"
-#include "score/staff.h"
-#include "score/tempo.h"
-#include "score/timesignature.h"
+#include "score/slur.h"
 #include "score/voice.h"
 
 /*!
@@ -39,11 +30,22 @@
 	3) Optionally configure playback (setInitTimeStart() to start playback from the specific time. Default 0).
 	4) Call myPlaybackObject->run(). This will start playing in a new thread.
 	5) Call myPlaybackObject->stop() to stop the playback. Playback also stops automatically when finished.
-	6) Playback is also used for creating the events for midi file export. Therefore the music length time _curTime
-	   is also transferred as a paramter in send() and sendMetaEvent() to export the music lengths independent of tempo.
 
 	The playbackFinished() signal is emitted once playback has finished or stopped.
 
+	Before playing, the whole sheet is compiled into a flat list of events (see CAPlaybackTimeline)
+	with repeats unrolled and tempo changes resolved to miliseconds since the beginning of the
+	music. Playback from the initial time is a binary search in the events. The program, volume
+	and tempo events before it are sent immediately, so the instruments and dynamics are correct.
+	Events are sent at these absolute deadlines measured by a monotonic clock, so the time spent
+	sending the events and the oversleeping of the OS don't accumulate. The thread sleeps until
+	each deadline (see waitUntil()). Lateness of the events is measured and reported by
+	timingSamples(), meanJitter(), maxJitter() and drift(). The main window shows them in the
+	status bar when playback finishes.
+
+	Other threads shouldn't read curPlaying() while playing. The started and stopped notes and rests
+	are published to playingQueue() instead, which the GUI consumes to draw the playback cursor.
+
 	If you want to immediately play only given elements (eg. when inserting notes), call playImmediately().
 */
 
@@ -74,10 +76,7 @@ CAPlayback::CAPlayback(CAMidiDevice* m)
 */
 void CAPlayback::initPlayback()
 {
-    _repeating = 0;
-    _lastRepeatOpenIdx = nullptr;
     _curTime = 0;
-    _streamIdx = nullptr;
     _stop = false;
     _stopLock = false;
 
@@ -86,13 +85,18 @@ void CAPlayback::initPlayback()
     _midiDevice = nullptr;
     _playSelectionOnly = false;
     _initTimeStart = 0;
-    _sleepFactor = 1.0; // set by tempo to determine the miliseconds for sleep
+    _deadline = 0;
+    _timingSamples = 0;
+    _jitterSum = 0;
+    _jitterMax = 0;
+    _firstLateness = 0;
+    _drift = 0;
 
     connect(this, SIGNAL(finished()), SLOT(stopNow()));
 }
 
 /*!
-	Destructor deletes the created arrays.
+	Destructor stops the playback thread.
 */
 CAPlayback::~CAPlayback()
 {
@@ -100,13 +104,19 @@ CAPlayback::~CAPlayback()
         terminate();
         wait();
     }
+}
 
-    if (_lastRepeatOpenIdx)
-        delete[] _lastRepeatOpenIdx;
+/*!
+	Longest time in microseconds the playback thread sleeps at once while waiting for the next
+	event, so it notices stop() soon.
+*/
+const qint64 CAPlayback::MAX_SLEEP = 20000;
 
-    if (_streamIdx)
-        delete[] _streamIdx;
-}
+/*!
+	Time in microseconds before the next event the playback thread stops sleeping and yields
+	until the deadline instead.
+*/
+const qint64 CAPlayback::SPIN_TIME = 1500;
 
 /*!
 	Immediately plays the given \a elts.
@@ -129,146 +139,146 @@ void CAPlayback::run()
         return;
     }
 
-    // list of all the music element lists (ie. streams) taken from all the contexts
-    QList<QList<CAMusElement*>> stream;
-    QVector<unsigned char> message; // midi 3-byte message sent to midi device
-
-    // initializes all the streams, indices, repeat barlines etc.
-    if (!streamList().size()) {
-        initStreams(sheet());
+    // compiles the events of all the voices, unrolls the repeats etc.
+    if (_timeline.isEmpty()) {
+        _timeline.compile(sheet());
     }
 
-    if (!streamList().size())
+    if (_timeline.isEmpty())
         stop();
     else
         setStop(false);
 
-    int minLength = -1;
-    int mSeconds = 0; // actual song time, used when creating a midi file
-    while (!_stop || _curPlaying.size()) { // at stop true: enter to switch all notes off
-        for (int i = 0; i < _curPlaying.size(); i++) {
-            if (_stop || _curPlaying[i]->timeEnd() <= _curTime) {
-                // note off
-                CANote* note = dynamic_cast<CANote*>(_curPlaying[i]);
-                if (note) {
-                    message << (128 + note->voice()->midiChannel()); // note off
-                    message << static_cast<uchar>(CADiatonicPitch::diatonicPitchToMidiPitch(note->diatonicPitch()) + note->voice()->midiPitchOffset());
-                    message << (127);
-                    if ((note->musElementType() != CAMusElement::Rest) && // first because rest has no tie
-                        !(note->tieStart() && note->tieStart()->noteEnd()))
-                        midiDevice()->send(message, _curTime);
-                    message.clear();
-                }
-                _curPlaying.removeAt(i--);
-            }
-        }
-
-        for (int i = 0; i < streamList().size(); i++) {
-            loopUntilPlayable(i);
+    _timingSamples = 0;
+    _jitterSum = 0;
+    _jitterMax = 0;
+    _firstLateness = 0;
+    _drift = 0;
+
+    const QVector<CAPlaybackTimeline::CAEvent>& events = _timeline.events();
+    int first = _timeline.eventIndex(_timeline.unrolledTime(getInitTimeStart()));
+    for (int i = 0; i < first && !_stop; i++) {
+        if (isStateEvent(events[i])) {
+            sendEvent(events[i]);
         }
+    }
 
-        if (_stop)
-            continue; // no notes on anymore
-
-        minLength = -1;
-        for (int i = 0; i < streamList().size(); i++) {
-
-            while (streamAt(i).size() > streamIdx(i) && streamAt(i).at(streamIdx(i))->timeStart() == _curTime) {
-
-                // check if a rest carries a tempo mark
-                CAMusElement* me = streamAt(i).at(streamIdx(i));
-                if (me->musElementType() == CAMusElement::Rest) {
-                    for (int j = 0; j < me->markList().size(); j++) {
-                        if (me->markList()[j]->markType() == CAMark::Tempo) {
-                            CATempo* tempo = static_cast<CATempo*>(me->markList()[j]);
-                            midiDevice()->sendMetaEvent(_curTime, CAMidiDevice::Meta_Tempo, static_cast<char>(tempo->bpm()), 0, 0);
-                        }
-                    }
-                }
+    double startMsec = (first < events.size() ? events[first].msec : 0);
+    _deadline = startMsec;
+    _clock.start();
 
-                // note on
-
-                CANote* note = dynamic_cast<CANote*>(streamAt(i).at(streamIdx(i)));
-                if (note) {
-                    QVector<unsigned char> message;
-
-                    // send dynamic information
-                    for (int j = 0; j < note->markList().size(); j++) {
-                        if (note->markList()[j]->markType() == CAMark::Dynamic) {
-                            message << (176 + note->voice()->midiChannel()); // set volume
-                            message << (CAMidiDevice::Midi_Ctl_Volume /* 7 */);
-                            message << static_cast<uchar>(qRound(127 * static_cast<CADynamic*>(note->markList()[j])->volume() / 100.0));
-                            midiDevice()->send(message, _curTime);
-                            message.clear();
-                        } else if (note->markList()[j]->markType() == CAMark::InstrumentChange) {
-                            message << (192 + note->voice()->midiChannel()); // change program
-                            message << static_cast<unsigned char>(static_cast<CAInstrumentChange*>(note->markList()[j])->instrument());
-                            midiDevice()->send(message, _curTime);
-                            message.clear();
-                        } else if (note->markList()[j]->markType() == CAMark::Tempo) {
-                            updateSleepFactor(static_cast<CATempo*>(note->markList()[j]));
-                            CATempo* tempo = static_cast<CATempo*>(note->markList()[j]);
-                            midiDevice()->sendMetaEvent(_curTime, CAMidiDevice::Meta_Tempo, tempo->bpm(), 0, 0);
-                        }
-                    }
-
-                    message << (144 + note->voice()->midiChannel()); // note on
-                    message << static_cast<uchar>(CADiatonicPitch::diatonicPitchToMidiPitch(note->diatonicPitch()) + note->voice()->midiPitchOffset());
-                    message << (127);
-                    if (!note->tieEnd())
-                        midiDevice()->send(message, _curTime);
-                    message.clear();
-                }
-
-                if (streamAt(i).at(streamIdx(i))->isPlayable()) {
-                    _curPlaying << static_cast<CAPlayable*>(streamAt(i).at(streamIdx(i)));
-                }
+    for (int i = first; i < events.size() && !_stop; i++) {
+        if (events[i].msec > _deadline) {
+            _deadline = events[i].msec;
+            if (midiDevice()->isRealTime())
+                waitUntil(_deadline - startMsec);
 
-                int delta;
-                if ((delta = (streamAt(i).at(streamIdx(i))->timeEnd() - _curTime)) < minLength
-                    || minLength == -1)
-                    minLength = delta;
+            if (_stop)
+                break;
+        }
 
-                streamIdx(i)++;
-            }
+        sendEvent(events[i]);
+    }
 
-            // calculate the pause needed by msleep
-            // last playables in the stream - _curPlaying is otherwise always set!
-            // pre-last pass, set minLength to their timeLengths to stop the notes
-            for (int j = 0; j < _curPlaying.size(); j++) {
-                if ((_curPlaying[j]->timeEnd() - _curTime) < minLength || minLength == -1)
-                    minLength = _curPlaying[j]->timeEnd() - _curTime;
+    // switch off the notes still playing, if stopped
+    for (int i = 0; i < _curPlaying.size(); i++) {
+        if (_curPlaying[i]->musElementType() == CAMusElement::Note) {
+            CANote* note = static_cast<CANote*>(_curPlaying[i]);
+            if (!(note->tieStart() && note->tieStart()->noteEnd())) {
+                QVector<unsigned char> message;
+                message << (128 + note->voice()->midiChannel()); // note off
+                message << static_cast<uchar>(CADiatonicPitch::diatonicPitchToMidiPitch(note->diatonicPitch()) + note->voice()->midiPitchOffset());
+                message << (127);
+                midiDevice()->send(message, _curTime);
             }
         }
+        _playingQueue.push(_curPlaying[i], false);
+    }
 
-        if (minLength == -1) {
-            // last pass, notes indices are at the ends and no notes are played anymore
-            setStop(true);
-        }
-
-        if (minLength != -1) {
-            mSeconds += qRound(minLength * _sleepFactor);
+    _curPlaying.clear();
+    stop();
+}
 
-            if (midiDevice()->isRealTime())
-                msleep(static_cast<ulong>(qRound(minLength * _sleepFactor)));
+/*!
+	Sends the compiled event \a e to the midi device and updates the list of currently playing
+	elements.
+ */
+void CAPlayback::sendEvent(const CAPlaybackTimeline::CAEvent& e)
+{
+    _curTime = e.time;
 
-            _curTime += minLength;
+    switch (e.type) {
+    case CAPlaybackTimeline::Message: {
+        QVector<unsigned char> message(e.size);
+        for (int i = 0; i < e.size; i++) {
+            message[i] = e.data[i];
+        }
+        midiDevice()->send(message, e.time);
+        break;
+    }
+    case CAPlaybackTimeline::Meta:
+        midiDevice()->sendMetaEvent(e.time, static_cast<char>(e.data[0]), static_cast<char>(e.data[1]), static_cast<char>(e.data[2]), e.value);
+        break;
+    case CAPlaybackTimeline::PlayableOn:
+        _curPlaying << e.playable;
+        _playingQueue.push(e.playable, true);
+        break;
+    case CAPlaybackTimeline::PlayableOff:
+        if (_curPlaying.removeOne(e.playable)) { // not started, if playback started in the middle of it
+            _playingQueue.push(e.playable, false);
         }
+        break;
     }
+}
 
-    _curPlaying.clear();
-    stop();
+/*!
+	Returns True, if the event \a e changes the state of the midi device (program, volume,
+	tempo etc.) and needs to be sent even when playback starts after it.
+	Notes and playables aren't state events.
+ */
+bool CAPlayback::isStateEvent(const CAPlaybackTimeline::CAEvent& e)
+{
+    switch (e.type) {
+    case CAPlaybackTimeline::Message:
+        return (e.data[0] & 0xF0) != 0x80 && (e.data[0] & 0xF0) != 0x90; // not a note off or on
+    case CAPlaybackTimeline::Meta:
+        return true;
+    default:
+        return false;
+    }
 }
 
 /*!
-	Calculates the sleep factor for the given tempo \a t.
-	If \a t is null, it does nothing.
+	Blocks until the given \a deadline in miliseconds since the beginning of playback.
+
+	The thread sleeps until SPIN_TIME before the deadline, at most MAX_SLEEP at once, and
+	sleeps again, if woken up early. The OS may oversleep by a scheduler tick, so the rest of
+	the time is waited by yielding the CPU in a loop. The lateness of the wake up is recorded in
+	the timing statistics. Returns immediately, if the deadline already passed or the playback
+	was stopped.
  */
-void CAPlayback::updateSleepFactor(CATempo* t)
+void CAPlayback::waitUntil(double deadline)
 {
-    if (t) {
-        _sleepFactor = 60000.0f / (CAPlayableLength::playableLengthToTimeLength(t->beat()) * t->bpm());
+    qint64 deadlineUs = static_cast<qint64>(deadline * 1000);
+    qint64 remaining;
+
+    while (!_stop && (remaining = deadlineUs - _clock.nsecsElapsed() / 1000) > SPIN_TIME) {
+        usleep(static_cast<unsigned long>(qMin(remaining - SPIN_TIME, MAX_SLEEP)));
+    }
+    while (!_stop && deadlineUs - _clock.nsecsElapsed() / 1000 > 0) {
+        yieldCurrentThread();
+    }
+
+    qint64 lateness = _clock.nsecsElapsed() / 1000 - deadlineUs;
+    if (!_timingSamples) {
+        _firstLateness = lateness;
     }
+    _drift = lateness - _firstLateness;
+    if (lateness > 0) {
+        _jitterSum += lateness;
+        _jitterMax = qMax(_jitterMax, lateness);
+    }
+    _timingSamples++;
 }
 
 /*!
@@ -374,95 +384,3 @@ void CAPlayback::stopNow()
     setStopLock(false);
     emit playbackFinished();
 }
-
-/*!
-	Generates streams (elements lists) of playable elements (notes, rests) from the given sheet.
-*/
-void CAPlayback::initStreams(CASheet* sheet)
-{
-    for (int i = 0; i < sheet->contextList().size(); i++) {
-        if (sheet->contextList()[i]->contextType() == CAContext::Staff) {
-            CAStaff* staff = static_cast<CAStaff*>(sheet->contextList()[i]);
-            // add all the voices lists to the common list stream
-            for (int j = 0; j < staff->voiceList().size(); j++) {
-                _streamList << staff->voiceList()[j]->musElementList();
-
-                QVector<unsigned char> message;
-                message << (192 + staff->voiceList()[j]->midiChannel()); // change program
-                message << (staff->voiceList()[j]->midiProgram());
-                midiDevice()->send(message, _curTime);
-                message.clear();
-
-                message << (176 + staff->voiceList()[j]->midiChannel()); // set volume
-                message << (7);
-                message << (100);
-                midiDevice()->send(message, _curTime);
-                message.clear();
-            }
-        }
-    }
-    _streamIdx = new int[streamList().size()];
-    _lastRepeatOpenIdx = new int[streamList().size()];
-
-    // init streams indices, current times and last repeat barlines
-    for (int i = 0; i < streamList().size(); i++) {
-        _curTime = getInitTimeStart();
-        streamIdx(i) = 0;
-        lastRepeatOpenIdx(i) = -1;
-        _repeating = false;
-        loopUntilPlayable(i, true); // ignore repeats
-    }
-
-    if (_sheet) {
-        updateSleepFactor(_sheet->getTempo(getInitTimeStart()));
-    }
-}
-
-/*!
-	Loops from the stream with the given index \a i until the last element with smaller or equal start time of the current time.
-	This function also remembers any special signs like open repeat barlines.
-*/
-void CAPlayback::loopUntilPlayable(int i, bool ignoreRepeats)
-{
-    for (int j = streamIdx(i);
-         j < streamAt(i).size() && streamAt(i).at(j)->timeStart() <= _curTime && (streamAt(i).at(j)->timeStart() != _curTime || !(streamAt(i).at(j)->musElementType() == CAMusElement::Note) || (static_cast<CANote*>(streamAt(i).at(j))->isFirstInChord()));
-         streamIdx(i) = j++) {
-
-        if (streamAt(i).at(j)->musElementType() == CAMusElement::TimeSignature) {
-
-            int beats = static_cast<CATimeSignature*>(streamAt(i).at(j))->beats();
-            int beat = static_cast<CATimeSignature*>(streamAt(i).at(j))->beat();
-            //std::cout<<"  exportiere Time Signature    "<<_curTime<<" mit "<<beats<<"/"<<beat<<std::endl;
-            midiDevice()->sendMetaEvent(_curTime, CAMidiDevice::Meta_Timesig, beats, beat, 0);
-        }
-        if (streamAt(i).at(j)->musElementType() == CAMusElement::KeySignature) {
-            //int key = (static_cast<CAKeySignature*>(streamAt(i).at(j)))->diatonicKey()->numberOfAccs();
-            CAKeySignature* ks = dynamic_cast<CAKeySignature*>(streamAt(i).at(j));
-            CADiatonicKey dk = ks->diatonicKey();
-            int key = dk.numberOfAccs();
-            int minor = dk.gender() == CADiatonicKey::Minor ? 1 : 0;
-            midiDevice()->sendMetaEvent(_curTime, CAMidiDevice::Meta_Keysig, key, minor, 0);
-        }
-
-        if (streamAt(i).at(j)->musElementType() == CAMusElement::Barline && static_cast<CABarline*>(streamAt(i).at(j))->barlineType() == CABarline::RepeatOpen) {
-            lastRepeatOpenIdx(i) = j;
-        }
-
-        if (streamAt(i).at(j)->musElementType() == CAMusElement::Barline && static_cast<CABarline*>(streamAt(i).at(j))->barlineType() == CABarline::RepeatClose && !ignoreRepeats) {
-            if (!_repeating) {
-                // set the new index in ALL streams
-                for (int k = 0; k < streamList().size(); k++) {
-                    streamIdx(k) = lastRepeatOpenIdx(k) + 1;
-                }
-
-                _curTime = streamAt(i).at(streamIdx(i))->timeStart();
-                j = streamIdx(i);
-                _repeating = true;
-            }
-        }
-    }
-
-    // last element if non-playable is exception - increase the index counter
-    if (streamIdx(i) == streamAt(i).size() - 1 && !streamAt(i).at(streamIdx(i))->isPlayable())
-        streamIdx(i)++;
-}
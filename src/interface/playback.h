@@ -8,15 +8,18 @@
 #ifndef PLAYBACK_H_
 #define PLAYBACK_H_
 
+#include <QElapsedTimer>
 #include <QList>
 #include <QThread>
 
+#include "interface/playbackqueue.h"
+#include "interface/playbacktimeline.h"
+
 class CAMidiDevice;
 class CASheet;
 class CAMusElement;
 class CAPlayable;
 class CANote;
-class CATempo;
 
 class CAPlayback : public QThread {
 #ifndef SWIG
@@ -37,7 +40,18 @@ public:
     inline CAMidiDevice* midiDevice() { return _midiDevice; }
     inline CASheet* sheet() { return _sheet; }
     inline void setSheet(CASheet* s) { _sheet = s; }
-    inline QList<CAPlayable*>& curPlaying() { return _curPlaying; }
+    inline QList<CAPlayable*>& curPlaying() { return _curPlaying; } // only safe to use from the playback thread
+    inline CAPlaybackQueue& playingQueue() { return _playingQueue; }
+    inline const CAPlaybackTimeline& timeline() { return _timeline; }
+
+    // timing statistics of the last playback in microseconds
+    inline int timingSamples() { return _timingSamples; }
+    inline qint64 meanJitter() { return _timingSamples ? _jitterSum / _timingSamples : 0; }
+    inline qint64 maxJitter() { return _jitterMax; }
+    inline qint64 drift() { return _drift; } // change of the lateness from the first to the last event
+
+    static const qint64 MAX_SLEEP;
+    static const qint64 SPIN_TIME;
 
 #ifndef SWIG
 public slots:
@@ -53,15 +67,10 @@ signals:
 
 private:
     void initPlayback();
-    void initStreams(CASheet* sheet);
-    void loopUntilPlayable(int i, bool ignoreRepeats = false);
     void playSelectionImpl();
-    void updateSleepFactor(CATempo* t);
-
-    inline QList<CAMusElement*>& streamAt(int idx) { return _streamList[idx]; }
-    inline const QList<QList<CAMusElement*>>& streamList() { return _streamList; }
-    inline int& streamIdx(int i) { return _streamIdx[i]; }
-    inline int& lastRepeatOpenIdx(int i) { return _lastRepeatOpenIdx[i]; }
+    void sendEvent(const CAPlaybackTimeline::CAEvent& e);
+    static bool isStateEvent(const CAPlaybackTimeline::CAEvent& e);
+    void waitUntil(double deadline);
 
     inline bool stopLock() { return _stopLock; }
     inline void setStopLock(bool lock) { _stopLock = lock; }
@@ -79,13 +88,18 @@ private:
     QList<CAMusElement*> _selection;
 
     int _initTimeStart;
-    float _sleepFactor;
 
-    QList<QList<CAMusElement*>> _streamList;
+    QElapsedTimer _clock; // monotonic clock started at the beginning of playback
+    double _deadline; // time of the next event in miliseconds since the beginning of the music
+    int _timingSamples;
+    qint64 _jitterSum;
+    qint64 _jitterMax;
+    qint64 _firstLateness;
+    qint64 _drift;
+
+    CAPlaybackTimeline _timeline;
     QList<CAPlayable*> _curPlaying; // list of currently playing notes and rests
-    int* _streamIdx;
-    bool _repeating;
-    int* _lastRepeatOpenIdx;
+    CAPlaybackQueue _playingQueue; // started and stopped notes and rests for the GUI thread
     int _curTime;
 };
 
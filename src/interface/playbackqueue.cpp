@@ -0,0 +1,79 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include "interface/playbackqueue.h"
+
+/*!
+	\class CAPlaybackQueue
+	\brief Lock-free queue of started and stopped playables
+
+	The playback thread pushes an event each time a note or rest starts or stops sounding and the
+	GUI thread pops them to update the playback cursor. The queue is a fixed size ring buffer with
+	a single producer and a single consumer: the producer only writes the head index and the
+	consumer only writes the tail index, so neither thread ever blocks.
+
+	If the consumer doesn't keep up and the buffer is full, new events are dropped. The consumer
+	should check takeDropped() and resynchronize, because the stop events of the started
+	playables might be lost.
+
+	\sa CAPlayback, CAScoreView::setPlayingElements()
+*/
+
+CAPlaybackQueue::CAPlaybackQueue()
+    : _head(0)
+    , _tail(0)
+    , _dropped(0)
+{
+}
+
+/*!
+	Appends the event for the given \a playable. \a on is True, if the playable started
+	sounding and False, if it stopped. Called by the producer only.
+
+	Returns False, if the queue was full and the event was dropped.
+*/
+bool CAPlaybackQueue::push(CAPlayable* playable, bool on)
+{
+    int head = _head.load();
+    int next = (head + 1) % CAPACITY;
+    if (next == _tail.loadAcquire()) {
+        _dropped.fetchAndAddOrdered(1);
+        return false;
+    }
+
+    _buffer[head].playable = playable;
+    _buffer[head].on = on;
+    _head.storeRelease(next); // publish the event after it's written
+    return true;
+}
+
+/*!
+	Takes the oldest event from the queue and stores it to \a event. Called by the consumer only.
+
+	Returns False, if the queue was empty.
+*/
+bool CAPlaybackQueue::pop(CAPlayingEvent& event)
+{
+    int tail = _tail.load();
+    if (tail == _head.loadAcquire()) {
+        return false;
+    }
+
+    event = _buffer[tail];
+    _tail.storeRelease((tail + 1) % CAPACITY);
+    return true;
+}
+
+/*!
+	Removes all the events. Neither the producer nor the consumer may use the queue meanwhile.
+*/
+void CAPlaybackQueue::clear()
+{
+    _head.storeRelease(0);
+    _tail.storeRelease(0);
+    _dropped.storeRelease(0);
+}
@@ -0,0 +1,39 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#ifndef PLAYBACKQUEUE_H_
+#define PLAYBACKQUEUE_H_
+
+#include <QAtomicInt>
+
+class CAPlayable;
+
+class CAPlaybackQueue {
+public:
+    struct CAPlayingEvent {
+        CAPlayable* playable;
+        bool on; // True, if the playable started, False if it stopped sounding
+    };
+
+    CAPlaybackQueue();
+
+    static const int CAPACITY = 1024;
+
+    bool push(CAPlayable* playable, bool on);
+    bool pop(CAPlayingEvent& event);
+    void clear();
+
+    inline int takeDropped() { return _dropped.fetchAndStoreOrdered(0); } // called by the consumer only
+
+private:
+    CAPlayingEvent _buffer[CAPACITY];
+    QAtomicInt _head; // index of the next event to be pushed, only written by the producer
+    QAtomicInt _tail; // index of the next event to be popped, only written by the consumer
+    QAtomicInt _dropped; // number of events dropped since the last takeDropped()
+};
+
+#endif /* PLAYBACKQUEUE_H_ */
@@ -0,0 +1,356 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include "interface/mididevice.h"
+#include "interface/playbacktimeline.h"
+#include "score/barline.h"
+#include "score/context.h"
+#include "score/dynamic.h"
+#include "score/instrumentchange.h"
+#include "score/keysignature.h"
+#include "score/mark.h"
+#include "score/note.h"
+#include "score/sheet.h"
+#include "score/slur.h"
+#include "score/staff.h"
+#include "score/tempo.h"
+#include "score/timesignature.h"
+#include "score/voice.h"
+
+/*!
+	\class CAPlaybackTimeline
+	\brief Flat list of playback events compiled from the sheet
+
+	compile() walks the voices of the sheet once and generates a time sorted array of plain
+	events: MIDI messages, meta events (tempo, time and key signatures) and the start and end
+	of each playable element, used to highlight the currently playing notes. Each event also
+	remembers the voice which generated it, so the MIDI export can split the events into tracks.
+
+	While compiling, repeats are unrolled, tempo marks are resolved to the time of each event in
+	miliseconds, dynamics and instrument changes are converted to MIDI messages and tied notes are
+	merged into a single note on/off pair. CAPlayback and the MIDI export then only walk the
+	events. Seeking to a given time is a binary search (see unrolledTime() and eventIndex()).
+
+	\sa CAPlayback
+*/
+
+CAPlaybackTimeline::CAPlaybackTimeline()
+{
+    clear();
+}
+
+/*!
+	Removes all the events.
+*/
+void CAPlaybackTimeline::clear()
+{
+    _events.clear();
+    _passList.clear();
+    _streamList.clear();
+    _voiceList.clear();
+    _streamIdx.clear();
+    _lastRepeatOpenIdx.clear();
+    _repeating = false;
+    _curVoice = nullptr;
+    _curTime = 0;
+    _time = 0;
+    _msec = 0;
+    _sleepFactor = 1.0;
+}
+
+/*!
+	Generates the events for the music of the given \a sheet starting at \a timeStart.
+	Any previous events are removed.
+*/
+void CAPlaybackTimeline::compile(CASheet* sheet, int timeStart)
+{
+    clear();
+    if (!sheet) {
+        return;
+    }
+
+    initStreams(sheet, timeStart);
+
+    QList<CAPlayable*> playing; // currently playing notes and rests
+    bool stop = _streamList.isEmpty();
+    while (!stop || playing.size()) { // at stop true: enter to switch all notes off
+        for (int i = 0; i < playing.size(); i++) {
+            if (stop || playing[i]->timeEnd() <= _curTime) {
+                _curVoice = playing[i]->voice();
+                if (playing[i]->musElementType() == CAMusElement::Note) {
+                    CANote* note = static_cast<CANote*>(playing[i]);
+                    if (!(note->tieStart() && note->tieStart()->noteEnd())) {
+                        addNoteOff(note);
+                    }
+                }
+                addPlayableEvent(PlayableOff, playing[i]);
+                playing.removeAt(i--);
+            }
+        }
+
+        for (int i = 0; i < _streamList.size(); i++) {
+            loopUntilPlayable(i);
+        }
+
+        if (stop)
+            continue; // no notes on anymore
+
+        int minLength = -1;
+        for (int i = 0; i < _streamList.size(); i++) {
+            const QList<CAMusElement*>& stream = _streamList[i];
+            _curVoice = _voiceList[i];
+
+            while (stream.size() > _streamIdx[i] && stream[_streamIdx[i]]->timeStart() == _curTime) {
+                CAMusElement* elt = stream[_streamIdx[i]];
+
+                if (elt->musElementType() == CAMusElement::Rest) {
+                    // check if a rest carries a tempo mark
+                    const QList<CAMark*> marks = elt->markList();
+                    for (int j = 0; j < marks.size(); j++) {
+                        if (marks[j]->markType() == CAMark::Tempo) {
+                            CATempo* tempo = static_cast<CATempo*>(marks[j]);
+                            updateSleepFactor(tempo);
+                            addTempoEvent(tempo);
+                        }
+                    }
+                } else if (elt->musElementType() == CAMusElement::Note) {
+                    CANote* note = static_cast<CANote*>(elt);
+                    unsigned char channel = note->voice()->midiChannel();
+
+                    // resolve dynamics, instrument changes and tempo
+                    const QList<CAMark*> marks = note->markList();
+                    for (int j = 0; j < marks.size(); j++) {
+                        if (marks[j]->markType() == CAMark::Dynamic) {
+                            addMessage(176 + channel, CAMidiDevice::Midi_Ctl_Volume, static_cast<unsigned char>(qRound(127 * static_cast<CADynamic*>(marks[j])->volume() / 100.0)));
+                        } else if (marks[j]->markType() == CAMark::InstrumentChange) {
+                            addMessage(192 + channel, static_cast<unsigned char>(static_cast<CAInstrumentChange*>(marks[j])->instrument()));
+                        } else if (marks[j]->markType() == CAMark::Tempo) {
+                            CATempo* tempo = static_cast<CATempo*>(marks[j]);
+                            updateSleepFactor(tempo);
+                            addTempoEvent(tempo);
+                        }
+                    }
+
+                    if (!note->tieEnd()) {
+                        addMessage(144 + channel, static_cast<unsigned char>(CADiatonicPitch::diatonicPitchToMidiPitch(note->diatonicPitch()) + note->voice()->midiPitchOffset()), 127);
+                    }
+                }
+
+                if (elt->isPlayable()) {
+                    playing << static_cast<CAPlayable*>(elt);
+                    addPlayableEvent(PlayableOn, static_cast<CAPlayable*>(elt));
+                }
+
+                int delta;
+                if ((delta = (elt->timeEnd() - _curTime)) < minLength || minLength == -1)
+                    minLength = delta;
+
+                _streamIdx[i]++;
+            }
+
+            // last playables in the stream - playing is otherwise always set!
+            // pre-last pass, set minLength to their timeLengths to stop the notes
+            for (int j = 0; j < playing.size(); j++) {
+                if ((playing[j]->timeEnd() - _curTime) < minLength || minLength == -1)
+                    minLength = playing[j]->timeEnd() - _curTime;
+            }
+        }
+
+        if (minLength == -1) {
+            // last pass, notes indices are at the ends and no notes are played anymore
+            stop = true;
+        } else {
+            _msec += minLength * _sleepFactor;
+            _curTime += minLength;
+            _time += minLength;
+        }
+    }
+
+    // the compiler state is not needed anymore
+    _streamList.clear();
+    _voiceList.clear();
+    _streamIdx.clear();
+    _lastRepeatOpenIdx.clear();
+}
+
+/*!
+	Returns the index of the first event at the given unrolled \a time or later.
+	Returns size(), if all the events happen earlier.
+*/
+int CAPlaybackTimeline::eventIndex(int time) const
+{
+    int low = 0, high = _events.size();
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (_events[mid].time < time)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+/*!
+	Returns the unrolled time when the given \a scoreTime in the score is played for the first
+	time. Both times are equal, if the music before doesn't repeat.
+*/
+int CAPlaybackTimeline::unrolledTime(int scoreTime) const
+{
+    for (int i = 0; i < _passList.size(); i++) {
+        int offset = scoreTime - _passList[i].second;
+        if (offset >= 0 && (i == _passList.size() - 1 || _passList[i].first + offset < _passList[i + 1].first)) {
+            return _passList[i].first + offset;
+        }
+    }
+
+    return scoreTime;
+}
+
+/*!
+	Generates streams (elements lists) of playable elements (notes, rests) from the given \a sheet
+	and the initial program and volume messages of each voice.
+*/
+void CAPlaybackTimeline::initStreams(CASheet* sheet, int timeStart)
+{
+    _time = timeStart;
+
+    for (int i = 0; i < sheet->contextList().size(); i++) {
+        if (sheet->contextList()[i]->contextType() == CAContext::Staff) {
+            CAStaff* staff = static_cast<CAStaff*>(sheet->contextList()[i]);
+            // add all the voices lists to the common list stream
+            for (int j = 0; j < staff->voiceList().size(); j++) {
+                _streamList << staff->voiceList()[j]->musElementList();
+                _voiceList << staff->voiceList()[j];
+
+                _curVoice = staff->voiceList()[j];
+                addMessage(192 + staff->voiceList()[j]->midiChannel(), staff->voiceList()[j]->midiProgram()); // change program
+                addMessage(176 + staff->voiceList()[j]->midiChannel(), 7, 100); // set volume
+            }
+        }
+    }
+
+    _streamIdx.fill(0, _streamList.size());
+    _lastRepeatOpenIdx.fill(-1, _streamList.size());
+
+    // init streams indices, current times and last repeat barlines
+    _curTime = timeStart;
+    _repeating = false;
+    _passList << qMakePair(_time, _curTime);
+    for (int i = 0; i < _streamList.size(); i++) {
+        loopUntilPlayable(i, true); // ignore repeats
+    }
+
+    updateSleepFactor(sheet->getTempo(timeStart));
+}
+
+/*!
+	Loops from the stream with the given index \a i until the last element with smaller or equal start time of the current time.
+	This function also remembers any special signs like open repeat barlines and unrolls the repeats.
+*/
+void CAPlaybackTimeline::loopUntilPlayable(int i, bool ignoreRepeats)
+{
+    const QList<CAMusElement*>& stream = _streamList[i];
+    _curVoice = _voiceList[i];
+
+    for (int j = _streamIdx[i];
+         j < stream.size() && stream[j]->timeStart() <= _curTime && (stream[j]->timeStart() != _curTime || stream[j]->musElementType() != CAMusElement::Note || static_cast<CANote*>(stream[j])->isFirstInChord());
+         _streamIdx[i] = j++) {
+
+        switch (stream[j]->musElementType()) {
+        case CAMusElement::TimeSignature: {
+            CATimeSignature* ts = static_cast<CATimeSignature*>(stream[j]);
+            addMetaEvent(CAMidiDevice::Meta_Timesig, ts->beats(), ts->beat());
+            break;
+        }
+        case CAMusElement::KeySignature: {
+            CADiatonicKey dk = static_cast<CAKeySignature*>(stream[j])->diatonicKey();
+            addMetaEvent(CAMidiDevice::Meta_Keysig, dk.numberOfAccs(), dk.gender() == CADiatonicKey::Minor ? 1 : 0);
+            break;
+        }
+        case CAMusElement::Barline: {
+            CABarline* barline = static_cast<CABarline*>(stream[j]);
+            if (barline->barlineType() == CABarline::RepeatOpen) {
+                _lastRepeatOpenIdx[i] = j;
+            } else if (barline->barlineType() == CABarline::RepeatClose && !ignoreRepeats && !_repeating) {
+                // set the new index in ALL streams
+                for (int k = 0; k < _streamList.size(); k++) {
+                    _streamIdx[k] = _lastRepeatOpenIdx[k] + 1;
+                }
+
+                _curTime = stream[_streamIdx[i]]->timeStart();
+                j = _streamIdx[i];
+                _repeating = true;
+                _passList << qMakePair(_time, _curTime);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    // last element if non-playable is exception - increase the index counter
+    if (_streamIdx[i] == stream.size() - 1 && !stream[_streamIdx[i]]->isPlayable())
+        _streamIdx[i]++;
+}
+
+/*!
+	Calculates the miliseconds per time unit for the given tempo \a t.
+	If \a t is null, it does nothing.
+ */
+void CAPlaybackTimeline::updateSleepFactor(CATempo* t)
+{
+    if (t) {
+        _sleepFactor = 60000.0f / (CAPlayableLength::playableLengthToTimeLength(t->beat()) * t->bpm());
+    }
+}
+
+void CAPlaybackTimeline::addMessage(unsigned char status, unsigned char data1)
+{
+    CAEvent e = { _time, _msec, Message, 2, { status, data1, 0 }, 0, nullptr, _curVoice };
+    _events << e;
+}
+
+void CAPlaybackTimeline::addMessage(unsigned char status, unsigned char data1, unsigned char data2)
+{
+    CAEvent e = { _time, _msec, Message, 3, { status, data1, data2 }, 0, nullptr, _curVoice };
+    _events << e;
+}
+
+void CAPlaybackTimeline::addMetaEvent(char event, char a, char b, int value)
+{
+    CAEvent e = { _time, _msec, Meta, 3, { static_cast<unsigned char>(event), static_cast<unsigned char>(a), static_cast<unsigned char>(b) }, value, nullptr, _curVoice };
+    _events << e;
+}
+
+/*!
+	Adds the tempo meta event for the tempo mark \a t. The value of the event is the tempo in
+	microseconds per quarter note, as written to MIDI files, with the beat of the tempo mark
+	(eg. a dotted quarter) taken into account.
+*/
+void CAPlaybackTimeline::addTempoEvent(CATempo* t)
+{
+    if (!t->bpm()) {
+        return;
+    }
+
+    int beatTime = CAPlayableLength::playableLengthToTimeLength(t->beat());
+    int quarterTime = CAPlayableLength::musicLengthToTimeLength(CAPlayableLength::Quarter);
+    int usPerQuarter = qRound(60000000.0 * quarterTime / (static_cast<double>(beatTime) * t->bpm()));
+    addMetaEvent(CAMidiDevice::Meta_Tempo, 0, 0, usPerQuarter);
+}
+
+void CAPlaybackTimeline::addPlayableEvent(CAEventType type, CAPlayable* playable)
+{
+    CAEvent e = { _time, _msec, type, 0, { 0, 0, 0 }, 0, playable, _curVoice };
+    _events << e;
+}
+
+void CAPlaybackTimeline::addNoteOff(CANote* note)
+{
+    addMessage(128 + note->voice()->midiChannel(), static_cast<unsigned char>(CADiatonicPitch::diatonicPitchToMidiPitch(note->diatonicPitch()) + note->voice()->midiPitchOffset()), 127);
+}
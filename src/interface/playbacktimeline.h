@@ -0,0 +1,82 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#ifndef PLAYBACKTIMELINE_H_
+#define PLAYBACKTIMELINE_H_
+
+#include <QList>
+#include <QPair>
+#include <QVector>
+
+class CASheet;
+class CAMusElement;
+class CAPlayable;
+class CANote;
+class CAVoice;
+class CATempo;
+
+class CAPlaybackTimeline {
+public:
+    enum CAEventType {
+        Message, // MIDI message of size bytes in data
+        Meta, // meta event data[0] with parameters data[1], data[2] and value
+        PlayableOn, // playable starts sounding
+        PlayableOff // playable stops sounding
+    };
+
+    struct CAEvent {
+        int time; // Canorus time with repeats unrolled
+        double msec; // miliseconds since the beginning with tempo changes resolved
+        CAEventType type;
+        unsigned char size;
+        unsigned char data[3];
+        int value;
+        CAPlayable* playable;
+        CAVoice* voice; // voice which generated the event
+    };
+
+    CAPlaybackTimeline();
+
+    void compile(CASheet* sheet, int timeStart = 0);
+    void clear();
+
+    inline const QVector<CAEvent>& events() const { return _events; }
+    inline int size() const { return _events.size(); }
+    inline bool isEmpty() const { return _events.isEmpty(); }
+
+    int eventIndex(int time) const;
+    int unrolledTime(int scoreTime) const;
+
+private:
+    void initStreams(CASheet* sheet, int timeStart);
+    void loopUntilPlayable(int i, bool ignoreRepeats = false);
+    void updateSleepFactor(CATempo* t);
+
+    void addMessage(unsigned char status, unsigned char data1);
+    void addMessage(unsigned char status, unsigned char data1, unsigned char data2);
+    void addMetaEvent(char event, char a, char b, int value = 0);
+    void addTempoEvent(CATempo* t);
+    void addPlayableEvent(CAEventType type, CAPlayable* playable);
+    void addNoteOff(CANote* note);
+
+    QVector<CAEvent> _events;
+    QList<QPair<int, int>> _passList; // unrolled and score time at the beginning of each pass over the music
+
+    // compiler state
+    QList<QList<CAMusElement*>> _streamList;
+    QList<CAVoice*> _voiceList; // voice of each stream
+    QVector<int> _streamIdx;
+    QVector<int> _lastRepeatOpenIdx;
+    bool _repeating;
+    int _curTime; // current Canorus time in the score
+    int _time; // current Canorus time with repeats unrolled
+    double _msec;
+    float _sleepFactor;
+    CAVoice* _curVoice; // voice of the events being added
+};
+
+#endif /* PLAYBACKTIMELINE_H_ */
@@ -7,12 +7,27 @@
 
 #include <QPainter>
 
+#include "core/settings.h"
 #include "layout/drawable.h"
+#include "layout/drawablearena.h"
 #include "layout/drawablecontext.h"
 #include "layout/drawablemuselement.h"
 
 const int CADrawable::SCALE_HANDLES_SIZE = 2;
 
+double CADrawable::_reducedDetailZoom = CASettings::DEFAULT_REDUCED_DETAIL_ZOOM;
+double CADrawable::_outlineDetailZoom = CASettings::DEFAULT_OUTLINE_DETAIL_ZOOM;
+
+namespace {
+// Stored in front of each drawable element to know where its memory came from
+struct CAAllocationHeader {
+    CADrawableArena* arena;
+    std::size_t size;
+};
+
+const std::size_t HEADER_SIZE = (sizeof(CAAllocationHeader) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+}
+
 CADrawable::CADrawable(double x, double y)
     : _xPos(x)
     , _yPos(y)
@@ -25,6 +40,75 @@ CADrawable::CADrawable(double x, double y)
 {
 }
 
+/*!
+	Allocates the drawable element in the current arena, if any, or on the heap.
+
+	\sa CADrawableArena::CAScope
+*/
+void* CADrawable::operator new(std::size_t size)
+{
+    CADrawableArena* arena = CADrawableArena::current();
+    char* p = static_cast<char*>(arena ? arena->allocate(HEADER_SIZE + size) : ::operator new(HEADER_SIZE + size));
+
+    CAAllocationHeader* header = reinterpret_cast<CAAllocationHeader*>(p);
+    header->arena = arena;
+    header->size = HEADER_SIZE + size;
+    return p + HEADER_SIZE;
+}
+
+/*!
+	Frees the memory of a drawable element allocated on the heap. The memory of the elements
+	allocated in an arena is reused, when the arena is reset.
+*/
+void CADrawable::operator delete(void* p)
+{
+    if (!p) {
+        return;
+    }
+
+    CAAllocationHeader* header = reinterpret_cast<CAAllocationHeader*>(static_cast<char*>(p) - HEADER_SIZE);
+    if (header->arena) {
+        header->arena->release(header->size);
+    } else {
+        ::operator delete(header);
+    }
+}
+
+/*!
+	Returns the level of detail the elements are drawn with at the given \a zoom level.
+
+	When the whole score is zoomed out to fit the window, the glyphs and texts are only a few
+	pixels large and rendering them dominates the repaint. Below the reduced detail zoom level
+	the noteheads are drawn as simple ellipses, the slurs as straight lines and the marks and
+	texts are skipped. Below the outline zoom level notes, rests and clefs are only blocks in the
+	staff, and the ledger lines, accidentals, flags and dots are left out.
+
+	\sa setDetailZoomLevels(), CASettings::reducedDetailZoom()
+*/
+CADrawable::CADetailLevel CADrawable::detailLevel(double zoom)
+{
+    if (zoom < _outlineDetailZoom) {
+        return OutlineDetail;
+    } else if (zoom < _reducedDetailZoom) {
+        return ReducedDetail;
+    }
+
+    return FullDetail;
+}
+
+/*!
+	Sets the zoom levels below which the elements are drawn with less detail.
+	The outline zoom level is limited to the reduced detail zoom level.
+	Call it from the GUI thread only, while no tiles are being rendered.
+
+	\sa detailLevel()
+*/
+void CADrawable::setDetailZoomLevels(double reducedDetailZoom, double outlineDetailZoom)
+{
+    _reducedDetailZoom = reducedDetailZoom;
+    _outlineDetailZoom = qMin(outlineDetailZoom, reducedDetailZoom);
+}
+
 void CADrawable::drawHScaleHandles(QPainter* p, CADrawSettings s)
 {
     p->setPen(QPen(s.color));
@@ -11,6 +11,8 @@
 #include <QColor>
 #include <QRectF>
 
+#include <cstddef>
+
 class QPainter;
 
 struct CADrawSettings {
@@ -31,6 +33,12 @@ public:
         DrawableContext
     };
 
+    enum CADetailLevel {
+        FullDetail, // all the glyphs and texts
+        ReducedDetail, // simple noteheads, straight slurs, no texts and marks
+        OutlineDetail // staffs, barlines and a block for each note
+    };
+
     enum CADirection {
         Undefined,
         Top,
@@ -45,9 +53,17 @@ public:
 
     CADrawable(double x, double y); // x and y position of an element in absolute world units
     virtual ~CADrawable() {}
+
+    static void* operator new(std::size_t size);
+    static void operator delete(void* p);
     virtual void draw(QPainter* p, const CADrawSettings s) = 0;
     virtual CADrawable* clone() = 0;
 
+    static CADetailLevel detailLevel(double zoom);
+    static void setDetailZoomLevels(double reducedDetailZoom, double outlineDetailZoom);
+    static inline double reducedDetailZoom() { return _reducedDetailZoom; }
+    static inline double outlineDetailZoom() { return _outlineDetailZoom; }
+
     void drawHScaleHandles(QPainter* p, const CADrawSettings s);
     void drawVScaleHandles(QPainter* p, const CADrawSettings s);
 
@@ -95,6 +111,10 @@ protected:
     bool _vScalable; // Can the element be streched vertically
 
     static const int SCALE_HANDLES_SIZE; // Width and Height of the scale handles squares in pixels
+
+private:
+    static double _reducedDetailZoom; // Zoom level below which the elements are drawn with ReducedDetail
+    static double _outlineDetailZoom; // Zoom level below which the elements are drawn with OutlineDetail
 };
 
 #endif /* DRAWABLE_H_ */
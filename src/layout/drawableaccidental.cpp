@@ -12,6 +12,7 @@
 #include "layout/drawableaccidental.h"
 #include "layout/drawableclef.h"
 #include "layout/drawablecontext.h"
+#include "layout/glyphcache.h"
 #include "score/muselement.h"
 
 /*!
@@ -58,26 +59,28 @@ CADrawableAccidental::~CADrawableAccidental()
 
 void CADrawableAccidental::draw(QPainter* p, CADrawSettings s)
 {
-    QFont font("Emmentaler");
-    font.setPixelSize(qRound(34 * s.z));
+    const int glyphSize = qRound(34 * s.z);
+    if (detailLevel(s.z) == OutlineDetail) {
+        return; // the block of the note is enough in the outline
+    }
+
     p->setPen(QPen(s.color));
-    p->setFont(font);
 
     switch (_accs) {
     case 0:
-        p->drawText(s.x, s.y + qRound(height() / 2 * s.z), QString(CACanorus::fetaCodepoint("accidentals.natural")));
+        CAGlyphCache::drawGlyph(p, s.x, s.y + qRound(height() / 2 * s.z), "accidentals.natural", glyphSize, s.color);
         break;
     case 1:
-        p->drawText(s.x, s.y + qRound((height() / 2 + 0.3) * s.z), QString(CACanorus::fetaCodepoint("accidentals.sharp")));
+        CAGlyphCache::drawGlyph(p, s.x, s.y + qRound((height() / 2 + 0.3) * s.z), "accidentals.sharp", glyphSize, s.color);
         break;
     case -1:
-        p->drawText(s.x, s.y + qRound((height() / 2 + 5) * s.z), QString(CACanorus::fetaCodepoint("accidentals.flat")));
+        CAGlyphCache::drawGlyph(p, s.x, s.y + qRound((height() / 2 + 5) * s.z), "accidentals.flat", glyphSize, s.color);
         break;
     case 2:
-        p->drawText(s.x, s.y + qRound(height() / 2 * s.z), QString(CACanorus::fetaCodepoint("accidentals.doublesharp")));
+        CAGlyphCache::drawGlyph(p, s.x, s.y + qRound(height() / 2 * s.z), "accidentals.doublesharp", glyphSize, s.color);
         break;
     case -2:
-        p->drawText(s.x, s.y + qRound((height() / 2 + 5) * s.z), QString(CACanorus::fetaCodepoint("accidentals.flatflat")));
+        CAGlyphCache::drawGlyph(p, s.x, s.y + qRound((height() / 2 + 5) * s.z), "accidentals.flatflat", glyphSize, s.color);
         break;
     }
 }
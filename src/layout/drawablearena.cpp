@@ -0,0 +1,147 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QtGlobal>
+#include <new>
+
+#include "layout/drawablearena.h"
+
+/*!
+	\class CADrawableArena
+	\brief Monotonic memory buffer for the drawable elements of a layout
+
+	The layout engine creates thousands of small drawable elements on each layout. While a
+	CAScope is active, CADrawable::operator new() takes the memory for them from the current
+	arena instead of the heap. Allocation only moves a pointer inside a large block and the
+	elements of a layout sit next to each other in memory in the order they were placed.
+
+	Deleting a drawable element allocated in the arena runs its destructor, but the memory
+	is only counted as released. The memory of all the elements is reused at once by reset(),
+	once they are all deleted (see CASheetLayout::clear()). The blocks are kept for the next
+	layout and freed when the arena is destroyed.
+
+	Incremental layouts delete some of the elements and create new ones, so the released
+	memory grows. isFragmented() tells when a full layout should be done to reclaim it.
+
+	The current arena is set per thread, so drawable elements created by other threads are
+	never allocated in the arena of a layout running in the GUI thread.
+
+	setEnabled(false) makes all the scopes allocate on the heap, eg. to compare the layout
+	performance or to find memory errors of the drawable elements with a memory checker.
+
+	\sa CASheetLayout, CADrawable
+*/
+
+const std::size_t CADrawableArena::ALIGNMENT = alignof(std::max_align_t);
+const std::size_t CADrawableArena::BLOCK_SIZE = 64 * 1024;
+
+thread_local CADrawableArena* CADrawableArena::_current = nullptr;
+bool CADrawableArena::_enabled = true;
+
+CADrawableArena::CADrawableArena()
+    : _block(-1)
+    , _pos(nullptr)
+    , _end(nullptr)
+    , _used(0)
+    , _released(0)
+{
+}
+
+CADrawableArena::~CADrawableArena()
+{
+    for (int i = 0; i < _blocks.size(); i++) {
+        ::operator delete(_blocks[i]);
+    }
+    for (int i = 0; i < _largeBlocks.size(); i++) {
+        ::operator delete(_largeBlocks[i]);
+    }
+}
+
+/*!
+	Returns \a size bytes of memory aligned to ALIGNMENT.
+*/
+void* CADrawableArena::allocate(std::size_t size)
+{
+    size = alignedSize(size);
+    _used += size;
+
+    if (size > BLOCK_SIZE) {
+        _largeBlocks << static_cast<char*>(::operator new(size));
+        return _largeBlocks.last();
+    }
+
+    if (static_cast<std::size_t>(_end - _pos) < size) {
+        nextBlock();
+    }
+
+    void* p = _pos;
+    _pos += size;
+    return p;
+}
+
+/*!
+	Moves to the next block which is reused or allocated, if there is none.
+*/
+void CADrawableArena::nextBlock()
+{
+    _block++;
+    if (_block == _blocks.size()) {
+        _blocks << static_cast<char*>(::operator new(BLOCK_SIZE));
+    }
+
+    _pos = _blocks[_block];
+    _end = _pos + BLOCK_SIZE;
+}
+
+/*!
+	Makes all the memory of the arena available again.
+	All the objects allocated in the arena must be deleted before.
+*/
+void CADrawableArena::reset()
+{
+    Q_ASSERT(_released == _used); // an element allocated in the arena is still alive
+
+    for (int i = 0; i < _largeBlocks.size(); i++) {
+        ::operator delete(_largeBlocks[i]);
+    }
+    _largeBlocks.clear();
+
+    _block = -1;
+    _pos = _end = nullptr;
+    _used = _released = 0;
+}
+
+/*!
+	Returns True, if more than half of the used memory belongs to deleted objects.
+	Small arenas are never fragmented.
+*/
+bool CADrawableArena::isFragmented() const
+{
+    return _released > BLOCK_SIZE * 16 && _released > _used / 2;
+}
+
+/*!
+	\class CADrawableArena::CAScope
+	\brief Sets the arena the new drawable elements are allocated from
+
+	The arena is used from the construction of the scope until it is destroyed. Scopes may be
+	nested. A scope with a null arena or created while the arenas are disabled makes the
+	drawable elements be allocated on the heap.
+
+	\sa setEnabled()
+*/
+
+CADrawableArena::CAScope::CAScope(CADrawableArena* arena)
+    : _previous(CADrawableArena::_current)
+{
+    CADrawableArena::_current = CADrawableArena::_enabled ? arena : nullptr;
+}
+
+CADrawableArena::CAScope::~CAScope()
+{
+    CADrawableArena::_current = _previous;
+}
@@ -0,0 +1,62 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#ifndef DRAWABLEARENA_H_
+#define DRAWABLEARENA_H_
+
+#include <QVector>
+
+#include <cstddef>
+
+class CADrawableArena {
+public:
+    CADrawableArena();
+    CADrawableArena(const CADrawableArena&) = delete;
+    CADrawableArena& operator=(const CADrawableArena&) = delete;
+    ~CADrawableArena();
+
+    void* allocate(std::size_t size);
+    inline void release(std::size_t size) { _released += alignedSize(size); }
+    void reset();
+
+    inline std::size_t usedBytes() const { return _used; }
+    inline std::size_t releasedBytes() const { return _released; }
+    bool isFragmented() const;
+
+    static inline CADrawableArena* current() { return _current; }
+    static inline bool isEnabled() { return _enabled; }
+    static inline void setEnabled(bool enabled) { _enabled = enabled; }
+    static inline std::size_t alignedSize(std::size_t size) { return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT; }
+
+    class CAScope {
+    public:
+        CAScope(CADrawableArena* arena);
+        ~CAScope();
+
+    private:
+        CADrawableArena* _previous;
+    };
+
+    static const std::size_t ALIGNMENT; // Alignment of all the allocations
+    static const std::size_t BLOCK_SIZE; // Size of the blocks allocated from the heap
+
+private:
+    void nextBlock();
+
+    static thread_local CADrawableArena* _current; // Arena new drawable elements are allocated from in this thread, see CAScope
+    static bool _enabled; // Whether scopes use their arena, see setEnabled()
+
+    QVector<char*> _blocks; // Blocks of BLOCK_SIZE bytes, kept when the arena is reset
+    QVector<char*> _largeBlocks; // Blocks of the allocations larger than BLOCK_SIZE, freed when the arena is reset
+    int _block; // Index of the current block in _blocks
+    char* _pos; // Next free byte in the current block
+    char* _end; // End of the current block
+    std::size_t _used; // Bytes allocated since the last reset
+    std::size_t _released; // Bytes of the objects deleted since the last reset
+};
+
+#endif /* DRAWABLEARENA_H_ */
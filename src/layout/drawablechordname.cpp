@@ -46,6 +46,10 @@ CADrawableChordName::~CADrawableChordName()
 
 void CADrawableChordName::draw(QPainter* p, const CADrawSettings s)
 {
+    if (detailLevel(s.z) != FullDetail) {
+        return;
+    }
+
     QPen pen(s.color);
     pen.setWidth(qRound(1.2 * s.z));
     pen.setCapStyle(Qt::RoundCap);
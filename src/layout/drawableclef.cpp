@@ -12,6 +12,7 @@
 
 #include "layout/drawableclef.h"
 #include "layout/drawablestaff.h"
+#include "layout/glyphcache.h"
 
 #include "canorus.h"
 #include "score/clef.h"
@@ -73,10 +74,14 @@ CADrawableClef::CADrawableClef(CAClef* musElement, CADrawableStaff* drawableStaf
 
 void CADrawableClef::draw(QPainter* p, CADrawSettings s)
 {
-    QFont font("Emmentaler");
-    font.setPixelSize(qRound(35 * s.z));
+    const int glyphSize = qRound(35 * s.z);
+    if (detailLevel(s.z) == OutlineDetail) {
+        // only a bar over the height of the clef
+        p->fillRect(s.x, s.y, qMax(1, qRound(width() * s.z / 3)), qMax(1, qRound(height() * s.z)), s.color);
+        return;
+    }
+
     p->setPen(QPen(s.color));
-    p->setFont(font);
 
     /*
 		There are two glyphs for each clef type: a normal clef (placed at the beginning of the system) and a smaller one (at the center of the system, key change).
@@ -84,13 +89,13 @@ void CADrawableClef::draw(QPainter* p, CADrawSettings s)
 	*/
     switch (clef()->clefType()) {
     case CAClef::G:
-        p->drawText(s.x, qRound(s.y + (clef()->offset() > 0 ? CLEF_EIGHT_SIZE * s.z : 0) + 0.63 * (height() - (clef()->offset() ? CLEF_EIGHT_SIZE : 0)) * s.z), QString(CACanorus::fetaCodepoint("clefs.G")));
+        CAGlyphCache::drawGlyph(p, s.x, qRound(s.y + (clef()->offset() > 0 ? CLEF_EIGHT_SIZE * s.z : 0) + 0.63 * (height() - (clef()->offset() ? CLEF_EIGHT_SIZE : 0)) * s.z), "clefs.G", glyphSize, s.color);
         break;
     case CAClef::F:
-        p->drawText(s.x, qRound(s.y + (clef()->offset() > 0 ? CLEF_EIGHT_SIZE * s.z : 0) + 0.32 * (height() - (clef()->offset() ? CLEF_EIGHT_SIZE : 0)) * s.z), QString(CACanorus::fetaCodepoint("clefs.F")));
+        CAGlyphCache::drawGlyph(p, s.x, qRound(s.y + (clef()->offset() > 0 ? CLEF_EIGHT_SIZE * s.z : 0) + 0.32 * (height() - (clef()->offset() ? CLEF_EIGHT_SIZE : 0)) * s.z), "clefs.F", glyphSize, s.color);
         break;
     case CAClef::C:
-        p->drawText(s.x, qRound(s.y + (clef()->offset() > 0 ? CLEF_EIGHT_SIZE * s.z : 0) + 0.5 * (height() - (clef()->offset() ? CLEF_EIGHT_SIZE : 0)) * s.z), QString(CACanorus::fetaCodepoint("clefs.C")));
+        CAGlyphCache::drawGlyph(p, s.x, qRound(s.y + (clef()->offset() > 0 ? CLEF_EIGHT_SIZE * s.z : 0) + 0.5 * (height() - (clef()->offset() ? CLEF_EIGHT_SIZE : 0)) * s.z), "clefs.C", glyphSize, s.color);
         break;
     case CAClef::Tab:
     case CAClef::PercussionHigh:
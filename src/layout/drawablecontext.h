@@ -9,6 +9,7 @@
 #define DRAWABLECONTEXT_H_
 
 #include <QList>
+#include <QSet>
 
 #include "layout/drawable.h"
 #include "layout/drawablemuselement.h"
@@ -36,6 +37,7 @@ public:
         _drawableMusElementList.insert(++i, elt);
     }
     virtual int removeMElement(CADrawableMusElement* elt) { return _drawableMusElementList.removeAll(elt); }
+    virtual void removeMElements(const QSet<CADrawableMusElement*>& elts);
     CADrawableMusElement* lastDrawableMusElement()
     {
         if (_drawableMusElementList.size())
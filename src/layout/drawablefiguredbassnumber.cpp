@@ -30,6 +30,10 @@ CADrawableFiguredBassNumber::~CADrawableFiguredBassNumber()
 
 void CADrawableFiguredBassNumber::draw(QPainter* p, const CADrawSettings s)
 {
+    if (detailLevel(s.z) != FullDetail) {
+        return;
+    }
+
     QPen pen(s.color);
     pen.setWidth(qRound(1.2 * s.z));
     pen.setCapStyle(Qt::RoundCap);
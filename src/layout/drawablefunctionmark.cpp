@@ -176,6 +176,10 @@ CADrawableFunctionMark::~CADrawableFunctionMark()
 
 void CADrawableFunctionMark::draw(QPainter* p, CADrawSettings s)
 {
+    if (detailLevel(s.z) != FullDetail) { // texts are unreadable when zoomed out
+        return;
+    }
+
     int rightBorder = s.x + qRound(width() * s.z);
 
     QFont font("FreeSans");
@@ -390,6 +394,10 @@ CADrawableFunctionMarkSupport::~CADrawableFunctionMarkSupport()
 
 void CADrawableFunctionMarkSupport::draw(QPainter* p, const CADrawSettings s)
 {
+    if (detailLevel(s.z) != FullDetail) {
+        return;
+    }
+
     QFont font("FreeSans");
     QString text;
     CAFunctionMark::CAFunctionType type = CAFunctionMark::CAFunctionType::Undefined;
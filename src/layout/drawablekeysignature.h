@@ -25,6 +25,7 @@ public:
     void draw(QPainter* p, CADrawSettings s);
     CADrawableKeySignature* clone(CADrawableContext* newContext = 0);
     inline CAKeySignature* keySignature() { return (CAKeySignature*)_musElement; }
+    inline QList<CADrawableAccidental*>& drawableAccidentalList() { return _drawableAccidentalList; }
 
 private:
     QList<CADrawableAccidental*> _drawableAccidentalList; ///List of actual drawable accidentals
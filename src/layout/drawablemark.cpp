@@ -11,6 +11,7 @@
 #include "layout/drawablecontext.h"
 #include "layout/drawablemark.h"
 #include "layout/drawablenote.h" // needed for tempo mark
+#include "layout/glyphcache.h"
 
 #include "interface/mididevice.h" // needed for instrument change
 
@@ -193,6 +194,10 @@ CADrawableMark::~CADrawableMark()
 
 void CADrawableMark::draw(QPainter* p, CADrawSettings s)
 {
+    if (detailLevel(s.z) != FullDetail) { // marks are left out of the zoomed out overview
+        return;
+    }
+
     p->setPen(QPen(s.color));
 
     switch (mark()->markType()) {
@@ -252,9 +257,7 @@ void CADrawableMark::draw(QPainter* p, CADrawSettings s)
         break;
     }
     case CAMark::Fermata: {
-        QFont font("Emmentaler");
-        font.setPixelSize(qRound(DEFAULT_TEXT_SIZE * 1.1 * s.z));
-        p->setFont(font);
+        const int glyphSize = qRound(DEFAULT_TEXT_SIZE * 1.1 * s.z);
 
         int inverted = 0;
         if (mark()->associatedElement()->musElementType() == CAMusElement::Note && static_cast<CANote*>(mark()->associatedElement())->actualSlurDirection() == CASlur::SlurDown)
@@ -264,16 +267,16 @@ void CADrawableMark::draw(QPainter* p, CADrawSettings s)
         int y = qRound(s.y + (inverted ? 0 : (height() * s.z)));
         switch (static_cast<CAFermata*>(mark())->fermataType()) {
         case CAFermata::NormalFermata:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.ufermata") + inverted));
+            CAGlyphCache::drawGlyph(p, x, y, QChar(CACanorus::fetaCodepoint("scripts.ufermata") + inverted), glyphSize, s.color);
             break;
         case CAFermata::ShortFermata:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.ushortfermata") + inverted));
+            CAGlyphCache::drawGlyph(p, x, y, QChar(CACanorus::fetaCodepoint("scripts.ushortfermata") + inverted), glyphSize, s.color);
             break;
         case CAFermata::LongFermata:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.ulongfermata") + inverted));
+            CAGlyphCache::drawGlyph(p, x, y, QChar(CACanorus::fetaCodepoint("scripts.ulongfermata") + inverted), glyphSize, s.color);
             break;
         case CAFermata::VeryLongFermata:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.uverylongfermata") + inverted));
+            CAGlyphCache::drawGlyph(p, x, y, QChar(CACanorus::fetaCodepoint("scripts.uverylongfermata") + inverted), glyphSize, s.color);
             break;
         }
         break;
@@ -311,21 +314,22 @@ void CADrawableMark::draw(QPainter* p, CADrawSettings s)
         }
 
         // draw the actual sign
+        const int glyphSize = qRound(DEFAULT_TEXT_SIZE * 1.4 * s.z);
         QFont font("Emmentaler");
-        font.setPixelSize(qRound(DEFAULT_TEXT_SIZE * 1.4 * s.z));
+        font.setPixelSize(glyphSize);
         p->setFont(font);
         switch (static_cast<CARepeatMark*>(mark())->repeatMarkType()) {
         case CARepeatMark::Segno:
         case CARepeatMark::DalSegno:
-            p->drawText(s.x, s.y, QString(CACanorus::fetaCodepoint("scripts.segno")));
+            CAGlyphCache::drawGlyph(p, s.x, s.y, "scripts.segno", glyphSize, s.color);
             break;
         case CARepeatMark::Coda:
         case CARepeatMark::DalCoda:
-            p->drawText(s.x, s.y, QString(CACanorus::fetaCodepoint("scripts.coda")));
+            CAGlyphCache::drawGlyph(p, s.x, s.y, "scripts.coda", glyphSize, s.color);
             break;
         case CARepeatMark::VarCoda:
         case CARepeatMark::DalVarCoda:
-            p->drawText(s.x, s.y, QString(CACanorus::fetaCodepoint("scripts.varcoda")));
+            CAGlyphCache::drawGlyph(p, s.x, s.y, "scripts.varcoda", glyphSize, s.color);
             break;
         case CARepeatMark::Volta:
             break;
@@ -354,102 +358,98 @@ void CADrawableMark::draw(QPainter* p, CADrawSettings s)
         break;
     }
     case CAMark::Pedal: {
-        QFont font("Emmentaler");
-        font.setPixelSize(qRound(DEFAULT_TEXT_SIZE * 1.6 * s.z));
-        p->setFont(font);
-        p->drawText(s.x, s.y + qRound(height() * s.z), QString(CACanorus::fetaCodepoint("pedal.Ped")));
-        p->drawText(s.x + qRound((width() - 10) * s.z), s.y + qRound(height() * s.z), QString(CACanorus::fetaCodepoint("pedal.*")));
+        const int glyphSize = qRound(DEFAULT_TEXT_SIZE * 1.6 * s.z);
+        CAGlyphCache::drawGlyph(p, s.x, s.y + qRound(height() * s.z), "pedal.Ped", glyphSize, s.color);
+        CAGlyphCache::drawGlyph(p, s.x + qRound((width() - 10) * s.z), s.y + qRound(height() * s.z), "pedal.*", glyphSize, s.color);
 
         break;
     }
     case CAMark::Articulation: {
-        QFont font("Emmentaler");
-        font.setPixelSize(qRound(DEFAULT_TEXT_SIZE * 1.4 * s.z));
-        p->setFont(font);
+        const int glyphSize = qRound(DEFAULT_TEXT_SIZE * 1.4 * s.z);
 
         int x = s.x + qRound((width() / 2.0) * s.z);
         int y = s.y + qRound(height() * s.z);
         switch (static_cast<CAArticulation*>(mark())->articulationType()) {
         case CAArticulation::Accent:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.sforzato")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.sforzato", glyphSize, s.color);
             break;
         case CAArticulation::Marcato:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.umarcato")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.umarcato", glyphSize, s.color);
             break;
         case CAArticulation::Staccatissimo:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.ustaccatissimo")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.ustaccatissimo", glyphSize, s.color);
             break;
         case CAArticulation::Espressivo:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.espr")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.espr", glyphSize, s.color);
             break;
         case CAArticulation::Staccato:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.staccato")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.staccato", glyphSize, s.color);
             break;
         case CAArticulation::Tenuto:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.tenuto")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.tenuto", glyphSize, s.color);
             break;
         case CAArticulation::Breath:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.rcomma")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.rcomma", glyphSize, s.color);
             break;
         case CAArticulation::Portato:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.uportato")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.uportato", glyphSize, s.color);
             break;
         case CAArticulation::UpBow:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.upbow")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.upbow", glyphSize, s.color);
             break;
         case CAArticulation::DownBow:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.downbow")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.downbow", glyphSize, s.color);
             break;
         case CAArticulation::Flageolet:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.flageolet")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.flageolet", glyphSize, s.color);
             break;
         case CAArticulation::Open:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.open")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.open", glyphSize, s.color);
             break;
         case CAArticulation::Stopped:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.stopped")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.stopped", glyphSize, s.color);
             break;
         case CAArticulation::Turn:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.turn")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.turn", glyphSize, s.color);
             break;
         case CAArticulation::ReverseTurn:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.reverseturn")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.reverseturn", glyphSize, s.color);
             break;
         case CAArticulation::Trill:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.trill")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.trill", glyphSize, s.color);
             break;
         case CAArticulation::Prall:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.prall")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.prall", glyphSize, s.color);
             break;
         case CAArticulation::Mordent:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.mordent")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.mordent", glyphSize, s.color);
             break;
         case CAArticulation::PrallPrall:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.prallprall")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.prallprall", glyphSize, s.color);
             break;
         case CAArticulation::PrallMordent:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.prallmordent")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.prallmordent", glyphSize, s.color);
             break;
         case CAArticulation::UpPrall:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.upprall")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.upprall", glyphSize, s.color);
             break;
         case CAArticulation::DownPrall:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.downprall")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.downprall", glyphSize, s.color);
             break;
         case CAArticulation::UpMordent:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.upmordent")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.upmordent", glyphSize, s.color);
             break;
         case CAArticulation::DownMordent:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.downmordent")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.downmordent", glyphSize, s.color);
             break;
         case CAArticulation::PrallDown:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.pralldown")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.pralldown", glyphSize, s.color);
             break;
         case CAArticulation::PrallUp:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.prallup")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.prallup", glyphSize, s.color);
             break;
         case CAArticulation::LinePrall:
-            p->drawText(x, y, QString(CACanorus::fetaCodepoint("scripts.lineprall")));
+            CAGlyphCache::drawGlyph(p, x, y, "scripts.lineprall", glyphSize, s.color);
             break;
         case CAArticulation::Undefined:
             fprintf(stderr, "Warning: CADrawableMark::draw - Unhandled A-Type %d", static_cast<CAArticulation*>(mark())->articulationType());
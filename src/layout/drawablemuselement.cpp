@@ -13,4 +13,6 @@ CADrawableMusElement::CADrawableMusElement(CAMusElement* m, CADrawableContext* d
     setDrawableType(CADrawable::DrawableMusElement);
     _musElement = m;
     _drawableContext = drawableContext;
+    _state = 0;
+    _layoutIndex = -1;
 }
@@ -34,6 +34,18 @@ public:
         DrawableChordName,
     };
 
+    /*!
+		Properties of the music element which affect painting, set when the element is added
+		to the layout, so painting doesn't need to look them up. The selection and the selected
+		voice are kept in each score view, because the drawable elements are shared by all the
+		views of the sheet (see CASheetLayout). The view stores their state bits by
+		layoutIndex().
+	*/
+    enum CADrawableState {
+        Hidden = 0x01, // hidden rest
+        Invisible = 0x02 // music element set as not visible
+    };
+
     CADrawableMusElement(CAMusElement* musElement, CADrawableContext* drawableContext, double x, double y);
 
     CADrawableMusElementType drawableMusElementType() { return _drawableMusElementType; }
@@ -43,6 +55,12 @@ public:
     virtual CADrawable* clone() { return clone(nullptr); }
     virtual CADrawableMusElement* clone(CADrawableContext* newContext = nullptr) = 0;
 
+    inline bool hasState(CADrawableState state) const { return _state & state; }
+    inline void setState(CADrawableState state, bool on) { _state = on ? (_state | state) : (_state & ~state); }
+
+    inline int layoutIndex() const { return _layoutIndex; }
+    inline void setLayoutIndex(int index) { _layoutIndex = index; }
+
 protected:
     void setDrawableMusElementType(CADrawableMusElementType t) { _drawableMusElementType = t; }
 
@@ -50,6 +68,8 @@ protected:
     CADrawableContext* _drawableContext;
     CAMusElement* _musElement;
     bool _selectable;
+    unsigned int _state; // CADrawableState flags
+    int _layoutIndex; // Position in CASheetLayout::drawableMOrder(), -1 if not in a layout. Indexes the per-view state of the element.
 };
 
 #endif /* DRAWABLEMUSELEMENT_H_ */
@@ -10,6 +10,7 @@
 #include "layout/drawableaccidental.h"
 #include "layout/drawablecontext.h"
 #include "layout/drawablestaff.h"
+#include "layout/glyphcache.h"
 #include "score/staff.h"
 #include "score/voice.h"
 #include <QPainter>
@@ -141,11 +142,16 @@ CADrawableNote::~CADrawableNote()
 
 void CADrawableNote::draw(QPainter* p, CADrawSettings s)
 {
-    QFont font("Emmentaler");
-    font.setPixelSize(qRound(35 * s.z));
+    const int glyphSize = qRound(35 * s.z);
+    const CADetailLevel detail = detailLevel(s.z);
+
+    if (detail == OutlineDetail) {
+        // only a block in place of the notehead
+        p->fillRect(s.x, s.y, qMax(1, qRound(_noteHeadWidth * s.z)), qMax(1, qRound(height() * s.z)), s.color);
+        return;
+    }
 
     p->setPen(QPen(s.color));
-    p->setFont(font);
 
     QPen pen;
 
@@ -173,7 +179,20 @@ void CADrawableNote::draw(QPainter* p, CADrawSettings s)
 
     // Draw notehead
     s.y += height() * s.z / 2;
-    p->drawText(s.x, s.y, QString(CACanorus::fetaCodepoint(_noteHeadGlyphName)));
+    if (detail == ReducedDetail) {
+        // ellipse instead of the glyph, filled for quarters and shorter
+        QRectF head(s.x, s.y - height() * s.z / 2, _noteHeadWidth * s.z, height() * s.z);
+        if (note()->noteLength().musicLength() >= CAPlayableLength::Quarter) {
+            p->setPen(Qt::NoPen);
+            p->setBrush(s.color);
+        } else {
+            p->setPen(QPen(s.color));
+        }
+        p->drawEllipse(head);
+        p->setBrush(Qt::NoBrush);
+    } else {
+        CAGlyphCache::drawGlyph(p, s.x, s.y, _noteHeadGlyphName, glyphSize, s.color);
+    }
 
     if (note()->noteLength().musicLength() >= CAPlayableLength::Half) {
         // Draw stem and flag
@@ -184,15 +203,15 @@ void CADrawableNote::draw(QPainter* p, CADrawSettings s)
         if (_stemDirection == CANote::StemUp) {
             s.x += qRound(_noteHeadWidth * s.z); // increase X-offset before drawing the stem
             p->drawLine(s.x, qRound(s.y - 1 * s.z), s.x, s.y - qRound(_stemLength * s.z));
-            if (note()->noteLength().musicLength() >= CAPlayableLength::Eighth) {
-                p->drawText(qRound(s.x + 0.6 * s.z), qRound(s.y - _stemLength * s.z), QString(CACanorus::fetaCodepoint(_flagUpGlyphName)));
+            if (note()->noteLength().musicLength() >= CAPlayableLength::Eighth && detail == FullDetail) {
+                CAGlyphCache::drawGlyph(p, qRound(s.x + 0.6 * s.z), qRound(s.y - _stemLength * s.z), _flagUpGlyphName, glyphSize, s.color);
                 s.x += qRound(6 * s.z); // additional X-offset for dots because of the flag on the right
             }
         } else {
             s.x += qRound(0.6 * s.z);
             p->drawLine(s.x, qRound(s.y + 1 * s.z), s.x, s.y + qRound(_stemLength * s.z));
-            if (note()->noteLength().musicLength() >= CAPlayableLength::Eighth) {
-                p->drawText(qRound(s.x + 0.4 * s.z), qRound(s.y + (_stemLength + 5) * s.z), QString(CACanorus::fetaCodepoint(_flagDownGlyphName)));
+            if (note()->noteLength().musicLength() >= CAPlayableLength::Eighth && detail == FullDetail) {
+                CAGlyphCache::drawGlyph(p, qRound(s.x + 0.4 * s.z), qRound(s.y + (_stemLength + 5) * s.z), _flagDownGlyphName, glyphSize, s.color);
             }
             s.x += qRound(_noteHeadWidth * s.z); // increase X-offset after drawing the stem
         }
@@ -202,7 +221,7 @@ void CADrawableNote::draw(QPainter* p, CADrawSettings s)
 
     // Draw Dots
     double delta = 4 * s.z;
-    for (int i = 0; i < note()->playableLength().dotted(); i++) {
+    for (int i = 0; detail == FullDetail && i < note()->playableLength().dotted(); i++) {
         pen.setWidth(qRound(2.7 * s.z) + 1);
         pen.setCapStyle(Qt::RoundCap);
         pen.setColor(s.color);
@@ -9,6 +9,7 @@
 #include "canorus.h"
 #include "layout/drawablecontext.h"
 #include "layout/drawablestaff.h"
+#include "layout/glyphcache.h"
 #include "score/rest.h"
 
 #include <QPainter>
@@ -100,48 +101,52 @@ CADrawableRest* CADrawableRest::clone(CADrawableContext* newContext)
 
 void CADrawableRest::draw(QPainter* p, CADrawSettings s)
 {
-    QFont font("Emmentaler");
-    font.setPixelSize(qRound(35 * s.z));
+    const int glyphSize = qRound(35 * s.z);
+
+    if (detailLevel(s.z) == OutlineDetail) {
+        // only a thin block in the middle of the rest
+        p->fillRect(s.x, qRound(s.y + height() * s.z / 3), qMax(1, qRound(_restWidth * s.z)), qMax(1, qRound(height() * s.z / 3)), s.color);
+        return;
+    }
 
     p->setPen(QPen(s.color));
-    p->setFont(font);
 
     QPen pen;
     switch (rest()->playableLength().musicLength()) {
     case CAPlayableLength::HundredTwentyEighth: {
-        p->drawText(qRound(s.x + 4 * s.z), qRound(s.y + (2.6 * (static_cast<CADrawableStaff*>(_drawableContext))->lineSpace()) * s.z), QString(CACanorus::fetaCodepoint("rests.7")));
+        CAGlyphCache::drawGlyph(p, qRound(s.x + 4 * s.z), qRound(s.y + (2.6 * (static_cast<CADrawableStaff*>(_drawableContext))->lineSpace()) * s.z), "rests.7", glyphSize, s.color);
         break;
     }
     case CAPlayableLength::SixtyFourth: {
-        p->drawText(qRound(s.x + 3 * s.z), qRound(s.y + (1.75 * (static_cast<CADrawableStaff*>(_drawableContext))->lineSpace()) * s.z), QString(CACanorus::fetaCodepoint("rests.6")));
+        CAGlyphCache::drawGlyph(p, qRound(s.x + 3 * s.z), qRound(s.y + (1.75 * (static_cast<CADrawableStaff*>(_drawableContext))->lineSpace()) * s.z), "rests.6", glyphSize, s.color);
         break;
     }
     case CAPlayableLength::ThirtySecond: {
-        p->drawText(qRound(s.x + 2.5 * s.z), qRound(s.y + (1.8 * (static_cast<CADrawableStaff*>(_drawableContext))->lineSpace()) * s.z), QString(CACanorus::fetaCodepoint("rests.5")));
+        CAGlyphCache::drawGlyph(p, qRound(s.x + 2.5 * s.z), qRound(s.y + (1.8 * (static_cast<CADrawableStaff*>(_drawableContext))->lineSpace()) * s.z), "rests.5", glyphSize, s.color);
         break;
     }
     case CAPlayableLength::Sixteenth: {
-        p->drawText(qRound(s.x + 1 * s.z), qRound(s.y + ((static_cast<CADrawableStaff*>(_drawableContext))->lineSpace() - 0.9) * s.z), QString(CACanorus::fetaCodepoint("rests.4")));
+        CAGlyphCache::drawGlyph(p, qRound(s.x + 1 * s.z), qRound(s.y + ((static_cast<CADrawableStaff*>(_drawableContext))->lineSpace() - 0.9) * s.z), "rests.4", glyphSize, s.color);
         break;
     }
     case CAPlayableLength::Eighth: {
-        p->drawText(s.x, qRound(s.y + ((static_cast<CADrawableStaff*>(_drawableContext))->lineSpace() - 0.9) * s.z), QString(CACanorus::fetaCodepoint("rests.3")));
+        CAGlyphCache::drawGlyph(p, s.x, qRound(s.y + ((static_cast<CADrawableStaff*>(_drawableContext))->lineSpace() - 0.9) * s.z), "rests.3", glyphSize, s.color);
         break;
     }
     case CAPlayableLength::Quarter: {
-        p->drawText(s.x, qRound(s.y + 0.5 * height() * s.z), QString(CACanorus::fetaCodepoint("rests.2")));
+        CAGlyphCache::drawGlyph(p, s.x, qRound(s.y + 0.5 * height() * s.z), "rests.2", glyphSize, s.color);
         break;
     }
     case CAPlayableLength::Half: {
-        p->drawText(s.x, qRound(s.y + height() * s.z + 0.5), QString(CACanorus::fetaCodepoint("rests.1")));
+        CAGlyphCache::drawGlyph(p, s.x, qRound(s.y + height() * s.z + 0.5), "rests.1", glyphSize, s.color);
         break;
     }
     case CAPlayableLength::Whole: {
-        p->drawText(s.x, s.y, QString(CACanorus::fetaCodepoint("rests.0")));
+        CAGlyphCache::drawGlyph(p, s.x, s.y, "rests.0", glyphSize, s.color);
         break;
     }
     case CAPlayableLength::Breve: {
-        p->drawText(s.x, qRound(s.y + height() * s.z), QString(CACanorus::fetaCodepoint("rests.M1")));
+        CAGlyphCache::drawGlyph(p, s.x, qRound(s.y + height() * s.z), "rests.M1", glyphSize, s.color);
         break;
     }
     case CAPlayableLength::Undefined:
@@ -91,6 +91,14 @@ void CADrawableSlur::draw(QPainter* p, const CADrawSettings s)
     double yMidl = s.y + (yMid() - minY) * s.z;
     double xMidl = s.x + (xMid() - xPos()) * s.z;
     double yRight = s.y + (y2() - minY) * s.z;
+    if (detailLevel(s.z) != FullDetail) {
+        // straight segments through the middle point instead of the rounded curve
+        QPoint points[3] = { QPoint(s.x, qRound(yLeft)), QPoint(qRound(xMidl), qRound(yMidl)), QPoint(qRound(s.x + width() * s.z), qRound(yRight)) };
+        p->drawPolyline(points, 3);
+        p->setRenderHint(QPainter::Antialiasing, aliasing);
+        return;
+    }
+
     double deltaY1 = (yMidl - yLeft);
     double deltaY2 = (yRight - yMidl);
     double deltaX1 = xMidl - s.x;
@@ -7,6 +7,7 @@
 
 #include <QDebug>
 #include <QPainter>
+#include <QVector>
 
 #include "layout/drawablebarline.h"
 #include "layout/drawableclef.h"
@@ -38,10 +39,11 @@ void CADrawableStaff::draw(QPainter* p, const CADrawSettings s)
     pen.setColor(s.color);
     p->setPen(pen);
     double dy = lineSpace() * s.z;
-    for (int i = 0; i < staff()->numberOfLines(); i++) {
-        p->drawLine(0, qRound(s.y + dy * i),
-            s.w, qRound(s.y + dy * i));
+    QVector<QLine> lines(staff()->numberOfLines());
+    for (int i = 0; i < lines.size(); i++) {
+        lines[i] = QLine(0, qRound(s.y + dy * i), s.w, qRound(s.y + dy * i));
     }
+    p->drawLines(lines); // all the lines at once, the pen is set up only once
 }
 
 CADrawableStaff* CADrawableStaff::clone()
@@ -179,10 +181,8 @@ int CADrawableStaff::getAccs(double x, int pitch)
 {
     CAKeySignature* key = getKeySignature(x);
 
-    //find nearest left element
-    int i;
-    for (i = 0; i < _drawableMusElementList.size() && _drawableMusElementList[i]->xPos() < x; i++)
-        ;
+    //find nearest left element, the elements are sorted by their left borders
+    int i = static_cast<int>(std::lower_bound(_drawableMusElementList.constBegin(), _drawableMusElementList.constEnd(), x, [](const CADrawableMusElement* elt, double x) { return elt->xPos() < x; }) - _drawableMusElementList.constBegin());
     i--;
 
     while (i >= 0 && _drawableMusElementList[i]->drawableMusElementType() != CADrawableMusElement::DrawableBarline && _drawableMusElementList[i]->drawableMusElementType() != CADrawableMusElement::DrawableKeySignature && (!(_drawableMusElementList[i]->drawableMusElementType() == CADrawableMusElement::DrawableNote && (static_cast<CANote*>(_drawableMusElementList[i]->musElement())->diatonicPitch().noteName() == pitch)))) { // go back until the barline, key signature or note with accidentals is found
@@ -350,10 +350,12 @@ int CADrawableStaff::removeMElement(CADrawableMusElement* elt)
     case CADrawableMusElement::DrawableTimeSignature:
         removeTimeSignature(static_cast<CADrawableTimeSignature*>(elt));
         break;
+    case CADrawableMusElement::DrawableBarline:
+        removeBarline(static_cast<CADrawableBarline*>(elt));
+        break;
     case CADrawableMusElement::DrawableNote:
     case CADrawableMusElement::DrawableRest:
     case CADrawableMusElement::DrawableMidiNote:
-    case CADrawableMusElement::DrawableBarline:
     case CADrawableMusElement::DrawableAccidental:
     case CADrawableMusElement::DrawableSlur:
     case CADrawableMusElement::DrawableTuplet:
@@ -369,3 +371,24 @@ int CADrawableStaff::removeMElement(CADrawableMusElement* elt)
 
     return _drawableMusElementList.removeAll(elt);
 }
+
+/*!
+	Removes all the given drawable music elements \a elts from the staff and its look-up lists.
+*/
+void CADrawableStaff::removeMElements(const QSet<CADrawableMusElement*>& elts)
+{
+    for (int i = _drawableClefList.size() - 1; i >= 0; i--)
+        if (elts.contains(_drawableClefList[i]))
+            _drawableClefList.removeAt(i);
+    for (int i = _drawableKeySignatureList.size() - 1; i >= 0; i--)
+        if (elts.contains(_drawableKeySignatureList[i]))
+            _drawableKeySignatureList.removeAt(i);
+    for (int i = _drawableTimeSignatureList.size() - 1; i >= 0; i--)
+        if (elts.contains(_drawableTimeSignatureList[i]))
+            _drawableTimeSignatureList.removeAt(i);
+    for (int i = _drawableBarlineList.size() - 1; i >= 0; i--)
+        if (elts.contains(_drawableBarlineList[i]))
+            _drawableBarlineList.removeAt(i);
+
+    CADrawableContext::removeMElements(elts);
+}
@@ -59,6 +59,7 @@ public:
     int getAccs(double x, int pitch);
     void addMElement(CADrawableMusElement* elt);
     int removeMElement(CADrawableMusElement* elt);
+    void removeMElements(const QSet<CADrawableMusElement*>& elts);
 
 private:
     QList<CADrawableClef*> _drawableClefList; // List of all the drawable clefs. Used for fast look-up with the given key - X-coordinate usually.
@@ -39,6 +39,10 @@ CADrawableSyllable::~CADrawableSyllable()
 
 void CADrawableSyllable::draw(QPainter* p, const CADrawSettings s)
 {
+    if (detailLevel(s.z) != FullDetail) { // lyrics are unreadable at this size
+        return;
+    }
+
     QPen pen(s.color);
     pen.setWidth(qRound(1.2 * s.z));
     pen.setCapStyle(Qt::RoundCap);
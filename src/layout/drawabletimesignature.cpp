@@ -7,6 +7,7 @@
 
 #include "layout/drawabletimesignature.h"
 #include "layout/drawablestaff.h"
+#include "layout/glyphcache.h"
 #include "score/timesignature.h"
 
 #include <QDebug>
@@ -47,10 +48,8 @@ CADrawableTimeSignature::~CADrawableTimeSignature()
 
 void CADrawableTimeSignature::draw(QPainter* p, CADrawSettings s)
 {
-    QFont font("Emmentaler");
-    font.setPixelSize(qRound(37 * s.z));
+    const int glyphSize = qRound(37 * s.z);
     p->setPen(QPen(s.color));
-    p->setFont(font);
 
     /*
 	 * Time signature emmentaler numbers glyphs:
@@ -64,10 +63,10 @@ void CADrawableTimeSignature::draw(QPainter* p, CADrawSettings s)
         // Draw C or C|, if needed.
         if (timeSignature()->timeSignatureType() == CATimeSignature::Classical) {
             if ((timeSignature()->beat() == 4) && (timeSignature()->beats() == 4)) {
-                p->drawText(s.x, qRound(s.y + 0.5 * height() * s.z), QString(CACanorus::fetaCodepoint("timesig.C44")));
+                CAGlyphCache::drawGlyph(p, s.x, qRound(s.y + 0.5 * height() * s.z), "timesig.C44", glyphSize, s.color);
                 break;
             } else if ((timeSignature()->beat() == 2) && (timeSignature()->beats() == 2)) {
-                p->drawText(s.x, qRound(s.y + 0.5 * height() * s.z), QString(CACanorus::fetaCodepoint("timesig.C22")));
+                CAGlyphCache::drawGlyph(p, s.x, qRound(s.y + 0.5 * height() * s.z), "timesig.C22", glyphSize, s.color);
                 break;
             }
         }
@@ -78,9 +77,9 @@ void CADrawableTimeSignature::draw(QPainter* p, CADrawSettings s)
         double curX = s.x;
         while (!curBeats.isEmpty() || !curBeat.isEmpty()) {
             if (!curBeats.isEmpty())
-                p->drawText(qRound(curX), qRound(s.y + 0.5 * drawableContext()->height() * s.z), QString(curBeats[0]));
+                CAGlyphCache::drawGlyph(p, qRound(curX), qRound(s.y + 0.5 * drawableContext()->height() * s.z), curBeats[0], glyphSize, s.color);
             if (!curBeat.isEmpty())
-                p->drawText(qRound(curX), qRound(s.y + drawableContext()->height() * s.z), QString(curBeat[0]));
+                CAGlyphCache::drawGlyph(p, qRound(curX), qRound(s.y + drawableContext()->height() * s.z), curBeat[0], glyphSize, s.color);
 
             curX += (14 * s.z);
 
@@ -0,0 +1,175 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QFont>
+#include <QFontMetrics>
+#include <QMutexLocker>
+#include <QPaintDevice>
+#include <QPaintEngine>
+#include <QPainter>
+#include <QtMath>
+
+#include "canorus.h"
+#include "layout/glyphcache.h"
+
+/*!
+	\class CAGlyphCache
+	\brief Cache of pre-rasterized Emmentaler glyphs
+
+	Drawing a feta glyph with QPainter::drawText() goes through the font shaping and
+	rasterization machinery on every repaint, even though a score only uses a few dozen
+	different symbols. This class renders each glyph once per (codepoint, pixel size, color,
+	device pixel ratio) into a transparent image and blits it afterwards.
+
+	The pixel size already encodes the zoom level, so views at different zoom levels keep
+	separate entries. The cache is bounded by the memory of its images (see MAX_COST) and evicts
+	the least recently drawn glyphs first, so changing the zoom of one view doesn't flush the
+	glyphs of the others.
+
+	Painters which don't render into a raster device (printers, SVG, PDF) or use a scaling or
+	rotating transformation still get the vector glyph drawn by drawText().
+
+	The cache is shared by all drawables and views and is guarded by a mutex, so it can be used
+	from rendering threads as well.
+*/
+
+/*!
+	Maximum total size of the cached glyph images in bytes. When exceeded, the least recently
+	used images are dropped.
+*/
+const int CAGlyphCache::MAX_COST = 16 * 1024 * 1024;
+
+QCache<CAGlyphCache::CAGlyphKey, CAGlyphCache::CAGlyphEntry> CAGlyphCache::_cache(CAGlyphCache::MAX_COST);
+QMutex CAGlyphCache::_mutex;
+
+/*!
+	Draws the Emmentaler glyph named \a glyphName (eg. "noteheads.s2") with its baseline origin
+	at \a x, \a y using the given \a pixelSize and \a color.
+*/
+void CAGlyphCache::drawGlyph(QPainter* p, int x, int y, const QString& glyphName, int pixelSize, const QColor& color)
+{
+    drawGlyph(p, x, y, QChar(CACanorus::fetaCodepoint(glyphName)), pixelSize, color);
+}
+
+/*!
+	Draws the Emmentaler character \a glyph with its baseline origin at \a x, \a y.
+	This is an overloaded function provided for glyphs not looked up by name (eg. time signature
+	digits).
+*/
+void CAGlyphCache::drawGlyph(QPainter* p, int x, int y, QChar glyph, int pixelSize, const QColor& color)
+{
+    if (pixelSize <= 0) {
+        return;
+    }
+
+    if (!isCacheable(p)) {
+        QFont font("Emmentaler");
+        font.setPixelSize(pixelSize);
+        p->save();
+        p->setFont(font);
+        p->setPen(QPen(color));
+        p->drawText(x, y, QString(glyph));
+        p->restore();
+        return;
+    }
+
+    qreal dpr = p->device()->devicePixelRatioF();
+    CAGlyphKey key = { glyph.unicode(), pixelSize, color.rgba(), qRound(dpr * 100) };
+
+    CAGlyphEntry entry;
+    _mutex.lock();
+    CAGlyphEntry* cached = _cache.object(key); // also marks the entry as most recently used
+    if (cached) {
+        entry = *cached; // images are implicitly shared, blit them outside of the lock
+    } else {
+        entry = rasterize(glyph, pixelSize, color, dpr);
+        _cache.insert(key, new CAGlyphEntry(entry), qMax(1, entry.image.bytesPerLine() * entry.image.height()));
+    }
+    _mutex.unlock();
+
+    if (!entry.image.isNull()) {
+        p->drawImage(x + entry.offset.x(), y + entry.offset.y(), entry.image);
+    }
+}
+
+/*!
+	Removes all cached glyph images.
+*/
+void CAGlyphCache::clear()
+{
+    QMutexLocker locker(&_mutex);
+    _cache.clear();
+}
+
+/*!
+	Returns the number of cached glyph images.
+*/
+int CAGlyphCache::count()
+{
+    QMutexLocker locker(&_mutex);
+    return _cache.size();
+}
+
+/*!
+	Returns the total size of the cached glyph images in bytes.
+	\sa MAX_COST
+*/
+int CAGlyphCache::cost()
+{
+    QMutexLocker locker(&_mutex);
+    return _cache.totalCost();
+}
+
+/*!
+	Returns True, if the bitmaps can be blitted pixel-exact to the painter's device.
+*/
+bool CAGlyphCache::isCacheable(QPainter* p)
+{
+    if (!p->paintEngine()) {
+        return false;
+    }
+
+    switch (p->paintEngine()->type()) {
+    case QPaintEngine::Raster:
+    case QPaintEngine::OpenGL2:
+        break;
+    default:
+        return false;
+    }
+
+    return p->worldTransform().type() <= QTransform::TxTranslate;
+}
+
+/*!
+	Renders the \a glyph into a transparent image large enough to hold its bounding box.
+*/
+CAGlyphCache::CAGlyphEntry CAGlyphCache::rasterize(QChar glyph, int pixelSize, const QColor& color, qreal dpr)
+{
+    QFont font("Emmentaler");
+    font.setPixelSize(pixelSize);
+    QFontMetrics fm(font);
+
+    CAGlyphEntry entry;
+    QRect rect = fm.boundingRect(glyph).adjusted(-2, -2, 2, 2); // antialiasing margin
+    if (rect.isEmpty()) {
+        return entry;
+    }
+
+    entry.offset = rect.topLeft();
+    entry.image = QImage(qCeil(rect.width() * dpr), qCeil(rect.height() * dpr), QImage::Format_ARGB32_Premultiplied);
+    entry.image.setDevicePixelRatio(dpr);
+    entry.image.fill(Qt::transparent);
+
+    QPainter gp(&entry.image);
+    gp.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing);
+    gp.setFont(font);
+    gp.setPen(QPen(color));
+    gp.drawText(-rect.left(), -rect.top(), QString(glyph));
+    gp.end();
+
+    return entry;
+}
@@ -0,0 +1,62 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#ifndef GLYPHCACHE_H_
+#define GLYPHCACHE_H_
+
+#include <QCache>
+#include <QChar>
+#include <QColor>
+#include <QImage>
+#include <QMutex>
+#include <QPoint>
+#include <QString>
+
+class QPainter;
+
+class CAGlyphCache {
+public:
+    static void drawGlyph(QPainter* p, int x, int y, const QString& glyphName, int pixelSize, const QColor& color);
+    static void drawGlyph(QPainter* p, int x, int y, QChar glyph, int pixelSize, const QColor& color);
+
+    static void clear();
+    static int count();
+    static int cost();
+
+    static const int MAX_COST;
+
+private:
+    struct CAGlyphKey {
+        ushort codepoint;
+        int pixelSize;
+        QRgb color;
+        int dpr; // device pixel ratio * 100
+
+        inline bool operator==(const CAGlyphKey& k) const
+        {
+            return codepoint == k.codepoint && pixelSize == k.pixelSize && color == k.color && dpr == k.dpr;
+        }
+    };
+
+    struct CAGlyphEntry {
+        QImage image;
+        QPoint offset; // top-left corner of the image relative to the glyph origin on the baseline
+    };
+
+    friend inline uint qHash(const CAGlyphKey& k, uint seed = 0)
+    {
+        return ::qHash((uint(k.codepoint) << 16) ^ uint(k.pixelSize) ^ (uint(k.dpr) << 8), seed) ^ ::qHash(k.color, seed);
+    }
+
+    static bool isCacheable(QPainter* p);
+    static CAGlyphEntry rasterize(QChar glyph, int pixelSize, const QColor& color, qreal dpr);
+
+    static QCache<CAGlyphKey, CAGlyphEntry> _cache;
+    static QMutex _mutex;
+};
+
+#endif /* GLYPHCACHE_H_ */
@@ -8,10 +8,12 @@
 #ifndef KDTREE_H
 #define KDTREE_H
 
-#include <QMultiMap>
+#include <QList>
 #include <QRect>
+#include <algorithm>
 #include <iostream> // debugging
 #include <limits> // max double for managing staffs with unlimited width
+#include <vector>
 
 #include "layout/drawable.h"
 #include "layout/drawablecontext.h"
@@ -27,10 +29,20 @@
 	\brief Space partitioning structure for fast access to drawable elements on canvas
 
 	This class is a data structure focused on efficient access to the drawable
-	instances of the music elements. It is based on an interval tree and employs
-	multiple QMap instances to enable efficient query of elements in the given
-	interval, finding the next element in the same staff and mapping a music
-	element to one or more drawable instances.
+	instances of the music elements. It is a packed R-tree which is bulk-loaded
+	using the Sort-Tile-Recursive algorithm.
+
+	Elements are only collected when added. The tree is built the first time it
+	is queried after a change, usually once the layout engine placed all the
+	elements. This way the elements geometry may still be changed while the
+	engraver is placing them.
+
+	Rectangle queries take O(log n + k) time. Elements with zero width (eg. contexts)
+	are unlimited to the right and elements with zero height (eg. helper lines) are
+	unlimited vertically.
+
+	The elements are also kept sorted by their left borders for finding the nearest
+	left and right elements by binary search.
 
 	\sa CAScoreView, CADrawable
 */
@@ -41,7 +53,6 @@ public:
     CAKDTree();
 
     void addElement(T elt);
-    T removeElement(double x, double y);
 
     QList<T> findInRange(double x, double y, double w = 0, double h = 0);
     QList<T> findInRange(QRect& area);
@@ -54,18 +65,44 @@ public:
     double getMaxY();
 
     void clear(bool autoDelete = true);
-    inline int size() { return _mapX.size(); }
-    QList<T> list() { return _mapX.values(); }
+    inline int size() { return _elts.size(); }
+    QList<T> list();
 
 private:
+    class CABox {
+    public:
+        double x1, y1, x2, y2; // bounding box, may be infinite for unlimited elements
+        int first; // index of the first child node or the first entry for leaves
+        int count; // number of children or entries
+        bool leaf;
+    };
+
+    void build();
+    void pack(std::vector<CABox>& items, std::vector<CABox>& parents, bool leaf);
+    bool matches(const CABox& b, double x1, double y1, double x2, double y2) const
+    {
+        return (b.x1 <= x2 && b.x2 >= x1 && b.y1 <= y2 && b.y2 >= y1);
+    }
+    bool isOnVoice(T elt, CADrawableContext* context, CAVoice* voice);
+
+    static const int NODE_CAPACITY = 16; // Maximum number of children per node
+
     //////////////////////
     // Basic properties //
     //////////////////////
-    QMultiMap<double, T> _mapX; // List of all the drawable elements sorted by xPos()
-    QMultiMap<double, T> _mapXW; // List of all the drawable elements sorted by xPos()+width()
-    double _maxY; // The largest Ypos()+height() value of any element
-
-    void calculateMaxY();
+    QList<T> _elts; // List of all the drawable elements in the order they were added
+
+    ///////////////////////////////////////////
+    // Index, built on demand by build() //
+    ///////////////////////////////////////////
+    bool _dirty; // Elements were added since the last build
+    std::vector<T> _sorted; // All the drawable elements sorted by xPos(), the most recently added first on ties
+    std::vector<double> _sortedX; // xPos() of the sorted elements used for binary search
+    std::vector<int> _rankXW; // Rank of the sorted elements by xPos()+width(). Used to order query results.
+    std::vector<CABox> _entries; // Bounding boxes of the elements grouped by leaves. first holds the index in _sorted.
+    std::vector<CABox> _nodes; // All the tree nodes, the root being the last one
+    double _maxX; // The largest xPos()+width() value of any limited element
+    double _maxY; // The largest yPos()+height() value of any element
 };
 
 /*!
@@ -74,28 +111,20 @@ private:
 template <typename T>
 CAKDTree<T>::CAKDTree()
 {
+    _dirty = false;
+    _maxX = 0;
     _maxY = 0;
 }
 
 /*!
 	Adds a drawable element \a elt to the tree.
+	The index is rebuilt when queried next time.
 */
 template <typename T>
 void CAKDTree<T>::addElement(T elt)
 {
-    _mapX.insertMulti(elt->xPos(), elt);
-
-    if (elt->width()) {
-        // regular music element
-        _mapXW.insertMulti(elt->xPos() + elt->width(), elt);
-    } else {
-        // music element with unlimited width (e.g. staffs)
-        _mapXW.insertMulti(std::numeric_limits<double>::max(), elt);
-    }
-
-    if (elt->yPos() + elt->height() > _maxY) {
-        _maxY = elt->yPos() + elt->height();
-    }
+    _elts << elt;
+    _dirty = true;
 }
 
 /*!
@@ -106,38 +135,218 @@ template <typename T>
 void CAKDTree<T>::clear(bool autoDelete)
 {
     if (autoDelete) {
-        for (typename QMultiMap<double, T>::const_iterator it = _mapX.constBegin(); it != _mapX.constEnd(); it++) {
-            delete it.value();
+        for (int i = 0; i < _elts.size(); i++) {
+            delete _elts[i];
         }
     }
 
-    _mapX.clear();
-    _mapXW.clear();
+    _elts.clear();
+    _sorted.clear();
+    _sortedX.clear();
+    _rankXW.clear();
+    _entries.clear();
+    _nodes.clear();
+    _dirty = false;
 
+    _maxX = 0;
     _maxY = 0;
 }
 
+/*!
+	Returns all the elements sorted by their left borders.
+*/
+template <typename T>
+QList<T> CAKDTree<T>::list()
+{
+    build();
+
+    QList<T> l;
+    l.reserve(static_cast<int>(_sorted.size()));
+    for (size_t i = 0; i < _sorted.size(); i++) {
+        l << _sorted[i];
+    }
+    return l;
+}
+
+/*!
+	Bulk-loads the tree out of the added elements, if any were added since the last build.
+	This operation takes O(n log n) time where n is number of elements in the tree.
+*/
+template <typename T>
+void CAKDTree<T>::build()
+{
+    if (!_dirty)
+        return;
+    _dirty = false;
+
+    const double inf = std::numeric_limits<double>::infinity();
+    const int n = _elts.size();
+
+    // sort by the left border, the most recently added element first on ties
+    std::vector<int> order(static_cast<size_t>(n));
+    for (int i = 0; i < n; i++)
+        order[static_cast<size_t>(i)] = i;
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        if (_elts[a]->xPos() != _elts[b]->xPos())
+            return _elts[a]->xPos() < _elts[b]->xPos();
+        return a > b;
+    });
+
+    _sorted.resize(static_cast<size_t>(n));
+    _sortedX.resize(static_cast<size_t>(n));
+    _maxX = 0;
+    _maxY = 0;
+    std::vector<CABox> items(static_cast<size_t>(n));
+    std::vector<double> right(static_cast<size_t>(n));
+    for (int i = 0; i < n; i++) {
+        T elt = _elts[order[static_cast<size_t>(i)]];
+        _sorted[static_cast<size_t>(i)] = elt;
+        _sortedX[static_cast<size_t>(i)] = elt->xPos();
+
+        CABox& b = items[static_cast<size_t>(i)];
+        b.x1 = elt->xPos();
+        b.x2 = elt->width() ? elt->xPos() + elt->width() : inf; // music element with unlimited width (e.g. staffs)
+        b.y1 = elt->height() ? elt->yPos() : -inf; // music element with unlimited height (e.g. helper lines)
+        b.y2 = elt->height() ? elt->yPos() + elt->height() : inf;
+        b.first = i;
+        b.count = 1;
+        b.leaf = true;
+        right[static_cast<size_t>(i)] = b.x2;
+
+        if (elt->width() && elt->xPos() + elt->width() > _maxX)
+            _maxX = elt->xPos() + elt->width();
+        if (elt->yPos() + elt->height() > _maxY)
+            _maxY = elt->yPos() + elt->height();
+    }
+
+    // rank by the right border, the most recently added element first on ties
+    std::vector<int> byRight(static_cast<size_t>(n));
+    for (int i = 0; i < n; i++)
+        byRight[static_cast<size_t>(i)] = i;
+    std::sort(byRight.begin(), byRight.end(), [&right, &order](int a, int b) {
+        if (right[static_cast<size_t>(a)] != right[static_cast<size_t>(b)])
+            return right[static_cast<size_t>(a)] < right[static_cast<size_t>(b)];
+        return order[static_cast<size_t>(a)] > order[static_cast<size_t>(b)];
+    });
+    _rankXW.resize(static_cast<size_t>(n));
+    for (int i = 0; i < n; i++)
+        _rankXW[static_cast<size_t>(byRight[static_cast<size_t>(i)])] = i;
+
+    // pack the leaves, then the upper levels until a single root remains
+    _entries.clear();
+    _nodes.clear();
+    if (!n)
+        return;
+
+    std::vector<CABox> level;
+    pack(items, level, true);
+    _entries = items; // reordered by pack()
+
+    std::vector<std::vector<CABox>> levels;
+    while (level.size() > 1) {
+        std::vector<CABox> parents;
+        pack(level, parents, false);
+        levels.push_back(level);
+        level = parents;
+    }
+    levels.push_back(level);
+
+    // flatten the levels, children of a node are stored contiguously in the previous level
+    int offset = 0;
+    for (size_t l = 0; l < levels.size(); l++) {
+        for (size_t i = 0; i < levels[l].size(); i++) {
+            CABox b = levels[l][i];
+            if (!b.leaf)
+                b.first += offset - static_cast<int>(levels[l - 1].size());
+            _nodes.push_back(b);
+        }
+        offset += static_cast<int>(levels[l].size());
+    }
+}
+
+/*!
+	Groups the given \a items into tiles of at most NODE_CAPACITY items using the Sort-Tile-Recursive
+	algorithm and stores the bounding boxes of the groups to \a parents.
+	The \a items are reordered so that the children of each parent are stored contiguously.
+*/
+template <typename T>
+void CAKDTree<T>::pack(std::vector<CABox>& items, std::vector<CABox>& parents, bool leaf)
+{
+    const size_t n = items.size();
+    const size_t leaves = (n + NODE_CAPACITY - 1) / NODE_CAPACITY;
+    size_t slices = 1;
+    while (slices * slices < leaves)
+        slices++;
+    const size_t sliceSize = slices * NODE_CAPACITY;
+
+    // vertical slices sorted by left border, each slice sorted by top border
+    std::stable_sort(items.begin(), items.end(), [](const CABox& a, const CABox& b) { return a.x1 < b.x1; });
+    for (size_t s = 0; s < n; s += sliceSize) {
+        std::stable_sort(items.begin() + static_cast<long>(s), items.begin() + static_cast<long>(std::min(n, s + sliceSize)),
+            [](const CABox& a, const CABox& b) { return a.y1 < b.y1; });
+    }
+
+    parents.clear();
+    for (size_t s = 0; s < n; s += sliceSize) {
+        size_t sliceEnd = std::min(n, s + sliceSize);
+        for (size_t i = s; i < sliceEnd; i += NODE_CAPACITY) {
+            CABox p;
+            p.first = static_cast<int>(i);
+            p.count = static_cast<int>(std::min(sliceEnd, i + NODE_CAPACITY) - i);
+            p.leaf = leaf;
+            p.x1 = items[i].x1;
+            p.y1 = items[i].y1;
+            p.x2 = items[i].x2;
+            p.y2 = items[i].y2;
+            for (size_t j = i + 1; j < i + static_cast<size_t>(p.count); j++) {
+                p.x1 = std::min(p.x1, items[j].x1);
+                p.y1 = std::min(p.y1, items[j].y1);
+                p.x2 = std::max(p.x2, items[j].x2);
+                p.y2 = std::max(p.y2, items[j].y2);
+            }
+            parents.push_back(p);
+        }
+    }
+}
+
 /*!
 	Returns the list of elements present in the given rectangular area or an empty list if none found.
 	Element is in the list, if the region only touches it - not neccessarily fits the whole in the region.
+	Elements are sorted by their right borders.
 */
 template <typename T>
 QList<T> CAKDTree<T>::findInRange(double x, double y, double w, double h)
 {
-    QList<T> l;
+    build();
 
-    T rightMostElt = _mapX.lowerBound(x + w).value();
-    for (typename QMultiMap<double, T>::const_iterator it = _mapXW.upperBound(x); (it != _mapXW.end()) && (it.value() != rightMostElt); it++) {
-        if (( // The object is normal and fits into the area
-                (it.value()->yPos() <= y + h) && (it.value()->yPos() + it.value()->height() >= y))
-            || ( // The object is unlimited in width (eg. contexts)
-                   (it.value()->width() == 0) && (it.value()->yPos() <= y + h) && (it.value()->yPos() + it.value()->height() >= y))
-            || ( // The object is unlimited in height (eg. helper lines)
-                   (it.value()->height() == 0))) {
-            l << it.value();
+    QList<T> l;
+    if (_nodes.empty())
+        return l;
+
+    std::vector<int> found;
+    std::vector<int> stack;
+    stack.push_back(static_cast<int>(_nodes.size()) - 1);
+    while (!stack.empty()) {
+        const CABox& node = _nodes[static_cast<size_t>(stack.back())];
+        stack.pop_back();
+        if (!matches(node, x, y, x + w, y + h))
+            continue;
+
+        for (int i = node.first; i < node.first + node.count; i++) {
+            if (node.leaf) {
+                if (matches(_entries[static_cast<size_t>(i)], x, y, x + w, y + h))
+                    found.push_back(_entries[static_cast<size_t>(i)].first);
+            } else {
+                stack.push_back(i);
+            }
         }
     }
 
+    std::sort(found.begin(), found.end(), [this](int a, int b) { return _rankXW[static_cast<size_t>(a)] < _rankXW[static_cast<size_t>(b)]; });
+    l.reserve(static_cast<int>(found.size()));
+    for (size_t i = 0; i < found.size(); i++)
+        l << _sorted[static_cast<size_t>(found[i])];
+
     return l;
 }
 
@@ -152,6 +361,24 @@ QList<T> CAKDTree<T>::findInRange(QRect& rect)
     return findInRange(rect.x(), rect.y(), rect.width(), rect.height());
 }
 
+/*!
+	Returns True, if the given element \a elt belongs to the given \a context and \a voice.
+	Null \a context or \a voice match any element.
+*/
+template <typename T>
+bool CAKDTree<T>::isOnVoice(T elt, CADrawableContext* context, CAVoice* voice)
+{
+    return (
+        // compare contexts
+        (!context || elt->drawableContext() == context) &&
+        // compare voices
+        (!voice || (
+                       // if the element isn't playable, see if it has the same context as the voice
+                       (!elt->musElement()->isPlayable() && elt->musElement()->context() == voice->staff()) ||
+                       // if the element is playable, see if it has the exactly same voice
+                       (elt->musElement()->isPlayable() && static_cast<CAPlayable*>(elt->musElement())->voice() == voice))));
+}
+
 /*!
 	Finds the nearest left element to the given coordinate and returns a pointer to it or 0 if none
 	found. Left elements borders are taken into account.
@@ -161,35 +388,16 @@ QList<T> CAKDTree<T>::findInRange(QRect& rect)
 	according to the nearest start/end time.
 */
 template <typename T>
-T CAKDTree<T>::findNearestLeft(double x, bool timeBased, CADrawableContext* context, CAVoice* voice)
+T CAKDTree<T>::findNearestLeft(double x, bool, CADrawableContext* context, CAVoice* voice)
 {
-    if (_mapX.size() == 0) {
-        return 0;
-    }
-
-    typename QMultiMap<double, T>::const_iterator it = _mapX.lowerBound(x); // returns constEnd, if not found
-    while (it != _mapX.constBegin() && (it == _mapX.constEnd() || it.value()->xPos() >= x)) {
-        it--;
-    }
-
-    if (it.value()->xPos() >= x) {
-        // no elements to the left at all
-        return 0;
-    }
+    build();
 
-    do {
-        if (
-            // compare contexts
-            (!context || it.value()->drawableContext() == context) &&
-            // compare voices
-            (!voice || (
-                           // if the element isn't playable, see if it has the same context as the voice
-                           (!it.value()->musElement()->isPlayable() && it.value()->musElement()->context() == voice->staff()) ||
-                           // if the element is playable, see if it has the exactly same voice
-                           (it.value()->musElement()->isPlayable() && static_cast<CAPlayable*>(it.value()->musElement())->voice() == voice)))) {
-            return static_cast<T>(it.value());
+    // elements before the first one with xPos >= x
+    for (long i = std::lower_bound(_sortedX.begin(), _sortedX.end(), x) - _sortedX.begin() - 1; i >= 0; i--) {
+        if (isOnVoice(_sorted[static_cast<size_t>(i)], context, voice)) {
+            return _sorted[static_cast<size_t>(i)];
         }
-    } while ((it--) != _mapX.constBegin());
+    }
 
     // no regular elements to the left exists
     return 0;
@@ -204,21 +412,14 @@ T CAKDTree<T>::findNearestLeft(double x, bool timeBased, CADrawableContext* cont
 	according to the nearest start/end time.
 */
 template <typename T>
-T CAKDTree<T>::findNearestRight(double x, bool timeBased, CADrawableContext* context, CAVoice* voice)
+T CAKDTree<T>::findNearestRight(double x, bool, CADrawableContext* context, CAVoice* voice)
 {
-    typename QMultiMap<double, T>::const_iterator it = _mapX.upperBound(x);
-
-    for (; it != _mapX.constEnd(); it++) {
-        if (
-            // compare contexts
-            (!context || it.value()->drawableContext() == context) &&
-            // compare voices
-            (!voice || (
-                           // if the element isn't playable, see if it has the same context as the voice
-                           (!it.value()->musElement()->isPlayable() && it.value()->musElement()->context() == voice->staff()) ||
-                           // if the element is playable, see if it has the exactly same voice
-                           (it.value()->musElement()->isPlayable() && static_cast<CAPlayable*>(it.value()->musElement())->voice() == voice)))) {
-            return static_cast<T>(it.value());
+    build();
+
+    // elements from the first one with xPos > x
+    for (size_t i = static_cast<size_t>(std::upper_bound(_sortedX.begin(), _sortedX.end(), x) - _sortedX.begin()); i < _sorted.size(); i++) {
+        if (isOnVoice(_sorted[i], context, voice)) {
+            return _sorted[i];
         }
     }
 
@@ -228,112 +429,113 @@ T CAKDTree<T>::findNearestRight(double x, bool timeBased, CADrawableContext* con
 
 /*!
 	Finds the nearest upper element to the given coordinate and returns a pointer to it or 0 if none
-	found. Top element border is taken into account.
+	found. Bottom element border is taken into account.
 
-	If \a timeBased is false (default), the lookup should be view-based - the nearest element is
-	selected as it appears on the screen. If \a timeBased if true, the nearest element is selected
-	according to the nearest start/end time.
+	Subtrees which cannot contain a closer element are skipped.
 */
 template <typename T>
 T CAKDTree<T>::findNearestUp(double y)
 {
-    if (_mapX.isEmpty())
+    build();
+    if (_nodes.empty())
         return 0;
 
-    T elt = 0;
-    for (typename QMultiMap<double, T>::const_iterator it = _mapX.constBegin(); it != _mapX.constEnd(); it++) {
-        if (((!elt) || ((it.value()->yPos() + it.value()->height()) > (elt->yPos() + elt->height())))
-            && ((it.value()->yPos() + it.value()->height()) < y)) {
-            elt = it.value();
+    int best = -1;
+    double bestY = 0;
+    std::vector<int> stack;
+    stack.push_back(static_cast<int>(_nodes.size()) - 1);
+    while (!stack.empty()) {
+        const CABox& node = _nodes[static_cast<size_t>(stack.back())];
+        stack.pop_back();
+        if (node.y1 >= y || (best != -1 && std::min(node.y2, y) < bestY))
+            continue;
+
+        for (int i = node.first; i < node.first + node.count; i++) {
+            if (!node.leaf) {
+                stack.push_back(i);
+                continue;
+            }
+
+            int idx = _entries[static_cast<size_t>(i)].first;
+            T elt = _sorted[static_cast<size_t>(idx)];
+            double bottom = elt->yPos() + elt->height();
+            if (bottom < y && (best == -1 || bottom > bestY || (bottom == bestY && idx < best))) {
+                best = idx;
+                bestY = bottom;
+            }
         }
     }
-    return elt;
+
+    return (best != -1) ? _sorted[static_cast<size_t>(best)] : 0;
 }
 
 /*!
 	Finds the nearest lower element to the given coordinate and returns a pointer to it or 0 if none
 	found. Top element border is taken into account.
 
-	If \a timeBased is false (default), the lookup should be view-based - the nearest element is
-	selected as it appears on the screen. If \a timeBased if true, the nearest element is selected
-	according to the nearest start/end time.
+	Subtrees which cannot contain a closer element are skipped.
 */
 template <typename T>
 T CAKDTree<T>::findNearestDown(double y)
 {
-    if (_mapX.isEmpty())
+    build();
+    if (_nodes.empty())
         return 0;
 
-    T elt = 0;
-    for (typename QMultiMap<double, T>::const_iterator it = _mapX.constBegin(); it != _mapX.constEnd(); it++) {
-        if (((!elt) || (it.value()->yPos() < elt->yPos())) && (it.value()->yPos() > y)) {
-            elt = it.value();
+    int best = -1;
+    double bestY = 0;
+    std::vector<int> stack;
+    stack.push_back(static_cast<int>(_nodes.size()) - 1);
+    while (!stack.empty()) {
+        const CABox& node = _nodes[static_cast<size_t>(stack.back())];
+        stack.pop_back();
+        if (node.y2 <= y || (best != -1 && std::max(node.y1, y) > bestY))
+            continue;
+
+        for (int i = node.first; i < node.first + node.count; i++) {
+            if (!node.leaf) {
+                stack.push_back(i);
+                continue;
+            }
+
+            int idx = _entries[static_cast<size_t>(i)].first;
+            T elt = _sorted[static_cast<size_t>(idx)];
+            if (elt->yPos() > y && (best == -1 || elt->yPos() < bestY || (elt->yPos() == bestY && idx < best))) {
+                best = idx;
+                bestY = elt->yPos();
+            }
         }
     }
 
-    return elt;
+    return (best != -1) ? _sorted[static_cast<size_t>(best)] : 0;
 }
 
 /*!
 	Returns the max X coordinate of the end of the most-right element.
-	This value is read from buffer, so the calculation time is constant.
+	Elements with unlimited width are not taken into account.
+	This value is read from buffer, so the calculation time is constant once the tree is built.
 */
 template <typename T>
 double CAKDTree<T>::getMaxX()
 {
-    if (_mapXW.constEnd() == _mapXW.constBegin())
-        return 0.0;
-    for (typename QMultiMap<double, T>::const_iterator it = (--_mapXW.constEnd());
-         it != _mapXW.constBegin();
-         it--) {
-        if (it.key() != std::numeric_limits<double>::max()) {
-            // don't take contexts unlimited length into account
-            return it.key();
-        }
-    }
-    return 0;
+    build();
+    return _maxX;
 }
 
 /*!
 	Returns the max Y coordinate of the end of the most-bottom element.
-	This value is read from buffer, so the calculation time is constant.
+	This value is read from buffer, so the calculation time is constant once the tree is built.
 */
 template <typename T>
 double CAKDTree<T>::getMaxY()
 {
+    build();
     return _maxY;
 }
 
-/*!
-	Used internally for the maxX and maxY properties to update.
-	Calculates the largest X and Y coordinates among all ends of elements and store it locally.
-	This operation takes O(n) time complexity where n is number of elements in the tree.
-*/
-template <typename T>
-void CAKDTree<T>::calculateMaxY()
-{
-    _maxY = 0;
-    for (typename QMultiMap<double, T>::iterator it = _mapX.begin(); it != _mapX.end(); it++) {
-        if (it.value()->yPos() + it.value()->height() > _maxY) {
-            _maxY = it.value()->yPos() + it.value()->height();
-        }
-    }
-}
-
 #endif
 
 /*!
 	\fn int CAKDTree<T>::size()
 	Returns the number of elements currently in the tree.
 */
-
-/*!
-	\fn CADrawable *CAKDTree<T>:at(int i)
-	Returns the element with index \a i in the tree.
-	If the element doesn't exist (eg. index out of bounds), returns 0.
-*/
-
-/*!
-	\fn QList<T>& CAKDTree<T>:list()
-	Returns the pointer to the list of all the elements.
-*/
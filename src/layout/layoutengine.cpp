@@ -8,6 +8,7 @@
 #include <QDebug>
 #include <QList>
 #include <QMap>
+#include <QSet>
 
 #include "layout/layoutengine.h"
 
@@ -69,6 +70,54 @@
 QList<CADrawableMusElement*> CALayoutEngine::scalableElts;
 int* CALayoutEngine::streamsRehersalMarks;
 
+/*!
+	\class CALayoutAccidentals
+	\brief Accidentals in effect in a staff at the current position of the layout
+
+	The layout engine keeps one table for each staff and updates it while placing the elements:
+	key signatures set the key accidentals, barlines forget the accidentals of the notes in the
+	bar and each placed note remembers its accidentals for the rest of the bar. This way, the
+	engine decides whether a note needs an accidental without scanning the already placed
+	elements (see CADrawableStaff::getAccs()).
+*/
+
+CALayoutAccidentals::CALayoutAccidentals()
+{
+    for (int i = 0; i < 7; i++)
+        keyAccs[i] = 0;
+}
+
+/*!
+	Sets the key accidentals to the ones of \a keySig and forgets the accidentals of the notes.
+*/
+void CALayoutAccidentals::setKeySignature(CAKeySignature* keySig)
+{
+    for (int i = 0; i < 7; i++)
+        keyAccs[i] = (keySig && i < keySig->accidentals().size()) ? keySig->accidentals()[i] : 0;
+    noteAccs.clear();
+}
+
+/*!
+	Returns the accidentals a note with the given \a noteName would get without its own accidental.
+*/
+int CALayoutAccidentals::accs(int noteName) const
+{
+    QHash<int, int>::const_iterator it = noteAccs.constFind(noteName);
+    if (it != noteAccs.constEnd())
+        return it.value();
+
+    return keyAccs[noteName < 0 ? 6 - (-noteName - 1) % 7 : noteName % 7]; // watch: % operator with negative numbers is implementation dependent
+}
+
+bool CALayoutAccidentals::operator==(const CALayoutAccidentals& a) const
+{
+    for (int i = 0; i < 7; i++)
+        if (keyAccs[i] != a.keyAccs[i])
+            return false;
+
+    return noteAccs == a.noteAccs;
+}
+
 /*!
 	\class CAEngraver
 	\brief Class for correctly placing the abstract notes to the score canvas.
@@ -83,12 +132,80 @@ int* CALayoutEngine::streamsRehersalMarks;
 */
 void CALayoutEngine::reposit(CAScoreView* v)
 {
-    //int i;
+    CADrawableArena::CAScope arenaScope(&v->sheetLayout()->arena());
+    layout(v, -1, -1);
+}
+
+/*!
+	Repositions only the part of the sheet of the given score view \a v which starts at
+	\a timeStart. The music before \a timeStart is assumed unchanged.
+
+	While laying out, the engine takes a checkpoint of all the streams at every barline.
+	The layout is resumed from the last checkpoint before \a timeStart and the drawable
+	elements placed before it are kept. If \a timeEnd is given and the layout after it
+	reaches a barline in exactly the same state as before the change, the remaining old
+	drawable elements are only shifted horizontally instead of being created again.
+
+	Returns False and leaves the view untouched, if the layout cannot be resumed (eg. the
+	contexts changed or no checkpoint is available). Call reposit(CAScoreView*) on a cleared
+	view in that case.
+*/
+bool CALayoutEngine::reposit(CAScoreView* v, int timeStart, int timeEnd)
+{
+    if (timeStart < 0)
+        return false;
+
+    CADrawableArena::CAScope arenaScope(&v->sheetLayout()->arena());
+    return layout(v, timeStart, timeEnd);
+}
+
+/*!
+	Moves the drawable music element \a e horizontally by \a dx including any of its
+	inner coordinates.
+*/
+void CALayoutEngine::shiftMElement(CADrawableMusElement* e, double dx)
+{
+    switch (e->drawableMusElementType()) {
+    case CADrawableMusElement::DrawableSlur: {
+        CADrawableSlur* slur = static_cast<CADrawableSlur*>(e);
+        slur->setX1(slur->x1() + dx);
+        slur->setXMid(slur->xMid() + dx);
+        slur->setX2(slur->x2() + dx);
+        break;
+    }
+    case CADrawableMusElement::DrawableTuplet: {
+        CADrawableTuplet* tuplet = static_cast<CADrawableTuplet*>(e);
+        tuplet->setX1(tuplet->x1() + dx);
+        tuplet->setX2(tuplet->x2() + dx);
+        tuplet->setXPos(tuplet->xPos() + dx);
+        break;
+    }
+    case CADrawableMusElement::DrawableKeySignature: {
+        CADrawableKeySignature* keySig = static_cast<CADrawableKeySignature*>(e);
+        for (int i = 0; i < keySig->drawableAccidentalList().size(); i++)
+            keySig->drawableAccidentalList()[i]->setXPos(keySig->drawableAccidentalList()[i]->xPos() + dx);
+        keySig->setXPos(keySig->xPos() + dx);
+        break;
+    }
+    default:
+        e->setXPos(e->xPos() + dx);
+        break;
+    }
+}
+
+/*!
+	Does the actual layout for reposit().
+	If \a dirtyStart is -1, the whole sheet is placed to the cleared view.
+*/
+bool CALayoutEngine::layout(CAScoreView* v, int dirtyStart, int dirtyEnd)
+{
     CASheet* sheet = v->sheet();
+    bool resume = (dirtyStart >= 0);
 
     //list of all the music element lists (ie. streams) taken from all the contexts
     QList<QList<CAMusElement*>> musStreamList; // streams music elements
     QList<CAContext*> contexts; // which context does the stream belong to
+    QList<void*> streamOwners; // voice or context the stream was taken from
 
     int dy = 50;
     QList<int> nonFirstVoiceIdxs; //list of indexes of musStreamLists which the voices aren't the first voice. This is used later for determining should a sign be created or not (if it has been created in 1st voice already, don't recreate it in the other voices in the same staff).
@@ -101,14 +218,21 @@ void CALayoutEngine::reposit(CAScoreView* v)
                 dy += 70;
 
             CAStaff* staff = static_cast<CAStaff*>(sheet->contextList()[i]);
-            /// \todo replace raw pointer with shared or unique pointer
-            drawableContextMap[staff] = new CADrawableStaff(staff, 0, dy);
-            v->addCElement(drawableContextMap[staff]);
+            if (resume) {
+                drawableContextMap[staff] = v->findCElement(staff);
+                if (!drawableContextMap[staff])
+                    return false;
+            } else {
+                /// \todo replace raw pointer with shared or unique pointer
+                drawableContextMap[staff] = new CADrawableStaff(staff, 0, dy);
+                v->addCElement(drawableContextMap[staff]);
+            }
 
             //add all the voices lists to the common list
             for (int j = 0; j < staff->voiceList().size(); j++) {
                 musStreamList << staff->voiceList()[j]->musElementList();
                 contexts << staff;
+                streamOwners << staff->voiceList()[j];
                 if (staff->voiceList()[j]->voiceNumber() != 1)
                     nonFirstVoiceIdxs << musStreamList.size() - 1;
             }
@@ -121,8 +245,14 @@ void CALayoutEngine::reposit(CAScoreView* v)
                 dy += 70; // the previous context wasn't lyrics or was not related to the current lyrics
             }
 
-            drawableContextMap[lyricsContext] = new CADrawableLyricsContext(lyricsContext, 0, dy);
-            v->addCElement(drawableContextMap[lyricsContext]);
+            if (resume) {
+                drawableContextMap[lyricsContext] = v->findCElement(lyricsContext);
+                if (!drawableContextMap[lyricsContext])
+                    return false;
+            } else {
+                drawableContextMap[lyricsContext] = new CADrawableLyricsContext(lyricsContext, 0, dy);
+                v->addCElement(drawableContextMap[lyricsContext]);
+            }
 
             // convert QList<CASyllable*> to QList<CAMusElement*>
             QList<CAMusElement*> syllableList;
@@ -132,6 +262,7 @@ void CALayoutEngine::reposit(CAScoreView* v)
 
             musStreamList << syllableList;
             contexts << lyricsContext;
+            streamOwners << lyricsContext;
             dy += drawableContextMap[lyricsContext]->height();
             break;
         }
@@ -140,8 +271,14 @@ void CALayoutEngine::reposit(CAScoreView* v)
                 dy += 70;
 
             CAFiguredBassContext* fbContext = static_cast<CAFiguredBassContext*>(sheet->contextList()[i]);
-            drawableContextMap[fbContext] = new CADrawableFiguredBassContext(fbContext, 0, dy);
-            v->addCElement(drawableContextMap[fbContext]);
+            if (resume) {
+                drawableContextMap[fbContext] = v->findCElement(fbContext);
+                if (!drawableContextMap[fbContext])
+                    return false;
+            } else {
+                drawableContextMap[fbContext] = new CADrawableFiguredBassContext(fbContext, 0, dy);
+                v->addCElement(drawableContextMap[fbContext]);
+            }
             QList<CAFiguredBassMark*> fbmList = fbContext->figuredBassMarkList();
             // TODO: Is there a faster way to cast QList<CAFiguredBassMark*> to QList<CAMusElement*>?
             QList<CAMusElement*> musList;
@@ -149,6 +286,7 @@ void CALayoutEngine::reposit(CAScoreView* v)
                 musList << fbmList[j];
             musStreamList << musList;
             contexts << fbContext;
+            streamOwners << fbContext;
             dy += drawableContextMap[fbContext]->height();
             break;
         }
@@ -157,6 +295,10 @@ void CALayoutEngine::reposit(CAScoreView* v)
                 dy += 70;
             }
 
+            // function marks look back for tonicizations and modulations over the whole context
+            if (resume)
+                return false;
+
             CAFunctionMarkContext* fmContext = static_cast<CAFunctionMarkContext*>(sheet->contextList()[i]);
             drawableContextMap[fmContext] = new CADrawableFunctionMarkContext(fmContext, 0, dy);
             v->addCElement(drawableContextMap[fmContext]);
@@ -167,6 +309,7 @@ void CALayoutEngine::reposit(CAScoreView* v)
                 musList << fmList[j];
             musStreamList << musList;
             contexts << fmContext;
+            streamOwners << fmContext;
             dy += drawableContextMap[fmContext]->height();
             break;
         }
@@ -175,8 +318,14 @@ void CALayoutEngine::reposit(CAScoreView* v)
                 dy += 70;
 
             CAChordNameContext* cnContext = static_cast<CAChordNameContext*>(sheet->contextList()[i]);
-            drawableContextMap[cnContext] = new CADrawableChordNameContext(cnContext, 0, dy);
-            v->addCElement(drawableContextMap[cnContext]);
+            if (resume) {
+                drawableContextMap[cnContext] = v->findCElement(cnContext);
+                if (!drawableContextMap[cnContext])
+                    return false;
+            } else {
+                drawableContextMap[cnContext] = new CADrawableChordNameContext(cnContext, 0, dy);
+                v->addCElement(drawableContextMap[cnContext]);
+            }
             QList<CAChordName*> cnList = cnContext->chordNameList();
             // TODO: Is there a faster way to cast QList<CAChordName*> to QList<CAMusElement*>?
             QList<CAMusElement*> musList;
@@ -184,6 +333,7 @@ void CALayoutEngine::reposit(CAScoreView* v)
                 musList << cnList[j];
             musStreamList << musList;
             contexts << cnContext;
+            streamOwners << cnContext;
             dy += drawableContextMap[cnContext]->height();
             break;
         }
@@ -191,6 +341,34 @@ void CALayoutEngine::reposit(CAScoreView* v)
     }
 
     unsigned int streams = static_cast<unsigned int>(musStreamList.size());
+
+    // find the last checkpoint before the change, which still matches the streams
+    int checkpointIdx = -1;
+    if (resume) {
+        if (streamOwners != v->layoutStreamOwners() || v->hasDrawableNoteCheckerErrors())
+            return false;
+
+        const QList<CALayoutCheckpoint>& checkpoints = v->layoutCheckpoints();
+        for (int k = checkpoints.size() - 1; k >= 0 && checkpointIdx == -1; k--) {
+            const CALayoutCheckpoint& cp = checkpoints[k];
+            if (cp.timeStart > dirtyStart || cp.drawableCount > v->drawableMElementCount())
+                continue;
+
+            bool valid = true;
+            for (int i = 0; i < static_cast<int>(streams) && valid; i++) {
+                int idx = cp.streamsIdx[i];
+                if (idx > musStreamList[i].size() || (idx ? musStreamList[i][idx - 1] : nullptr) != cp.streamsPrev[i] || (idx < musStreamList[i].size() && musStreamList[i][idx]->timeStart() < cp.timeStart))
+                    valid = false;
+            }
+
+            if (valid)
+                checkpointIdx = k;
+        }
+
+        if (checkpointIdx == -1)
+            return false;
+    }
+
     int* streamsIdx = new int[streams];
     for (unsigned int i = 0; i < streams; i++)
         streamsIdx[i] = 0;
@@ -214,8 +392,55 @@ void CALayoutEngine::reposit(CAScoreView* v)
     for (unsigned int i = 0; i < streams; i++)
         lastTimeSig[i] = nullptr;
     scalableElts.clear();
+    QHash<CAContext*, CALayoutAccidentals> accidentals; // accidentals in effect in each staff
+
+    int openSpanners = 0; // slurs, ties and tuplets started, but not finished yet
+    bool staffsOnly = true; // only staffs can be shifted when resynchronized with the old layout
+    for (int i = 0; i < contexts.size(); i++)
+        if (contexts[i]->contextType() != CAContext::Staff)
+            staffsOnly = false;
+
+    QList<CALayoutCheckpoint> oldCheckpoints; // checkpoints after the resumed one, used for resynchronization
+    QList<CADrawableMusElement*> oldTail; // drawable elements placed after the resumed checkpoint
+    QList<CADrawableMusElement*> oldScalableTail; // scalable marks collected after the resumed checkpoint
+    int oldTailDrawableCount = 0;
+    int oldTailScalableCount = 0;
+    if (resume) {
+        CALayoutCheckpoint cp = v->layoutCheckpoints()[checkpointIdx];
+        oldCheckpoints = v->layoutCheckpoints().mid(checkpointIdx + 1);
+        v->layoutCheckpoints().erase(v->layoutCheckpoints().begin() + checkpointIdx, v->layoutCheckpoints().end());
+
+        // scalable marks are always placed at the end, so they are part of the taken elements
+        QList<CADrawableMusElement*> oldScalableElts = v->layoutScalableElts();
+        scalableElts = oldScalableElts.mid(0, cp.scalableCount);
+        oldScalableTail = oldScalableElts.mid(cp.scalableCount);
+        QSet<CADrawableMusElement*> oldScalableSet;
+        for (int i = 0; i < oldScalableElts.size(); i++)
+            oldScalableSet.insert(oldScalableElts[i]);
+        QList<CADrawableMusElement*> taken = v->takeMElements(cp.drawableCount);
+        for (int i = 0; i < taken.size(); i++)
+            if (!oldScalableSet.contains(taken[i]))
+                oldTail << taken[i];
+        oldTailDrawableCount = cp.drawableCount;
+        oldTailScalableCount = cp.scalableCount;
+
+        for (unsigned int i = 0; i < streams; i++) {
+            streamsIdx[i] = cp.streamsIdx[static_cast<int>(i)];
+            streamsX[i] = cp.streamsX[static_cast<int>(i)];
+            streamsRehersalMarks[i] = cp.streamsRehersalMarks[static_cast<int>(i)];
+            lastClef[i] = cp.lastClef[static_cast<int>(i)];
+            lastKeySig[i] = cp.lastKeySig[static_cast<int>(i)];
+            lastTimeSig[i] = cp.lastTimeSig[static_cast<int>(i)];
+        }
+        openSpanners = cp.openSpanners;
+        accidentals = cp.accidentals;
+    } else {
+        v->layoutCheckpoints().clear();
+    }
+    v->setLayoutStreamOwners(streamOwners);
 
     int timeStart = 0;
+    int lastTimeStart = -1;
     bool done = false;
     /// \todo replace raw pointer with shared or unique pointer
     CADrawableFunctionMarkSupport** lastDFMTonicizations = new CADrawableFunctionMarkSupport*[streams];
@@ -247,6 +472,72 @@ void CALayoutEngine::reposit(CAScoreView* v)
         }
         //timeStart now holds the nearest next time we're going to draw
 
+        // Take a checkpoint at the beginning of each bar, so the layout can be resumed from there later
+        bool barlineNext = false;
+        for (unsigned int i = 0; (i < streams) && (timeStart != lastTimeStart) && !barlineNext; i++)
+            if ((streamsIdx[i] < musStreamList[static_cast<int>(i)].size()) && (musStreamList[static_cast<int>(i)].at(streamsIdx[i])->timeStart() == timeStart) && (musStreamList[static_cast<int>(i)].at(streamsIdx[i])->musElementType() == CAMusElement::Barline))
+                barlineNext = true;
+
+        if (barlineNext) {
+            CALayoutCheckpoint cp;
+            cp.timeStart = timeStart;
+            cp.drawableCount = v->drawableMElementCount();
+            cp.scalableCount = scalableElts.size();
+            cp.openSpanners = openSpanners;
+            for (int i = 0; i < static_cast<int>(streams); i++) {
+                cp.streamsIdx << streamsIdx[i];
+                cp.streamsX << streamsX[i];
+                cp.streamsRehersalMarks << streamsRehersalMarks[i];
+                cp.streamsPrev << (streamsIdx[i] ? musStreamList[i].at(streamsIdx[i] - 1) : nullptr);
+                cp.streamsNext << ((streamsIdx[i] < musStreamList[i].size()) ? musStreamList[i].at(streamsIdx[i]) : nullptr);
+                cp.lastClef << lastClef[i];
+                cp.lastKeySig << lastKeySig[i];
+                cp.lastTimeSig << lastTimeSig[i];
+            }
+            cp.accidentals = accidentals;
+
+            // Past the changed part, reuse the old layout if the bar starts in the same state as before
+            while (!oldCheckpoints.isEmpty() && oldCheckpoints.first().timeStart < timeStart)
+                oldCheckpoints.removeFirst();
+
+            if (dirtyEnd >= 0 && timeStart >= dirtyEnd && staffsOnly && !openSpanners && !oldCheckpoints.isEmpty()) {
+                CALayoutCheckpoint old = oldCheckpoints.first();
+                if (old.timeStart == timeStart && !old.openSpanners && old.streamsPrev == cp.streamsPrev && old.streamsNext == cp.streamsNext && old.streamsRehersalMarks == cp.streamsRehersalMarks && old.lastClef == cp.lastClef && old.lastKeySig == cp.lastKeySig && old.lastTimeSig == cp.lastTimeSig && old.accidentals == cp.accidentals) {
+                    double dx = cp.streamsX[0] - old.streamsX[0];
+
+                    int drawableCount = v->drawableMElementCount();
+                    int tailStart = old.drawableCount - oldTailDrawableCount;
+                    for (int i = tailStart; i < oldTail.size(); i++) {
+                        shiftMElement(oldTail[i], dx);
+                        v->addMElement(oldTail[i]);
+                    }
+                    oldTail.erase(oldTail.begin() + tailStart, oldTail.end());
+
+                    int scalableCount = scalableElts.size();
+                    int scalableTailStart = old.scalableCount - oldTailScalableCount;
+                    scalableElts += oldScalableTail.mid(scalableTailStart);
+                    oldScalableTail.erase(oldScalableTail.begin() + scalableTailStart, oldScalableTail.end());
+
+                    for (int k = 0; k < oldCheckpoints.size(); k++) {
+                        CALayoutCheckpoint shifted = oldCheckpoints[k];
+                        shifted.drawableCount = drawableCount + (oldCheckpoints[k].drawableCount - old.drawableCount);
+                        shifted.scalableCount = scalableCount + (oldCheckpoints[k].scalableCount - old.scalableCount);
+                        for (int i = 0; i < static_cast<int>(streams); i++) {
+                            shifted.streamsIdx[i] += cp.streamsIdx[i] - old.streamsIdx[i];
+                            shifted.streamsX[i] += qRound(dx);
+                        }
+                        v->layoutCheckpoints() << shifted;
+                    }
+
+                    done = true;
+                    continue;
+                }
+            }
+
+            v->layoutCheckpoints() << cp;
+        }
+        lastTimeStart = timeStart;
+
         //go through all the streams and check if the following element has this time
         CAMusElement* elt;
         CADrawableContext* drawableContext;
@@ -300,6 +591,7 @@ void CALayoutEngine::reposit(CAScoreView* v)
                         for (int j = 0; j < contexts.size(); j++)
                             if (contexts[j] == contexts[static_cast<int>(i)])
                                 lastKeySig[j] = keySig->keySignature();
+                        accidentals[elt->context()].setKeySignature(keySig->keySignature());
 
                         streamsX[i] += (keySig->neededWidth() + MINIMUM_SPACE);
                         //placedSymbol = true;
@@ -356,7 +648,6 @@ void CALayoutEngine::reposit(CAScoreView* v)
                         streamsX[i],
                         static_cast<CADrawableFunctionMarkContext*>(drawableContext)->yPosLine(CADrawableFunctionMarkContext::Middle));
                     streamsX[i] += (support->neededWidth());
-                    v->addMElement(support);
                     lastDFMKeyNames << support;
                 }
             }
@@ -389,6 +680,7 @@ void CALayoutEngine::reposit(CAScoreView* v)
                     drawableContext->yPos());
 
                 v->addMElement(bar);
+                accidentals[elt->context()].clearNotes();
                 //placedSymbol = true;
                 streamsX[i] += (bar->neededWidth() + MINIMUM_SPACE);
                 streamsIdx[i] = streamsIdx[i] + 1;
@@ -417,7 +709,7 @@ void CALayoutEngine::reposit(CAScoreView* v)
             while ((streamsIdx[i] < musStreamList[static_cast<int>(i)].size()) && ((elt = musStreamList[static_cast<int>(i)].at(streamsIdx[i]))->timeStart() == timeStart) && (elt->isPlayable())) {
                 drawableContext = drawableContextMap[elt->context()];
 
-                if (elt->musElementType() == CAMusElement::Note && static_cast<CADrawableStaff*>(drawableContext)->getAccs(streamsX[i], static_cast<CANote*>(elt)->diatonicPitch().noteName()) != static_cast<CANote*>(elt)->diatonicPitch().accs()) {
+                if (elt->musElementType() == CAMusElement::Note && accidentals.value(elt->context()).accs(static_cast<CANote*>(elt)->diatonicPitch().noteName()) != static_cast<CANote*>(elt)->diatonicPitch().accs()) {
                     newElt = new CADrawableAccidental(
                         static_cast<signed char>(static_cast<CANote*>(elt)->diatonicPitch().accs()),
                         static_cast<CANote*>(elt),
@@ -425,7 +717,6 @@ void CALayoutEngine::reposit(CAScoreView* v)
                         streamsX[i],
                         static_cast<CADrawableStaff*>(drawableContext)->calculateCenterYCoord(static_cast<CANote*>(elt), lastClef[i]));
 
-                    v->addMElement(newElt);
                     lastAccidentals << static_cast<CADrawableAccidental*>(newElt);
                     if (newElt->neededWidth() > maxWidth)
                         maxWidth = static_cast<int>(newElt->neededWidth());
@@ -446,13 +737,16 @@ void CALayoutEngine::reposit(CAScoreView* v)
         for (unsigned int i = 0; i < streams; i++)
             streamsX[i] = maxX;
 
-        // Align support elements (accidentals, function key names) to the right
-        for (int i = 0; i < lastDFMKeyNames.size(); i++)
+        // Align support elements (accidentals, function key names) to the right and add them once their position is final
+        for (int i = 0; i < lastDFMKeyNames.size(); i++) {
             lastDFMKeyNames[i]->setXPos(maxX - lastDFMKeyNames[i]->neededWidth() - 2);
+            v->addMElement(lastDFMKeyNames[i]);
+        }
 
         double deltaXPos = maxX - maxAccidentalXEnd;
         for (int i = 0; i < lastAccidentals.size(); i++) {
             lastAccidentals[i]->setXPos(lastAccidentals[i]->xPos() + deltaXPos - 1);
+            v->addMElement(lastAccidentals[i]);
         }
 
         // Place noteheads and other elements aligned to noteheads (syllables, function marks)
@@ -469,6 +763,7 @@ void CALayoutEngine::reposit(CAScoreView* v)
                         drawableContext,
                         streamsX[i],
                         static_cast<CADrawableStaff*>(drawableContext)->calculateCenterYCoord(static_cast<CANote*>(elt), lastClef[i]));
+                    accidentals[elt->context()].setNoteAccs(static_cast<CANote*>(elt)->diatonicPitch().noteName(), static_cast<CANote*>(elt)->diatonicPitch().accs());
 
                     // Create Ties
                     if (static_cast<CADrawableNote*>(newElt)->note()->tieStart()) {
@@ -490,8 +785,10 @@ void CALayoutEngine::reposit(CAScoreView* v)
                                 newElt->xPos() + 40, newElt->yPos() + newElt->height());
                         }
                         v->addMElement(tie);
+                        openSpanners++;
                     }
                     if (static_cast<CADrawableNote*>(newElt)->note()->tieEnd()) {
+                        openSpanners--;
                         // Set the slur coordinates for the second note
                         CASlur::CASlurDirection dir = static_cast<CADrawableNote*>(newElt)->note()->tieEnd()->slurDirection();
                         if (dir == CASlur::SlurPreferred || dir == CASlur::SlurNeutral)
@@ -528,8 +825,10 @@ void CALayoutEngine::reposit(CAScoreView* v)
                                 newElt->xPos() + 40, newElt->yPos() + newElt->height());
                         }
                         v->addMElement(slur);
+                        openSpanners++;
                     }
                     if (static_cast<CADrawableNote*>(newElt)->note()->slurEnd()) {
+                        openSpanners--;
                         // Set the slur coordinates for the second note
                         CASlur::CASlurDirection dir = static_cast<CADrawableNote*>(newElt)->note()->slurEnd()->slurDirection();
                         if (dir == CASlur::SlurPreferred || dir == CASlur::SlurNeutral)
@@ -568,8 +867,10 @@ void CALayoutEngine::reposit(CAScoreView* v)
                                 newElt->xPos() + 40, newElt->yPos() + newElt->height());
                         }
                         v->addMElement(phrasingSlur);
+                        openSpanners++;
                     }
                     if (static_cast<CADrawableNote*>(newElt)->note()->phrasingSlurEnd()) {
+                        openSpanners--;
                         // Set the slur coordinates for the second note
                         CASlur::CASlurDirection dir = static_cast<CADrawableNote*>(newElt)->note()->phrasingSlurEnd()->slurDirection();
                         if (dir == CASlur::SlurPreferred || dir == CASlur::SlurNeutral)
@@ -589,7 +890,10 @@ void CALayoutEngine::reposit(CAScoreView* v)
                     v->addMElement(newElt);
 
                     // add tuplet - same as for the rests
+                    if (static_cast<CADrawableNote*>(newElt)->note()->isFirstInTuplet())
+                        openSpanners++;
                     if (static_cast<CADrawableNote*>(newElt)->note()->isLastInTuplet()) {
+                        openSpanners--;
                         double x1 = v->findMElement(static_cast<CADrawableNote*>(newElt)->note()->tuplet()->firstNote())->xPos();
                         double x2 = newElt->xPos() + newElt->width();
                         double y1 = v->findMElement(static_cast<CADrawableNote*>(newElt)->note()->tuplet()->firstNote())->yPos();
@@ -631,7 +935,10 @@ void CALayoutEngine::reposit(CAScoreView* v)
                     streamsX[i] += (newElt->neededWidth() + MINIMUM_SPACE);
 
                     // add tuplet - same as for the notes
+                    if (static_cast<CADrawableRest*>(newElt)->rest()->isFirstInTuplet())
+                        openSpanners++;
                     if (static_cast<CADrawableRest*>(newElt)->rest()->isLastInTuplet()) {
+                        openSpanners--;
                         double x1 = v->findMElement(static_cast<CADrawableRest*>(newElt)->rest()->tuplet()->firstNote())->xPos();
                         double x2 = newElt->xPos() + newElt->width();
                         double y1 = v->findMElement(static_cast<CADrawableRest*>(newElt)->rest()->tuplet()->firstNote())->yPos();
@@ -984,11 +1291,20 @@ void CALayoutEngine::reposit(CAScoreView* v)
     }
 
     // reposit the scalable elements (eg. crescendo)
+    v->updateTimeIndex();
     for (int i = 0; i < scalableElts.size(); i++) {
         scalableElts[i]->setXPos(v->timeToCoords(scalableElts[i]->musElement()->timeStart()));
         scalableElts[i]->setWidth(v->timeToCoords(scalableElts[i]->musElement()->timeEnd()) - scalableElts[i]->xPos());
         v->addMElement(scalableElts[i]);
     }
+    v->setLayoutScalableElts(scalableElts);
+
+    // delete the old elements which were not reused
+    for (int i = 0; i < oldTail.size(); i++)
+        delete oldTail[i];
+    for (int i = 0; i < oldScalableTail.size(); i++)
+        delete oldScalableTail[i];
+
     delete[] streamsIdx;
     delete[] streamsX;
     delete[] streamsRehersalMarks;
@@ -996,6 +1312,8 @@ void CALayoutEngine::reposit(CAScoreView* v)
     delete[] lastKeySig;
     delete[] lastTimeSig;
     delete[] lastDFMTonicizations;
+
+    return true;
 }
 
 /*!
@@ -8,18 +8,60 @@
 #ifndef LAYOUTENGINE_
 #define LAYOUTENGINE_
 
+#include <QHash>
 #include <QList>
 
 class CAScoreView;
 class CADrawableMusElement;
+class CAMusElement;
+class CAClef;
+class CAKeySignature;
+class CATimeSignature;
+class CAContext;
+
+class CALayoutAccidentals {
+public:
+    CALayoutAccidentals();
+
+    void setKeySignature(CAKeySignature* keySig);
+    inline void clearNotes() { noteAccs.clear(); } // at barlines
+    inline void setNoteAccs(int noteName, int accs) { noteAccs[noteName] = accs; }
+    int accs(int noteName) const;
+
+    bool operator==(const CALayoutAccidentals& a) const;
+
+    int keyAccs[7]; // accidentals of the key signature for each note name
+    QHash<int, int> noteAccs; // accidentals of the notes placed in the bar so far by their note names
+};
+
+class CALayoutCheckpoint {
+public:
+    int timeStart; // time of the barline the checkpoint was taken at
+    int drawableCount; // number of drawable music elements placed before the checkpoint
+    int scalableCount; // number of scalable marks collected before the checkpoint
+    int openSpanners; // number of slurs, ties and tuplets crossing the checkpoint
+
+    QList<int> streamsIdx;
+    QList<int> streamsX;
+    QList<int> streamsRehersalMarks;
+    QList<CAMusElement*> streamsPrev; // last element placed in each stream or nullptr
+    QList<CAMusElement*> streamsNext; // next element to be placed in each stream or nullptr
+    QList<CAClef*> lastClef;
+    QList<CAKeySignature*> lastKeySig;
+    QList<CATimeSignature*> lastTimeSig;
+    QHash<CAContext*, CALayoutAccidentals> accidentals; // accidentals in effect in each staff
+};
 
 class CALayoutEngine {
 public:
     static void reposit(CAScoreView* v);
+    static bool reposit(CAScoreView* v, int timeStart, int timeEnd = -1);
 
 private:
+    static bool layout(CAScoreView* v, int timeStart, int timeEnd);
     static void placeMarks(CADrawableMusElement*, CAScoreView*, int);
     static void placeNoteCheckerErrors(CADrawableMusElement*, CAScoreView*);
+    static void shiftMElement(CADrawableMusElement*, double dx);
     static int* streamsRehersalMarks;
     static QList<CADrawableMusElement*> scalableElts;
 };
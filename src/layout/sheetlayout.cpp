@@ -0,0 +1,215 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QSet>
+
+#include "layout/sheetlayout.h"
+
+#include "layout/drawablecontext.h"
+#include "layout/drawablemuselement.h"
+#include "layout/drawablenotecheckererror.h"
+#include "score/document.h"
+#include "score/rest.h"
+#include "score/sheet.h"
+#include "widgets/scoreview.h"
+
+/*!
+	\class CASheetLayout
+	\brief Drawable elements of a sheet shared by all its score views
+
+	Score views showing the same sheet (split views, several main windows of the same document)
+	share a single sheet layout. The layout owns the drawable elements, the lookup trees, the
+	engraver checkpoints and the time index. The view-specific state (selection, selected voice,
+	current context, shadow notes, zoom and the rasterized tiles) is kept in each score view.
+
+	The layout remembers the document revision it was made for (see CADocument::revision()).
+	When the UI is rebuilt, the first score view lays the sheet out and the others only
+	synchronize with the result, see CAScoreView::rebuild().
+
+	Score views are notified before the drawable elements they may point to are removed, and
+	after the layout is finished.
+
+	The drawable elements placed by the engraver are allocated in the arena of the layout (see
+	CADrawableArena). clear() deletes them and reuses their memory at once.
+
+	\sa CALayoutEngine
+*/
+
+QHash<CASheet*, CASheetLayout*> CASheetLayout::_layouts;
+
+CASheetLayout::CASheetLayout(CASheet* sheet)
+    : _sheet(sheet)
+    , _revision(0)
+    , _laidOut(false)
+    , _generation(0)
+    , _firstBarNumber(0)
+{
+}
+
+CASheetLayout::~CASheetLayout()
+{
+    _drawableMList.clear(true);
+    _drawableCList.clear(true);
+    _drawableNCEList.clear(true);
+}
+
+/*!
+	Returns the shared layout of the \a sheet and adds the score view \a v to its views.
+	The layout is created, if no other view shows the sheet. Views without a sheet get their
+	own layout.
+
+	\sa detach()
+*/
+CASheetLayout* CASheetLayout::attach(CASheet* sheet, CAScoreView* v)
+{
+    CASheetLayout* layout = sheet ? _layouts.value(sheet) : nullptr;
+    if (!layout) {
+        layout = new CASheetLayout(sheet);
+        if (sheet) {
+            _layouts[sheet] = layout;
+        }
+    }
+
+    layout->_views << v;
+    return layout;
+}
+
+/*!
+	Removes the score view \a v from the views of the layout.
+	The layout and its drawable elements are deleted, when the last view is detached.
+*/
+void CASheetLayout::detach(CAScoreView* v)
+{
+    _views.removeAll(v);
+    if (_views.isEmpty()) {
+        if (_sheet && _layouts.value(_sheet) == this) {
+            _layouts.remove(_sheet);
+        }
+        delete this;
+    }
+}
+
+/*!
+	Returns True, if the layout was finished for the current revision of the document.
+*/
+bool CASheetLayout::isUpToDate()
+{
+    return _laidOut && _sheet && _sheet->document() && _sheet->document()->revision() == _revision;
+}
+
+/*!
+	Marks the layout as finished for the current revision of the document and lets all the
+	score views synchronize with it.
+*/
+void CASheetLayout::finishLayout()
+{
+    _laidOut = true;
+    _revision = (_sheet && _sheet->document()) ? _sheet->document()->revision() : 0;
+    _generation++;
+
+    for (int i = 0; i < _views.size(); i++) {
+        _views[i]->syncWithLayout();
+    }
+}
+
+/*!
+	Adds the drawable music element \a elt to the layout and its drawable context.
+	The element's layout index is its position in drawableMOrder().
+*/
+void CASheetLayout::addMElement(CADrawableMusElement* elt)
+{
+    CAMusElement* m = elt->musElement();
+    elt->setState(CADrawableMusElement::Hidden, m && m->musElementType() == CAMusElement::Rest && static_cast<CARest*>(m)->restType() == CARest::Hidden);
+    elt->setState(CADrawableMusElement::Invisible, m && !m->isVisible());
+    elt->setLayoutIndex(_drawableMOrder.size());
+
+    _drawableMList.addElement(elt);
+    _drawableMOrder << elt;
+    _mapDrawable.insertMulti(m, elt);
+
+    elt->drawableContext()->addMElement(elt);
+}
+
+void CASheetLayout::addCElement(CADrawableContext* elt)
+{
+    _drawableCList.addElement(elt);
+    _mapDrawable.insertMulti(elt->context(), elt);
+}
+
+void CASheetLayout::addDrawableNoteCheckerError(CADrawableNoteCheckerError* dnce)
+{
+    _drawableNCEList.addElement(dnce);
+    _mapDrawable.insertMulti(nullptr, dnce);
+}
+
+/*!
+	Removes the drawable music elements added after the first \a from elements from the layout
+	and returns them in the order they were added.
+	The ownership of the returned elements is passed to the caller.
+
+	\sa CALayoutEngine::reposit(CAScoreView*, int, int)
+*/
+QList<CADrawableMusElement*> CASheetLayout::takeMElements(int from)
+{
+    QList<CADrawableMusElement*> taken = _drawableMOrder.mid(from);
+    if (taken.isEmpty())
+        return taken;
+
+    _drawableMOrder.erase(_drawableMOrder.begin() + from, _drawableMOrder.end());
+
+    QSet<CADrawableMusElement*> takenSet;
+    QSet<CADrawableContext*> contexts;
+    double minX = taken[0]->xPos();
+    for (int i = 0; i < taken.size(); i++) {
+        taken[i]->setLayoutIndex(-1);
+        minX = qMin(minX, taken[i]->xPos());
+        takenSet.insert(taken[i]);
+        contexts.insert(taken[i]->drawableContext());
+        _mapDrawable.remove(taken[i]->musElement(), taken[i]);
+    }
+
+    for (CADrawableContext* context : contexts)
+        context->removeMElements(takenSet);
+
+    for (int i = 0; i < _views.size(); i++) {
+        _views[i]->aboutToTakeMElements(takenSet, minX);
+    }
+
+    // rebuild the lookup tree out of the remaining elements
+    _drawableMList.clear(false);
+    for (int i = 0; i < _drawableMOrder.size(); i++)
+        _drawableMList.addElement(_drawableMOrder[i]);
+
+    return taken;
+}
+
+/*!
+	Deletes all the drawable elements and the engraver state.
+	The score views are notified first, so they can drop their pointers to the elements.
+*/
+void CASheetLayout::clear()
+{
+    for (int i = 0; i < _views.size(); i++) {
+        _views[i]->aboutToClearLayout();
+    }
+
+    _drawableMList.clear(true);
+    _drawableMOrder.clear();
+    _drawableCList.clear(true);
+    _drawableNCEList.clear(true);
+    _mapDrawable.clear();
+    _layoutCheckpoints.clear();
+    _layoutStreamOwners.clear();
+    _layoutScalableElts.clear();
+    _timeIndexTimes.clear();
+    _timeIndexX.clear();
+    _barIndex.clear();
+    _firstBarNumber = 0;
+    _laidOut = false;
+
+    _arena.reset();
+}
@@ -0,0 +1,98 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#ifndef SHEETLAYOUT_H_
+#define SHEETLAYOUT_H_
+
+#include <QHash>
+#include <QList>
+#include <QMultiMap>
+#include <QVector>
+
+#include "layout/drawablearena.h"
+#include "layout/kdtree.h"
+#include "layout/layoutengine.h"
+
+class CASheet;
+class CAScoreView;
+class CADrawable;
+class CADrawableBarline;
+class CADrawableContext;
+class CADrawableMusElement;
+class CADrawableNoteCheckerError;
+
+class CASheetLayout {
+public:
+    static CASheetLayout* attach(CASheet* sheet, CAScoreView* v);
+    void detach(CAScoreView* v);
+
+    inline CASheet* sheet() { return _sheet; }
+    inline const QList<CAScoreView*>& views() { return _views; }
+
+    bool isUpToDate();
+    inline int generation() { return _generation; }
+    void finishLayout();
+
+    ////////////////////////////////////////////
+    // Addition, removal of drawable elements //
+    ////////////////////////////////////////////
+    void addMElement(CADrawableMusElement* elt);
+    void addCElement(CADrawableContext* elt);
+    void addDrawableNoteCheckerError(CADrawableNoteCheckerError* dnce);
+    QList<CADrawableMusElement*> takeMElements(int from);
+    void clear();
+
+    inline CAKDTree<CADrawableMusElement*>& drawableMList() { return _drawableMList; }
+    inline CAKDTree<CADrawableContext*>& drawableCList() { return _drawableCList; }
+    inline CAKDTree<CADrawableNoteCheckerError*>& drawableNCEList() { return _drawableNCEList; }
+    inline const QMultiMap<void*, CADrawable*>& mapDrawable() { return _mapDrawable; }
+    inline const QList<CADrawableMusElement*>& drawableMOrder() { return _drawableMOrder; }
+    inline CADrawableArena& arena() { return _arena; }
+
+    ///////////////////////////////////
+    // Layout state for the engraver //
+    ///////////////////////////////////
+    inline QList<CALayoutCheckpoint>& layoutCheckpoints() { return _layoutCheckpoints; }
+    inline const QList<void*>& layoutStreamOwners() { return _layoutStreamOwners; }
+    inline void setLayoutStreamOwners(const QList<void*>& owners) { _layoutStreamOwners = owners; }
+    inline const QList<CADrawableMusElement*>& layoutScalableElts() { return _layoutScalableElts; }
+    inline void setLayoutScalableElts(const QList<CADrawableMusElement*>& elts) { _layoutScalableElts = elts; }
+
+    inline QVector<int>& timeIndexTimes() { return _timeIndexTimes; }
+    inline QVector<double>& timeIndexX() { return _timeIndexX; }
+    inline QVector<CADrawableBarline*>& barIndex() { return _barIndex; }
+    inline int firstBarNumber() { return _firstBarNumber; }
+    inline void setFirstBarNumber(int n) { _firstBarNumber = n; }
+
+private:
+    CASheetLayout(CASheet* sheet);
+    ~CASheetLayout();
+
+    static QHash<CASheet*, CASheetLayout*> _layouts; // Shared layouts of the sheets shown in any score view
+
+    CASheet* _sheet;
+    QList<CAScoreView*> _views; // Score views showing the layout
+    unsigned int _revision; // Document revision the layout was made for
+    bool _laidOut; // Was the layout finished since the last clear()
+    int _generation; // Increased on each finished layout
+    CADrawableArena _arena; // Memory of the drawable elements placed by the engraver
+
+    CAKDTree<CADrawableMusElement*> _drawableMList; // The list of music elements stored in a tree for faster lookup and other operations
+    CAKDTree<CADrawableContext*> _drawableCList; // The list of context drawable elements (staffs, lyrics etc.)
+    CAKDTree<CADrawableNoteCheckerError*> _drawableNCEList; // The list of drawable note checker errors
+    QMultiMap<void*, CADrawable*> _mapDrawable; // Mapping of all music elements/contexts in the score -> drawable elements on canvas
+    QList<CADrawableMusElement*> _drawableMOrder; // Drawable music elements in the order they were added by the engraver. Used to take the elements placed after a layout checkpoint.
+    QList<CALayoutCheckpoint> _layoutCheckpoints; // Engraver state at the barlines, used to resume the layout after a local change
+    QList<void*> _layoutStreamOwners; // Voices and contexts the engraver took its streams from at the last layout
+    QList<CADrawableMusElement*> _layoutScalableElts; // Scalable marks placed by the engraver at the end of the last layout
+    QVector<int> _timeIndexTimes; // Times of the noteheads, rests and barlines in ascending order, see CAScoreView::updateTimeIndex()
+    QVector<double> _timeIndexX; // Non-decreasing X coordinate of each time in _timeIndexTimes
+    QVector<CADrawableBarline*> _barIndex; // Non-dotted barlines of the staff with most barlines, ordered by X
+    int _firstBarNumber; // Bar number of the first barline in _barIndex
+};
+
+#endif /* SHEETLAYOUT_H_ */
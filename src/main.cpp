@@ -6,12 +6,14 @@
 */
 
 #include <QApplication>
+#include <QCoreApplication>
 #include <QFile>
 #include <QFont>
 #include <QSplashScreen>
 
 // Python.h needs to be loaded first!
 #include "canorus.h"
+#include "core/batchconverter.h"
 #include "core/settings.h"
 #include "interface/pluginmanager.h"
 #include "ui/mainwin.h"
@@ -34,9 +36,22 @@ void catch_sig(int)
 /*!
 	Main function. This is the first function called when Canorus is run.
 	It initializes CACanorus class and creates the main window.
+
+	When started with --convert or --batch, Canorus only converts the given files without
+	initializing the user interface (see CABatchConverter).
 */
 int main(int argc, char* argv[])
 {
+    if (CABatchConverter::isBatchMode(argc, argv)) {
+        QCoreApplication batchApp(argc, argv);
+        CABatchConverter converter;
+        if (!converter.parseArguments(batchApp.arguments())) {
+            return 1;
+        }
+
+        return converter.run();
+    }
+
     QApplication mainApp(argc, argv);
 
 #ifdef Q_WS_X11
@@ -8,6 +8,7 @@
 #include "score/barline.h"
 #include "score/mark.h"
 #include "score/staff.h"
+#include "score/voicerecorder.h"
 
 /*!
 	\class CABarline
@@ -36,6 +37,7 @@ CABarline::CABarline(CABarlineType type, CAStaff* staff, int startTime)
 */
 CABarline::~CABarline()
 {
+    CAVoiceRecorder::notifyDeleting(this);
 }
 
 CABarline* CABarline::clone(CAContext* context)
@@ -153,6 +153,17 @@ CAMusElement* CAChordNameContext::previous(CAMusElement* elt)
         return nullptr;
 }
 
+void CAChordNameContext::swapContents(CAContext* other)
+{
+    CAChordNameContext* o = static_cast<CAChordNameContext*>(other);
+    _chordNameList.swap(o->_chordNameList);
+
+    for (int i = 0; i < _chordNameList.size(); i++)
+        adoptMusElement(_chordNameList[i]);
+    for (int i = 0; i < o->_chordNameList.size(); i++)
+        o->adoptMusElement(o->_chordNameList[i]);
+}
+
 bool CAChordNameContext::remove(CAMusElement* elt)
 {
     if (!elt || elt->musElementType() != CAMusElement::ChordName)
@@ -23,6 +23,7 @@ public:
     CAMusElement* next(CAMusElement* elt);
     CAMusElement* previous(CAMusElement* elt);
     bool remove(CAMusElement* elt);
+    void swapContents(CAContext* other);
 
     QList<CAChordName*>& chordNameList() { return _chordNameList; }
     CAChordName* chordNameAtTimeStart(int timeStart);
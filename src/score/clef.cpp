@@ -8,6 +8,7 @@
 #include "score/clef.h"
 #include "score/mark.h"
 #include "score/staff.h"
+#include "score/voicerecorder.h"
 
 /*!
 	\class CAClef
@@ -50,6 +51,14 @@ CAClef::CAClef(CAClefType type, int c1, CAStaff* staff, int time, int offset)
     setClefType(type);
 }
 
+/*!
+	Destroys the clef.
+*/
+CAClef::~CAClef()
+{
+    CAVoiceRecorder::notifyDeleting(this);
+}
+
 void CAClef::setPredefinedType(CAPredefinedClefType type)
 {
     switch (type) {
@@ -130,7 +139,7 @@ void CAClef::setClefType(CAClefType type)
 
 CAClef* CAClef::clone(CAContext* context)
 {
-    CAClef* c = new CAClef(_clefType, _c1, static_cast<CAStaff*>(context), _timeStart, _offset);
+    CAClef* c = new CAClef(_clefType, _c1, static_cast<CAStaff*>(context), timeStart(), _offset);
 
     for (int i = 0; i < markList().size(); i++) {
         CAMark* m = static_cast<CAMark*>(markList()[i]->clone(c));
@@ -44,6 +44,7 @@ public:
 
     CAClef(CAPredefinedClefType type, CAStaff* staff, int time, int offsetInterval = 0);
     CAClef(CAClefType type, int c1, CAStaff* staff, int time, int offset = 0);
+    virtual ~CAClef();
     CAClef* clone(CAContext* context = nullptr);
     CAStaff* staff() { return static_cast<CAStaff*>(context()); }
 
@@ -6,6 +6,7 @@
 */
 
 #include "score/context.h"
+#include "score/mark.h"
 
 /*!
 	\class CAContext
@@ -34,6 +35,19 @@ CAContext::~CAContext()
 {
 }
 
+/*!
+	Sets this context as the parent of the music element \a elt and its marks.
+
+	\sa swapContents()
+*/
+void CAContext::adoptMusElement(CAMusElement* elt)
+{
+    elt->setContext(this);
+    for (int i = 0; i < elt->markList().size(); i++) {
+        elt->markList()[i]->setContext(this);
+    }
+}
+
 /*!
 	\enum CAContext::CAContextType
 	This enum holds different CAContext types:
@@ -110,3 +124,14 @@ CAContext::~CAContext()
 
 	\sa CAMusElement::clone(), CADocument::clone()
 */
+
+/*!
+	\fn CAContext::swapContents( CAContext *other )
+	Exchanges the music elements of this context with the ones of the \a other context of the same
+	type. The elements are reparented, so the contexts and voices themselves stay in place.
+
+	This is used by the undo to restore the contents of a changed context without cloning the
+	whole document.
+
+	\sa CAContextDelta
+*/
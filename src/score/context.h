@@ -39,9 +39,11 @@ public:
     virtual CAMusElement* next(CAMusElement* elt) = 0;
     virtual CAMusElement* previous(CAMusElement* elt) = 0;
     virtual bool remove(CAMusElement* elt) = 0;
+    virtual void swapContents(CAContext* other) = 0;
 
 protected:
     void setContextType(CAContextType t) { _contextType = t; }
+    void adoptMusElement(CAMusElement* elt);
 
     CASheet* _sheet;
     QString _name;
@@ -24,6 +24,8 @@
 	\sa CASheet
 */
 
+QAtomicInt CADocument::_lastRevision(0);
+
 /*!
 	Creates an empty document.
 
@@ -36,6 +38,7 @@ CADocument::CADocument()
     setTimeEdited(0);
     setArchive(new CAArchive());
     setModified(false);
+    _revision = nextRevision();
 }
 
 /*!
@@ -51,6 +54,8 @@ CADocument* CADocument::clone()
     newDocument->setComposer(composer());
     newDocument->setArranger(arranger());
     newDocument->setPoet(poet());
+    newDocument->setTextTranslator(textTranslator());
+    newDocument->setDedication(dedication());
     newDocument->setCopyright(copyright());
     newDocument->setDateCreated(dateCreated());
     newDocument->setDateLastModified(dateLastModified());
@@ -8,6 +8,7 @@
 #ifndef DOCUMENT_H_
 #define DOCUMENT_H_
 
+#include <QAtomicInt>
 #include <QDateTime>
 #include <QList>
 #include <QString>
@@ -65,10 +66,16 @@ public:
     ///////////////////////////////////////////////////////
     const QString fileName() { return _fileName; }
     bool isModified() { return _modified; }
+    unsigned int revision() { return _revision; }
     CAArchive* archive() { return _archive; }
 
     void setFileName(const QString fileName) { _fileName = fileName; } // not saved!
-    void setModified(bool m) { _modified = m; }
+    void setModified(bool m)
+    {
+        _modified = m;
+        if (m)
+            _revision = nextRevision();
+    }
     void setArchive(CAArchive* a) { _archive = a; }
 
 private:
@@ -93,6 +100,9 @@ private:
     ////////////////////////////////////////////////////
     QString _fileName; // absolute filename of the document
     bool _modified; // unsaved changes
+    unsigned int _revision; // unique among all documents, changed on each modification
+    static unsigned int nextRevision() { return static_cast<unsigned int>(_lastRevision.fetchAndAddRelaxed(1) + 1); }
+    static QAtomicInt _lastRevision; // documents may be created in parallel (see CABatchConverter)
     CAArchive* _archive; // pointer to existing archive, if it exists
 };
 #endif /* DOCUMENT_H_ */
@@ -175,6 +175,17 @@ CAMusElement* CAFiguredBassContext::previous(CAMusElement* elt)
         return nullptr;
 }
 
+void CAFiguredBassContext::swapContents(CAContext* other)
+{
+    CAFiguredBassContext* o = static_cast<CAFiguredBassContext*>(other);
+    _figuredBassMarkList.swap(o->_figuredBassMarkList);
+
+    for (int i = 0; i < _figuredBassMarkList.size(); i++)
+        adoptMusElement(_figuredBassMarkList[i]);
+    for (int i = 0; i < o->_figuredBassMarkList.size(); i++)
+        o->adoptMusElement(o->_figuredBassMarkList[i]);
+}
+
 bool CAFiguredBassContext::remove(CAMusElement* elt)
 {
     if (!elt || elt->musElementType() != CAMusElement::FiguredBassMark)
@@ -23,6 +23,7 @@ public:
     CAMusElement* next(CAMusElement* elt);
     CAMusElement* previous(CAMusElement* elt);
     bool remove(CAMusElement* elt);
+    void swapContents(CAContext* other);
 
     QList<CAFiguredBassMark*>& figuredBassMarkList() { return _figuredBassMarkList; }
     CAFiguredBassMark* figuredBassMarkAtTimeStart(int timeStart);
@@ -96,6 +96,17 @@ CAMusElement* CAFunctionMarkContext::previous(CAMusElement* elt)
         return _functionMarkList[idx];
 }
 
+void CAFunctionMarkContext::swapContents(CAContext* other)
+{
+    CAFunctionMarkContext* o = static_cast<CAFunctionMarkContext*>(other);
+    _functionMarkList.swap(o->_functionMarkList);
+
+    for (int i = 0; i < _functionMarkList.size(); i++)
+        adoptMusElement(_functionMarkList[i]);
+    for (int i = 0; i < o->_functionMarkList.size(); i++)
+        o->adoptMusElement(o->_functionMarkList[i]);
+}
+
 bool CAFunctionMarkContext::remove(CAMusElement* elt)
 {
     return _functionMarkList.removeAll(static_cast<CAFunctionMark*>(elt));
@@ -33,6 +33,7 @@ public:
     CAMusElement* next(CAMusElement* elt);
     CAMusElement* previous(CAMusElement* elt);
     bool remove(CAMusElement* elt);
+    void swapContents(CAContext* other);
 
 private:
     QList<CAFunctionMark*> _functionMarkList;
@@ -8,6 +8,7 @@
 #include "score/keysignature.h"
 #include "score/mark.h"
 #include "score/staff.h"
+#include "score/voicerecorder.h"
 
 /*!
 	\class CAKeySignature
@@ -110,6 +111,7 @@ void CAKeySignature::updateAccidentals()
 
 CAKeySignature::~CAKeySignature()
 {
+    CAVoiceRecorder::notifyDeleting(this);
 }
 
 CAKeySignature* CAKeySignature::clone(CAContext* context)
@@ -147,6 +147,17 @@ CAMusElement* CALyricsContext::previous(CAMusElement* elt)
         return nullptr;
 }
 
+void CALyricsContext::swapContents(CAContext* other)
+{
+    CALyricsContext* o = static_cast<CALyricsContext*>(other);
+    _syllableList.swap(o->_syllableList);
+
+    for (int i = 0; i < _syllableList.size(); i++)
+        adoptMusElement(_syllableList[i]);
+    for (int i = 0; i < o->_syllableList.size(); i++)
+        o->adoptMusElement(o->_syllableList[i]);
+}
+
 /*!
 	Removes the given syllable from the list.
 */
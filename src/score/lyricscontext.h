@@ -29,6 +29,7 @@ public:
     CAMusElement* next(CAMusElement*);
     CAMusElement* previous(CAMusElement*);
     bool remove(CAMusElement*);
+    void swapContents(CAContext* other);
     void clear();
 
     inline const QList<CASyllable*>& syllableList() { return _syllableList; }
@@ -7,6 +7,7 @@
 
 #include "score/mark.h"
 #include "score/note.h"
+#include "score/voicerecorder.h"
 
 /*!
 	\class CAMark
@@ -117,11 +118,25 @@ CAMark::CAMarkType CAMark::markTypeFromString(const QString s)
 
 CAMark::~CAMark()
 {
+    if (associatedElement() && associatedElement()->markList().contains(this)) {
+        CAVoiceRecorder::notifyLinksChanging(associatedElement());
+    }
+
     if (associatedElement()) {
         associatedElement()->removeMark(this);
     }
 }
 
+/*!
+	Returns the time of the associated element, if any.
+	The times of the elements in a voice are shifted when music elements are inserted or removed
+	before them (see CAVoice::updateTimes()) and their marks move with them.
+*/
+int CAMark::timeStart() const
+{
+    return _associatedElt ? _associatedElt->timeStart() : CAMusElement::timeStart();
+}
+
 CAMark* CAMark::clone(CAMusElement* elt)
 {
     return new CAMark(markType(), elt, timeStart(), timeLength());
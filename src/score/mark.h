@@ -44,6 +44,8 @@ public:
     virtual CAMark* clone(CAMusElement* elt = nullptr);
     virtual int compare(CAMusElement* elt);
 
+    int timeStart() const;
+
     inline CAMusElement* associatedElement() { return _associatedElt; }
     inline void setAssociatedElement(CAMusElement* elt)
     {
@@ -12,6 +12,7 @@
 #include "score/notecheckererror.h"
 #include "score/playable.h"
 #include "score/staff.h"
+#include "score/voice.h"
 
 /*!
 	\class CAMusElement
@@ -69,6 +70,65 @@ CAMusElement::~CAMusElement()
     }
 }
 
+/*!
+	Returns the time in the score when the music element appears in time.
+	The returned time is in absolute time units.
+
+	\sa _timeStart, setTimeStart()
+*/
+int CAMusElement::timeStart() const
+{
+    return _timeStart + pendingTimeShift();
+}
+
+/*!
+	Sets the time in the score when the music element appears for this music element to \a time.
+	The given time is in absolute time units.
+
+	\sa _timeStart, timeStart()
+*/
+void CAMusElement::setTimeStart(int time)
+{
+    _timeStart = time - pendingTimeShift();
+}
+
+/*!
+	Returns the shift of the time not applied to _timeStart yet.
+
+	Voices shift the times of the elements after an insertion or removal lazily (see
+	CAVoiceIndex::shiftTimes()). A playable element is only indexed by its voice. Clefs, key and
+	time signatures and barlines are shared by the voices of the staff, so the shifts pending in
+	all of them are summed.
+*/
+int CAMusElement::pendingTimeShift() const
+{
+    CAMusElement* elt = const_cast<CAMusElement*>(this);
+    switch (_musElementType) {
+    case Note:
+    case Rest: {
+        CAVoice* voice = static_cast<CAPlayable*>(elt)->voice();
+        return voice ? voice->pendingTimeShift(this) : 0;
+    }
+    case Barline:
+    case Clef:
+    case TimeSignature:
+    case KeySignature: {
+        if (!_context || _context->contextType() != CAContext::Staff) {
+            return 0;
+        }
+
+        int pending = 0;
+        const QList<CAVoice*>& voices = static_cast<CAStaff*>(_context)->voiceList();
+        for (int i = 0; i < voices.size(); i++) {
+            pending += voices[i]->pendingTimeShift(this);
+        }
+        return pending;
+    }
+    default:
+        return 0;
+    }
+}
+
 /*!
 	Returns true, if the current element is playable; otherwise false.
 	Playable elements are music elements with _timeLength variable greater
@@ -228,21 +288,6 @@ void CAMusElement::addMarks(QList<CAMark*> marks)
 	\sa CAContext
 */
 
-/*!
-	\fn CAMusElement::timeStart()
-	Returns the time in the score when the music element appears in time.
-	The returned time is in absolute time units.
-
-	\sa _timeStart, setTimeStart()
-*/
-
-/*!
- 	\fn CAMusElement::setTimeStart(int time)
-	Sets the time in the score when the music element appears for this music element to \a time.
-	The given time is in absolute time units.
-
-	\sa _timeStart, timeStart()
-*/
 
 /*!
 	\fn CAMusElement::timeLength()
@@ -314,7 +359,8 @@ void CAMusElement::addMarks(QList<CAMark*> marks)
 
 /*!
 	\var CAMusElement::_timeStart
-	Where does the music element starts in time.
+	Where does the music element starts in time, without the shifts pending in the voices
+	(see pendingTimeShift()).
 	Time is stored in absolute time units and is not affected by different tempos or
 	other expressions.
 
@@ -19,6 +19,8 @@ class CAMark;
 class CANoteCheckerError;
 
 class CAMusElement {
+    friend class CAVoiceIndex; // applies the pending time shifts to _timeStart
+
 public:
     enum CAMusElementType {
         Undefined = 0,
@@ -49,13 +51,13 @@ public:
     inline CAContext* context() { return _context; }
     inline void setContext(CAContext* context) { _context = context; }
 
-    inline virtual int timeStart() const { return _timeStart; }
-    inline void setTimeStart(int time) { _timeStart = time; }
+    virtual int timeStart() const;
+    void setTimeStart(int time);
     inline virtual int timeLength() const { return _timeLength; }
     inline void setTimeLength(int length) { _timeLength = length; }
     inline int timeEnd() { return timeStart() + timeLength(); }
 
-    inline virtual int realTimeStart() { return _timeStart; } // TODO: calculates and returns time in miliseconds
+    inline virtual int realTimeStart() { return timeStart(); } // TODO: calculates and returns time in miliseconds
     inline virtual int realTimeLength() { return _timeLength; } // TODO: calculates and returns time in miliseconds
     inline int realTimeEnd() { return realTimeStart() + realTimeLength(); } // TODO: calculates and returns time in miliseconds
 
@@ -84,6 +86,7 @@ public:
 
 protected:
     inline void setMusElementType(CAMusElementType type) { _musElementType = type; }
+    int pendingTimeShift() const;
 
     CAMusElementType _musElementType;
     QList<CAMark*> _markList;
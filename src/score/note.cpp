@@ -10,6 +10,7 @@
 #include "score/mark.h"
 #include "score/staff.h"
 #include "score/voice.h"
+#include "score/voicerecorder.h"
 
 /*!
 	\class CANote
@@ -47,6 +48,8 @@ CANote::CANote(CADiatonicPitch pitch, CAPlayableLength length, CAVoice* voice, i
 
 CANote::~CANote()
 {
+    CAVoiceRecorder::notifyDeleting(this);
+
     if (tieStart())
         delete tieStart(); // slurs destructor also disconnects itself from the notes
     if (tieEnd())
@@ -164,14 +167,14 @@ const QString CANote::generateNoteName(int pitch, int accs)
 */
 bool CANote::isPartOfChord()
 {
-    int idx = voice()->musElementList().indexOf(this);
+    int idx = voice()->musElementIndex(this);
 
     // is there a note with the same start time after ours?
-    if (idx + 1 < voice()->musElementList().size() && voice()->musElementList()[idx + 1]->musElementType() == CAMusElement::Note && voice()->musElementList()[idx + 1]->timeStart() == _timeStart)
+    if (idx + 1 < voice()->musElementList().size() && voice()->musElementList()[idx + 1]->musElementType() == CAMusElement::Note && voice()->musElementList()[idx + 1]->timeStart() == timeStart())
         return true;
 
     // is there a note with the same start time before ours?
-    if (idx > 0 && voice()->musElementList()[idx - 1]->musElementType() == CAMusElement::Note && voice()->musElementList()[idx - 1]->timeStart() == _timeStart)
+    if (idx > 0 && voice()->musElementList()[idx - 1]->musElementType() == CAMusElement::Note && voice()->musElementList()[idx - 1]->timeStart() == timeStart())
         return true;
 
     return false;
@@ -182,10 +185,10 @@ bool CANote::isPartOfChord()
 */
 bool CANote::isFirstInChord()
 {
-    int idx = voice()->musElementList().indexOf(this);
+    int idx = voice()->musElementIndex(this);
 
     //is there a note with the same start time before ours?
-    if (idx > 0 && voice()->musElementList()[idx - 1]->musElementType() == CAMusElement::Note && voice()->musElementList()[idx - 1]->timeStart() == _timeStart)
+    if (idx > 0 && voice()->musElementList()[idx - 1]->musElementType() == CAMusElement::Note && voice()->musElementList()[idx - 1]->timeStart() == timeStart())
         return false;
 
     return true;
@@ -196,10 +199,10 @@ bool CANote::isFirstInChord()
 */
 bool CANote::isLastInChord()
 {
-    int idx = voice()->musElementList().indexOf(this);
+    int idx = voice()->musElementIndex(this);
 
     //is there a note with the same start time after ours?
-    if (idx + 1 < voice()->musElementList().size() && voice()->musElementList()[idx + 1]->musElementType() == CAMusElement::Note && voice()->musElementList()[idx + 1]->timeStart() == _timeStart)
+    if (idx + 1 < voice()->musElementList().size() && voice()->musElementList()[idx + 1]->musElementType() == CAMusElement::Note && voice()->musElementList()[idx + 1]->timeStart() == timeStart())
         return false;
 
     return true;
@@ -216,7 +219,7 @@ bool CANote::isLastInChord()
 QList<CANote*> CANote::getChord()
 {
     QList<CANote*> list;
-    int idx = voice()->musElementList().indexOf(this) - 1;
+    int idx = voice()->musElementIndex(this) - 1;
 
     while (idx >= 0 && voice()->musElementList()[idx]->musElementType() == CAMusElement::Note && voice()->musElementList()[idx]->timeStart() == timeStart())
         idx--;
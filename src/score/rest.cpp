@@ -8,6 +8,7 @@
 #include "score/rest.h"
 #include "score/mark.h"
 #include "score/staff.h"
+#include "score/voicerecorder.h"
 
 /*!
 	\class CARest
@@ -34,6 +35,7 @@ CARest::CARest(CARestType type, CAPlayableLength length, CAVoice* voice, int tim
 */
 CARest::~CARest()
 {
+    CAVoiceRecorder::notifyDeleting(this);
 }
 
 CARest* CARest::clone(CAVoice* voice)
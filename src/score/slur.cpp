@@ -7,6 +7,7 @@
 
 #include "score/slur.h"
 #include "score/note.h"
+#include "score/voicerecorder.h"
 
 /*!
 	\class CASlur
@@ -56,6 +57,9 @@ CASlur::CASlur(CASlurType type, CASlurDirection dir, CAContext* c, CANote* noteS
 
 CASlur::~CASlur()
 {
+    if (noteStart())
+        CAVoiceRecorder::notifyLinksChanging(noteStart());
+
     switch (slurType()) {
     case TieType:
         if (noteStart())
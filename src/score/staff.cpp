@@ -8,14 +8,17 @@
 #include <QtDebug>
 
 #include <QPainter>
+#include <QSet>
 #include <iostream>
 
 #include "score/note.h"
 #include "score/rest.h" // used for voice synchronization
+#include "score/slur.h"
 #include "score/staff.h"
 #include "score/tempo.h"
 #include "score/tuplet.h"
 #include "score/voice.h"
+#include "score/voicerecorder.h"
 
 #include "score/barline.h"
 #include "score/timesignature.h"
@@ -44,10 +47,14 @@ CAStaff::CAStaff(const QString name, CASheet* s, int numberOfLines)
     _contextType = CAContext::Staff;
     _numberOfLines = numberOfLines;
     _name = name;
+    _recorder = nullptr;
 }
 
 CAStaff::~CAStaff()
 {
+    if (_recorder)
+        _recorder->staffDeleting();
+
     clear();
 }
 
@@ -221,7 +228,7 @@ CAVoice* CAStaff::addVoice()
 CAMusElement* CAStaff::next(CAMusElement* elt)
 {
     for (int i = 0; i < voiceList().size(); i++) { // go through all the voices and check, if any of them includes the given element
-        if (voiceList()[i]->musElementList().contains(elt)) {
+        if (voiceList()[i]->musElementIndex(elt) != -1) {
             return voiceList()[i]->next(elt);
         }
     }
@@ -237,7 +244,7 @@ CAMusElement* CAStaff::next(CAMusElement* elt)
 CAMusElement* CAStaff::previous(CAMusElement* elt)
 {
     for (int i = 0; i < voiceList().size(); i++) { // go through all the voices and check, if any of them includes the given element
-        if (voiceList()[i]->musElementList().contains(elt)) {
+        if (voiceList()[i]->musElementIndex(elt) != -1) {
             return voiceList()[i]->previous(elt);
         }
     }
@@ -260,6 +267,61 @@ bool CAStaff::remove(CAMusElement* elt, bool updateSignTimes)
     return voiceList()[0]->remove(elt, updateSignTimes);
 }
 
+/*!
+	Exchanges the music elements of the voices and the references lists of shared signs with the
+	\a other staff. Voices are paired by their index, so both staves should have the same number
+	of voices.
+
+	\sa CAContext::swapContents()
+*/
+void CAStaff::swapContents(CAContext* other)
+{
+    CAStaff* o = static_cast<CAStaff*>(other);
+    for (int i = 0; i < _voiceList.size() && i < o->_voiceList.size(); i++) {
+        _voiceList[i]->swapMusElements(o->_voiceList[i]);
+    }
+
+    _clefList.swap(o->_clefList);
+    _keySignatureList.swap(o->_keySignatureList);
+    _timeSignatureList.swap(o->_timeSignatureList);
+    _barlineList.swap(o->_barlineList);
+
+    adoptVoiceElements();
+    o->adoptVoiceElements();
+}
+
+/*!
+	Sets this staff and its voices as the parents of the music elements in the voices, their
+	marks, slurs and tuplets.
+*/
+void CAStaff::adoptVoiceElements()
+{
+    for (int i = 0; i < _voiceList.size(); i++) {
+        const QList<CAMusElement*>& list = _voiceList[i]->musElementList();
+        for (int j = 0; j < list.size(); j++) {
+            if (list[j]->isPlayable()) {
+                CAPlayable* p = static_cast<CAPlayable*>(list[j]);
+                p->setVoice(_voiceList[i]);
+                if (p->tuplet()) {
+                    p->tuplet()->setContext(this);
+                }
+            }
+
+            if (list[j]->musElementType() == CAMusElement::Note) {
+                CANote* n = static_cast<CANote*>(list[j]);
+                CASlur* slurs[] = { n->tieStart(), n->tieEnd(), n->slurStart(), n->slurEnd(), n->phrasingSlurStart(), n->phrasingSlurEnd() };
+                for (CASlur* slur : slurs) {
+                    if (slur) {
+                        slur->setContext(this);
+                    }
+                }
+            }
+
+            adoptMusElement(list[j]);
+        }
+    }
+}
+
 /*!
 	Returns the first voice with the given \a name or Null, if such a voice doesn't exist.
 */
@@ -351,36 +413,52 @@ CATempo* CAStaff::getTempo(int time)
 	3) If a voice elements are not linear (every N-th element's timeEnd should be N+1-th element's timeStart)
 	   inserts rests to achieve linearity.
 
+	Only the elements starting at \a timeStart or later are synchronized. The music before it is
+	expected to be synchronized already, eg. when called after an edit at \a timeStart. If \a timeEnd
+	is given, the synchronization stops after that time, so the caller should be sure the music after
+	it didn't change. The references lists of shared signs are updated for the synchronized range only.
+
 	Synchronizing voices is relatively slow (O(n*m) where n is number of voices and m number of elements
 	in voice n). This was the main reason to not automate the synchronization: import filters use lots of
 	insertions and synchronization of the voices every time a new element is inserted would considerably
-	slow down the import filter.
+	slow down the import filter. Limit the range to the edited music whenever possible.
 
 	\return True, if everything was ok. False, if fixes were needed.
 */
-bool CAStaff::synchronizeVoices()
+bool CAStaff::synchronizeVoices(int timeStart, int timeEnd)
 {
-    int* pidx = new int[voiceList().size()];
+    if (timeStart < 0)
+        timeStart = 0;
+
+    // first fix any inconsistencies inside a voice
     for (int i = 0; i < voiceList().size(); i++)
-        pidx[i] = -1; // array of current indices of voices at current timeStart
+        voiceList()[i]->synchronizeMusElements(timeStart);
+
+    int* pidx = new int[voiceList().size()]; // array of current indices of voices at current timeStart
     CAMusElement** plastPlayable = new CAMusElement*[voiceList().size()];
-    for (int i = 0; i < voiceList().size(); i++)
+    for (int i = 0; i < voiceList().size(); i++) {
+        pidx[i] = voiceList()[i]->lowerBound_startTime(timeStart) - 1;
         plastPlayable[i] = nullptr;
+        for (int j = pidx[i]; j >= 0; j--) {
+            if (voiceList()[i]->musElementList()[j]->isPlayable()) {
+                plastPlayable[i] = voiceList()[i]->musElementList()[j];
+                break;
+            }
+        }
+    }
 
-    _clefList.clear();
-    _keySignatureList.clear();
-    _timeSignatureList.clear();
-    _barlineList.clear();
+    // shared signs in the synchronized range are gathered again below
+    QList<CAMusElement*> clefTail = takeRefs(_clefList, timeStart);
+    QList<CAMusElement*> keySignatureTail = takeRefs(_keySignatureList, timeStart);
+    QList<CAMusElement*> timeSignatureTail = takeRefs(_timeSignatureList, timeStart);
+    QList<CAMusElement*> barlineTail = takeRefs(_barlineList, timeStart);
 
-    int timeStart = 0;
+    int syncedTime = timeStart;
     bool done = false;
     bool changesMade = false;
 
-    // first fix any inconsistencies inside a voice
-    for (int i = 0; i < voiceList().size(); i++)
-        voiceList()[i]->synchronizeMusElements();
-
     while (!done) {
+        syncedTime = timeStart;
         QList<CAMusElement*> sharedList; // list of shared music elements having the same time-start sorted by voice number
 
         // gather shared elements into sharedList and remove them from the voice at new timeStart
@@ -390,7 +468,7 @@ bool CAStaff::synchronizeVoices()
                 if (!sharedList.contains(voiceList()[i]->musElementList()[pidx[i] + 1])) {
                     sharedList << voiceList()[i]->musElementList()[pidx[i] + 1];
                 }
-                voiceList()[i]->_musElementList.removeAt(pidx[i] + 1);
+                voiceList()[i]->removeMusElementAt(pidx[i] + 1);
             }
         }
 
@@ -399,7 +477,7 @@ bool CAStaff::synchronizeVoices()
         if (sharedList.size()) {
             for (int i = 0; i < voiceList().size(); i++) {
                 for (int j = 0; j < sharedList.size(); j++) {
-                    voiceList()[i]->_musElementList.insert(pidx[i] + 1 + j, sharedList[j]);
+                    voiceList()[i]->insertMusElementAt(pidx[i] + 1 + j, sharedList[j]);
                 }
                 pidx[i]++; // jump to the first one inserted from the sharedList, if inserting shared elts for the first time
                     // or the first one after the sharedList in second pass
@@ -450,9 +528,9 @@ bool CAStaff::synchronizeVoices()
                     int gapLength = plastPlayable[j]->timeEnd() - timeStart;
                     QList<CARest*> restList = CARest::composeRests(gapLength, voiceList()[i]->musElementList()[pidx[i]]->timeStart(), voiceList()[i]);
 
-                    voiceList()[i]->musElementList()[pidx[i]]->setTimeStart(plastPlayable[j]->timeEnd());
+                    voiceList()[i]->setMusElementTimeStart(pidx[i], plastPlayable[j]->timeEnd());
                     for (int k = 0; k < restList.size(); k++)
-                        voiceList()[i]->_musElementList.insert(pidx[i]++, restList[k]); // insert the missing rests, rests are added in back, pidx++
+                        voiceList()[i]->insertMusElementAt(pidx[i]++, restList[k]); // insert the missing rests, rests are added in back, pidx++
                     voiceList()[i]->updateTimes(pidx[i], gapLength, false); // increase playable timeStarts
                     if (restList.size()) {
                         plastPlayable[i] = restList.last();
@@ -473,7 +551,7 @@ bool CAStaff::synchronizeVoices()
                 int gapLength = timeStart - ((pidx[j] == -1 || !plastPlayable[j]) ? 0 : plastPlayable[j]->timeEnd());
                 QList<CARest*> restList = CARest::composeRests(gapLength, (pidx[j] == -1 || !plastPlayable[j]) ? 0 : plastPlayable[j]->timeEnd(), voiceList()[j]);
                 for (int k = 0; k < restList.size(); k++)
-                    voiceList()[j]->_musElementList.insert(pidx[j]++, restList[k]); // insert the missing rests, rests are added in back, pidx++
+                    voiceList()[j]->insertMusElementAt(pidx[j]++, restList[k]); // insert the missing rests, rests are added in back, pidx++
                 voiceList()[j]->updateTimes(pidx[j], gapLength, false); // increase playable timeStarts
                 if (restList.size()) {
                     plastPlayable[j] = restList.last();
@@ -506,12 +584,57 @@ bool CAStaff::synchronizeVoices()
         for (int i = 0; i < voiceList().size(); i++)
             if (pidx[i] < voiceList()[i]->musElementList().size() - 1)
                 done = false;
+
+        if (timeEnd != -1 && timeStart > timeEnd)
+            done = true;
     }
 
+    // restore the references of shared signs after the synchronized range
+    restoreRefs(_clefList, clefTail, syncedTime);
+    restoreRefs(_keySignatureList, keySignatureTail, syncedTime);
+    restoreRefs(_timeSignatureList, timeSignatureTail, syncedTime);
+    restoreRefs(_barlineList, barlineTail, syncedTime);
+
     delete[] pidx;
+    delete[] plastPlayable;
     return changesMade;
 }
 
+/*!
+	Removes the references starting at \a timeStart or later from the sorted \a refs list and
+	returns them.
+
+	\sa synchronizeVoices(), restoreRefs()
+*/
+QList<CAMusElement*> CAStaff::takeRefs(QList<CAMusElement*>& refs, int timeStart)
+{
+    int i = refs.size();
+    while (i > 0 && refs[i - 1]->timeStart() >= timeStart)
+        i--;
+
+    QList<CAMusElement*> tail = refs.mid(i);
+    refs.erase(refs.begin() + i, refs.end());
+    return tail;
+}
+
+/*!
+	Appends the references from \a tail starting after \a syncedTime back to \a refs.
+	The references up to \a syncedTime were gathered by synchronizeVoices() already.
+
+	\sa synchronizeVoices(), takeRefs()
+*/
+void CAStaff::restoreRefs(QList<CAMusElement*>& refs, const QList<CAMusElement*>& tail, int syncedTime)
+{
+    QSet<CAMusElement*> gathered; // signs moved after syncedTime when synchronizing are gathered already
+    for (int i = 0; i < refs.size(); i++)
+        gathered.insert(refs[i]);
+
+    for (int i = 0; i < tail.size(); i++) {
+        if (tail[i]->timeStart() > syncedTime && !gathered.contains(tail[i]))
+            refs << tail[i];
+    }
+}
+
 /*!
 	Places a barline in front of the element, if needed and the element is the
 	last element in the staff.
@@ -545,7 +668,7 @@ bool CAStaff::placeAutoBar(CAPlayable* elt)
     if (t) {
         if ((b ? (b->timeStart()) : 0) + t->barDuration() <= elt->timeStart()) {
             elt->voice()->insert(elt, new CABarline(CABarline::Single, elt->staff(), elt->timeStart()));
-            elt->staff()->synchronizeVoices();
+            elt->staff()->synchronizeVoices(elt->timeStart());
 
             return true;
         }
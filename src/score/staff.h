@@ -21,6 +21,7 @@ class CAContext;
 class CAVoice;
 class CANote;
 class CATempo;
+class CAVoiceRecorder;
 
 class CAStaff : public CAContext {
 public:
@@ -43,6 +44,7 @@ public:
     CAMusElement* previous(CAMusElement* elt);
     bool remove(CAMusElement* elt, bool updateSignTimes);
     bool remove(CAMusElement* elt) { return remove(elt, true); }
+    void swapContents(CAContext* other);
 
     int lastTimeEnd();
     QList<CAMusElement*> getEltByType(CAMusElement::CAMusElementType type, int startTime);
@@ -51,7 +53,7 @@ public:
     QList<CAPlayable*> getChord(int time);
     CATempo* getTempo(int time);
 
-    bool synchronizeVoices();
+    bool synchronizeVoices(int timeStart = 0, int timeEnd = -1);
 
     static bool placeAutoBar(CAPlayable* elt);
 
@@ -61,7 +63,14 @@ public:
     inline QList<CAMusElement*>& timeSignatureRefs() { return _timeSignatureList; }
     inline QList<CAMusElement*>& barlineRefs() { return _barlineList; }
 
+    inline CAVoiceRecorder* recorder() { return _recorder; }
+    inline void setRecorder(CAVoiceRecorder* recorder) { _recorder = recorder; }
+
 private:
+    void adoptVoiceElements();
+    static QList<CAMusElement*> takeRefs(QList<CAMusElement*>& refs, int timeStart);
+    static void restoreRefs(QList<CAMusElement*>& refs, const QList<CAMusElement*>& tail, int syncedTime);
+
     QList<CAVoice*> _voiceList;
 
     int _numberOfLines;
@@ -70,5 +79,7 @@ private:
     QList<CAMusElement*> _keySignatureList;
     QList<CAMusElement*> _timeSignatureList;
     QList<CAMusElement*> _barlineList;
+
+    CAVoiceRecorder* _recorder; // observer of the changes of the voices, not owned
 };
 #endif /* STAFF_H_ */
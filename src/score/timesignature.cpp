@@ -9,6 +9,7 @@
 #include "score/mark.h"
 #include "score/playablelength.h"
 #include "score/staff.h"
+#include "score/voicerecorder.h"
 
 /*!
 	\class CATimeSignature
@@ -62,11 +63,12 @@ CATimeSignature::CATimeSignature(int beats, int beat, CAStaff* staff, int startT
 
 CATimeSignature::~CATimeSignature()
 {
+    CAVoiceRecorder::notifyDeleting(this);
 }
 
 CATimeSignature* CATimeSignature::clone(CAContext* context)
 {
-    CATimeSignature* t = new CATimeSignature(_beats, _beat, static_cast<CAStaff*>(context), _timeStart, _timeSignatureType);
+    CATimeSignature* t = new CATimeSignature(_beats, _beat, static_cast<CAStaff*>(context), timeStart(), _timeSignatureType);
 
     for (int i = 0; i < markList().size(); i++) {
         CAMark* m = static_cast<CAMark*>(markList()[i]->clone(t));
@@ -8,6 +8,7 @@
 #include "score/tuplet.h"
 #include "score/playable.h"
 #include "score/voice.h"
+#include "score/voicerecorder.h"
 #include <iostream> // debug
 
 /*!
@@ -38,6 +39,7 @@ CATuplet::CATuplet(int number, int actualNumber, QList<CAPlayable*> noteList)
     , _noteList(noteList)
 {
     setMusElementType(Tuplet);
+    CAVoiceRecorder::notifyLinksChanging(_noteList);
 
     assignTimes();
 }
@@ -58,6 +60,7 @@ CATuplet::CATuplet(int number, int actualNumber)
 
 CATuplet::~CATuplet()
 {
+    CAVoiceRecorder::notifyLinksChanging(_noteList);
     resetTimes();
 }
 
@@ -295,12 +298,25 @@ void CATuplet::resetTimes()
  */
 void CATuplet::addNote(CAPlayable* p)
 {
+    CAVoiceRecorder::notifyLinksChanging(_noteList);
+    CAVoiceRecorder::notifyLinksChanging(p);
+
     int i;
     for (i = 0; i < noteList().size() && noteList()[i]->timeStart() <= p->timeStart() && (noteList()[i]->musElementType() != Note || noteList()[i]->timeStart() != p->timeStart() || static_cast<CANote*>(noteList()[i])->diatonicPitch().noteName() < static_cast<CANote*>(p)->diatonicPitch().noteName()); i++)
         ;
     _noteList.insert(i, p);
 }
 
+/*!
+	Removes the note or rest \a p from the tuplet.
+	The times of the elements are not changed, call assignTimes() afterwards.
+*/
+void CATuplet::removeNote(CAPlayable* p)
+{
+    CAVoiceRecorder::notifyLinksChanging(_noteList);
+    _noteList.removeAll(p);
+}
+
 /*!
 	Returns a pointer to the next member of tuplet with a greater timeStart.
 	If it doesn't exist it returns nullptr.
@@ -33,7 +33,7 @@ public:
     inline const QList<CAPlayable*>& noteList() const { return _noteList; }
     void addNote(CAPlayable* p);
     inline void addNotes(QList<CAPlayable*> l) { _noteList << l; }
-    inline void removeNote(CAPlayable* p) { _noteList.removeAll(p); }
+    void removeNote(CAPlayable* p);
     CAPlayable* firstNote();
     CAPlayable* lastNote();
     inline bool containsNote(CAPlayable* p) { return noteList().contains(p); }
@@ -19,6 +19,7 @@
 #include "score/staff.h"
 #include "score/tempo.h"
 #include "score/timesignature.h"
+#include "score/voicerecorder.h"
 
 /*!
 	\class CAVoice
@@ -27,6 +28,12 @@
 	CAVoice is a class which holds music elements in the staff. In hieararchy, staff
 	includes multiple voices and every voice includes multiple music elements.
 
+	Besides the ordered list of music elements, the voice keeps an index of their positions
+	in the list (see CAVoiceIndex), so next(), previous() and other queries relative to a given
+	element don't need to search the whole list. The index is updated in O(log n) by each
+	insertion or removal regardless of its position. The index also shifts the times of the
+	elements after an inserted or removed one lazily, so updateTimes() is O(log n) as well.
+
 	\sa CAStaff, CAMusElement
 */
 
@@ -105,7 +112,7 @@ void CAVoice::clear()
         if (_musElementList.front()->isPlayable() || (staff() && staff()->voiceList().size() < 2))
             delete _musElementList.front(); // CAMusElement's destructor removes it from the list
         else
-            _musElementList.removeFirst();
+            removeMusElementAt(0);
     }
 }
 
@@ -173,7 +180,7 @@ bool CAVoice::insert(CAMusElement* eltAfter, CAMusElement* elt, bool addToChord)
 
         // calculate note positions in staff when inserting a new clef
         if (elt->musElementType() == CAMusElement::Clef) {
-            for (int i = musElementList().indexOf(elt) + 1; i < musElementList().size(); i++) {
+            for (int i = musElementIndex(elt) + 1; i < musElementList().size(); i++) {
                 if (musElementList()[i]->musElementType() == CAMusElement::Note)
                     static_cast<CANote*>(musElementList()[i])->setDiatonicPitch(static_cast<CANote*>(musElementList()[i])->diatonicPitch());
             }
@@ -191,7 +198,7 @@ bool CAVoice::insert(CAMusElement* eltAfter, CAMusElement* elt, bool addToChord)
 
         elt->setTimeStart(eltAfter ? (eltAfter->timeStart()) : lastTimeEnd());
         res = insertMusElement(eltAfter, elt);
-        updateTimes(musElementList().indexOf(elt) + 1, elt->timeLength(), true);
+        updateTimes(musElementIndex(elt) + 1, elt->timeLength(), true);
     }
 
     return res;
@@ -244,57 +251,66 @@ CAPlayable* CAVoice::insertInTupletAndVoiceAt(CAPlayable* reference, CAPlayable*
 	Returns a pointer to the clef which the given \a elt belongs to.
 	Returns nullptr, if no clefs placed yet.
 
-	Warning! This operation is slow (linear time), but always returns the
-	correct clef depending on the order of the musElementList. If a timeBased
+	This operation is linear in the number of elements between the clef and \a elt, but always
+	returns the correct clef depending on the order of the musElementList. If a timeBased
 	result suffices, use CAStaff::getClef(time).
 */
 CAClef* CAVoice::getClef(CAMusElement* elt)
 {
-    if (!elt || !musElementList().contains(elt))
-        elt = lastMusElement();
+    int i = musElementIndex(elt);
+    if (i == -1)
+        i = musElementList().size() - 1;
 
-    while (elt && (elt->musElementType() != CAMusElement::Clef) && (elt = previous(elt)))
-        ;
+    for (; i >= 0; i--) {
+        if (musElementList()[i]->musElementType() == CAMusElement::Clef)
+            return static_cast<CAClef*>(musElementList()[i]);
+    }
 
-    return static_cast<CAClef*>(elt);
+    return nullptr;
 }
 
 /*!
 	Returns a pointer to the time signature which the given \a elt belongs to.
 	Returns nullptr, if no time signatures placed yet.
 
-	Warning! This operation is slow (linear time), but always returns the
-	correct timeSig depending on the order of the musElementList. If a timeBased
+	This operation is linear in the number of elements between the time signature and \a elt,
+	but always returns the correct timeSig depending on the order of the musElementList. If a timeBased
 	result suffices, use CAStaff::getClef(time).
 */
 CATimeSignature* CAVoice::getTimeSig(CAMusElement* elt)
 {
-    if (!elt || !musElementList().contains(elt))
-        elt = lastMusElement();
+    int i = musElementIndex(elt);
+    if (i == -1)
+        i = musElementList().size() - 1;
 
-    while (elt && (elt->musElementType() != CAMusElement::TimeSignature) && (elt = previous(elt)))
-        ;
+    for (; i >= 0; i--) {
+        if (musElementList()[i]->musElementType() == CAMusElement::TimeSignature)
+            return static_cast<CATimeSignature*>(musElementList()[i]);
+    }
 
-    return static_cast<CATimeSignature*>(elt);
+    return nullptr;
 }
 
 /*!
 	Returns a pointer to the key signature which the given \a elt belongs to.
 	Returns nullptr, if no key signatures placed yet.
 
-	Warning! This operation is slow (linear time), but always returns the
-	correct keySig depending on the order of the musElementList. If a timeBased
+	This operation is linear in the number of elements between the key signature and \a elt,
+	but always returns the correct keySig depending on the order of the musElementList. If a timeBased
 	result suffices, use CAStaff::getClef(time).
 */
 CAKeySignature* CAVoice::getKeySig(CAMusElement* elt)
 {
-    if (!elt || !musElementList().contains(elt))
-        elt = lastMusElement();
+    int i = musElementIndex(elt);
+    if (i == -1)
+        i = musElementList().size() - 1;
 
-    while (elt && (elt->musElementType() != CAMusElement::KeySignature) && (elt = previous(elt)))
-        ;
+    for (; i >= 0; i--) {
+        if (musElementList()[i]->musElementType() == CAMusElement::KeySignature)
+            return static_cast<CAKeySignature*>(musElementList()[i]);
+    }
 
-    return static_cast<CAKeySignature*>(elt);
+    return nullptr;
 }
 
 /*!
@@ -314,10 +330,15 @@ CAKeySignature* CAVoice::getKeySig(CAMusElement* elt)
 */
 bool CAVoice::remove(CAMusElement* elt, bool updateSigns)
 {
-    if (_musElementList.contains(elt)) { // if the search element is found
+    if (musElementIndex(elt) != -1) { // if the search element is found
+        if (staff() && staff()->recorder() && CAVoiceRecorder::hasLinks(elt))
+            staff()->recorder()->linksChanging(elt); // slurs, tuplets and marks are changed below
+
         if (!elt->isPlayable() && staff()) { // element is shared - remove it from all the voices
             for (int i = 0; i < staff()->voiceList().size(); i++) {
-                staff()->voiceList()[i]->_musElementList.removeAll(elt);
+                int idx = staff()->voiceList()[i]->musElementIndex(elt);
+                if (idx != -1)
+                    staff()->voiceList()[i]->removeMusElementAt(idx);
             }
             // remove it from the references list
             if (elt->musElementType() == CAMusElement::KeySignature)
@@ -359,15 +380,15 @@ bool CAVoice::remove(CAMusElement* elt, bool updateSigns)
                     if (n->tuplet())
                         delete n->tuplet();
 
-                    updateTimes(musElementList().indexOf(elt) + 1, elt->timeLength() * (-1), updateSigns); // shift back timeStarts of playable elements after it
+                    updateTimes(musElementIndex(elt) + 1, elt->timeLength() * (-1), updateSigns); // shift back timeStarts of playable elements after it
                 }
             } else {
                 if (elt->isPlayable() && static_cast<CAPlayable*>(elt)->tuplet())
                     delete static_cast<CAPlayable*>(elt)->tuplet();
-                updateTimes(musElementList().indexOf(elt) + 1, elt->timeLength() * (-1), updateSigns); // shift back timeStarts of playable elements after it
+                updateTimes(musElementIndex(elt) + 1, elt->timeLength() * (-1), updateSigns); // shift back timeStarts of playable elements after it
             }
 
-            _musElementList.removeAll(elt); // removes the element from the voice music element list
+            removeMusElementAt(musElementIndex(elt)); // removes the element from the voice music element list
         }
 
         return true;
@@ -385,13 +406,13 @@ bool CAVoice::remove(CAMusElement* elt, bool updateSigns)
 bool CAVoice::insertMusElement(CAMusElement* eltAfter, CAMusElement* elt)
 {
     if (!eltAfter || !_musElementList.size()) {
-        _musElementList.push_back(elt);
+        insertMusElementAt(_musElementList.size(), elt);
     } else {
-        int i = musElementList().indexOf(eltAfter);
+        int i = musElementIndex(eltAfter);
 
         // if element wasn't found and the element before is slur
         if (eltAfter->musElementType() == CAMusElement::Slur && i == -1)
-            i = musElementList().indexOf(static_cast<CASlur*>(eltAfter)->noteEnd());
+            i = musElementIndex(static_cast<CASlur*>(eltAfter)->noteEnd());
 
         if (i == -1) {
             // eltBefore still wasn't found, return False
@@ -399,7 +420,7 @@ bool CAVoice::insertMusElement(CAMusElement* eltAfter, CAMusElement* elt)
         }
 
         // eltBefore found, insert it
-        _musElementList.insert(i, elt);
+        insertMusElementAt(i, elt);
     }
 
     CAMusElement* next = nextByType(elt->musElementType(), elt);
@@ -447,23 +468,23 @@ bool CAVoice::insertMusElement(CAMusElement* eltAfter, CAMusElement* elt)
 */
 bool CAVoice::addNoteToChord(CANote* note, CANote* referenceNote)
 {
-    int idx = _musElementList.indexOf(referenceNote);
+    int idx = musElementIndex(referenceNote);
 
     if (idx == -1)
         return false;
 
     QList<CANote*> chord = referenceNote->getChord();
-    idx = _musElementList.indexOf(chord.first());
+    idx = musElementIndex(chord.first());
 
     int i;
     for (i = 0; i < chord.size() && chord[i]->diatonicPitch().noteName() < note->diatonicPitch().noteName(); i++)
         ;
 
-    _musElementList.insert(idx + i, note);
     note->setPlayableLength(referenceNote->playableLength());
     note->setTimeLength(referenceNote->timeLength());
     note->setTimeStart(referenceNote->timeStart());
     note->setStemDirection(referenceNote->stemDirection());
+    insertMusElementAt(idx + i, note);
 
     return true;
 }
@@ -550,6 +571,23 @@ bool CAVoice::binarySearch_startTime(int time, int& position)
     return false;
 }
 
+/*!
+	Returns the index of the first music element with timeStart equal or greater than the given
+	\a time or the number of elements, if all the elements start earlier.
+*/
+int CAVoice::lowerBound_startTime(int time)
+{
+    int low = 0, high = _musElementList.size();
+    while (low < high) {
+        int midpoint = (low + high) / 2;
+        if (_musElementList[midpoint]->timeStart() < time)
+            low = midpoint + 1;
+        else
+            high = midpoint;
+    }
+    return low;
+}
+
 /*!
 	Returns a music element which has the given \a startTime and \a type.
 	This is useful for querying for eg. If a barline exists at the certain
@@ -754,7 +792,7 @@ CAMusElement* CAVoice::next(CAMusElement* elt)
     if (musElementList().isEmpty())
         return nullptr;
     if (elt) {
-        int idx = _musElementList.indexOf(elt);
+        int idx = musElementIndex(elt);
 
         if (idx == -1) //the element wasn't found
             return nullptr;
@@ -811,7 +849,7 @@ CAMusElement* CAVoice::previous(CAMusElement* elt)
     if (musElementList().isEmpty())
         return nullptr;
     if (elt) {
-        int idx = _musElementList.indexOf(elt);
+        int idx = musElementIndex(elt);
 
         if (--idx < 0) //if the element wasn't found or was the first element
             return nullptr;
@@ -930,24 +968,89 @@ CAPlayable* CAVoice::previousPlayable(int timeStart)
         return nullptr;
 }
 
+/*!
+	Returns the position of the given music element \a elt in musElementList() or -1, if the
+	element isn't part of this voice.
+*/
+int CAVoice::musElementIndex(const CAMusElement* elt)
+{
+    if (!elt)
+        return -1;
+
+    return _musElementIndex.indexOf(elt);
+}
+
+/*!
+	Inserts the music element \a elt at position \a idx of the music elements list and
+	its index.
+*/
+void CAVoice::insertMusElementAt(int idx, CAMusElement* elt)
+{
+    _musElementList.insert(idx, elt);
+    _musElementIndex.insert(idx, elt);
+
+    if (_staff && _staff->recorder())
+        _staff->recorder()->musElementInserted(this, idx);
+}
+
+/*!
+	Removes the music element at position \a idx of the music elements list and its index.
+*/
+void CAVoice::removeMusElementAt(int idx)
+{
+    if (_staff && _staff->recorder())
+        _staff->recorder()->musElementRemoving(this, idx);
+
+    _musElementList.removeAt(idx);
+    _musElementIndex.removeAt(idx);
+}
+
+/*!
+	Sets the time start of the music element at position \a idx to \a time.
+	Used instead of CAMusElement::setTimeStart() for the elements already part of the voice, so
+	the change is reported to the recorder of the staff.
+
+	\sa CAVoiceRecorder
+*/
+void CAVoice::setMusElementTimeStart(int idx, int time)
+{
+    CAMusElement* elt = _musElementList[idx];
+    int oldTimeStart = elt->timeStart();
+    elt->setTimeStart(time);
+
+    if (_staff && _staff->recorder())
+        _staff->recorder()->timeStartChanged(this, idx, oldTimeStart);
+}
+
+/*!
+	Exchanges the music elements and their positions index with the \a other voice.
+	The parent voice and context of the elements are not changed.
+
+	\sa CAStaff::swapContents()
+*/
+void CAVoice::swapMusElements(CAVoice* other)
+{
+    _musElementList.swap(other->_musElementList);
+    _musElementIndex.swap(other->_musElementIndex);
+}
+
 /*!
 	Updates times of playable elements and optionally \a signsToo after and including the given index
 	\a idx for a delta \a length. The order of the elements stays intact.
 
+	The times are shifted lazily by the positions index in O(log n) (see CAVoiceIndex::shiftTimes()).
+	Marks follow the time of their element (see CAMark::timeStart()).
+
 	This method is usually called when inserting, removing or changing the music elements so they affect
 	others.
 */
 bool CAVoice::updateTimes(int idx, int length, bool signsToo)
 {
-    for (int i = idx; i < musElementList().size(); i++)
-        if (signsToo || musElementList()[i]->isPlayable()) {
-            musElementList()[i]->setTimeStart(musElementList()[i]->timeStart() + length);
-            for (int j = 0; j < musElementList()[i]->markList().size(); j++) {
-                CAMark* m = musElementList()[i]->markList()[j];
-                if (!m->isCommon() || musElementList()[i]->musElementType() != CAMusElement::Note || static_cast<CANote*>(musElementList()[i])->isFirstInChord())
-                    m->setTimeStart(musElementList()[i]->timeStart());
-            }
-        }
+    _musElementIndex.shiftTimes(idx, length, signsToo);
+
+    if (_staff && _staff->recorder())
+        _staff->recorder()->timesUpdated(this, idx, length, signsToo);
+
     return true; // What to return ? Maybe if some music element times were actually set
 }
 
@@ -957,16 +1060,28 @@ bool CAVoice::updateTimes(int idx, int length, bool signsToo)
 	   to first note in the chord.
 	   The exception are non-common marks (eg. fingering), which are assigned to each note separately.
 
+	Only the elements starting at \a timeStart or later are checked.
+
 	Returns True, if fixes were made or False otherwise.
 */
-bool CAVoice::synchronizeMusElements()
+bool CAVoice::synchronizeMusElements(int timeStart)
 {
     bool fixesMade = false;
-    for (int i = 0; i < musElementList().size(); i++) {
+    for (int i = lowerBound_startTime(timeStart); i < musElementList().size(); i++) {
         if (musElementList()[i]->musElementType() == CAMusElement::Note && musElementList()[i]->markList().size() && static_cast<CANote*>(musElementList()[i])->isPartOfChord()) {
             QList<CAMark*> marks; // list of shared marks
             QList<CANote*> chord = static_cast<CANote*>(musElementList()[i])->getChord();
 
+            // the shared marks of the other notes are moved to the first note below
+            for (int j = 1; j < chord.size() && staff() && staff()->recorder(); j++) {
+                for (int k = 0; k < chord[j]->markList().size(); k++) {
+                    if (chord[j]->markList()[k]->isCommon()) {
+                        staff()->recorder()->linksChanging(chord.first());
+                        break;
+                    }
+                }
+            }
+
             // gather a list of marks and remove them from the chord
             for (int j = 0; j < chord.size(); j++) {
                 for (int k = 0; k < chord[j]->markList().size(); k++) {
@@ -1039,7 +1154,7 @@ CATempo* CAVoice::getTempo(int time)
     if (chord.isEmpty()) {
         curElt = musElementList().size() - 1;
     } else {
-        curElt = musElementList().indexOf(chord.last());
+        curElt = musElementIndex(chord.last());
     }
 
     CATempo* tempo = nullptr;
@@ -12,6 +12,7 @@
 
 #include "score/muselement.h"
 #include "score/note.h"
+#include "score/voiceindex.h" // music elements positions
 
 class CAKeySignature;
 class CATimeSignature;
@@ -22,6 +23,7 @@ class CATempo;
 
 class CAVoice {
     friend class CAStaff; // used for insertion of music elements and updateTimes() when inserting elements and synchronizing voices
+    friend class CAMusElementsDelta; // repeats the recorded insertions and removals on undo and redo
 
 public:
     CAVoice(const QString name, CAStaff* staff, CANote::CAStemDirection stemDirection = CANote::StemNeutral);
@@ -39,12 +41,14 @@ public:
     bool insert(CAMusElement* eltAfter, CAMusElement* elt, bool addToChord = false);
     bool remove(CAMusElement* elt, bool updateSignsTimes = true);
     CAPlayable* insertInTupletAndVoiceAt(CAPlayable* p, CAPlayable* n);
-    bool synchronizeMusElements();
+    bool synchronizeMusElements(int timeStart = 0);
 
     //////////////////////////////
     // Voice analysis and query //
     //////////////////////////////
     inline const QList<CAMusElement*>& musElementList() { return _musElementList; }
+    int musElementIndex(const CAMusElement* elt);
+    inline int pendingTimeShift(const CAMusElement* elt) const { return _musElementIndex.pendingTimeShift(elt); }
 
     QList<CAMusElement*> getSignList();
     QList<CANote*> getNoteList();
@@ -63,6 +67,7 @@ public:
     CAPlayable* previousPlayable(int timeStart);
 
     bool binarySearch_startTime(int time, int& position);
+    int lowerBound_startTime(int time);
 
     CAMusElement* getOneEltByType(CAMusElement::CAMusElementType type, int startTime);
     QList<CAMusElement*> getEltByType(CAMusElement::CAMusElementType type, int startTime);
@@ -121,8 +126,16 @@ private:
     bool insertMusElement(CAMusElement* before, CAMusElement* elt);
     bool updateTimes(int idx, int length, bool signsToo = false);
 
+    void insertMusElementAt(int idx, CAMusElement* elt);
+    void removeMusElementAt(int idx);
+    void setMusElementTimeStart(int idx, int time);
+    void swapMusElements(CAVoice* other);
+
     // list of all the music elements
     QList<CAMusElement*> _musElementList;
+
+    // positions of the music elements in _musElementList
+    CAVoiceIndex _musElementIndex;
     CAStaff* _staff; // parent staff
 
     CANote::CAStemDirection _stemDirection;
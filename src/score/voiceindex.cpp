@@ -0,0 +1,320 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include "score/voiceindex.h"
+#include "score/muselement.h"
+
+/*!
+	\class CAVoiceIndex
+	\brief Positions of the music elements in a voice
+
+	CAVoice keeps its music elements in a list. This class mirrors the order of the list in an
+	order-statistic tree (a treap keyed by position) and maps each element to its tree node. The
+	position of an element is the number of nodes left of it, which is summed up on the way from
+	its node to the root. Inserting, removing and looking up an element are all O(log n), so
+	editing the beginning of a long voice doesn't reindex the elements after it.
+
+	The index must be updated at the same positions as the list. Each element is expected to be
+	present in the voice only once.
+
+	The tree also shifts the times of the elements. shiftTimes() moves all the elements from a
+	position on, so inserting or removing a note doesn't touch the elements after it. The shift
+	is applied to the root of the moved subtree only and kept in the node as a pending shift of
+	its descendants. Pending shifts are pushed down to the children whenever split() or merge()
+	restructure a node, so each element keeps the sum of the pending shifts of its ancestors.
+	CAMusElement::timeStart() adds this sum (see pendingTimeShift()) to the stored time of the
+	element. Shared signs are indexed by every voice of the staff, so their pending shifts are
+	summed over all the voices.
+
+	\sa CAVoice::musElementIndex(), CAVoice::updateTimes()
+*/
+
+CAVoiceIndex::CAVoiceIndex()
+    : _root(nullptr)
+    , _seed(2463534242u)
+    , _shiftedNodes(0)
+{
+}
+
+CAVoiceIndex::~CAVoiceIndex()
+{
+    clear();
+}
+
+/*!
+	Inserts the music element \a elt at position \a idx.
+*/
+void CAVoiceIndex::insert(int idx, CAMusElement* elt)
+{
+    CANode* n = new CANode;
+    n->elt = elt;
+    n->left = n->right = n->parent = nullptr;
+    n->size = 1;
+    n->priority = nextPriority();
+    n->shift = n->playableShift = 0;
+
+    CANode *l, *r;
+    split(_root, idx, l, r);
+    _root = merge(merge(l, n), r);
+    _root->parent = nullptr;
+
+    _nodes.insert(elt, n);
+}
+
+/*!
+	Removes the music element at position \a idx.
+	The shifts of its time pending in this index are applied to the element first.
+*/
+void CAVoiceIndex::removeAt(int idx)
+{
+    CANode *l, *m, *r;
+    split(_root, idx, l, r);
+    split(r, 1, m, r);
+    _root = merge(l, r);
+    if (_root) {
+        _root->parent = nullptr;
+    }
+
+    if (m) {
+        QHash<const CAMusElement*, CANode*>::iterator it = _nodes.find(m->elt);
+        if (it != _nodes.end() && it.value() == m) {
+            _nodes.erase(it);
+        }
+        setShifts(m, 0, 0); // split() pushed the shifts of the ancestors to the element
+        delete m;
+    }
+}
+
+/*!
+	Returns the position of the music element \a elt or -1, if the element isn't indexed.
+*/
+int CAVoiceIndex::indexOf(const CAMusElement* elt) const
+{
+    const CANode* n = _nodes.value(elt, nullptr);
+    if (!n) {
+        return -1;
+    }
+
+    int idx = size(n->left);
+    for (; n->parent; n = n->parent) {
+        if (n == n->parent->right) {
+            idx += size(n->parent->left) + 1;
+        }
+    }
+
+    return idx;
+}
+
+/*!
+	Removes all the elements from the index.
+	Time shifts pending in the index are dropped, so only call it when the elements are deleted
+	or their times don't matter anymore.
+*/
+void CAVoiceIndex::clear()
+{
+    deleteTree(_root);
+    _root = nullptr;
+    _nodes.clear();
+    _shiftedNodes = 0;
+}
+
+/*!
+	Exchanges the indexed elements with the \a other index.
+*/
+void CAVoiceIndex::swap(CAVoiceIndex& other)
+{
+    qSwap(_root, other._root);
+    _nodes.swap(other._nodes);
+    qSwap(_shiftedNodes, other._shiftedNodes);
+}
+
+/*!
+	Shifts the times of the elements from position \a idx on by \a length. If \a signsToo is
+	False, only the playable elements are shifted. This is O(log n) regardless of the number of
+	the shifted elements.
+
+	\sa pendingTimeShift()
+*/
+void CAVoiceIndex::shiftTimes(int idx, int length, bool signsToo)
+{
+    if (!length) {
+        return;
+    }
+
+    CANode *l, *r;
+    split(_root, idx, l, r);
+    if (r) {
+        shift(r, length, signsToo);
+    }
+    _root = merge(l, r);
+    if (_root) {
+        _root->parent = nullptr;
+    }
+}
+
+/*!
+	Returns the shift of the time of the element \a elt which is pending in this index, or 0 if
+	the element isn't indexed.
+
+	\sa shiftTimes(), CAMusElement::timeStart()
+*/
+int CAVoiceIndex::pendingTimeShift(const CAMusElement* elt) const
+{
+    if (!_shiftedNodes) {
+        return 0;
+    }
+
+    const CANode* n = _nodes.value(elt, nullptr);
+    if (!n) {
+        return 0;
+    }
+
+    bool playable = n->elt->isPlayable();
+    int pending = 0;
+    for (n = n->parent; n; n = n->parent) {
+        pending += n->shift + (playable ? n->playableShift : 0);
+    }
+
+    return pending;
+}
+
+/*!
+	Shifts the element of node \a n by \a length and leaves the same shift pending for its
+	descendants. If \a signsToo is False, only the playable elements are shifted.
+*/
+void CAVoiceIndex::shift(CANode* n, int length, bool signsToo)
+{
+    if (!length) {
+        return;
+    }
+
+    if (signsToo || n->elt->isPlayable()) {
+        n->elt->_timeStart += length;
+    }
+
+    if (signsToo) {
+        setShifts(n, n->shift + length, n->playableShift);
+    } else {
+        setShifts(n, n->shift, n->playableShift + length);
+    }
+}
+
+/*!
+	Applies the time shifts pending in node \a n to its children.
+	Called before the children of the node are changed.
+*/
+void CAVoiceIndex::push(CANode* n)
+{
+    if (!n->shift && !n->playableShift) {
+        return;
+    }
+
+    CANode* children[] = { n->left, n->right };
+    for (CANode* c : children) {
+        if (c) {
+            shift(c, n->shift, true);
+            shift(c, n->playableShift, false);
+        }
+    }
+    setShifts(n, 0, 0);
+}
+
+/*!
+	Sets the pending time shifts of node \a n and counts the nodes with pending shifts.
+*/
+void CAVoiceIndex::setShifts(CANode* n, int shift, int playableShift)
+{
+    bool wasShifted = (n->shift || n->playableShift);
+    n->shift = shift;
+    n->playableShift = playableShift;
+    bool isShifted = (n->shift || n->playableShift);
+
+    if (wasShifted != isShifted) {
+        _shiftedNodes += (isShifted ? 1 : -1);
+    }
+}
+
+/*!
+	Recalculates the subtree size of the node \a n and links its children back to it.
+*/
+void CAVoiceIndex::update(CANode* n)
+{
+    n->size = 1 + size(n->left) + size(n->right);
+    if (n->left) {
+        n->left->parent = n;
+    }
+    if (n->right) {
+        n->right->parent = n;
+    }
+}
+
+/*!
+	Splits the tree \a t into the first \a k nodes \a l and the rest \a r.
+	Parents of the returned roots are not reset.
+*/
+void CAVoiceIndex::split(CANode* t, int k, CANode*& l, CANode*& r)
+{
+    if (!t) {
+        l = r = nullptr;
+        return;
+    }
+
+    push(t);
+    if (size(t->left) < k) {
+        split(t->right, k - size(t->left) - 1, t->right, r);
+        l = t;
+    } else {
+        split(t->left, k, l, t->left);
+        r = t;
+    }
+    update(t);
+}
+
+/*!
+	Concatenates the trees \a l and \a r and returns the new root.
+*/
+CAVoiceIndex::CANode* CAVoiceIndex::merge(CANode* l, CANode* r)
+{
+    if (!l) {
+        return r;
+    }
+    if (!r) {
+        return l;
+    }
+
+    if (l->priority > r->priority) {
+        push(l);
+        l->right = merge(l->right, r);
+        update(l);
+        return l;
+    } else {
+        push(r);
+        r->left = merge(l, r->left);
+        update(r);
+        return r;
+    }
+}
+
+void CAVoiceIndex::deleteTree(CANode* n)
+{
+    if (n) {
+        deleteTree(n->left);
+        deleteTree(n->right);
+        delete n;
+    }
+}
+
+/*!
+	Returns a pseudo-random priority of a new node (xorshift) which keeps the tree balanced.
+*/
+quint32 CAVoiceIndex::nextPriority()
+{
+    _seed ^= _seed << 13;
+    _seed ^= _seed >> 17;
+    _seed ^= _seed << 5;
+    return _seed;
+}
@@ -0,0 +1,61 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#ifndef VOICEINDEX_H_
+#define VOICEINDEX_H_
+
+#include <QHash>
+
+class CAMusElement;
+
+class CAVoiceIndex {
+public:
+    CAVoiceIndex();
+    ~CAVoiceIndex();
+
+    void insert(int idx, CAMusElement* elt);
+    void removeAt(int idx);
+    int indexOf(const CAMusElement* elt) const;
+    inline int size() const { return size(_root); }
+    void clear();
+    void swap(CAVoiceIndex& other);
+
+    void shiftTimes(int idx, int length, bool signsToo);
+    int pendingTimeShift(const CAMusElement* elt) const;
+
+private:
+    CAVoiceIndex(const CAVoiceIndex&);
+    CAVoiceIndex& operator=(const CAVoiceIndex&);
+
+    struct CANode {
+        CAMusElement* elt;
+        CANode* left;
+        CANode* right;
+        CANode* parent;
+        int size; // number of nodes in the subtree
+        quint32 priority;
+        int shift; // time shift of all the elements below the node, not applied yet
+        int playableShift; // time shift of the playable elements below the node, not applied yet
+    };
+
+    static inline int size(const CANode* n) { return n ? n->size : 0; }
+    static void update(CANode* n);
+    void split(CANode* t, int k, CANode*& l, CANode*& r);
+    CANode* merge(CANode* l, CANode* r);
+    void shift(CANode* n, int length, bool signsToo);
+    void push(CANode* n);
+    void setShifts(CANode* n, int shift, int playableShift);
+    static void deleteTree(CANode* n);
+    quint32 nextPriority();
+
+    CANode* _root;
+    QHash<const CAMusElement*, CANode*> _nodes;
+    quint32 _seed;
+    int _shiftedNodes; // number of nodes with time shifts not applied yet
+};
+
+#endif /* VOICEINDEX_H_ */
@@ -0,0 +1,177 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include "score/voicerecorder.h"
+#include "score/mark.h"
+#include "score/note.h"
+#include "score/playable.h"
+#include "score/staff.h"
+#include "score/voice.h"
+
+/*!
+	\class CAVoiceRecorder
+	\brief Observer of the changes of the music elements in the voices of a staff
+
+	A recorder is set to the staff by CAStaff::setRecorder(). The voices of the staff then report
+	each music element inserted to or removed from their lists, each shift of the times and
+	each time start changed by CAStaff::synchronizeVoices(). The indices passed are the positions
+	in CAVoice::musElementList(), so the changes can be repeated on a clone of the staff.
+
+	Music elements report their destruction by musElementDeleting() while they are still intact
+	(see notifyDeleting()). Changes of ties, slurs, tuplets and marks of the elements in the
+	staff are not described element by element, the recorder gets linksChanging() before they
+	are made.
+
+	\sa CAMusElementsDelta
+*/
+
+CAVoiceRecorder::~CAVoiceRecorder()
+{
+}
+
+/*!
+	\fn CAVoiceRecorder::musElementInserted(CAVoice* voice, int idx)
+	Called after the music element was inserted to the \a voice at position \a idx.
+*/
+
+/*!
+	\fn CAVoiceRecorder::musElementRemoving(CAVoice* voice, int idx)
+	Called before the music element at position \a idx is removed from the \a voice.
+*/
+
+/*!
+	\fn CAVoiceRecorder::timesUpdated(CAVoice* voice, int idx, int length, bool signsToo)
+	Called after the times of the elements from position \a idx on were shifted by \a length.
+
+	\sa CAVoice::updateTimes()
+*/
+
+/*!
+	\fn CAVoiceRecorder::timeStartChanged(CAVoice* voice, int idx, int oldTimeStart)
+	Called after the time start of the element at position \a idx was changed from \a oldTimeStart.
+*/
+
+/*!
+	\fn CAVoiceRecorder::musElementDeleting(CAMusElement* elt)
+	Called by the destructor of the note, rest or sign \a elt before any of its parts is destroyed.
+	The element may still be part of the voices.
+*/
+
+/*!
+	\fn CAVoiceRecorder::linksChanging(CAMusElement* elt)
+	Called before the ties, slurs, tuplet or marks of the music element \a elt part of the staff
+	are changed.
+*/
+
+/*!
+	\fn CAVoiceRecorder::staffDeleting()
+	Called when the observed staff is destroyed. The recorder shouldn't touch the staff anymore.
+*/
+
+/*!
+	Returns the recorder of the staff the music element \a elt belongs to or nullptr, if the
+	staff isn't observed.
+*/
+CAVoiceRecorder* CAVoiceRecorder::recorder(CAMusElement* elt)
+{
+    if (!elt || !elt->context() || elt->context()->contextType() != CAContext::Staff) {
+        return nullptr;
+    }
+
+    return static_cast<CAStaff*>(elt->context())->recorder();
+}
+
+/*!
+	Returns True, if removing the music element \a elt from its voice changes the elements linked
+	to it. These are the notes tied or slurred to it, its tuplet and the shared marks and slurs of
+	a chord moved to the next note, when the first note of the chord is removed.
+
+	\sa CAVoice::remove()
+*/
+bool CAVoiceRecorder::hasLinks(CAMusElement* elt)
+{
+    if (!elt->isPlayable()) {
+        return false;
+    }
+
+    if (static_cast<CAPlayable*>(elt)->tuplet()) {
+        return true;
+    }
+
+    if (elt->musElementType() != CAMusElement::Note) {
+        return false;
+    }
+
+    CANote* note = static_cast<CANote*>(elt);
+    if (note->tieStart() || note->tieEnd() || note->slurStart() || note->slurEnd() || note->phrasingSlurStart() || note->phrasingSlurEnd()) {
+        return true;
+    }
+
+    if (note->isPartOfChord() && note->isFirstInChord()) {
+        for (int i = 0; i < note->markList().size(); i++) {
+            if (note->markList()[i]->isCommon()) {
+                return true;
+            }
+        }
+
+        CANote* second = note->getChord().at(1);
+        if (second->slurStart() || second->slurEnd() || second->phrasingSlurStart() || second->phrasingSlurEnd()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*!
+	Reports the destruction of the note, rest or sign \a elt to the recorder of its staff.
+	Call it first in the destructor of the element.
+*/
+void CAVoiceRecorder::notifyDeleting(CAMusElement* elt)
+{
+    CAVoiceRecorder* r = recorder(elt);
+    if (r) {
+        r->musElementDeleting(elt);
+    }
+}
+
+/*!
+	Reports the change of the links of the music element \a elt to the recorder of its staff, if
+	the element is part of a voice.
+*/
+void CAVoiceRecorder::notifyLinksChanging(CAMusElement* elt)
+{
+    CAVoiceRecorder* r = recorder(elt);
+    if (!r) {
+        return;
+    }
+
+    if (elt->isPlayable()) {
+        CAVoice* voice = static_cast<CAPlayable*>(elt)->voice();
+        if (voice && voice->musElementIndex(elt) != -1) {
+            r->linksChanging(elt);
+        }
+    } else {
+        const QList<CAVoice*>& voices = static_cast<CAStaff*>(elt->context())->voiceList();
+        for (int i = 0; i < voices.size(); i++) {
+            if (voices[i]->musElementIndex(elt) != -1) {
+                r->linksChanging(elt);
+                return;
+            }
+        }
+    }
+}
+
+/*!
+	Reports the change of the tuplet of the \a playables.
+*/
+void CAVoiceRecorder::notifyLinksChanging(const QList<CAPlayable*>& playables)
+{
+    for (int i = 0; i < playables.size(); i++) {
+        notifyLinksChanging(playables[i]);
+    }
+}
@@ -0,0 +1,37 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#ifndef VOICERECORDER_H_
+#define VOICERECORDER_H_
+
+#include <QList>
+
+class CAMusElement;
+class CAPlayable;
+class CAVoice;
+
+class CAVoiceRecorder {
+public:
+    virtual ~CAVoiceRecorder();
+
+    virtual void musElementInserted(CAVoice* voice, int idx) = 0;
+    virtual void musElementRemoving(CAVoice* voice, int idx) = 0;
+    virtual void timesUpdated(CAVoice* voice, int idx, int length, bool signsToo) = 0;
+    virtual void timeStartChanged(CAVoice* voice, int idx, int oldTimeStart) = 0;
+    virtual void musElementDeleting(CAMusElement* elt) = 0;
+    virtual void linksChanging(CAMusElement* elt) = 0;
+    virtual void staffDeleting() = 0;
+
+    static CAVoiceRecorder* recorder(CAMusElement* elt);
+    static bool hasLinks(CAMusElement* elt);
+
+    static void notifyDeleting(CAMusElement* elt);
+    static void notifyLinksChanging(CAMusElement* elt);
+    static void notifyLinksChanging(const QList<CAPlayable*>& playables);
+};
+
+#endif /* VOICERECORDER_H_ */
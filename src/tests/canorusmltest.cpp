@@ -0,0 +1,355 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QDir>
+#include <QDomDocument>
+#include <QFile>
+#include <QSaveFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QtTest>
+
+#include "export/canorusmlexport.h"
+#include "import/canorusmlimport.h"
+#include "score/barline.h"
+#include "score/document.h"
+#include "score/note.h"
+#include "score/resource.h"
+#include "score/sheet.h"
+#include "score/staff.h"
+#include "score/voice.h"
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/*!
+	\class CACanorusMLTest
+	\brief Regression tests and benchmark of CACanorusMLImport and CACanorusMLExport
+
+	The test scores in this directory are imported, exported and imported again. The output must
+	be stable, so exporting the reimported document gives the same bytes. exportLargeDocument()
+	measures the export of a long staff and compares it with writing the same score through a DOM
+	tree, the way CACanorusMLExport did before (see exportDocumentDom()).
+*/
+class CACanorusMLTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void roundTrip_data();
+    void roundTrip();
+    void escapeAttributes();
+    void attachedResource();
+    void exportLargeDocument_data();
+    void exportLargeDocument();
+    void exportLargeDocumentMemory();
+
+private:
+    static CADocument* importDocument(const QString& xml);
+    static QString exportDocument(CADocument* doc);
+    static QString exportDocumentDom(CADocument* doc);
+    static QList<int> elementCounts(CADocument* doc);
+    static CADocument* largeDocument();
+    static qint64 exportMemory(CADocument* doc, bool dom);
+};
+
+CADocument* CACanorusMLTest::importDocument(const QString& xml)
+{
+    CACanorusMLImport import(xml);
+    import.importDocument();
+    import.wait();
+    return import.importedDocument();
+}
+
+QString CACanorusMLTest::exportDocument(CADocument* doc)
+{
+    QString xml;
+    QTextStream stream(&xml);
+    CACanorusMLExport exp(&stream);
+    exp.exportDocument(doc, false);
+    return xml;
+}
+
+/*!
+	Writes the staves, voices, notes and barlines of \a doc by building a QDomDocument tree
+	first and converting it to a string, as CACanorusMLExport did before it wrote to the stream
+	directly. Used as the baseline of exportLargeDocument(), other elements are skipped.
+*/
+QString CACanorusMLTest::exportDocumentDom(CADocument* doc)
+{
+    QDomDocument dDoc("canorusml");
+    dDoc.appendChild(dDoc.createProcessingInstruction("xml", "version=\"1.0\" encoding=\"UTF-8\" "));
+    QDomElement dCanorusDocument = dDoc.createElement("canorus-document");
+    dDoc.appendChild(dCanorusDocument);
+    QDomElement dDocument = dDoc.createElement("document");
+    dCanorusDocument.appendChild(dDocument);
+    dDocument.setAttribute("title", doc->title());
+
+    for (int i = 0; i < doc->sheetList().size(); i++) {
+        QDomElement dSheet = dDoc.createElement("sheet");
+        dDocument.appendChild(dSheet);
+        dSheet.setAttribute("name", doc->sheetList()[i]->name());
+
+        QList<CAStaff*> staves = doc->sheetList()[i]->staffList();
+        for (int j = 0; j < staves.size(); j++) {
+            QDomElement dStaff = dDoc.createElement("staff");
+            dSheet.appendChild(dStaff);
+            dStaff.setAttribute("name", staves[j]->name());
+            dStaff.setAttribute("number-of-lines", staves[j]->numberOfLines());
+
+            for (int k = 0; k < staves[j]->voiceList().size(); k++) {
+                CAVoice* voice = staves[j]->voiceList()[k];
+                QDomElement dVoice = dDoc.createElement("voice");
+                dStaff.appendChild(dVoice);
+                dVoice.setAttribute("name", voice->name());
+
+                for (int l = 0; l < voice->musElementList().size(); l++) {
+                    CAMusElement* elt = voice->musElementList()[l];
+                    QDomElement dElt;
+                    if (elt->musElementType() == CAMusElement::Note) {
+                        CANote* note = static_cast<CANote*>(elt);
+                        dElt = dDoc.createElement("note");
+                        QDomElement dLength = dDoc.createElement("playable-length");
+                        dLength.setAttribute("music-length", CAPlayableLength::musicLengthToString(note->playableLength().musicLength()));
+                        dLength.setAttribute("dotted", note->playableLength().dotted());
+                        dElt.appendChild(dLength);
+                        QDomElement dPitch = dDoc.createElement("diatonic-pitch");
+                        dPitch.setAttribute("note-name", note->diatonicPitch().noteName());
+                        dPitch.setAttribute("accs", note->diatonicPitch().accs());
+                        dElt.appendChild(dPitch);
+                        dElt.setAttribute("time-length", elt->timeLength());
+                    } else if (elt->musElementType() == CAMusElement::Barline) {
+                        dElt = dDoc.createElement("barline");
+                        dElt.setAttribute("barline-type", CABarline::barlineTypeToString(static_cast<CABarline*>(elt)->barlineType()));
+                    } else {
+                        continue;
+                    }
+                    dElt.setAttribute("time-start", elt->timeStart());
+                    dVoice.appendChild(dElt);
+                }
+            }
+        }
+    }
+
+    return dDoc.toString();
+}
+
+/*!
+	Returns the number of music elements in each voice of the document \a doc.
+*/
+QList<int> CACanorusMLTest::elementCounts(CADocument* doc)
+{
+    QList<int> counts;
+    for (int i = 0; i < doc->sheetList().size(); i++) {
+        QList<CAVoice*> voices = doc->sheetList()[i]->voiceList();
+        for (int j = 0; j < voices.size(); j++) {
+            counts << voices[j]->musElementList().size();
+        }
+    }
+    return counts;
+}
+
+void CACanorusMLTest::roundTrip_data()
+{
+    QTest::addColumn<QString>("fileName");
+
+    QDir dir(CANORUS_TESTS_DIR);
+    QStringList files = dir.entryList(QStringList() << "*.xml", QDir::Files, QDir::Name);
+    for (int i = 0; i < files.size(); i++) {
+        QTest::newRow(files[i].toUtf8().constData()) << dir.filePath(files[i]);
+    }
+}
+
+void CACanorusMLTest::roundTrip()
+{
+    QFETCH(QString, fileName);
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    CADocument* original = importDocument(QString::fromUtf8(file.readAll()));
+    QVERIFY(original);
+
+    QString xml = exportDocument(original);
+    CADocument* reimported = importDocument(xml);
+    QVERIFY(reimported);
+    QCOMPARE(elementCounts(reimported), elementCounts(original));
+    QCOMPARE(exportDocument(reimported), xml);
+
+    delete reimported;
+    delete original;
+}
+
+/*!
+	Special characters in attribute values are escaped and read back unchanged.
+*/
+void CACanorusMLTest::escapeAttributes()
+{
+    CADocument doc;
+    doc.setTitle("<Title> & \"subtitle\"\n\tsecond line");
+    doc.addSheet();
+
+    QString xml = exportDocument(&doc);
+    CADocument* reimported = importDocument(xml);
+    QVERIFY(reimported);
+    QCOMPARE(reimported->title(), doc.title());
+    QCOMPARE(exportDocument(reimported), xml);
+
+    delete reimported;
+}
+
+/*!
+	Attached resources are copied next to the file name set by setFileName(), when the document is
+	written to a QSaveFile like the recovery files.
+*/
+void CACanorusMLTest::attachedResource()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QFile source(dir.filePath("image.png"));
+    QVERIFY(source.open(QIODevice::WriteOnly));
+    source.write("png");
+    source.close();
+
+    CADocument doc;
+    doc.addSheet();
+    CAResource* resource = new CAResource(QUrl::fromLocalFile(source.fileName()), "image", false, CAResource::Image);
+    doc.addResource(resource);
+
+    QSaveFile file(dir.filePath("recovery0"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    {
+        CACanorusMLExport exp;
+        exp.setStreamToDevice(&file);
+        exp.setFileName(file.fileName());
+        exp.exportDocument(&doc, false);
+    }
+    QVERIFY(file.commit());
+
+    doc.removeResource(resource);
+    delete resource;
+
+    QFile resourceCopy(dir.filePath("recovery0 files/image.png"));
+    QVERIFY(resourceCopy.open(QIODevice::ReadOnly));
+    QCOMPARE(resourceCopy.readAll(), QByteArray("png"));
+
+    QFile xml(file.fileName());
+    QVERIFY(xml.open(QIODevice::ReadOnly));
+    QVERIFY(xml.readAll().contains("recovery0 files/image.png\""));
+}
+
+/*!
+	Returns a new document with a staff of 32000 notes and 8000 barlines.
+*/
+CADocument* CACanorusMLTest::largeDocument()
+{
+    CADocument* doc = new CADocument();
+    CAVoice* voice = doc->addSheet()->addStaff()->voiceList()[0];
+    for (int i = 0; i < 8000; i++) {
+        for (int j = 0; j < 4; j++) {
+            voice->append(new CANote(CADiatonicPitch(28 + (i + j) % 7), CAPlayableLength(CAPlayableLength::Quarter), voice, voice->lastTimeEnd()));
+        }
+        voice->append(new CABarline(CABarline::Single, voice->staff(), voice->lastTimeEnd()));
+    }
+
+    return doc;
+}
+
+/*!
+	Returns the growth of the peak resident memory in kB while exporting the \a doc by
+	CACanorusMLExport or by exportDocumentDom(), if \a dom is True, or -1 if unknown.
+	Each export runs in a forked child process, as the peak of the process can't be reset.
+*/
+qint64 CACanorusMLTest::exportMemory(CADocument* doc, bool dom)
+{
+#ifdef Q_OS_UNIX
+    int fds[2];
+    if (pipe(fds)) {
+        return -1;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        struct rusage before, after;
+        getrusage(RUSAGE_SELF, &before);
+        QString xml = dom ? exportDocumentDom(doc) : exportDocument(doc);
+        getrusage(RUSAGE_SELF, &after);
+
+        qint64 growth = after.ru_maxrss - before.ru_maxrss;
+#ifdef Q_OS_MACOS
+        growth /= 1024; // in bytes
+#endif
+        ssize_t written = write(fds[1], &growth, sizeof(growth));
+        _exit((xml.isEmpty() || written != sizeof(growth)) ? 1 : 0);
+    }
+
+    close(fds[1]);
+    qint64 growth = -1;
+    if (pid > 0) {
+        if (read(fds[0], &growth, sizeof(growth)) != sizeof(growth)) {
+            growth = -1;
+        }
+        waitpid(pid, nullptr, 0);
+    }
+    close(fds[0]);
+
+    return growth;
+#else
+    Q_UNUSED(doc);
+    Q_UNUSED(dom);
+    return -1;
+#endif
+}
+
+void CACanorusMLTest::exportLargeDocument_data()
+{
+    QTest::addColumn<bool>("dom");
+    QTest::newRow("QXmlStreamWriter") << false;
+    QTest::newRow("QDomDocument") << true;
+}
+
+/*!
+	Measures the export of a staff of 32000 notes and 8000 barlines by CACanorusMLExport, which
+	writes directly to the stream, and by the DOM tree baseline. The growth of the peak resident
+	memory is printed as well.
+*/
+void CACanorusMLTest::exportLargeDocument()
+{
+    QFETCH(bool, dom);
+    CADocument* doc = largeDocument();
+
+    QString xml;
+    QBENCHMARK {
+        xml = dom ? exportDocumentDom(doc) : exportDocument(doc);
+    }
+    QCOMPARE(xml.count("</note>"), 32000);
+
+    qInfo("peak RSS growth: %lld kB", exportMemory(doc, dom));
+    delete doc;
+}
+
+/*!
+	Writing directly to the stream must take less memory than building the DOM tree first.
+*/
+void CACanorusMLTest::exportLargeDocumentMemory()
+{
+    CADocument* doc = largeDocument();
+    qint64 stream = exportMemory(doc, false);
+    qint64 dom = exportMemory(doc, true);
+    delete doc;
+
+    if (stream < 0 || dom < 0) {
+        QSKIP("peak resident memory is not available");
+    }
+    qInfo("peak RSS growth: %lld kB QXmlStreamWriter, %lld kB QDomDocument", stream, dom);
+    QVERIFY(stream < dom);
+}
+
+QTEST_GUILESS_MAIN(CACanorusMLTest)
+#include "canorusmltest.moc"
@@ -0,0 +1,130 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QThread>
+#include <QtTest>
+
+#include "layout/drawable.h"
+#include "layout/drawablearena.h"
+
+/*!
+	\class CADrawableArenaTest
+	\brief Regression tests and benchmark of CADrawableArena
+
+	allocate() compares creating and deleting the drawable elements of a layout on the heap
+	and in an arena, run the executable with -iterations N for stable numbers.
+*/
+class CADrawableArenaTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void reuseAfterReset();
+    void currentPerThread();
+    void allocate_data();
+    void allocate();
+
+private:
+    class CATestDrawable : public CADrawable {
+    public:
+        CATestDrawable()
+            : CADrawable(0, 0)
+        {
+        }
+        void draw(QPainter*, const CADrawSettings) {}
+        CADrawable* clone() { return new CATestDrawable(); }
+
+        double _data[8]; // about the size of a drawable note
+    };
+
+    class CAArenaThread : public QThread {
+    public:
+        CAArenaThread()
+            : _arena(nullptr)
+        {
+        }
+        void run() { _arena = CADrawableArena::current(); }
+        CADrawableArena* _arena;
+    };
+};
+
+/*!
+	The memory of the deleted elements is counted as released and reused after reset().
+*/
+void CADrawableArenaTest::reuseAfterReset()
+{
+    CADrawableArena arena;
+    QList<CADrawable*> drawables;
+    {
+        CADrawableArena::CAScope scope(&arena);
+        for (int i = 0; i < 1000; i++) {
+            drawables << new CATestDrawable();
+        }
+    }
+    CADrawable* first = drawables[0];
+    QVERIFY(arena.usedBytes() >= 1000 * sizeof(CATestDrawable));
+
+    qDeleteAll(drawables);
+    QCOMPARE(arena.releasedBytes(), arena.usedBytes());
+    arena.reset();
+    QCOMPARE(arena.usedBytes(), std::size_t(0));
+
+    CADrawableArena::CAScope scope(&arena);
+    CADrawable* d = new CATestDrawable();
+    QCOMPARE(d, first);
+    delete d;
+}
+
+/*!
+	The scope of the arena only applies to the thread which created it.
+*/
+void CADrawableArenaTest::currentPerThread()
+{
+    CADrawableArena arena;
+    CADrawableArena::CAScope scope(&arena);
+    QCOMPARE(CADrawableArena::current(), &arena);
+
+    CAArenaThread thread;
+    thread.start();
+    thread.wait();
+    QVERIFY(!thread._arena);
+}
+
+void CADrawableArenaTest::allocate_data()
+{
+    QTest::addColumn<bool>("useArena");
+
+    QTest::newRow("heap") << false;
+    QTest::newRow("arena") << true;
+}
+
+/*!
+	Creates and deletes 100000 drawable elements like a full layout of a large score does.
+*/
+void CADrawableArenaTest::allocate()
+{
+    QFETCH(bool, useArena);
+
+    const int count = 100000;
+    CADrawableArena arena;
+    QVector<CADrawable*> drawables(count);
+
+    QBENCHMARK {
+        {
+            CADrawableArena::CAScope scope(useArena ? &arena : nullptr);
+            for (int i = 0; i < count; i++) {
+                drawables[i] = new CATestDrawable();
+            }
+        }
+        for (int i = 0; i < count; i++) {
+            delete drawables[i];
+        }
+        arena.reset();
+    }
+}
+
+QTEST_GUILESS_MAIN(CADrawableArenaTest)
+#include "drawablearenatest.moc"
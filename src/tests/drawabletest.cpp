@@ -0,0 +1,144 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QDir>
+#include <QImage>
+#include <QPainter>
+#include <QtTest>
+
+#include "canorus.h"
+#include "core/settings.h"
+#include "layout/drawablenote.h"
+#include "layout/drawablerest.h"
+#include "layout/drawablestaff.h"
+#include "score/document.h"
+#include "score/note.h"
+#include "score/rest.h"
+#include "score/sheet.h"
+#include "score/staff.h"
+#include "score/voice.h"
+
+/*!
+	\class CADrawableTest
+	\brief Regression tests and benchmark of the levels of detail of the drawable elements
+
+	paintZoomedOut() paints a long staff zoomed out to fit a window with each level of detail,
+	run the executable with -iterations N for stable numbers.
+*/
+class CADrawableTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void cleanup();
+
+    void detailLevels();
+    void paintZoomedOut_data();
+    void paintZoomedOut();
+
+private:
+    CADocument* _document;
+    CADrawableStaff* _drawableStaff;
+    QList<CADrawable*> _drawables;
+};
+
+/*!
+	Creates the drawable elements of a staff of 4000 notes and rests with ledger lines.
+*/
+void CADrawableTest::initTestCase()
+{
+    QDir::addSearchPath("fonts", QString(CANORUS_TESTS_DIR) + "/../fonts");
+    CACanorus::initFonts();
+
+    _document = new CADocument();
+    CAStaff* staff = _document->addSheet()->addStaff();
+    CAVoice* voice = staff->voiceList()[0];
+    _drawableStaff = new CADrawableStaff(staff, 0, 50);
+
+    for (int i = 0; i < 4000; i++) {
+        double x = 40 + i * 20;
+        if (i % 4 == 3) {
+            CARest* rest = new CARest(CARest::Normal, CAPlayableLength(CAPlayableLength::Quarter), voice, voice->lastTimeEnd());
+            voice->append(rest);
+            _drawables << new CADrawableRest(rest, _drawableStaff, x, 50);
+        } else {
+            CANote* note = new CANote(CADiatonicPitch(20 + i % 21), CAPlayableLength(CAPlayableLength::Eighth), voice, voice->lastTimeEnd());
+            voice->append(note);
+            _drawables << new CADrawableNote(note, _drawableStaff, x, 50 + (34 - note->notePosition()) * 2.25);
+        }
+    }
+}
+
+void CADrawableTest::cleanupTestCase()
+{
+    qDeleteAll(_drawables);
+    delete _drawableStaff;
+    delete _document;
+}
+
+void CADrawableTest::cleanup()
+{
+    CADrawable::setDetailZoomLevels(CASettings::DEFAULT_REDUCED_DETAIL_ZOOM, CASettings::DEFAULT_OUTLINE_DETAIL_ZOOM);
+}
+
+/*!
+	The default thresholds are taken from the settings and the outline is never drawn above the
+	reduced detail zoom level.
+*/
+void CADrawableTest::detailLevels()
+{
+    QCOMPARE(CADrawable::reducedDetailZoom(), CASettings::DEFAULT_REDUCED_DETAIL_ZOOM);
+    QCOMPARE(CADrawable::outlineDetailZoom(), CASettings::DEFAULT_OUTLINE_DETAIL_ZOOM);
+    QVERIFY(CASettings::DEFAULT_OUTLINE_DETAIL_ZOOM < CASettings::DEFAULT_REDUCED_DETAIL_ZOOM);
+
+    QCOMPARE(CADrawable::detailLevel(1.0), CADrawable::FullDetail);
+    QCOMPARE(CADrawable::detailLevel((CASettings::DEFAULT_REDUCED_DETAIL_ZOOM + CASettings::DEFAULT_OUTLINE_DETAIL_ZOOM) / 2), CADrawable::ReducedDetail);
+    QCOMPARE(CADrawable::detailLevel(CASettings::DEFAULT_OUTLINE_DETAIL_ZOOM / 2), CADrawable::OutlineDetail);
+
+    CADrawable::setDetailZoomLevels(0.2, 0.3);
+    QCOMPARE(CADrawable::outlineDetailZoom(), 0.2);
+    QCOMPARE(CADrawable::detailLevel(0.25), CADrawable::FullDetail);
+}
+
+void CADrawableTest::paintZoomedOut_data()
+{
+    QTest::addColumn<double>("reducedDetailZoom");
+    QTest::addColumn<double>("outlineDetailZoom");
+
+    QTest::newRow("full detail") << 0.0 << 0.0;
+    QTest::newRow("reduced detail") << 1.0 << 0.0;
+    QTest::newRow("outline") << 1.0 << 1.0;
+}
+
+/*!
+	Paints the whole staff at zoom level 0.2 as when zoomed to fit the window.
+*/
+void CADrawableTest::paintZoomedOut()
+{
+    QFETCH(double, reducedDetailZoom);
+    QFETCH(double, outlineDetailZoom);
+    CADrawable::setDetailZoomLevels(reducedDetailZoom, outlineDetailZoom);
+
+    const double zoom = 0.2;
+    QImage image(qCeil((40 + _drawables.size() * 20) * zoom), qCeil(200 * zoom), QImage::Format_ARGB32_Premultiplied);
+
+    QBENCHMARK {
+        image.fill(Qt::white);
+        QPainter p(&image);
+        CADrawSettings s = { zoom, 0, qRound(_drawableStaff->yPos() * zoom), image.width(), image.height(), Qt::black, 0, 0 };
+        _drawableStaff->draw(&p, s);
+        for (int i = 0; i < _drawables.size(); i++) {
+            s.x = qRound(_drawables[i]->xPos() * zoom);
+            s.y = qRound(_drawables[i]->yPos() * zoom);
+            _drawables[i]->draw(&p, s);
+        }
+    }
+}
+
+QTEST_MAIN(CADrawableTest)
+#include "drawabletest.moc"
@@ -0,0 +1,141 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QDir>
+#include <QFont>
+#include <QImage>
+#include <QPainter>
+#include <QtTest>
+
+#include "canorus.h"
+#include "layout/glyphcache.h"
+
+/*!
+	\class CAGlyphCacheTest
+	\brief Regression tests and benchmark of CAGlyphCache
+
+	drawGlyphs() compares drawing the glyphs of a score with QPainter::drawText() and with the
+	glyph cache, run the executable with -iterations N for stable numbers.
+*/
+class CAGlyphCacheTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+
+    void cachedOnce();
+    void notCachedWhenScaled();
+    void drawGlyphs_data();
+    void drawGlyphs();
+
+private:
+    static const QStringList GLYPHS;
+};
+
+/*!
+	Glyphs drawn by the benchmark, roughly in the proportion they appear in a score.
+*/
+const QStringList CAGlyphCacheTest::GLYPHS = QStringList()
+    << "noteheads.s2" << "noteheads.s2" << "noteheads.s2" << "noteheads.s2" << "noteheads.s1"
+    << "flags.u3" << "rests.2" << "rests.3" << "accidentals.sharp" << "accidentals.flat" << "clefs.G";
+
+void CAGlyphCacheTest::initTestCase()
+{
+    QDir::addSearchPath("fonts", QString(CANORUS_TESTS_DIR) + "/../fonts");
+    CACanorus::initFonts();
+}
+
+void CAGlyphCacheTest::init()
+{
+    CAGlyphCache::clear();
+}
+
+/*!
+	A glyph is rasterized once per pixel size and color and blitted afterwards.
+*/
+void CAGlyphCacheTest::cachedOnce()
+{
+    QImage image(200, 200, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    QPainter p(&image);
+
+    for (int i = 0; i < 10; i++) {
+        CAGlyphCache::drawGlyph(&p, 10 + i * 15, 100, "noteheads.s2", 16, Qt::black);
+    }
+    QCOMPARE(CAGlyphCache::count(), 1);
+    QVERIFY(CAGlyphCache::cost() > 0);
+
+    CAGlyphCache::drawGlyph(&p, 10, 150, "noteheads.s2", 16, Qt::red);
+    CAGlyphCache::drawGlyph(&p, 10, 150, "noteheads.s2", 8, Qt::black);
+    QCOMPARE(CAGlyphCache::count(), 3);
+    p.end();
+
+    QVERIFY(image.pixel(15, 100) != QColor(Qt::white).rgb()); // the notehead was blitted
+}
+
+/*!
+	Painters with a scaling transformation get the vector glyph instead of a scaled bitmap.
+*/
+void CAGlyphCacheTest::notCachedWhenScaled()
+{
+    QImage image(200, 200, QImage::Format_ARGB32_Premultiplied);
+    QPainter p(&image);
+    p.scale(2, 2);
+
+    CAGlyphCache::drawGlyph(&p, 10, 50, "clefs.G", 16, Qt::black);
+    QCOMPARE(CAGlyphCache::count(), 0);
+}
+
+void CAGlyphCacheTest::drawGlyphs_data()
+{
+    QTest::addColumn<bool>("useCache");
+    QTest::addColumn<int>("pixelSize");
+
+    QTest::newRow("drawText, zoom 1") << false << 16;
+    QTest::newRow("glyph cache, zoom 1") << true << 16;
+    QTest::newRow("drawText, zoom 0.5") << false << 8;
+    QTest::newRow("glyph cache, zoom 0.5") << true << 8;
+}
+
+/*!
+	Draws 5000 glyphs onto a 1280x800 image like a repaint of a dense score does.
+*/
+void CAGlyphCacheTest::drawGlyphs()
+{
+    QFETCH(bool, useCache);
+    QFETCH(int, pixelSize);
+
+    const int count = 5000;
+    QImage image(1280, 800, QImage::Format_ARGB32_Premultiplied);
+    QVector<QChar> glyphs(count);
+    for (int i = 0; i < count; i++) {
+        glyphs[i] = QChar(CACanorus::fetaCodepoint(GLYPHS[i % GLYPHS.size()]));
+    }
+
+    QFont font("Emmentaler");
+    font.setPixelSize(pixelSize);
+
+    QBENCHMARK {
+        image.fill(Qt::white);
+        QPainter p(&image);
+        p.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing);
+        p.setFont(font);
+        p.setPen(Qt::black);
+        for (int i = 0; i < count; i++) {
+            int x = 10 + (i * 13) % 1260, y = 20 + (i / 97) * 15 % 780;
+            if (useCache) {
+                CAGlyphCache::drawGlyph(&p, x, y, glyphs[i], pixelSize, Qt::black);
+            } else {
+                p.drawText(x, y, QString(glyphs[i]));
+            }
+        }
+    }
+}
+
+QTEST_MAIN(CAGlyphCacheTest)
+#include "glyphcachetest.moc"
@@ -0,0 +1,208 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "core/journal.h"
+#include "core/undodelta.h"
+#include "score/document.h"
+#include "score/note.h"
+#include "score/sheet.h"
+#include "score/staff.h"
+#include "score/voice.h"
+
+/*!
+	\class CAJournalTest
+	\brief Regression tests of CAJournal
+
+	The changes are journaled on one document and replayed on its clone, which stands for the
+	document imported from the recovery file. lostAfterBarrier() shows that the changes after
+	a barrier are not recovered when Canorus crashes before the next recovery file is written.
+*/
+class CAJournalTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void replayRecords();
+    void insertedNoteRecovered();
+    void lostAfterBarrier();
+    void skipSnapshotRecords();
+    void incompleteRecord();
+
+private:
+    void rename(CAJournal& journal, const QString& name);
+    void insertNote(CAJournal& journal);
+
+    QTemporaryDir _dir;
+    QString _fileName;
+    CADocument* _document;
+    CADocument* _recovery;
+};
+
+void CAJournalTest::init()
+{
+    QVERIFY(_dir.isValid());
+    _fileName = _dir.filePath("recovery0.journal");
+
+    _document = new CADocument();
+    CASheet* sheet = _document->addSheet();
+    sheet->setName("A");
+    sheet->addStaff();
+    _recovery = _document->clone();
+}
+
+void CAJournalTest::cleanup()
+{
+    delete _recovery;
+    delete _document;
+    QFile::remove(_fileName);
+}
+
+/*!
+	Renames the sheet and journals the change.
+*/
+void CAJournalTest::rename(CAJournal& journal, const QString& name)
+{
+    CASheet* sheet = _document->sheetList()[0];
+    QString oldName = sheet->name();
+    sheet->setName(name);
+
+    CANameDelta delta(sheet, oldName);
+    journal.append(QList<CAUndoDelta*>() << &delta, false);
+}
+
+/*!
+	Appends a note to the first voice and journals the change.
+*/
+void CAJournalTest::insertNote(CAJournal& journal)
+{
+    CAVoice* voice = _document->sheetList()[0]->voiceList()[0];
+    CAMusElementsDelta delta(voice->staff());
+    voice->append(new CANote(CADiatonicPitch(28), CAPlayableLength(CAPlayableLength::Quarter), voice, 0));
+    delta.finish();
+    QVERIFY(delta.isJournaled());
+
+    journal.append(QList<CAUndoDelta*>() << &delta, false);
+}
+
+/*!
+	Redone records are applied in order, undone records are reverted.
+*/
+void CAJournalTest::replayRecords()
+{
+    {
+        CAJournal journal(_fileName);
+        rename(journal, "B");
+        rename(journal, "C");
+
+        CANameDelta delta(_document->sheetList()[0], "B");
+        journal.append(QList<CAUndoDelta*>() << &delta, true);
+        QVERIFY(journal.size() > 0);
+    }
+
+    QCOMPARE(CAJournal::replay(_fileName, _recovery), 3);
+    QCOMPARE(_recovery->sheetList()[0]->name(), QString("B"));
+}
+
+/*!
+	Inserted notes are journaled by CAMusElementsDelta. Undoing the insertion removes the note
+	from the recovered document, redoing it inserts the note read from the journal again.
+*/
+void CAJournalTest::insertedNoteRecovered()
+{
+    CAVoice* voice = _document->sheetList()[0]->voiceList()[0];
+    {
+        CAJournal journal(_fileName);
+        CAMusElementsDelta delta(voice->staff());
+        voice->append(new CANote(CADiatonicPitch(28), CAPlayableLength(CAPlayableLength::Quarter), voice, 0));
+        delta.finish();
+
+        journal.append(QList<CAUndoDelta*>() << &delta, false);
+        delta.undo(_document);
+        journal.append(QList<CAUndoDelta*>() << &delta, true);
+        delta.redo(_document);
+        journal.append(QList<CAUndoDelta*>() << &delta, false);
+        insertNote(journal);
+    }
+
+    QCOMPARE(CAJournal::replay(_fileName, _recovery), 4);
+    QList<CANote*> notes = _recovery->sheetList()[0]->voiceList()[0]->getNoteList();
+    QCOMPARE(notes.size(), 2);
+    QCOMPARE(notes[0]->diatonicPitch().noteName(), 28);
+    QCOMPARE(notes[0]->timeStart(), 0);
+    QCOMPARE(notes[1]->timeStart(), notes[0]->timeEnd());
+    QCOMPARE(notes[0]->voice(), _recovery->sheetList()[0]->voiceList()[0]);
+}
+
+/*!
+	Changes which can't be journaled are written as a barrier. The barrier and all the changes
+	after it are lost until the next recovery file is written.
+*/
+void CAJournalTest::lostAfterBarrier()
+{
+    {
+        CAJournal journal(_fileName);
+        rename(journal, "B");
+        journal.appendBarrier();
+        rename(journal, "C");
+    }
+
+    QCOMPARE(CAJournal::replay(_fileName, _recovery), 1);
+    QCOMPARE(_recovery->sheetList()[0]->name(), QString("B"));
+}
+
+/*!
+	The records before the offset of a snapshot record are contained in the recovery file
+	already and aren't replayed again.
+*/
+void CAJournalTest::skipSnapshotRecords()
+{
+    {
+        CAJournal journal(_fileName);
+        insertNote(journal);
+        qint64 offset = journal.size();
+        insertNote(journal);
+        journal.appendSnapshot(offset);
+        rename(journal, "B");
+    }
+
+    CAVoice* voice = _recovery->sheetList()[0]->voiceList()[0];
+    voice->append(new CANote(CADiatonicPitch(28), CAPlayableLength(CAPlayableLength::Quarter), voice, 0));
+
+    QCOMPARE(CAJournal::replay(_fileName, _recovery), 2);
+    QCOMPARE(voice->getNoteList().size(), 2);
+    QCOMPARE(_recovery->sheetList()[0]->name(), QString("B"));
+}
+
+/*!
+	A record cut off when crashing is skipped.
+*/
+void CAJournalTest::incompleteRecord()
+{
+    qint64 size;
+    {
+        CAJournal journal(_fileName);
+        rename(journal, "B");
+        size = journal.size();
+        rename(journal, "C");
+    }
+
+    QFile file(_fileName);
+    QVERIFY(file.resize(file.size() - 1));
+    QVERIFY(file.size() > size);
+
+    QCOMPARE(CAJournal::replay(_fileName, _recovery), 1);
+    QCOMPARE(_recovery->sheetList()[0]->name(), QString("B"));
+}
+
+QTEST_GUILESS_MAIN(CAJournalTest)
+#include "journaltest.moc"
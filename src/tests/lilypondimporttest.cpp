@@ -0,0 +1,145 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QtTest>
+
+#include "import/lilypondimport.h"
+#include "score/document.h"
+#include "score/note.h"
+#include "score/sheet.h"
+#include "score/staff.h"
+#include "score/voice.h"
+
+/*!
+	\class CALilyPondImportTest
+	\brief Regression tests and benchmark of CALilyPondImport
+
+	The LilyPond source is imported into a voice of a new staff like the LilyPond source view
+	does. importLongVoice() measures the lexer on a long voice, run the executable with
+	-iterations N for stable numbers.
+*/
+class CALilyPondImportTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void importVoice();
+    void skipComments();
+    void importChord();
+    void importLongVoice();
+
+private:
+    CAVoice* import(const QString& source);
+
+    CADocument* _document;
+    CAVoice* _templateVoice;
+};
+
+void CALilyPondImportTest::init()
+{
+    _document = new CADocument();
+    CASheet* sheet = _document->addSheet();
+    _templateVoice = sheet->addStaff()->voiceList()[0];
+}
+
+void CALilyPondImportTest::cleanup()
+{
+    delete _document;
+}
+
+/*!
+	Imports the LilyPond \a source and returns the new voice. The caller owns the voice.
+*/
+CAVoice* CALilyPondImportTest::import(const QString& source)
+{
+    CALilyPondImport li(source);
+    li.setTemplateVoice(_templateVoice);
+    li.importVoice();
+    li.wait();
+    return li.importedVoice();
+}
+
+void CALilyPondImportTest::importVoice()
+{
+    CAVoice* voice = import("\\relative c' { c4 d8 e f2 }\n");
+    QVERIFY(voice);
+
+    QList<CANote*> notes = voice->getNoteList();
+    QCOMPARE(notes.size(), 4);
+    for (int i = 1; i < notes.size(); i++) {
+        QCOMPARE(notes[i]->diatonicPitch().noteName(), notes[i - 1]->diatonicPitch().noteName() + 1);
+        QCOMPARE(notes[i]->timeStart(), notes[i - 1]->timeEnd());
+    }
+    QCOMPARE(notes[0]->playableLength().musicLength(), CAPlayableLength::Quarter);
+    QCOMPARE(notes[1]->playableLength().musicLength(), CAPlayableLength::Eighth);
+    QCOMPARE(notes[2]->playableLength().musicLength(), CAPlayableLength::Eighth);
+    QCOMPARE(notes[3]->playableLength().musicLength(), CAPlayableLength::Half);
+
+    delete voice;
+}
+
+/*!
+	Line and block comments between and right after the elements are skipped.
+*/
+void CALilyPondImportTest::skipComments()
+{
+    CAVoice* voice = import("% header comment\n"
+                            "\\relative c' {%{ block %}c4 % line comment d\n"
+                            "d %{ e f\n g %} e\tf }\n");
+    QVERIFY(voice);
+
+    QList<CANote*> notes = voice->getNoteList();
+    QCOMPARE(notes.size(), 4);
+    for (int i = 1; i < notes.size(); i++) {
+        QCOMPARE(notes[i]->diatonicPitch().noteName(), notes[i - 1]->diatonicPitch().noteName() + 1);
+    }
+
+    delete voice;
+}
+
+/*!
+	Chord brackets are syntax delimiters, also when written without the whitespace.
+*/
+void CALilyPondImportTest::importChord()
+{
+    CAVoice* voice = import("\\relative c' { <c e g>2 <d f a> }\n");
+    QVERIFY(voice);
+
+    QList<CANote*> notes = voice->getNoteList();
+    QCOMPARE(notes.size(), 6);
+    QCOMPARE(notes[0]->timeStart(), notes[2]->timeStart());
+    QCOMPARE(notes[3]->timeStart(), notes[0]->timeEnd());
+    QCOMPARE(notes[3]->getChord().size(), 3);
+
+    delete voice;
+}
+
+/*!
+	The lexer keeps a position in the input, so the import time grows linearly with the length
+	of the voice.
+*/
+void CALilyPondImportTest::importLongVoice()
+{
+    const int bars = 2000;
+    QString source = "\\relative c' { ";
+    for (int i = 0; i < bars; i++) {
+        source += "c4 d e f | g f e d |\n";
+    }
+    source += "}\n";
+
+    QBENCHMARK {
+        CAVoice* voice = import(source);
+        QVERIFY(voice);
+        QCOMPARE(voice->getNoteList().size(), bars * 8);
+        delete voice;
+    }
+}
+
+QTEST_GUILESS_MAIN(CALilyPondImportTest)
+#include "lilypondimporttest.moc"
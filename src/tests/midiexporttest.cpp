@@ -0,0 +1,177 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QBuffer>
+#include <QTextStream>
+#include <QtTest>
+
+#include "export/midiexport.h"
+#include "import/midifileparser.h"
+#include "score/document.h"
+#include "score/note.h"
+#include "score/sheet.h"
+#include "score/staff.h"
+#include "score/tempo.h"
+#include "score/voice.h"
+
+/*!
+	\class CAMidiExportTest
+	\brief Regression tests and benchmark of CAMidiExport
+
+	The exported MIDI file is read back by CAMidiFileParser and compared to the score.
+*/
+class CAMidiExportTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void tracksAndNotes();
+    void tempo();
+    void exportLargeSheet();
+
+private:
+    static QList<CANote*> appendNotes(CAVoice* voice, int count);
+    QByteArray exportDocument();
+    QList<CAMidiFileParser::CAMidiEvent> events(const QByteArray& midi, CAMidiFileParser::CAMidiEventType type);
+
+    CADocument* _document;
+    CASheet* _sheet;
+};
+
+void CAMidiExportTest::init()
+{
+    _document = new CADocument();
+    _sheet = _document->addSheet();
+}
+
+void CAMidiExportTest::cleanup()
+{
+    delete _document;
+}
+
+/*!
+	Appends \a count quarter notes going up from c' to the \a voice.
+*/
+QList<CANote*> CAMidiExportTest::appendNotes(CAVoice* voice, int count)
+{
+    QList<CANote*> notes;
+    for (int i = 0; i < count; i++) {
+        CANote* note = new CANote(CADiatonicPitch(28 + i % 7), CAPlayableLength(CAPlayableLength::Quarter), voice, voice->lastTimeEnd());
+        voice->append(note);
+        notes << note;
+    }
+    return notes;
+}
+
+QByteArray CAMidiExportTest::exportDocument()
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QTextStream stream(&buffer);
+    CAMidiExport midiExport(&stream);
+    midiExport.exportDocument(_document, false);
+    return buffer.data();
+}
+
+/*!
+	Parses the \a midi file and returns its events of the given \a type.
+*/
+QList<CAMidiFileParser::CAMidiEvent> CAMidiExportTest::events(const QByteArray& midi, CAMidiFileParser::CAMidiEventType type)
+{
+    CAMidiFileParser parser;
+    if (!parser.parse(reinterpret_cast<const unsigned char*>(midi.constData()), midi.size())) {
+        qWarning() << parser.errorString();
+        return QList<CAMidiFileParser::CAMidiEvent>();
+    }
+
+    QList<CAMidiFileParser::CAMidiEvent> ret;
+    for (int i = 0; i < parser.events().size(); i++) {
+        if (parser.events()[i].type == type) {
+            ret << parser.events()[i];
+        }
+    }
+    return ret;
+}
+
+/*!
+	Each voice gets its own track after the control track. Notes keep their pitch, start and
+	length.
+*/
+void CAMidiExportTest::tracksAndNotes()
+{
+    CAVoice* voice1 = _sheet->addStaff()->voiceList()[0];
+    CAVoice* voice2 = _sheet->addStaff()->voiceList()[0];
+    voice2->setMidiChannel(1);
+    QList<CANote*> notes = appendNotes(voice1, 4);
+    appendNotes(voice2, 2);
+
+    QByteArray midi = exportDocument();
+    QVERIFY(midi.startsWith("MThd"));
+
+    CAMidiFileParser parser;
+    QVERIFY(parser.parse(reinterpret_cast<const unsigned char*>(midi.constData()), midi.size()));
+    QCOMPARE(parser.format(), 1);
+    QCOMPARE(parser.tracks(), 3);
+    QCOMPARE(parser.timeBase(), CAPlayableLength::musicLengthToTimeLength(CAPlayableLength::Quarter));
+
+    QList<CAMidiFileParser::CAMidiEvent> channel0;
+    QList<CAMidiFileParser::CAMidiEvent> channel1;
+    QList<CAMidiFileParser::CAMidiEvent> all = events(midi, CAMidiFileParser::Note);
+    for (int i = 0; i < all.size(); i++) {
+        (all[i].channel ? channel1 : channel0) << all[i];
+    }
+    QCOMPARE(channel0.size(), 4);
+    QCOMPARE(channel1.size(), 2);
+
+    for (int i = 0; i < notes.size(); i++) {
+        QCOMPARE(static_cast<int>(channel0[i].data1), notes[i]->diatonicPitch().midiPitch());
+        QCOMPARE(channel0[i].time, notes[i]->timeStart());
+        QCOMPARE(channel0[i].length, notes[i]->timeLength());
+    }
+}
+
+/*!
+	Tempos above 127 bpm and tempo marks with other beats than a quarter are written in
+	microseconds per quarter note.
+*/
+void CAMidiExportTest::tempo()
+{
+    CAVoice* voice = _sheet->addStaff()->voiceList()[0];
+    QList<CANote*> notes = appendNotes(voice, 4);
+    notes[0]->addMark(new CATempo(CAPlayableLength(CAPlayableLength::Quarter), 150, notes[0]));
+    notes[2]->addMark(new CATempo(CAPlayableLength(CAPlayableLength::Quarter, 1), 60, notes[2]));
+
+    QList<CAMidiFileParser::CAMidiEvent> tempos = events(exportDocument(), CAMidiFileParser::Tempo);
+    QCOMPARE(tempos.size(), 2);
+    QCOMPARE(tempos[0].value, 400000);
+    QCOMPARE(tempos[0].time, notes[0]->timeStart());
+    QCOMPARE(tempos[1].value, 666667);
+    QCOMPARE(tempos[1].time, notes[2]->timeStart());
+}
+
+/*!
+	Exports 4 staffs of 10000 notes each.
+*/
+void CAMidiExportTest::exportLargeSheet()
+{
+    for (int i = 0; i < 4; i++) {
+        CAVoice* voice = _sheet->addStaff()->voiceList()[0];
+        voice->setMidiChannel(static_cast<unsigned char>(i));
+        appendNotes(voice, 10000);
+    }
+
+    QByteArray midi;
+    QBENCHMARK {
+        midi = exportDocument();
+    }
+    QCOMPARE(events(midi, CAMidiFileParser::Note).size(), 40000);
+}
+
+QTEST_GUILESS_MAIN(CAMidiExportTest)
+#include "midiexporttest.moc"
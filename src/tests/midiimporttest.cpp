@@ -0,0 +1,140 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QBuffer>
+#include <QTextStream>
+#include <QtTest>
+
+#include "export/midiexport.h"
+#include "import/midiimport.h"
+#include "score/document.h"
+#include "score/note.h"
+#include "score/sheet.h"
+#include "score/staff.h"
+#include "score/voice.h"
+
+/*!
+	\class CAMidiImportTest
+	\brief Regression tests and benchmark of CAMidiImport
+
+	The MIDI files are written by CAMidiExport into memory and imported from a buffer, so the
+	importer reads the device of the stream and doesn't know any file name. importLargeFile()
+	measures parsing and quantizing, run the executable with -iterations N for stable numbers.
+*/
+class CAMidiImportTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void importFromDevice();
+    void importInvalidData();
+    void importLargeFile();
+
+private:
+    static QByteArray exportDocument(int staffs, int notes);
+    static CADocument* importDocument(const QByteArray& midi);
+    static QList<CANote*> notes(CADocument* doc);
+};
+
+/*!
+	Returns a MIDI file of \a staffs staffs, each having \a notes quarter notes going up from c'.
+*/
+QByteArray CAMidiImportTest::exportDocument(int staffs, int notes)
+{
+    CADocument doc;
+    CASheet* sheet = doc.addSheet();
+    for (int i = 0; i < staffs; i++) {
+        CAVoice* voice = sheet->addStaff()->voiceList()[0];
+        voice->setMidiChannel(static_cast<unsigned char>(i));
+        for (int j = 0; j < notes; j++) {
+            voice->append(new CANote(CADiatonicPitch(28 + j % 7), CAPlayableLength(CAPlayableLength::Quarter), voice, voice->lastTimeEnd()));
+        }
+    }
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QTextStream stream(&buffer);
+    CAMidiExport midiExport(&stream);
+    midiExport.exportDocument(&doc, false);
+    return buffer.data();
+}
+
+CADocument* CAMidiImportTest::importDocument(const QByteArray& midi)
+{
+    QBuffer buffer;
+    buffer.setData(midi);
+    buffer.open(QIODevice::ReadOnly);
+    QTextStream stream(&buffer);
+    CAMidiImport midiImport(nullptr, &stream);
+    midiImport.importDocument();
+    midiImport.wait();
+    return midiImport.importedDocument();
+}
+
+/*!
+	Returns the notes of all voices of the document \a doc.
+*/
+QList<CANote*> CAMidiImportTest::notes(CADocument* doc)
+{
+    QList<CANote*> ret;
+    for (int i = 0; i < doc->sheetList().size(); i++) {
+        QList<CAVoice*> voices = doc->sheetList()[i]->voiceList();
+        for (int j = 0; j < voices.size(); j++) {
+            ret << voices[j]->getNoteList();
+        }
+    }
+    return ret;
+}
+
+/*!
+	The notes are read from the buffer, not from a file named after the stream.
+*/
+void CAMidiImportTest::importFromDevice()
+{
+    CADocument* doc = importDocument(exportDocument(1, 8));
+    QVERIFY(doc);
+    QCOMPARE(doc->sheetList().size(), 1);
+
+    QList<CANote*> imported = notes(doc);
+    QCOMPARE(imported.size(), 8);
+    for (int i = 0; i < imported.size(); i++) {
+        QCOMPARE(imported[i]->diatonicPitch().midiPitch(), CADiatonicPitch(28 + i % 7).midiPitch());
+        QCOMPARE(imported[i]->timeStart(), i * CAPlayableLength::musicLengthToTimeLength(CAPlayableLength::Quarter));
+    }
+
+    delete doc;
+}
+
+/*!
+	Data which is not a MIDI file gives an empty document.
+*/
+void CAMidiImportTest::importInvalidData()
+{
+    CADocument* doc = importDocument(QByteArray("MThd not a midi file"));
+    if (doc) {
+        QVERIFY(notes(doc).isEmpty());
+    }
+
+    delete doc;
+}
+
+/*!
+	Imports 4 staffs of 5000 notes each.
+*/
+void CAMidiImportTest::importLargeFile()
+{
+    QByteArray midi = exportDocument(4, 5000);
+
+    QBENCHMARK {
+        CADocument* doc = importDocument(midi);
+        QVERIFY(doc);
+        QCOMPARE(notes(doc).size(), 20000);
+        delete doc;
+    }
+}
+
+QTEST_GUILESS_MAIN(CAMidiImportTest)
+#include "midiimporttest.moc"
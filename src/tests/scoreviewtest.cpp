@@ -0,0 +1,186 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QDir>
+#include <QtTest>
+
+#include "canorus.h"
+#include "core/settings.h"
+#include "layout/drawablearena.h"
+#include "layout/layoutengine.h"
+#include "layout/sheetlayout.h"
+#include "score/barline.h"
+#include "score/clef.h"
+#include "score/document.h"
+#include "score/keysignature.h"
+#include "score/note.h"
+#include "score/rest.h"
+#include "score/sheet.h"
+#include "score/staff.h"
+#include "score/timesignature.h"
+#include "score/voice.h"
+#include "widgets/scoreview.h"
+#include "widgets/tilecache.h"
+
+/*!
+	\class CAScoreViewTest
+	\brief Benchmarks of the layout and painting of a large score in CAScoreView
+
+	repositAndClear() compares laying out and clearing the score with the drawable elements
+	allocated on the heap and in the arena of the sheet layout. paintFitToWindow() reports the
+	time of a frame of the whole score zoomed to fit the window, with the tiles rendered from
+	scratch or taken from CATileCache. Run the executable with -iterations N for stable numbers.
+*/
+class CAScoreViewTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void cleanup();
+
+    void repositAndClear_data();
+    void repositAndClear();
+    void paintFitToWindow_data();
+    void paintFitToWindow();
+
+private:
+    static void appendBars(CAStaff* staff, CAClef::CAPredefinedClefType clef, int firstPitch, int bars);
+
+    CADocument* _document;
+    CAScoreView* _scoreView;
+};
+
+/*!
+	Creates a score of two staves of 500 bars of eighth notes and rests.
+*/
+void CAScoreViewTest::initTestCase()
+{
+    QDir::addSearchPath("fonts", QString(CANORUS_TESTS_DIR) + "/../fonts");
+    CACanorus::initFonts();
+    CACanorus::initSettings();
+    CACanorus::settings()->setAntiAliasing(true); // don't depend on the settings of the user
+    CACanorus::settings()->setShowRuler(false);
+
+    _document = new CADocument();
+    CASheet* sheet = _document->addSheet();
+    appendBars(sheet->addStaff(), CAClef::Treble, 28, 500);
+    appendBars(sheet->addStaff(), CAClef::Bass, 16, 500);
+
+    _scoreView = new CAScoreView(sheet);
+    _scoreView->resize(1280, 800);
+}
+
+void CAScoreViewTest::cleanupTestCase()
+{
+    delete _scoreView;
+    delete _document;
+}
+
+void CAScoreViewTest::cleanup()
+{
+    CADrawableArena::setEnabled(true);
+    CACanorus::settings()->setReducedDetailZoom(CASettings::DEFAULT_REDUCED_DETAIL_ZOOM);
+    CACanorus::settings()->setOutlineDetailZoom(CASettings::DEFAULT_OUTLINE_DETAIL_ZOOM);
+}
+
+/*!
+	Appends the clef, key and time signature and \a bars bars of 4/4 to the first voice of
+	the \a staff. The pitches go up and down from \a firstPitch.
+*/
+void CAScoreViewTest::appendBars(CAStaff* staff, CAClef::CAPredefinedClefType clef, int firstPitch, int bars)
+{
+    CAVoice* voice = staff->voiceList()[0];
+    voice->append(new CAClef(clef, staff, 0));
+    voice->append(new CAKeySignature(CADiatonicKey(2, CADiatonicKey::Major), staff, 0));
+    voice->append(new CATimeSignature(4, 4, staff, 0));
+
+    for (int i = 0; i < bars; i++) {
+        for (int j = 0; j < 8; j++) {
+            if (j == 7) {
+                voice->append(new CARest(CARest::Normal, CAPlayableLength(CAPlayableLength::Eighth), voice, 0));
+            } else {
+                voice->append(new CANote(CADiatonicPitch(firstPitch + (i + j) % 10), CAPlayableLength(CAPlayableLength::Eighth), voice, 0));
+            }
+        }
+        voice->append(new CABarline(CABarline::Single, staff, 0));
+    }
+}
+
+void CAScoreViewTest::repositAndClear_data()
+{
+    QTest::addColumn<bool>("useArena");
+
+    QTest::newRow("heap") << false;
+    QTest::newRow("arena") << true;
+}
+
+/*!
+	Lays out the whole score and deletes its drawable elements again like the full rebuild of
+	the view after each change does.
+*/
+void CAScoreViewTest::repositAndClear()
+{
+    QFETCH(bool, useArena);
+    CADrawableArena::setEnabled(useArena);
+
+    QBENCHMARK {
+        CALayoutEngine::reposit(_scoreView);
+        QVERIFY(_scoreView->drawableMElementCount() > 500 * 9 * 2);
+        _scoreView->sheetLayout()->clear();
+    }
+
+    QCOMPARE(_scoreView->sheetLayout()->arena().usedBytes(), std::size_t(0));
+}
+
+void CAScoreViewTest::paintFitToWindow_data()
+{
+    QTest::addColumn<bool>("cached");
+    QTest::addColumn<bool>("fullDetail");
+
+    QTest::newRow("new tiles") << false << false;
+    QTest::newRow("new tiles, full detail") << false << true;
+    QTest::newRow("cached tiles") << true << false;
+}
+
+/*!
+	Zooms the whole score to fit a 1280x800 window and repaints it. Without the \a cached tiles
+	each frame renders all the visible tiles and waits for them like the first frame after
+	zooming does. \a fullDetail draws all the glyphs instead of the default levels of detail.
+*/
+void CAScoreViewTest::paintFitToWindow()
+{
+    QFETCH(bool, cached);
+    QFETCH(bool, fullDetail);
+    if (fullDetail) {
+        CACanorus::settings()->setReducedDetailZoom(0);
+        CACanorus::settings()->setOutlineDetailZoom(0);
+    }
+
+    _scoreView->show();
+    QVERIFY(QTest::qWaitForWindowExposed(_scoreView));
+    _scoreView->rebuild();
+    _scoreView->zoomToFit();
+    QVERIFY(_scoreView->zoom() < 0.2);
+
+    _scoreView->repaint();
+    _scoreView->tileCache()->waitForDone();
+
+    QBENCHMARK {
+        if (!cached) {
+            _scoreView->tileCache()->clear();
+            _scoreView->repaint(); // schedules the tiles
+            _scoreView->tileCache()->waitForDone();
+        }
+        _scoreView->repaint();
+    }
+
+    _scoreView->hide();
+}
+
+QTEST_MAIN(CAScoreViewTest)
+#include "scoreviewtest.moc"
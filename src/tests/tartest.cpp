@@ -0,0 +1,189 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QBuffer>
+#include <QFile>
+#include <QtTest>
+
+#include "core/archive.h"
+#include "core/tar.h"
+
+/*!
+	\class CATarTest
+	\brief Regression tests of CATar and CAArchive
+
+	Files are written to a tar or .can archive in memory and read back, both at once and chunk by
+	chunk as they arrive from the decompressor.
+*/
+class CATarTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void roundTrip();
+    void parseChunks_data();
+    void parseChunks();
+    void spillToTemporaryFile();
+    void truncatedHeader();
+    void archiveRoundTrip();
+
+private:
+    static QByteArray data(int size);
+    QByteArray writeTar(CATar& tar);
+
+    qint64 _spillThreshold;
+};
+
+void CATarTest::init()
+{
+    _spillThreshold = CATar::spillThreshold();
+}
+
+void CATarTest::cleanup()
+{
+    CATar::setSpillThreshold(_spillThreshold);
+}
+
+/*!
+	Returns \a size bytes of data which doesn't repeat every block.
+*/
+QByteArray CATarTest::data(int size)
+{
+    QByteArray ret(size, 0);
+    for (int i = 0; i < size; i++) {
+        ret[i] = static_cast<char>((i * 7 + i / 511) % 251);
+    }
+    return ret;
+}
+
+QByteArray CATarTest::writeTar(CATar& tar)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    tar.open(buffer);
+    tar.write(buffer);
+    tar.close(buffer);
+    return buffer.data();
+}
+
+void CATarTest::roundTrip()
+{
+    CATar tar;
+    QVERIFY(tar.addFile("content.xml", QByteArray("<canorus-document/>")));
+    QVERIFY(tar.addFile("content.xml files/image.png", data(100000)));
+
+    QByteArray bytes = writeTar(tar);
+    QCOMPARE(bytes.size() % 512, 0);
+
+    QBuffer buffer(&bytes);
+    CATar parsed(buffer);
+    QVERIFY(!parsed.error());
+    QVERIFY(parsed.contains("content.xml"));
+    QVERIFY(parsed.contains("content.xml files/image.png"));
+    QVERIFY(!parsed.contains("missing.xml"));
+    QCOMPARE(parsed.file("content.xml")->readAll(), QByteArray("<canorus-document/>"));
+    QCOMPARE(parsed.file("content.xml files/image.png")->readAll(), data(100000));
+}
+
+void CATarTest::parseChunks_data()
+{
+    QTest::addColumn<int>("chunk");
+
+    QTest::newRow("1 byte") << 1;
+    QTest::newRow("7 bytes") << 7;
+    QTest::newRow("block") << 512;
+    QTest::newRow("1000 bytes") << 1000;
+    QTest::newRow("whole") << 1000000;
+}
+
+/*!
+	Headers, data and padding split over the chunk boundaries must give the same files.
+*/
+void CATarTest::parseChunks()
+{
+    QFETCH(int, chunk);
+
+    CATar tar;
+    tar.addFile("a.txt", QByteArray("a"));
+    tar.addFile("b.bin", data(1536)); // no padding
+    tar.addFile("c.bin", data(3000));
+    QByteArray bytes = writeTar(tar);
+
+    CATar parsed;
+    for (int i = 0; i < bytes.size(); i += chunk) {
+        parsed.parseChunk(bytes.constData() + i, qMin(chunk, bytes.size() - i));
+    }
+    parsed.parseFinish();
+
+    QVERIFY(!parsed.error());
+    QCOMPARE(parsed.file("a.txt")->readAll(), QByteArray("a"));
+    QCOMPARE(parsed.file("b.bin")->readAll(), data(1536));
+    QCOMPARE(parsed.file("c.bin")->readAll(), data(3000));
+}
+
+/*!
+	Files larger than the spill threshold are kept in temporary files instead of memory.
+*/
+void CATarTest::spillToTemporaryFile()
+{
+    CATar::setSpillThreshold(1024);
+
+    CATar tar;
+    tar.addFile("small.txt", data(100));
+    tar.addFile("large.bin", data(10000));
+    QByteArray bytes = writeTar(tar);
+
+    QBuffer buffer(&bytes);
+    CATar parsed(buffer);
+    QVERIFY(!parsed.error());
+
+    CAIOPtr small = parsed.file("small.txt");
+    CAIOPtr large = parsed.file("large.bin");
+    QVERIFY(qobject_cast<QBuffer*>(small.get()));
+    QVERIFY(qobject_cast<QFile*>(large.get()));
+    QCOMPARE(small->readAll(), data(100));
+    QCOMPARE(large->readAll(), data(10000));
+}
+
+void CATarTest::truncatedHeader()
+{
+    CATar tar;
+    tar.addFile("a.txt", QByteArray("a"));
+    QByteArray bytes = writeTar(tar);
+    bytes.append(QByteArray(100, 'x')); // part of the next header
+
+    QBuffer buffer(&bytes);
+    CATar parsed(buffer);
+    QVERIFY(parsed.error());
+    QCOMPARE(parsed.file("a.txt")->readAll(), QByteArray("a"));
+}
+
+/*!
+	The .can archive is gzipped while writing and untarred while inflating.
+*/
+void CATarTest::archiveRoundTrip()
+{
+    QBuffer buffer;
+    {
+        CAArchive arc;
+        arc.addFile("content.xml", QByteArray("<canorus-document/>"));
+        arc.addFile("content.xml files/score.mid", data(200000));
+        QVERIFY(arc.write(buffer) > 0);
+    }
+
+    buffer.open(QIODevice::ReadOnly);
+    CAArchive parsed(buffer);
+    QVERIFY(!parsed.error());
+    QVERIFY(!parsed.version().isEmpty());
+    QCOMPARE(parsed.file("content.xml")->readAll(), QByteArray("<canorus-document/>"));
+    QCOMPARE(parsed.file("content.xml files/score.mid")->readAll(), data(200000));
+}
+
+QTEST_GUILESS_MAIN(CATarTest)
+#include "tartest.moc"
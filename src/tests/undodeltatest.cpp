@@ -0,0 +1,196 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QtTest>
+
+#include "core/undocommand.h"
+#include "core/undodelta.h"
+#include "score/barline.h"
+#include "score/document.h"
+#include "score/note.h"
+#include "score/sheet.h"
+#include "score/staff.h"
+#include "score/tuplet.h"
+#include "score/voice.h"
+
+/*!
+	\class CAUndoDeltaTest
+	\brief Regression tests of CAMusElementsDelta
+
+	Each test records an action on a staff of two voices, undoes and redoes it and compares the
+	types and times of the elements in the voices with the ones before and after the action.
+*/
+class CAUndoDeltaTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void insertNote();
+    void removeNoteAndSynchronize();
+    void deleteSharedBarline();
+    void fallbackOnTuplet();
+
+private:
+    CANote* newNote(CAVoice* voice);
+    QStringList staffState();
+    void verifyUndoRedo(CAMusElementsDelta* delta, const QStringList& before);
+
+    CADocument* _document;
+    CAStaff* _staff;
+    CAVoice* _first;
+    CAVoice* _second;
+    CABarline* _barline;
+};
+
+void CAUndoDeltaTest::init()
+{
+    _document = new CADocument();
+    _staff = _document->addSheet()->addStaff();
+    _first = _staff->voiceList()[0];
+    _second = _staff->addVoice();
+
+    for (int i = 0; i < 4; i++) {
+        _first->append(newNote(_first));
+        _second->append(newNote(_second));
+    }
+
+    _barline = new CABarline(CABarline::Single, _staff, 0);
+    _first->insert(_first->musElementList()[2], _barline);
+    _second->insert(_second->musElementList()[2], _barline);
+}
+
+void CAUndoDeltaTest::cleanup()
+{
+    delete _document;
+}
+
+CANote* CAUndoDeltaTest::newNote(CAVoice* voice)
+{
+    return new CANote(CADiatonicPitch(28), CAPlayableLength(CAPlayableLength::Quarter), voice, 0);
+}
+
+/*!
+	Returns the type, time start and time length of each element in the voices of the staff.
+*/
+QStringList CAUndoDeltaTest::staffState()
+{
+    QStringList state;
+    for (int i = 0; i < _staff->voiceList().size(); i++) {
+        QStringList voice;
+        for (int j = 0; j < _staff->voiceList()[i]->musElementList().size(); j++) {
+            CAMusElement* elt = _staff->voiceList()[i]->musElementList()[j];
+            voice << QString("%1:%2:%3").arg(elt->musElementType()).arg(elt->timeStart()).arg(elt->timeLength());
+        }
+        state << voice.join(" ");
+    }
+
+    return state;
+}
+
+/*!
+	Finishes the \a delta recorded since the staff was in the \a before state and checks its
+	undo and redo.
+*/
+void CAUndoDeltaTest::verifyUndoRedo(CAMusElementsDelta* delta, const QStringList& before)
+{
+    delta->finish();
+    QStringList after = staffState();
+    QVERIFY(after != before);
+
+    for (int i = 0; i < 2; i++) {
+        delta->undo(_document);
+        QCOMPARE(staffState(), before);
+        delta->redo(_document);
+        QCOMPARE(staffState(), after);
+    }
+}
+
+void CAUndoDeltaTest::insertNote()
+{
+    QStringList before = staffState();
+    CAMusElementsDelta* delta = new CAMusElementsDelta(_staff);
+    _first->insert(_first->musElementList()[1], newNote(_first));
+
+    verifyUndoRedo(delta, before);
+    QVERIFY(!_staff->recorder());
+    QVERIFY(delta->cost() < CAUndoCommand::cost(_staff)); // the staff isn't copied
+
+    delta->undo(_document);
+    delete delta; // destroys the note not in the document
+    QCOMPARE(staffState(), before);
+}
+
+/*!
+	Removes a note from the second voice and fills the gap by the rests synchronizing the voices.
+*/
+void CAUndoDeltaTest::removeNoteAndSynchronize()
+{
+    QStringList before = staffState();
+    CAMusElementsDelta* delta = new CAMusElementsDelta(_staff);
+    CAMusElement* note = _second->musElementList()[0];
+    _second->remove(note);
+    delete note;
+    _staff->synchronizeVoices();
+
+    verifyUndoRedo(delta, before);
+    delete delta;
+}
+
+/*!
+	Destroys a barline shared by both voices. Undo inserts its copy to both voices again.
+*/
+void CAUndoDeltaTest::deleteSharedBarline()
+{
+    QStringList before = staffState();
+    CAMusElementsDelta* delta = new CAMusElementsDelta(_staff);
+    delete _barline;
+    QCOMPARE(_first->musElementList().size(), 4);
+    QCOMPARE(_second->musElementList().size(), 4);
+
+    verifyUndoRedo(delta, before);
+
+    delta->undo(_document);
+    QCOMPARE(_first->musElementList()[2], _second->musElementList()[2]);
+    QCOMPARE(_staff->barlineRefs().size(), 1);
+    QCOMPARE(_staff->barlineRefs()[0], _first->musElementList()[2]);
+    delta->redo(_document);
+    QVERIFY(_staff->barlineRefs().isEmpty());
+    delete delta;
+}
+
+/*!
+	Creating a tuplet isn't recorded element by element, the delta copies the staff instead.
+*/
+void CAUndoDeltaTest::fallbackOnTuplet()
+{
+    QStringList before = staffState();
+    CAMusElementsDelta* delta = new CAMusElementsDelta(_staff);
+    _first->insert(_first->musElementList()[0], newNote(_first));
+
+    QList<CAPlayable*> notes;
+    for (int i = 0; i < 3; i++) {
+        notes << static_cast<CAPlayable*>(_first->musElementList()[i]);
+    }
+    new CATuplet(3, 2, notes);
+    QVERIFY(!_staff->recorder());
+    QVERIFY(notes[0]->tuplet());
+
+    delta->finish();
+    QStringList after = staffState();
+    delta->undo(_document);
+    QCOMPARE(staffState(), before); // also reverts the insertion recorded before the tuplet
+    QVERIFY(!static_cast<CAPlayable*>(_first->musElementList()[0])->tuplet());
+    delta->redo(_document);
+    QCOMPARE(staffState(), after);
+    QVERIFY(static_cast<CAPlayable*>(_first->musElementList()[0])->tuplet());
+    delete delta;
+}
+
+QTEST_GUILESS_MAIN(CAUndoDeltaTest)
+#include "undodeltatest.moc"
@@ -0,0 +1,179 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QtTest>
+
+#include "score/barline.h"
+#include "score/document.h"
+#include "score/note.h"
+#include "score/sheet.h"
+#include "score/staff.h"
+#include "score/text.h"
+#include "score/voice.h"
+
+/*!
+	\class CAVoiceTest
+	\brief Regression tests of the element times in CAVoice
+
+	Inserting or removing a note shifts the times of the following elements lazily in the
+	positions index of the voice. The tests check the times read back after the shifts were
+	split and merged by further edits. insertAtStart benchmarks the insertion and removal of a
+	note at the beginning of a long voice.
+*/
+class CAVoiceTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void insertShiftsTimes();
+    void removeShiftsTimes();
+    void sharedSigns();
+    void insertAtStart_data();
+    void insertAtStart();
+
+private:
+    CANote* newNote(CAVoice* voice);
+    void appendNotes(CAVoice* voice, int count);
+    void verifyTimes(CAVoice* voice);
+
+    CADocument* _document;
+    CAStaff* _staff;
+    int _quarter;
+};
+
+void CAVoiceTest::init()
+{
+    _document = new CADocument();
+    _staff = _document->addSheet()->addStaff();
+    _quarter = CAPlayableLength::musicLengthToTimeLength(CAPlayableLength::Quarter);
+}
+
+void CAVoiceTest::cleanup()
+{
+    delete _document;
+}
+
+CANote* CAVoiceTest::newNote(CAVoice* voice)
+{
+    return new CANote(CADiatonicPitch(28), CAPlayableLength(CAPlayableLength::Quarter), voice, 0);
+}
+
+void CAVoiceTest::appendNotes(CAVoice* voice, int count)
+{
+    for (int i = 0; i < count; i++) {
+        voice->append(newNote(voice));
+    }
+}
+
+/*!
+	Checks that each element of the \a voice starts where the playable elements before it end.
+*/
+void CAVoiceTest::verifyTimes(CAVoice* voice)
+{
+    int time = 0;
+    for (int i = 0; i < voice->musElementList().size(); i++) {
+        CAMusElement* elt = voice->musElementList()[i];
+        QCOMPARE(elt->timeStart(), time);
+        time += elt->timeLength();
+    }
+}
+
+void CAVoiceTest::insertShiftsTimes()
+{
+    CAVoice* voice = _staff->voiceList()[0];
+    appendNotes(voice, 8);
+    CABarline* barline = new CABarline(CABarline::Single, _staff, 0);
+    voice->insert(voice->musElementList()[4], barline);
+    CAText* text = new CAText("a", static_cast<CAPlayable*>(voice->musElementList()[6]));
+    voice->musElementList()[6]->addMark(text);
+    QCOMPARE(barline->timeStart(), 4 * _quarter);
+
+    for (int i = 0; i < 5; i++) {
+        voice->insert(voice->musElementList()[2 * i], newNote(voice));
+        verifyTimes(voice);
+    }
+
+    QCOMPARE(barline->timeStart(), 9 * _quarter);
+    QCOMPARE(text->timeStart(), text->associatedElement()->timeStart());
+    QCOMPARE(text->timeStart(), 10 * _quarter);
+}
+
+void CAVoiceTest::removeShiftsTimes()
+{
+    CAVoice* voice = _staff->voiceList()[0];
+    appendNotes(voice, 16);
+
+    for (int i = 0; i < 8; i++) {
+        CAMusElement* note = voice->musElementList()[i];
+        QVERIFY(voice->remove(note));
+        delete note;
+        verifyTimes(voice);
+    }
+
+    QCOMPARE(voice->lastTimeEnd(), 8 * _quarter);
+
+    // an element removed and inserted again keeps the shifts applied before
+    CAMusElement* note = voice->musElementList()[3];
+    int timeStart = note->timeStart();
+    voice->insert(voice->musElementList()[0], newNote(voice));
+    QCOMPARE(note->timeStart(), timeStart + _quarter);
+    QVERIFY(voice->remove(note));
+    QCOMPARE(note->timeStart(), timeStart + _quarter);
+    delete note;
+    verifyTimes(voice);
+}
+
+/*!
+	A barline shared by two voices is shifted once by an insertion in each of the voices.
+*/
+void CAVoiceTest::sharedSigns()
+{
+    CAVoice* first = _staff->voiceList()[0];
+    CAVoice* second = _staff->addVoice();
+    appendNotes(first, 4);
+    appendNotes(second, 4);
+
+    CABarline* barline = new CABarline(CABarline::Single, _staff, 0);
+    first->insert(first->musElementList()[2], barline);
+    second->insert(second->musElementList()[2], barline);
+    QCOMPARE(barline->timeStart(), 2 * _quarter);
+
+    second->insert(second->musElementList()[0], newNote(second));
+    QCOMPARE(barline->timeStart(), 3 * _quarter);
+    QCOMPARE(second->musElementList()[3], static_cast<CAMusElement*>(barline));
+
+    first->insert(first->musElementList()[0], newNote(first));
+    QCOMPARE(barline->timeStart(), 4 * _quarter);
+}
+
+void CAVoiceTest::insertAtStart_data()
+{
+    QTest::addColumn<int>("notes");
+    QTest::newRow("1000 notes") << 1000;
+    QTest::newRow("20000 notes") << 20000;
+}
+
+void CAVoiceTest::insertAtStart()
+{
+    QFETCH(int, notes);
+    CAVoice* voice = _staff->voiceList()[0];
+    appendNotes(voice, notes);
+
+    QBENCHMARK {
+        CANote* note = newNote(voice);
+        voice->insert(voice->musElementList()[0], note);
+        voice->remove(note);
+        delete note;
+    }
+
+    QCOMPARE(voice->lastTimeEnd(), notes * _quarter);
+}
+
+QTEST_GUILESS_MAIN(CAVoiceTest)
+#include "voicetest.moc"
@@ -60,6 +60,7 @@
 #include "widgets/pyconsole.h"
 #include "widgets/scoreview.h"
 #include "widgets/sourceview.h"
+#include "widgets/tilecache.h"
 #include "widgets/view.h"
 #include "widgets/viewcontainer.h"
 
@@ -78,6 +79,7 @@
 #include "core/muselementfactory.h"
 #include "core/settings.h"
 #include "core/undo.h"
+#include "core/undodelta.h"
 #include "score/articulation.h"
 #include "score/barline.h"
 #include "score/bookmark.h"
@@ -1615,8 +1617,10 @@ QString CAMainWin::createModeHash()
 	If \a repaint is True (default) the rebuilt Views are also repainted. If False, Views content is
 	only created but not yet drawn. This is useful when multiple operations which could potentially change the
 	content are to happen and we want to actually draw it only at the end.
+	If \a timeStart is given, score views only reposition the music starting at \a timeStart and music after
+	\a timeEnd is considered unchanged. See CAScoreView::rebuild(int, int).
 */
-void CAMainWin::rebuildUI(CASheet* sheet, bool repaint)
+void CAMainWin::rebuildUI(CASheet* sheet, bool repaint, int timeStart, int timeEnd)
 {
     if (rebuildUILock())
         return;
@@ -1628,7 +1632,10 @@ void CAMainWin::rebuildUI(CASheet* sheet, bool repaint)
             if (sheet && _viewList[i]->viewType() == CAView::ScoreView && static_cast<CAScoreView*>(_viewList[i])->sheet() != sheet)
                 continue;
 
-            _viewList[i]->rebuild();
+            if (timeStart >= 0 && _viewList[i]->viewType() == CAView::ScoreView)
+                static_cast<CAScoreView*>(_viewList[i])->rebuild(timeStart, timeEnd);
+            else
+                _viewList[i]->rebuild();
 
             if (_viewList[i]->viewType() == CAView::ScoreView)
                 static_cast<CAScoreView*>(_viewList[i])->checkScrollBars();
@@ -1791,7 +1798,7 @@ void CAMainWin::scoreViewMousePress(QMouseEvent* e, const QPoint coords)
             outStr << "drawableMusElement: " << dElt << ", x,y=" << dElt->xPos() << "," << dElt->yPos() << ", w,h=" << dElt->width() << "," << dElt->height() << ", dContext=" << dElt->drawableContext() << endl;
             outStr << "musElement: " << elt << ", timeStart=" << elt->timeStart() << ", timeEnd=" << elt->timeEnd() << ", context=" << elt->context();
             if (elt->isPlayable()) {
-                outStr << ", voice=" << (static_cast<CAPlayable*>(elt))->voice() << ", voiceNr=" << (static_cast<CAPlayable*>(elt))->voice()->voiceNumber() << ", idxInVoice=" << (static_cast<CAPlayable*>(elt))->voice()->musElementList().indexOf(elt);
+                outStr << ", voice=" << (static_cast<CAPlayable*>(elt))->voice() << ", voiceNr=" << (static_cast<CAPlayable*>(elt))->voice()->voiceNumber() << ", idxInVoice=" << (static_cast<CAPlayable*>(elt))->voice()->musElementIndex(elt);
                 outStr << ", voiceStaff=" << (static_cast<CAPlayable*>(elt))->voice()->staff();
 
                 if (static_cast<CAPlayable*>(elt)->tuplet()) {
@@ -1967,17 +1974,19 @@ void CAMainWin::scoreViewMouseMove(QMouseEvent* e, QPoint coords)
         musElementFactory()->setNoteAccs(iNoteAccs);
         c->setShadowNoteAccs(iNoteAccs);
         c->updateHelpers();
-        c->repaint();
+        c->updateOverlay();
     } else if (mode() != InsertMode) {
         if (c->resizeDirection() != CADrawable::Undefined) {
             // resize element
             int time = c->coordsToTime(coords.x());
             time -= (time % CAPlayableLength::musicLengthToTimeLength(CAPlayableLength::Sixteenth)); // round timelength to eighth notes length
             if (c->resizeDirection() == CADrawable::Right && (time > c->selection().at(0)->musElement()->timeStart())) {
+                CATileCache::cancelAll(); // the element may be painted by the tile workers of any view
                 c->selection().at(0)->musElement()->setTimeLength(time - c->selection().at(0)->musElement()->timeStart());
                 c->selection().at(0)->setWidth(c->timeToCoords(time) - c->selection().at(0)->xPos());
                 c->repaint();
             } else if (c->resizeDirection() == CADrawable::Left && (time < c->selection().at(0)->musElement()->timeEnd())) {
+                CATileCache::cancelAll();
                 c->selection().at(0)->musElement()->setTimeLength(c->selection().at(0)->musElement()->timeEnd() - time);
                 c->selection().at(0)->musElement()->setTimeStart(time);
                 c->selection().at(0)->setXPos(c->timeToCoords(time));
@@ -2011,7 +2020,7 @@ void CAMainWin::scoreViewMouseMove(QMouseEvent* e, QPoint coords)
                         musEltList.back()->xPos() + musEltList.back()->width() - musEltList.front()->xPos(), dcList[i]->height()));
                 }
             }
-            c->repaint();
+            c->updateOverlay();
         }
     }
     c->setMouseTracking(true); // re-enable mouse move events, we finished rendering
@@ -2198,7 +2207,7 @@ void CAMainWin::scoreViewKeyPress(QKeyEvent* e)
             }
         }
 
-        CACanorus::undo()->createUndoCommand(document(), tr("insert barline", "undo"));
+        CACanorus::undo()->createContextUndoCommand(document(), QList<CAContext*>() << staff, tr("insert barline", "undo"));
         CABarline* bar = new CABarline(
             CABarline::Single,
             staff,
@@ -2213,7 +2222,7 @@ void CAMainWin::scoreViewKeyPress(QKeyEvent* e)
                 staff->voiceList()[0]->insert(right, bar);
         }
 
-        staff->synchronizeVoices();
+        staff->synchronizeVoices(bar->timeStart());
 
         if (CACanorus::settings()->useNoteChecker()) {
             _noteChecker.checkSheet(v->sheet());
@@ -2230,7 +2239,7 @@ void CAMainWin::scoreViewKeyPress(QKeyEvent* e)
         if ((mode() == InsertMode) || (mode() == EditMode)) {
             bool rebuild = false;
             if (v->selection().size())
-                CACanorus::undo()->createUndoCommand(document(), tr("rise note", "undo"));
+                CACanorus::undo()->createDeltaUndoCommand(document(), tr("rise note", "undo"));
 
             QList<CAMusElement*> eltList;
             for (int i = 0; i < v->selection().size(); i++) {
@@ -2244,19 +2253,22 @@ void CAMainWin::scoreViewKeyPress(QKeyEvent* e)
                         key = note->voice()->getKeySig(note)->diatonicKey();
                     }
                     CADiatonicPitch pitch(note->diatonicPitch().noteName() + 1, key.noteAccs(note->diatonicPitch().noteName() + 1));
+                    CADiatonicPitch oldPitch = note->diatonicPitch();
                     note->setDiatonicPitch(pitch);
-                    CACanorus::undo()->pushUndoCommand();
+                    CACanorus::undo()->addDelta(new CANotePitchDelta(note, oldPitch));
                     rebuild = true;
                     eltList << note;
                 }
             }
 
+            CACanorus::undo()->pushUndoCommand();
+
             if (CACanorus::settings()->playInsertedNotes()) {
                 playImmediately(eltList);
             }
 
             if (rebuild)
-                CACanorus::rebuildUI(document(), currentSheet());
+                rebuildUIAfterPitchChange(eltList);
         }
         break;
     }
@@ -2265,7 +2277,7 @@ void CAMainWin::scoreViewKeyPress(QKeyEvent* e)
         if ((mode() == InsertMode) || (mode() == EditMode)) {
             //bool rebuild = false;
             if (v->selection().size())
-                CACanorus::undo()->createUndoCommand(document(), tr("lower note", "undo"));
+                CACanorus::undo()->createDeltaUndoCommand(document(), tr("lower note", "undo"));
 
             QList<CAMusElement*> eltList;
             for (int i = 0; i < v->selection().size(); i++) {
@@ -2279,18 +2291,21 @@ void CAMainWin::scoreViewKeyPress(QKeyEvent* e)
                         key = note->voice()->getKeySig(note)->diatonicKey();
                     }
                     CADiatonicPitch pitch(note->diatonicPitch().noteName() - 1, key.noteAccs(note->diatonicPitch().noteName() - 1));
+                    CADiatonicPitch oldPitch = note->diatonicPitch();
                     note->setDiatonicPitch(pitch);
-                    CACanorus::undo()->pushUndoCommand();
+                    CACanorus::undo()->addDelta(new CANotePitchDelta(note, oldPitch));
                     //rebuild = true;
                     eltList << note;
                 }
             }
 
+            CACanorus::undo()->pushUndoCommand();
+
             if (CACanorus::settings()->playInsertedNotes()) {
                 playImmediately(eltList);
             }
 
-            CACanorus::rebuildUI(document(), currentSheet());
+            rebuildUIAfterPitchChange(eltList);
         }
         break;
     }
@@ -2335,10 +2350,13 @@ void CAMainWin::scoreViewKeyPress(QKeyEvent* e)
                     if (elt->musElementType() == CAMusElement::Note) {
                         if (!sheet) {
                             sheet = static_cast<CANote*>(elt)->voice()->staff()->sheet();
-                            CACanorus::undo()->createUndoCommand(document(), tr("add sharp", "undo"));
+                            CACanorus::undo()->createDeltaUndoCommand(document(), tr("add sharp", "undo"));
                         }
-                        if (static_cast<CANote*>(elt)->diatonicPitch().accs() < 2) // limit the amount of accidentals
+                        if (static_cast<CANote*>(elt)->diatonicPitch().accs() < 2) { // limit the amount of accidentals
+                            CADiatonicPitch oldPitch = static_cast<CANote*>(elt)->diatonicPitch();
                             static_cast<CANote*>(elt)->diatonicPitch().setAccs(static_cast<CANote*>(elt)->diatonicPitch().accs() + 1);
+                            CACanorus::undo()->addDelta(new CANotePitchDelta(static_cast<CANote*>(elt), oldPitch));
+                        }
                     }
                     eltList << elt;
                 }
@@ -2370,10 +2388,13 @@ void CAMainWin::scoreViewKeyPress(QKeyEvent* e)
                     if (elt->musElementType() == CAMusElement::Note) {
                         if (!sheet) {
                             sheet = static_cast<CANote*>(elt)->voice()->staff()->sheet();
-                            CACanorus::undo()->createUndoCommand(document(), tr("add flat", "undo"));
+                            CACanorus::undo()->createDeltaUndoCommand(document(), tr("add flat", "undo"));
                         }
-                        if (static_cast<CANote*>(elt)->diatonicPitch().accs() > -2) // limit the amount of accidentals
+                        if (static_cast<CANote*>(elt)->diatonicPitch().accs() > -2) { // limit the amount of accidentals
+                            CADiatonicPitch oldPitch = static_cast<CANote*>(elt)->diatonicPitch();
                             static_cast<CANote*>(elt)->diatonicPitch().setAccs(static_cast<CANote*>(elt)->diatonicPitch().accs() - 1);
+                            CACanorus::undo()->addDelta(new CANotePitchDelta(static_cast<CANote*>(elt), oldPitch));
+                        }
                     }
                     eltList << elt;
                 }
@@ -2399,7 +2420,7 @@ void CAMainWin::scoreViewKeyPress(QKeyEvent* e)
             v->repaint();
         } else if (mode() == EditMode) {
             if (!(static_cast<CAScoreView*>(v))->selection().isEmpty()) {
-                CACanorus::undo()->createUndoCommand(document(), tr("set dotted", "undo"));
+                CACanorus::undo()->createContextUndoCommand(document(), currentScoreView()->selectionContexts(), tr("set dotted", "undo"));
                 CAPlayable* p = dynamic_cast<CAPlayable*>(currentScoreView()->selection().front()->musElement());
 
                 if (p) {
@@ -2439,7 +2460,7 @@ void CAMainWin::scoreViewKeyPress(QKeyEvent* e)
                             p->voice()->insert(next, rests[i]); // insert rests from shortest to longest
                         }
                     } else {
-                        p->staff()->synchronizeVoices();
+                        p->staff()->synchronizeVoices(p->timeStart());
                     }
 
                     for (int j = 0; j < p->voice()->lyricsContextList().size(); j++) { // reposit syllables
@@ -2605,7 +2626,38 @@ bool CAMainWin::insertMusElementAt(const QPoint coords, CAScoreView* v)
     if (!drawableContext)
         return false;
 
-    CACanorus::undo()->createUndoCommand(document(), tr("insertion of music element", "undo"));
+    // contexts changed by the insertion, the whole document is saved for undo if unknown
+    QList<CAContext*> changedContexts;
+    switch (musElementFactory()->musElementType()) {
+    case CAMusElement::Clef:
+    case CAMusElement::KeySignature:
+    case CAMusElement::TimeSignature:
+    case CAMusElement::Barline:
+    case CAMusElement::Note:
+    case CAMusElement::Rest:
+        changedContexts << staff;
+        break;
+    case CAMusElement::Mark:
+        if (v->musElementsAt(coords.x(), coords.y()).size())
+            changedContexts << v->musElementsAt(coords.x(), coords.y())[0]->musElement()->context();
+        break;
+    case CAMusElement::Slur:
+        changedContexts << staff;
+        if (v->selection().size())
+            changedContexts << v->selection().front()->musElement()->context() << v->selection().back()->musElement()->context();
+        break;
+    default:
+        break;
+    }
+    if (changedContexts.contains(nullptr))
+        changedContexts.clear();
+
+    // marks and slurs are linked to the existing elements, the whole staff is copied for them
+    bool recordElements = musElementFactory()->musElementType() != CAMusElement::Mark && musElementFactory()->musElementType() != CAMusElement::Slur;
+    CACanorus::undo()->createContextUndoCommand(document(), changedContexts, tr("insertion of music element", "undo"), recordElements);
+
+    // end of the changed music, if the music after it kept its times and needn't be synchronized
+    int syncTimeEnd = -1;
 
     switch (musElementFactory()->musElementType()) {
     case CAMusElement::Clef: {
@@ -2631,6 +2683,8 @@ bool CAMainWin::insertMusElementAt(const QPoint coords, CAScoreView* v)
     case CAMusElement::Mark: {
         if (v->musElementsAt(coords.x(), coords.y()).size())
             success = musElementFactory()->configureMark(v->musElementsAt(coords.x(), coords.y())[0]->musElement());
+        if (success)
+            syncTimeEnd = musElementFactory()->musElement()->timeEnd();
         break;
     }
     case CAMusElement::Note: { // Do we really need to do all that here??
@@ -2650,6 +2704,8 @@ bool CAMainWin::insertMusElementAt(const QPoint coords, CAScoreView* v)
                 break; // user clicked on an already placed note or wanted to place illegal length (not the one the chord is of) - return and do nothing
 
             success = musElementFactory()->configureNote(drawableStaff->calculatePitch(coords.x(), coords.y()), voice, left->musElement(), true);
+            if (success)
+                syncTimeEnd = left->musElement()->timeEnd(); // the chord length is kept
         } else if (left && left->musElement() && left->musElement()->musElementType() == CAMusElement::Rest && left->xPos() <= coords.x() && (left->width() + left->xPos() >= coords.x())) {
 
             // user clicked inside x borders of the rest - replace the rest/rests with the note
@@ -2666,6 +2722,7 @@ bool CAMainWin::insertMusElementAt(const QPoint coords, CAScoreView* v)
                 delete tuplet;
             }
 
+            int replacedTimeStart = left->musElement()->timeStart();
             int timeSum = left->musElement()->timeLength();
             int timeLength = CAPlayableLength::playableLengthToTimeLength(musElementFactory()->playableLength());
 
@@ -2695,6 +2752,9 @@ bool CAMainWin::insertMusElementAt(const QPoint coords, CAScoreView* v)
             if (success)
                 playableList.insert(tupIndex, static_cast<CAPlayable*>(musElementFactory()->musElement()));
 
+            if (success && !tuplet && timeSum >= timeLength)
+                syncTimeEnd = replacedTimeStart + timeSum; // the replaced rests were as long as the inserted note and the rests left
+
             if (success && tuplet) {
                 new CATuplet(number, actualNumber, playableList);
             }
@@ -2765,6 +2825,7 @@ bool CAMainWin::insertMusElementAt(const QPoint coords, CAScoreView* v)
                 delete tuplet;
             }
 
+            int replacedTimeStart = left->musElement()->timeStart();
             int timeSum = left->musElement()->timeLength();
             int timeLength = CAPlayableLength::playableLengthToTimeLength(musElementFactory()->playableLength());
 
@@ -2813,6 +2874,9 @@ bool CAMainWin::insertMusElementAt(const QPoint coords, CAScoreView* v)
                 playableList.insert(tupIndex, static_cast<CAPlayable*>(musElementFactory()->musElement()));
             }
 
+            if (success && !tuplet && timeSum >= timeLength)
+                syncTimeEnd = replacedTimeStart + timeSum;
+
             if (success && tuplet) {
                 new CATuplet(number, actualNumber, playableList);
             }
@@ -2891,6 +2955,8 @@ bool CAMainWin::insertMusElementAt(const QPoint coords, CAScoreView* v)
                 success = musElementFactory()->configureSlur(staff, noteStart, noteEnd);
             }
         }
+        if (success)
+            syncTimeEnd = musElementFactory()->musElement()->timeEnd(); // slurs don't change the times
         break;
     }
     case CAMusElement::FiguredBassMark: {
@@ -2937,13 +3003,21 @@ bool CAMainWin::insertMusElementAt(const QPoint coords, CAScoreView* v)
 
     if (success) {
         if (staff)
-            staff->synchronizeVoices();
+            staff->synchronizeVoices(musElementFactory()->musElement() ? musElementFactory()->musElement()->timeStart() : 0, syncTimeEnd);
 
         CACanorus::undo()->pushUndoCommand();
         if (CACanorus::settings()->useNoteChecker()) {
             _noteChecker.checkSheet(v->sheet());
         }
-        CACanorus::rebuildUI(document(), v->sheet());
+
+        // inserted notes and rests only change the music from their start on
+        int timeStart = -1, timeEnd = -1;
+        CAMusElement* elt = musElementFactory()->musElement();
+        if (elt && (elt->musElementType() == CAMusElement::Note || elt->musElementType() == CAMusElement::Rest)) {
+            timeStart = elt->timeStart();
+            timeEnd = elt->timeEnd();
+        }
+        CACanorus::rebuildUI(document(), v->sheet(), timeStart, timeEnd);
         CADrawableMusElement* d = v->selectMElement(musElementFactory()->musElement());
         musElementFactory()->emptyMusElem();
 
@@ -2992,10 +3066,20 @@ void CAMainWin::onTimeEditedTimerTimeout()
 
 /*!
 	Called when playback is finished or interrupted by the user.
-	It stops the playback, closes ports etc.
+	It stops the playback, closes ports etc. and shows the timing of the played events in the
+	status bar.
 */
 void CAMainWin::playbackFinished()
 {
+    if (_playback && _playback->timingSamples()) {
+        _permanentStatusBar->showMessage(tr("Playback timing of %1 events: mean lateness %2 ms, maximum %3 ms, drift %4 ms")
+                                             .arg(_playback->timingSamples())
+                                             .arg(_playback->meanJitter() / 1000.0, 0, 'f', 2)
+                                             .arg(_playback->maxJitter() / 1000.0, 0, 'f', 2)
+                                             .arg(_playback->drift() / 1000.0, 0, 'f', 2),
+            10000);
+    }
+
     delete _playback;
     _playback = nullptr;
     uiPlayFromSelection->setChecked(false);
@@ -3013,12 +3097,11 @@ void CAMainWin::playbackFinished()
     }
     CACanorus::midiDevice()->closeOutputPort();
 
+    _playingNotes.clear();
     if (_playbackView) {
-        static_cast<CAScoreView*>(_playbackView)->clearSelection();
-        static_cast<CAScoreView*>(_playbackView)->addToSelection(_prePlaybackSelection);
+        static_cast<CAScoreView*>(_playbackView)->setPlayingElements(_playingNotes);
         static_cast<CAScoreView*>(_playbackView)->unsetBorder();
     }
-    _prePlaybackSelection.clear();
 
     _playbackView = nullptr;
     setMode(mode());
@@ -3032,7 +3115,7 @@ void CAMainWin::on_uiPlayFromSelection_toggled(bool checked)
     if (checked && currentScoreView() && !_playback) {
         /// \todo replace raw pointer with shared or unique pointer
         _repaintTimer = new QTimer();
-        _repaintTimer->setInterval(100);
+        _repaintTimer->setInterval(40);
         _repaintTimer->start();
         //connect(_repaintTimer, SIGNAL(timeout()), this, SLOT(on_repaintTimer_timeout())); //TODO: timeout is connected directly to repaint() directly. This should be optimized in the future -Matevz
         connect(_repaintTimer, SIGNAL(timeout()), this, SLOT(onRepaintTimerTimeout()));
@@ -3053,10 +3136,7 @@ void CAMainWin::on_uiPlayFromSelection_toggled(bool checked)
         currentScoreView()->setBorder(p);
         currentScoreView()->setPlaying(true); // set the deadlock for borders
 
-        // Remember old selection
-        _prePlaybackSelection = currentScoreView()->selection();
-        currentScoreView()->clearSelection();
-
+        _playingNotes.clear();
         _playback->start();
     } else if (_playback) {
         _playback->stop();
@@ -3064,25 +3144,55 @@ void CAMainWin::on_uiPlayFromSelection_toggled(bool checked)
 }
 
 /*!
-	Called every few miliseconds during playback to repaint score View as the GUI can
-	only be repainted from the main thread.
+	Called every few miliseconds during playback to update the playback cursor in the score View
+	as the GUI can only be repainted from the main thread.
+
+	The started and stopped notes are taken from the playback's lock-free queue, so the
+	playback thread is never blocked and the selection is left intact. If the queue overflowed,
+	the highlighted notes are cleared, because some of their stop events were lost.
 */
 void CAMainWin::onRepaintTimerTimeout()
 {
-    CAScoreView* sv = static_cast<CAScoreView*>(_playbackView);
-    sv->clearSelection();
-    for (int i = 0; i < _playback->curPlaying().size(); i++) {
-        if (_playback->curPlaying().at(i)->musElementType() == CAMusElement::Note) {
-            CADrawableMusElement* elt = sv->addToSelection(_playback->curPlaying()[i]);
-            if (CACanorus::settings()->lockScrollPlayback()) {
-                if (elt && (elt->xPos() > (sv->worldX() + sv->worldWidth()) || elt->xPos() < sv->worldX())) {
-                    sv->setWorldX(elt->xPos() - 50, CACanorus::settings()->animatedScroll());
-                }
-            }
+    if (!_playback || !_playbackView) {
+        return;
+    }
+
+    bool changed = false;
+    int dropped = _playback->playingQueue().takeDropped();
+    CAPlaybackQueue::CAPlayingEvent e;
+    while (_playback->playingQueue().pop(e)) {
+        if (e.playable->musElementType() != CAMusElement::Note) {
+            continue;
         }
+
+        if (e.on) {
+            _playingNotes << e.playable;
+        } else {
+            _playingNotes.removeOne(e.playable);
+        }
+        changed = true;
     }
 
-    sv->repaint();
+    if (dropped) {
+        qWarning() << "Playback: dropped" << dropped << "playback cursor events, clearing the highlighted notes";
+        _playingNotes.clear();
+        changed = true;
+    }
+
+    if (!changed) {
+        return;
+    }
+
+    CAScoreView* sv = static_cast<CAScoreView*>(_playbackView);
+    sv->setPlayingElements(_playingNotes);
+
+    if (CACanorus::settings()->lockScrollPlayback() && _playingNotes.size()) {
+        double x = sv->timeToCoords(_playingNotes.last()->timeStart());
+        if (x >= 0 && (x > (sv->worldX() + sv->worldWidth()) || x < sv->worldX())) {
+            sv->setWorldX(x - 50, CACanorus::settings()->animatedScroll());
+            sv->repaint();
+        }
+    }
 }
 
 void CAMainWin::on_uiLockScrollPlayback_toggled(bool val)
@@ -3629,9 +3739,11 @@ void CAMainWin::on_uiVoiceName_returnPressed()
 {
     CAVoice* voice = currentVoice();
     if (voice) {
-        CACanorus::undo()->createUndoCommand(document(), tr("change voice name", "undo"));
-        CACanorus::undo()->pushUndoCommand();
+        CACanorus::undo()->createDeltaUndoCommand(document(), tr("change voice name", "undo"));
+        QString oldName = voice->name();
         voice->setName(uiVoiceName->text());
+        CACanorus::undo()->addDelta(new CANameDelta(voice, oldName));
+        CACanorus::undo()->pushUndoCommand();
         CACanorus::rebuildUI(document(), currentSheet());
     }
 }
@@ -3700,7 +3812,7 @@ void CAMainWin::on_uiPlayableLength_toggled(bool, int buttonId)
         }
     } else if (mode() == EditMode && currentScoreView() && currentScoreView()->selection().size()) {
         CAScoreView* v = currentScoreView();
-        CACanorus::undo()->createUndoCommand(document(), tr("change playable length", "undo"));
+        CACanorus::undo()->createContextUndoCommand(document(), v->selectionContexts(), tr("change playable length", "undo"));
 
         for (int i = 0; i < v->selection().size(); i++) {
             CAPlayable* p = dynamic_cast<CAPlayable*>(v->selection().at(i)->musElement());
@@ -3735,7 +3847,7 @@ void CAMainWin::on_uiPlayableLength_toggled(bool, int buttonId)
                         p->voice()->insert(next, rests[i]); // insert rests from shortest to longest
                     }
                 } else {
-                    p->staff()->synchronizeVoices();
+                    p->staff()->synchronizeVoices(p->timeStart());
                 }
 
                 for (int j = 0; j < p->voice()->lyricsContextList().size(); j++) { // reposit syllables
@@ -4610,9 +4722,11 @@ void CAMainWin::on_uiSheetName_returnPressed()
 {
     CASheet* sheet = currentSheet();
     if (sheet) {
-        CACanorus::undo()->createUndoCommand(document(), tr("change sheet name", "undo"));
-        CACanorus::undo()->pushUndoCommand();
+        CACanorus::undo()->createDeltaUndoCommand(document(), tr("change sheet name", "undo"));
+        QString oldName = sheet->name();
         sheet->setName(uiSheetName->text());
+        CACanorus::undo()->addDelta(new CANameDelta(sheet, oldName));
+        CACanorus::undo()->pushUndoCommand();
         CACanorus::rebuildUI(document(), currentSheet());
     }
 }
@@ -4632,9 +4746,11 @@ void CAMainWin::on_uiContextName_returnPressed()
 {
     CAContext* context = currentContext();
     if (context) {
-        CACanorus::undo()->createUndoCommand(document(), tr("change context name", "undo"));
-        CACanorus::undo()->pushUndoCommand();
+        CACanorus::undo()->createDeltaUndoCommand(document(), tr("change context name", "undo"));
+        QString oldName = context->name();
         context->setName(uiContextName->text());
+        CACanorus::undo()->addDelta(new CANameDelta(context, oldName));
+        CACanorus::undo()->pushUndoCommand();
         CACanorus::rebuildUI(document(), currentSheet());
     }
 }
@@ -4678,11 +4794,13 @@ void CAMainWin::on_uiVoiceStemDirection_toggled(bool, int direction)
 {
     CAVoice* voice = currentVoice();
     if (voice) {
-        CACanorus::undo()->createUndoCommand(document(), tr("change voice stem direction", "undo"));
-        if (voice->stemDirection() != static_cast<CANote::CAStemDirection>(direction))
+        CACanorus::undo()->createDeltaUndoCommand(document(), tr("change voice stem direction", "undo"));
+        if (voice->stemDirection() != static_cast<CANote::CAStemDirection>(direction)) {
+            CANote::CAStemDirection oldDirection = voice->stemDirection();
+            voice->setStemDirection(static_cast<CANote::CAStemDirection>(direction));
+            CACanorus::undo()->addDelta(new CAVoiceStemDirectionDelta(voice, oldDirection));
             CACanorus::undo()->pushUndoCommand();
-        CACanorus::undo()->pushUndoCommand();
-        voice->setStemDirection(static_cast<CANote::CAStemDirection>(direction));
+        }
         CACanorus::rebuildUI(document(), currentSheet());
     }
 }
@@ -4696,13 +4814,15 @@ void CAMainWin::on_uiNoteStemDirection_toggled(bool, int id)
     if (mode() == InsertMode)
         musElementFactory()->setNoteStemDirection(direction);
     else if (mode() == EditMode) {
-        CACanorus::undo()->createUndoCommand(document(), tr("change note stem direction", "undo"));
+        CACanorus::undo()->createDeltaUndoCommand(document(), tr("change note stem direction", "undo"));
         CAScoreView* v = currentScoreView();
         bool changed = false;
         for (int i = 0; v && i < v->selection().size(); i++) {
             CANote* note = dynamic_cast<CANote*>(v->selection().at(i)->musElement());
             if (note) {
+                CANote::CAStemDirection oldDirection = note->stemDirection();
                 note->setStemDirection(direction);
+                CACanorus::undo()->addDelta(new CANoteStemDirectionDelta(note, oldDirection));
                 changed = true;
             }
         }
@@ -5350,7 +5470,7 @@ void CAMainWin::on_uiCut_triggered()
 {
     if (currentScoreView()) {
         stopPlayback();
-        CACanorus::undo()->createUndoCommand(document(), tr("cut", "undo"));
+        CACanorus::undo()->createContextUndoCommand(document(), currentScoreView()->selectionContexts(), tr("cut", "undo"));
         copySelection(currentScoreView());
         deleteSelection(currentScoreView(), false, true, false); // and don't make undo as we already make it
         CACanorus::undo()->pushUndoCommand();
@@ -5527,7 +5647,7 @@ void CAMainWin::deleteSelection(CAScoreView* v, bool deleteSyllables, bool delet
 {
     if (v->selection().size()) {
         if (doUndo)
-            CACanorus::undo()->createUndoCommand(document(), tr("deletion of elements", "undo"));
+            CACanorus::undo()->createContextUndoCommand(document(), v->selectionContexts(), tr("deletion of elements", "undo"));
 
         QSet<CAMusElement*> musElemSet;
         QHash<CAFiguredBassMark*, QList<int>> numbersToDelete;
@@ -5687,8 +5807,8 @@ void CAMainWin::deleteSelection(CAScoreView* v, bool deleteSyllables, bool delet
                     }
                 }
 
-                // stop the playback before deleting the note
-                if (_playback && _playback->curPlaying().contains(p)) {
+                // stop the playback before deleting the note, the playback timeline refers to it
+                if (_playback && _playback->isRunning()) {
                     _playback->stopNow();
                 }
 
@@ -5836,7 +5956,7 @@ void CAMainWin::pasteAt(const QPoint coords, CAScoreView* v)
                     CASlur* tie = leftNote ? leftNote->tieStart() : nullptr;
 
                     if (tie) {
-                        if (tie->noteEnd() && staff->voiceList()[i]->musElementList().contains(tie->noteEnd()))
+                        if (tie->noteEnd() && staff->voiceList()[i]->musElementIndex(tie->noteEnd()) != -1)
                             // pasting between two tied notes - remove tie
                             delete tie; // resets notes' tieStart/tieEnd;
                         else {
@@ -6219,6 +6339,23 @@ void CAMainWin::playImmediately(QList<CAMusElement*> elements)
     _playback->playImmediately(elements, CACanorus::settings()->midiOutPort());
 }
 
+/*!
+	Rebuilds the current sheet after the pitch of the given notes \a elements was changed.
+	Only the bars containing the changed notes are repositioned, if possible.
+ */
+void CAMainWin::rebuildUIAfterPitchChange(QList<CAMusElement*> elements)
+{
+    int timeStart = -1, timeEnd = -1;
+    for (int i = 0; i < elements.size(); i++) {
+        if (timeStart == -1 || elements[i]->timeStart() < timeStart)
+            timeStart = elements[i]->timeStart();
+        if (elements[i]->timeEnd() > timeEnd)
+            timeEnd = elements[i]->timeEnd();
+    }
+
+    CACanorus::rebuildUI(document(), currentSheet(), timeStart, timeEnd);
+}
+
 /*!
 	\var CADocument *CAMainWin::_document
 	Pointer to the main window's document it represents.
@@ -6251,8 +6388,8 @@ void CAMainWin::playImmediately(QList<CAMusElement*> elements)
 
 /*!
 	\var QTimer* CACanorus::_repaintTimer
-	Used when playback is active to repaint the playback View.
-	\todo View should be repainted only when needed, not constantly as now. This should result in much less resource hunger.
+	Used when playback is active to update the playback cursor of the playback View.
+	The View is only repainted, when the playing notes changed.
 */
 
 /*!
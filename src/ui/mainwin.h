@@ -92,7 +92,7 @@ public:
     ~CAMainWin();
 
     void clearUI();
-    void rebuildUI(CASheet* sheet, bool repaint = true);
+    void rebuildUI(CASheet* sheet, bool repaint = true, int timeStart = -1, int timeEnd = -1);
     void rebuildUI(bool repaint = true);
     inline bool rebuildUILock() { return _rebuildUILock; }
     void updateWindowTitle();
@@ -359,6 +359,7 @@ private slots:
 
 private:
     void playImmediately(QList<CAMusElement*> elements);
+    void rebuildUIAfterPitchChange(QList<CAMusElement*> elements);
 
     ////////////////////////
     // General properties //
@@ -394,7 +395,7 @@ private:
     int _iNumAllowed;
     CAView* _currentView;
     CAView* _playbackView;
-    QList<CADrawableMusElement*> _prePlaybackSelection;
+    QList<CAMusElement*> _playingNotes; // Notes currently highlighted by the playback cursor
     QTimer* _repaintTimer;
     bool _rebuildUILock;
     inline void setRebuildUILock(bool l) { _rebuildUILock = l; }
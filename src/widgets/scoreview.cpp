@@ -8,14 +8,19 @@
 #include <QBrush>
 #include <QColor>
 #include <QDebug>
+#include <QFontMetrics>
 #include <QGridLayout>
 #include <QMouseEvent>
+#include <QPaintEvent>
 #include <QPainter>
 #include <QPalette>
 #include <QScrollBar>
+#include <QSet>
 #include <QTimer>
 #include <QWheelEvent>
+#include <QtMath>
 
+#include <algorithm>
 #include <math.h> // needed for square root in animated scrolls/zoom
 
 #include <iostream>
@@ -31,6 +36,7 @@
 #include "layout/drawabletimesignature.h"
 #include "layout/layoutengine.h"
 #include "widgets/scoreview.h"
+#include "widgets/tilecache.h"
 
 #include "score/barline.h"
 #include "score/bookmark.h"
@@ -42,6 +48,7 @@
 #include "score/note.h"
 #include "score/rest.h"
 #include "score/sheet.h"
+#include "score/slur.h"
 #include "score/staff.h"
 #include "score/syllable.h"
 #include "score/text.h"
@@ -56,6 +63,7 @@ const int CAScoreView::BOTTOM_EXTRA_SPACE = 30; // Gives some space after the mu
 const int CAScoreView::RULER_HEIGHT = 15;
 const int CAScoreView::ANIMATION_STEPS = 7;
 const int CAScoreView::SELECTION_REGION_THRESHOLD = 10;
+const int CAScoreView::TILE_MARGIN = 20; // World units around a tile whose elements are painted onto it as well
 
 /*!
 	\class CATextEdit
@@ -127,6 +135,10 @@ void CAScoreView::initScoreView(CASheet* sheet)
 {
     setViewType(ScoreView);
 
+    _sheetLayout = nullptr;
+    _layoutDetached = false;
+    _detachedContextIdx = -1;
+    _shadowNoteLength = CAPlayableLength(CAPlayableLength::Quarter);
     setSheet(sheet);
     _worldX = _worldY = 0;
     _worldW = _worldH = 0;
@@ -152,6 +164,7 @@ void CAScoreView::initScoreView(CASheet* sheet)
     _canvas = new QWidget(this);
     setMouseTracking(true);
     _repaintArea = nullptr;
+    _tileCache = new CATileCache(this);
 
     // init animation stuff
     _animationTimer = new QTimer(this);
@@ -208,16 +221,15 @@ void CAScoreView::initScoreView(CASheet* sheet)
 
 CAScoreView::~CAScoreView()
 {
-    // Delete the drawable elements/contexts
-    _drawableMList.clear(true);
-    _drawableCList.clear(true);
-    _drawableNCEList.clear(true);
-
     while (!_shadowNote.isEmpty()) {
         delete _shadowNote.takeFirst();
         delete _shadowDrawableNote.takeFirst(); // same size
     }
 
+    // Stop rendering the tiles first. The drawable elements/contexts are deleted with the last view of the sheet
+    delete _tileCache;
+    _sheetLayout->detach(this);
+
     _animationTimer->disconnect();
     _animationTimer->stop();
     delete _animationTimer;
@@ -277,46 +289,136 @@ CAScoreView* CAScoreView::clone(QWidget* parent)
 }
 
 /*!
-	Adds a drawable music element \a elt to the score view and selects it, if \a select is true.
+	Adds a drawable music element \a elt to the shared layout and selects it, if \a select is true.
 */
-
 void CAScoreView::addMElement(CADrawableMusElement* elt, bool select)
 {
-    _drawableMList.addElement(elt);
-    _mapDrawable.insertMulti(elt->musElement(), elt);
+    _sheetLayout->addMElement(elt);
     if (select) {
-        _selection.clear();
+        resetSelection();
         addToSelection(elt);
     }
-
-    elt->drawableContext()->addMElement(elt);
-    emit selectionChanged();
 }
 
 /*!
-	Adds a drawable music element \a elt to the score view and selects it, if \a select is true.
+	Adds a drawable context \a elt to the shared layout and sets it as the current context, if
+	\a select is true.
 */
 void CAScoreView::addCElement(CADrawableContext* elt, bool select)
 {
-    _drawableCList.addElement(elt);
-    _mapDrawable.insertMulti(elt->context(), elt);
+    _sheetLayout->addCElement(elt);
 
     if (select)
         setCurrentContext(elt);
+}
 
-    if (elt->drawableContextType() == CADrawableContext::DrawableStaff && static_cast<CAStaff*>(elt->context())->voiceList().size()) {
-        _shadowNote << new CANote(CADiatonicPitch(), CAPlayableLength(CAPlayableLength::Quarter, 0), static_cast<CAStaff*>(elt->context())->voiceList()[0], 0);
-        _shadowDrawableNote << new CADrawableNote(_shadowNote.back(), elt, 0, 0, true);
+/*!
+	Sets the sheet \a sheet shown by the view and attaches the view to its shared layout.
+	The view shows the new sheet after the next rebuild().
+*/
+void CAScoreView::setSheet(CASheet* sheet)
+{
+    if (_sheetLayout) {
+        if (_sheetLayout->sheet() == sheet) {
+            return;
+        }
+
+        aboutToClearLayout();
+        _sheetLayout->detach(this);
     }
+
+    _sheet = sheet;
+    _sheetLayout = CASheetLayout::attach(sheet, this);
+    _layoutGeneration = -1;
 }
 
 /*!
-	Adds a drawable music element \a elt to the score view and selects it, if \a select is true.
+	Remembers the selection and the current context as music elements and contexts, before the
+	drawable elements are changed by the layout. They are restored in syncWithLayout().
 */
-void CAScoreView::addDrawableNoteCheckerError(CADrawableNoteCheckerError* dnce)
+void CAScoreView::detachFromLayout()
 {
-    _drawableNCEList.addElement(dnce);
-    _mapDrawable.insertMulti(nullptr, dnce);
+    if (!_layoutDetached) {
+        _detachedSelection = musElementSelection();
+        _detachedContextIdx = (_currentContext ? _sheetLayout->drawableCList().list().indexOf(_currentContext) : -1);
+        _layoutDetached = true;
+    }
+}
+
+/*!
+	Called by the shared layout before all its drawable elements are deleted.
+	Drops the selection, the current context and the shadow notes which point to them.
+*/
+void CAScoreView::aboutToClearLayout()
+{
+    _tileCache->cancel();
+    detachFromLayout();
+    resetSelection();
+    _drawableStates.clear();
+    _currentContext = nullptr;
+
+    for (int i = 0; i < _shadowNote.size(); i++) {
+        delete _shadowDrawableNote[i];
+        _shadowNoteLength = _shadowNote[i]->playableLength();
+        delete _shadowNote[i];
+    }
+    _shadowNote.clear();
+    _shadowDrawableNote.clear();
+
+    _tileCache->invalidate();
+}
+
+/*!
+	Called by the shared layout before the \a taken drawable elements are removed.
+	\a minX is the left border of the leftmost taken element.
+*/
+void CAScoreView::aboutToTakeMElements(const QSet<CADrawableMusElement*>& taken, double minX)
+{
+    _tileCache->cancel();
+    detachFromLayout();
+
+    for (int i = _selection.size() - 1; i >= 0; i--) {
+        if (taken.contains(_selection[i])) {
+            _selection.removeAt(i);
+        }
+    }
+    _drawableStates.resize(qMin(_drawableStates.size(), _sheetLayout->drawableMOrder().size())); // drop the states of the taken elements
+
+    // new elements may reuse the addresses of the taken ones
+    _tileCache->invalidateRight(minX - TILE_MARGIN);
+}
+
+/*!
+	Updates the view after the shared layout was finished by this or another view of the sheet.
+	Recreates the shadow notes and restores the selection and the current context.
+*/
+void CAScoreView::syncWithLayout()
+{
+    QList<CADrawableContext*> contexts = _sheetLayout->drawableCList().list();
+    if (_shadowNote.isEmpty()) {
+        for (int i = 0; i < contexts.size(); i++) {
+            if (contexts[i]->drawableContextType() == CADrawableContext::DrawableStaff && static_cast<CAStaff*>(contexts[i]->context())->voiceList().size()) {
+                _shadowNote << new CANote(CADiatonicPitch(), _shadowNoteLength, static_cast<CAStaff*>(contexts[i]->context())->voiceList()[0], 0);
+                _shadowDrawableNote << new CADrawableNote(_shadowNote.back(), contexts[i], 0, 0, true);
+            }
+        }
+    }
+
+    QList<CAMusElement*> musElementSelection = (_layoutDetached ? _detachedSelection : this->musElementSelection());
+    if (_layoutDetached) {
+        if (!_currentContext && _detachedContextIdx != -1 && _detachedContextIdx < contexts.size()) // restore the last used context
+            setCurrentContext(contexts[_detachedContextIdx]);
+        _detachedSelection.clear();
+        _layoutDetached = false;
+    }
+
+    updateDrawableStates(_drawableStates.size()); // states of the elements placed since the last sync
+    resetSelection();
+    addToSelection(musElementSelection);
+
+    setWorldCoords(worldCoords()); // needed to update the scrollbars
+    checkScrollBars();
+    updateHelpers();
 }
 
 /*!
@@ -334,7 +436,7 @@ CADrawableContext* CAScoreView::selectContext(CAContext* context)
         return nullptr;
     }
 
-    QList<CADrawableContext*> drawableContexts = _drawableCList.list();
+    QList<CADrawableContext*> drawableContexts = _sheetLayout->drawableCList().list();
     for (int i = 0; i < drawableContexts.size(); i++) {
         CAContext* c = drawableContexts[i]->context();
         if (c == context) {
@@ -353,7 +455,7 @@ void CAScoreView::setLastMousePressCoordsAfter(const QList<CAMusElement*> list)
 {
     double maxX = 0;
     for (int i = 0; i < list.size(); i++) {
-        QList<CADrawable*> drawables = _mapDrawable.values(list[i]);
+        QList<CADrawable*> drawables = _sheetLayout->mapDrawable().values(list[i]);
         for (int j = 0; j < drawables.size(); j++) {
             maxX = qMax(drawables[j]->xPos() + drawables[j]->width(), maxX);
         }
@@ -374,7 +476,7 @@ void CAScoreView::setLastMousePressCoordsAfter(const QList<CAMusElement*> list)
 */
 CADrawableContext* CAScoreView::selectCElement(double x, double y)
 {
-    QList<CADrawableContext*> l = _drawableCList.findInRange(x, y);
+    QList<CADrawableContext*> l = _sheetLayout->drawableCList().findInRange(x, y);
 
     if (l.size() != 0) {
         setCurrentContext(l.front());
@@ -393,7 +495,7 @@ CADrawableContext* CAScoreView::selectCElement(double x, double y)
 */
 QList<CADrawableMusElement*> CAScoreView::musElementsAt(double x, double y)
 {
-    QList<CADrawableMusElement*> l = _drawableMList.findInRange(x, y);
+    QList<CADrawableMusElement*> l = _sheetLayout->drawableMList().findInRange(x, y);
     for (int i = 0; i < l.size(); i++)
         if (!l[i]->isSelectable() || (selectedVoice() && l[i]->musElement() && l[i]->musElement()->isPlayable() && static_cast<CAPlayable*>(l[i]->musElement())->voice() != selectedVoice()))
             l.removeAt(i--);
@@ -411,9 +513,9 @@ QList<CADrawableMusElement*> CAScoreView::musElementsAt(double x, double y)
 */
 CADrawableMusElement* CAScoreView::selectMElement(CAMusElement* elt)
 {
-    _selection.clear();
+    resetSelection();
 
-    QList<CADrawable*> drawables = _mapDrawable.values(elt);
+    QList<CADrawable*> drawables = _sheetLayout->mapDrawable().values(elt);
     for (int i = 0; i < drawables.size(); i++) {
         if (drawables[i]->drawableType() == CADrawable::DrawableMusElement && static_cast<CADrawableMusElement*>(drawables[i])->musElement() == elt && drawables[i]->isSelectable()) {
             addToSelection(static_cast<CADrawableMusElement*>(drawables[i]));
@@ -428,34 +530,6 @@ CADrawableMusElement* CAScoreView::selectMElement(CAMusElement* elt)
         return nullptr;
 }
 
-/**!
- * This function clones the given drawable instances of musElements and contexts.
- * 
- * \obsolete This Function was used in the past when cloning the views to also clone the
- * elements. This behaviour was replaced for creating a new drawable instances
- * from the scene from scratch.
- */
-void CAScoreView::importElements(CAKDTree<CADrawableMusElement*>* origDMusElts, CAKDTree<CADrawableContext*>* origDContexts)
-{
-    QList<CADrawableContext*> drawableContexts = origDContexts->list();
-    for (int i = 0; i < drawableContexts.size(); i++) {
-        addCElement(drawableContexts[i]->clone());
-    }
-    QList<CADrawableContext*> newDrawableContexts = _drawableCList.list();
-
-    QList<CADrawableMusElement*> drawableMusElements = origDMusElts->list();
-    for (int i = 0; i < drawableMusElements.size(); i++) {
-        int idx = drawableContexts.indexOf(drawableMusElements[i]->drawableContext());
-        if (idx == -1) {
-            std::cerr << "ERROR: Music element " << drawableMusElements[i] << " does not have a drawable context!" << std::endl;
-        } else if (newDrawableContexts.size() <= idx) {
-            std::cerr << "ERROR: Index out of range. " << newDrawableContexts.size() << " new drawable contexts created. Request for idx=" << idx << std::endl;
-        } else {
-            addMElement(drawableMusElements[i]->clone(newDrawableContexts[idx]));
-        }
-    }
-}
-
 /*!
 	Returns a pointer to the nearest drawable music element left of the current coordinates with the largest startTime.
 	Drawable elements left borders are taken into account.
@@ -463,7 +537,7 @@ void CAScoreView::importElements(CAKDTree<CADrawableMusElement*>* origDMusElts,
 */
 CADrawableMusElement* CAScoreView::nearestLeftElement(double x, double, CADrawableContext* context)
 {
-    return _drawableMList.findNearestLeft(x, true, context);
+    return _sheetLayout->drawableMList().findNearestLeft(x, true, context);
 }
 
 /*!
@@ -473,7 +547,7 @@ CADrawableMusElement* CAScoreView::nearestLeftElement(double x, double, CADrawab
 */
 CADrawableMusElement* CAScoreView::nearestLeftElement(double x, double, CAVoice* voice)
 {
-    return _drawableMList.findNearestLeft(x, true, nullptr, voice);
+    return _sheetLayout->drawableMList().findNearestLeft(x, true, nullptr, voice);
 }
 
 /*!
@@ -483,7 +557,7 @@ CADrawableMusElement* CAScoreView::nearestLeftElement(double x, double, CAVoice*
 */
 CADrawableMusElement* CAScoreView::nearestRightElement(double x, double, CADrawableContext* context)
 {
-    return _drawableMList.findNearestRight(x, true, context);
+    return _sheetLayout->drawableMList().findNearestRight(x, true, context);
 }
 
 /*!
@@ -493,7 +567,7 @@ CADrawableMusElement* CAScoreView::nearestRightElement(double x, double, CADrawa
 */
 CADrawableMusElement* CAScoreView::nearestRightElement(double x, double, CAVoice* voice)
 {
-    return _drawableMList.findNearestRight(x, true, nullptr, voice);
+    return _sheetLayout->drawableMList().findNearestRight(x, true, nullptr, voice);
 }
 
 /*!
@@ -502,7 +576,7 @@ CADrawableMusElement* CAScoreView::nearestRightElement(double x, double, CAVoice
 */
 CADrawableContext* CAScoreView::nearestUpContext(double, double y)
 {
-    return static_cast<CADrawableContext*>(_drawableCList.findNearestUp(y));
+    return static_cast<CADrawableContext*>(_sheetLayout->drawableCList().findNearestUp(y));
 }
 
 /*!
@@ -511,7 +585,7 @@ CADrawableContext* CAScoreView::nearestUpContext(double, double y)
 */
 CADrawableContext* CAScoreView::nearestDownContext(double, double y)
 {
-    return static_cast<CADrawableContext*>(_drawableCList.findNearestDown(y));
+    return static_cast<CADrawableContext*>(_sheetLayout->drawableCList().findNearestDown(y));
 }
 
 /*!
@@ -519,8 +593,8 @@ CADrawableContext* CAScoreView::nearestDownContext(double, double y)
 */
 int CAScoreView::calculateTime(double x, double)
 {
-    CADrawableMusElement* left = _drawableMList.findNearestLeft(x, true);
-    CADrawableMusElement* right = _drawableMList.findNearestRight(x, true);
+    CADrawableMusElement* left = _sheetLayout->drawableMList().findNearestLeft(x, true);
+    CADrawableMusElement* right = _sheetLayout->drawableMList().findNearestRight(x, true);
 
     if (left) //the user clicked right of the element - return the nearest left element end time
         return left->musElement()->timeStart() + left->musElement()->timeLength();
@@ -534,16 +608,24 @@ int CAScoreView::calculateTime(double x, double)
 	Creates a map of a bar number -> drawable barline in the score of a staff
 	with most barlines and enumerates them.
 
-	This function is usually called when drawing a ruler or jumping to specific bar.
+	This function is usually called when jumping to specific bar. Without dotted barlines, the
+	map is created out of the bar index built by updateTimeIndex().
 
 	\param dotted Also include dotted barlines in the list (which are usually ignored in the bar count)
 	\return Map of bar number -> drawable barline of the staff with most barlines
 */
 QMap<int, CADrawableBarline*> CAScoreView::computeBarlinePositions(bool dotted)
 {
-    QList<CADrawableContext*> dContextList = _drawableCList.list();
+    QList<CADrawableContext*> dContextList = _sheetLayout->drawableCList().list();
     QMap<int, CADrawableBarline*> result;
 
+    if (!dotted) {
+        for (int i = 0; i < _sheetLayout->barIndex().size(); i++) {
+            result[_sheetLayout->firstBarNumber() + i] = _sheetLayout->barIndex()[i];
+        }
+        return result;
+    }
+
     // determine staff with most barlines
     CADrawableStaff* dStaff = nullptr;
     for (int i = 0; i < dContextList.size(); i++) {
@@ -557,18 +639,7 @@ QMap<int, CADrawableBarline*> CAScoreView::computeBarlinePositions(bool dotted)
     }
 
     QList<CADrawableBarline*> drawableBarlineList = dStaff->drawableBarlineList();
-
-    // remove dotted barlines, if dotted=false
-    if (!dotted) {
-        for (int i = 0; i < drawableBarlineList.size(); i++) { // filter out dotted barlines
-            if (drawableBarlineList[i]->barline()->barlineType() == CABarline::Dotted) {
-                drawableBarlineList.removeAt(i);
-                i--;
-            }
-        }
-    }
-
-    if (dStaff && !drawableBarlineList.isEmpty()) {
+    if (!drawableBarlineList.isEmpty()) {
         // determine the bar number + do we have a pickup measure in the beginning
         CADrawableTimeSignature* firstDTimeSig = (dStaff->drawableTimeSignatureList().size() ? dStaff->drawableTimeSignatureList()[0] : nullptr);
         int barlineOffset = 2;
@@ -589,7 +660,7 @@ QMap<int, CADrawableBarline*> CAScoreView::computeBarlinePositions(bool dotted)
 */
 CAContext* CAScoreView::contextCollision(double x, double y)
 {
-    QList<CADrawableContext*> l = _drawableCList.findInRange(x, y, 0, 0);
+    QList<CADrawableContext*> l = _sheetLayout->drawableCList().findInRange(x, y, 0, 0);
     if (l.size() == 0) {
         return nullptr;
     } else {
@@ -601,49 +672,48 @@ CAContext* CAScoreView::contextCollision(double x, double y)
 /*!
 	Calls the engraver to reposition the music elements on the canvas.
 	Also updates scrollbars.
+
+	The drawable elements are shared by all the views of the sheet (see CASheetLayout). If another
+	view already laid the sheet out for the current document revision since this view was rebuilt
+	the last time, the view only synchronizes with its result. Rebuilding the same view again
+	always repositions the elements.
  */
 void CAScoreView::rebuild()
 {
-    // clear the shadow notes
-    CAPlayableLength l(CAPlayableLength::Quarter);
-    for (int i = 0; i < _shadowNote.size(); i++) {
-        delete _shadowDrawableNote[i];
-        l = _shadowNote[i]->playableLength();
-        delete _shadowNote[i];
-    }
-    _shadowNote.clear();
-    _shadowDrawableNote.clear();
-
-    QList<CAMusElement*> musElementSelection;
-    for (int i = 0; i < _selection.size(); i++) {
-        if (!musElementSelection.contains(_selection[i]->musElement()))
-            musElementSelection << _selection[i]->musElement();
+    if (layoutNeeded()) {
+        _sheetLayout->clear();
+        CALayoutEngine::reposit(this);
+        _sheetLayout->finishLayout(); // synchronizes all the views of the sheet
+    } else {
+        syncWithLayout();
     }
 
-    _selection.clear();
-
-    _drawableMList.clear(true);
-    int contextIdx = (_currentContext ? _drawableCList.list().indexOf(_currentContext) : -1); // remember the index of last used context
-    _drawableCList.clear(true);
-    _drawableNCEList.clear(true);
-    _mapDrawable.clear();
+    _layoutGeneration = _sheetLayout->generation();
+}
 
-    CALayoutEngine::reposit(this);
+/*!
+	Repositions only the music elements starting at \a timeStart and keeps the ones before.
+	If \a timeEnd is given, the music after it is assumed unchanged and its drawable elements
+	are shifted instead of being recreated, where possible.
+	Falls back to the full rebuild(), if the layout cannot be resumed or the memory of the
+	replaced drawable elements should be reclaimed (see CADrawableArena::isFragmented()).
 
-    for (int i = 0; i < _shadowNote.size(); i++) {
-        _shadowNote[i]->setPlayableLength(l);
+	\sa CALayoutEngine::reposit(CAScoreView*, int, int)
+ */
+void CAScoreView::rebuild(int timeStart, int timeEnd)
+{
+    if (layoutNeeded()) {
+        if (_sheetLayout->arena().isFragmented() || !CALayoutEngine::reposit(this, timeStart, timeEnd)) {
+            _layoutGeneration = _sheetLayout->generation(); // force the full layout
+            rebuild();
+            return;
+        }
+        _sheetLayout->finishLayout();
+    } else {
+        syncWithLayout();
     }
 
-    if (contextIdx != -1) // restore the last used context
-        setCurrentContext(static_cast<CADrawableContext*>((_drawableCList.size() > contextIdx) ? _drawableCList.list().at(contextIdx) : nullptr));
-    else
-        setCurrentContext(nullptr);
-
-    addToSelection(musElementSelection);
-
-    setWorldCoords(worldCoords()); // needed to update the scrollbars
-    checkScrollBars();
-    updateHelpers();
+    _layoutGeneration = _sheetLayout->generation();
 }
 
 /*!
@@ -655,7 +725,7 @@ void CAScoreView::rebuild()
 void CAScoreView::setWorldX(double x, bool animate, bool force)
 {
     if (!force) {
-        double maxX = (getMaxXExtended(_drawableMList) > getMaxXExtended(_drawableCList)) ? getMaxXExtended(_drawableMList) : getMaxXExtended(_drawableCList);
+        double maxX = (getMaxXExtended(_sheetLayout->drawableMList()) > getMaxXExtended(_sheetLayout->drawableCList())) ? getMaxXExtended(_sheetLayout->drawableMList()) : getMaxXExtended(_sheetLayout->drawableCList());
         if (x > maxX - _worldW)
             x = maxX - _worldW;
         if (x < 0)
@@ -689,7 +759,7 @@ void CAScoreView::setWorldX(double x, bool animate, bool force)
 void CAScoreView::setWorldY(double y, bool animate, bool force)
 {
     if (!force) {
-        int maxY = getMaxYExtended(_drawableMList) > getMaxYExtended(_drawableCList) ? getMaxYExtended(_drawableMList) : getMaxYExtended(_drawableCList);
+        int maxY = getMaxYExtended(_sheetLayout->drawableMList()) > getMaxYExtended(_sheetLayout->drawableCList()) ? getMaxYExtended(_sheetLayout->drawableMList()) : getMaxYExtended(_sheetLayout->drawableCList());
         if (y > maxY - _worldH)
             y = maxY - _worldH;
         if (y < 0)
@@ -731,7 +801,7 @@ void CAScoreView::setWorldWidth(double w, bool force)
     _worldW = w;
 
     double scrollMax;
-    if ((scrollMax = ((getMaxXExtended(_drawableMList) > getMaxXExtended(_drawableCList)) ? getMaxXExtended(_drawableMList) : getMaxXExtended(_drawableCList)) - _worldW) >= 0) {
+    if ((scrollMax = ((getMaxXExtended(_sheetLayout->drawableMList()) > getMaxXExtended(_sheetLayout->drawableCList())) ? getMaxXExtended(_sheetLayout->drawableMList()) : getMaxXExtended(_sheetLayout->drawableCList())) - _worldW) >= 0) {
         if (scrollMax < _worldX) //if you resize the widget at a large zoom level and if the getMax border has been reached
             setWorldX(scrollMax); //scroll the view away from the border
 
@@ -763,7 +833,7 @@ void CAScoreView::setWorldHeight(double h, bool force)
     _worldH = h;
 
     double scrollMax;
-    if ((scrollMax = ((getMaxYExtended(_drawableMList) > getMaxYExtended(_drawableCList)) ? getMaxYExtended(_drawableMList) : getMaxYExtended(_drawableCList)) - _worldH) >= 0) {
+    if ((scrollMax = ((getMaxYExtended(_sheetLayout->drawableMList()) > getMaxYExtended(_sheetLayout->drawableCList())) ? getMaxYExtended(_sheetLayout->drawableMList()) : getMaxYExtended(_sheetLayout->drawableCList())) - _worldH) >= 0) {
         if (scrollMax < _worldY) //if you resize the widget at a large zoom level and if the getMax border has been reached
             setWorldY(scrollMax); //scroll the view away from the border
 
@@ -851,20 +921,20 @@ void CAScoreView::zoomToSelection(bool animate, bool force)
 
 void CAScoreView::zoomToWidth(bool animate, bool force)
 {
-    int maxX = (getMaxXExtended(_drawableCList) > getMaxXExtended(_drawableMList)) ? getMaxXExtended(_drawableCList) : getMaxXExtended(_drawableMList);
+    int maxX = (getMaxXExtended(_sheetLayout->drawableCList()) > getMaxXExtended(_sheetLayout->drawableMList())) ? getMaxXExtended(_sheetLayout->drawableCList()) : getMaxXExtended(_sheetLayout->drawableMList());
     setWorldCoords(0, 0, maxX, 0, animate, force);
 }
 
 void CAScoreView::zoomToHeight(bool animate, bool force)
 {
-    int maxY = (getMaxYExtended(_drawableCList) > getMaxYExtended(_drawableMList)) ? getMaxYExtended(_drawableCList) : getMaxYExtended(_drawableMList);
+    int maxY = (getMaxYExtended(_sheetLayout->drawableCList()) > getMaxYExtended(_sheetLayout->drawableMList())) ? getMaxYExtended(_sheetLayout->drawableCList()) : getMaxYExtended(_sheetLayout->drawableMList());
     setWorldCoords(0, 0, 0, maxY, animate, force);
 }
 
 void CAScoreView::zoomToFit(bool animate, bool force)
 {
-    int maxX = ((_drawableCList.getMaxX() > _drawableMList.getMaxX()) ? _drawableCList.getMaxX() : _drawableMList.getMaxX());
-    int maxY = ((_drawableCList.getMaxY() > _drawableMList.getMaxY()) ? _drawableCList.getMaxY() : _drawableMList.getMaxY());
+    int maxX = ((_sheetLayout->drawableCList().getMaxX() > _sheetLayout->drawableMList().getMaxX()) ? _sheetLayout->drawableCList().getMaxX() : _sheetLayout->drawableMList().getMaxX());
+    int maxY = ((_sheetLayout->drawableCList().getMaxY() > _sheetLayout->drawableMList().getMaxY()) ? _sheetLayout->drawableCList().getMaxY() : _sheetLayout->drawableMList().getMaxY());
 
     setWorldCoords(0, 0, maxX, maxY, animate, force);
 }
@@ -956,7 +1026,7 @@ void CAScoreView::setZoom(float z, double x, double y, bool animate, bool force)
 */
 #include <sys/time.h> //benchmarking
 #include <time.h> //benchmarking
-void CAScoreView::paintEvent(QPaintEvent*)
+void CAScoreView::paintEvent(QPaintEvent* e)
 {
     if (_holdRepaint)
         return;
@@ -974,85 +1044,24 @@ void CAScoreView::paintEvent(QPaintEvent*)
     else
         p.fillRect(_canvas->x(), _canvas->y(), _canvas->width(), _canvas->height(), _backgroundColor);
 
-    // draw contexts
+    // draw contexts and music elements
     timeval timeStart, timeEnd, timeEnd2;
     gettimeofday(&timeStart, nullptr);
-    QList<CADrawableContext*> cList;
-    //int j = _drawableCList.size();
-    if (_repaintArea)
-        cList = _drawableCList.findInRange(_repaintArea->x(), _repaintArea->y(), _repaintArea->width(), _repaintArea->height());
-    else
-        cList = _drawableCList.findInRange(_worldX, _worldY, _worldW, _worldH);
-
-    for (int i = 0; i < cList.size(); i++) {
-        CADrawSettings s = {
-            _zoom,
-            qRound((cList[i]->xPos() - _worldX) * _zoom),
-            qRound((cList[i]->yPos() - _worldY) * _zoom),
-            drawableWidth(), drawableHeight(),
-            ((_currentContext == cList[i]) ? selectedContextColor() : foregroundColor()),
-            _worldX,
-            _worldY
-        };
-        cList[i]->draw(&p, s);
+    p.save();
+    p.setClipRect(_canvas->geometry());
+    if (_repaintArea) {
+        paintTiles(&p, _repaintArea->x(), _repaintArea->y(), _repaintArea->width(), _repaintArea->height());
+    } else if (_zoom > 0) {
+        // only the tiles under the invalidated area, eg. when just the overlay changed
+        QRectF area = QRectF(_worldX + e->rect().x() / _zoom, _worldY + e->rect().y() / _zoom, e->rect().width() / _zoom, e->rect().height() / _zoom) & QRectF(_worldX, _worldY, _worldW, _worldH);
+        if (!area.isEmpty()) {
+            paintTiles(&p, area.x(), area.y(), area.width(), area.height());
+        }
     }
-
-    // draw music elements
-    QList<CADrawableMusElement*> mList;
-    if (_repaintArea)
-        mList = _drawableMList.findInRange(_repaintArea->x(), _repaintArea->y(), _repaintArea->width(), _repaintArea->height());
-    else
-        mList = _drawableMList.findInRange(_worldX, _worldY, _worldW, _worldH);
+    p.restore();
 
     gettimeofday(&timeEnd, nullptr);
 
-    p.setRenderHint(QPainter::Antialiasing, CACanorus::settings()->antiAliasing());
-
-    for (int i = 0; i < mList.size(); i++) {
-        QColor color;
-        CAMusElement* elt = mList[i]->musElement();
-
-        // determine element color (based on selection, current mode, active voice etc.)
-        if (_selection.contains(mList[i])) {
-            color = selectionColor();
-        } else if ((selectedVoice() && ((elt && ((elt->isPlayable() && static_cast<CAPlayable*>(elt)->voice() == selectedVoice()) || (!elt->isPlayable() && elt->context() == selectedVoice()->staff()) || elt->context() != selectedVoice()->staff())) || (!elt && mList[i]->drawableContext()->context() == selectedVoice()->staff()))) || (!selectedVoice())) {
-            if (elt && elt->musElementType() == CAMusElement::Rest && static_cast<CAPlayable*>(elt)->voice() == selectedVoice() && static_cast<CARest*>(elt)->restType() == CARest::Hidden) {
-                color = hiddenElementsColor();
-            } else if ((elt && elt->musElementType() == CAMusElement::Rest && static_cast<CARest*>(elt)->restType() == CARest::Hidden) || (elt && !elt->isVisible())) {
-                color = QColor(0, 0, 0, 0); // transparent color
-            } else if (elt && elt->color().isValid()) {
-                color = elt->color(); // set elements color, if defined
-            } else {
-                color = foregroundColor(); // set default color for foreground elements
-            }
-        } else {
-            if (elt && elt->musElementType() == CAMusElement::Rest && static_cast<CARest*>(elt)->restType() == CARest::Hidden) {
-                color = QColor(0, 0, 0, 0); // transparent color
-            } else {
-                color = disabledElementsColor();
-            }
-        }
-
-        CADrawSettings s = {
-            _zoom,
-            qRound((mList[i]->xPos() - _worldX) * _zoom),
-            qRound((mList[i]->yPos() - _worldY) * _zoom),
-            drawableWidth(), drawableHeight(),
-            color,
-            _worldX,
-            _worldY
-        };
-        mList[i]->draw(&p, s);
-        if (_selection.contains(mList[i]) && mList[i]->isHScalable()) {
-            s.color = foregroundColor();
-            mList[i]->drawHScaleHandles(&p, s);
-        }
-        if (_selection.contains(mList[i]) && mList[i]->isVScalable()) {
-            s.color = foregroundColor();
-            mList[i]->drawVScaleHandles(&p, s);
-        }
-    }
-
     // draw ruler
     if (CACanorus::settings()->showRuler()) {
         p.fillRect(0, 0, width(), RULER_HEIGHT, QColor::fromRgb(200, 200, 200, 128));
@@ -1062,20 +1071,13 @@ void CAScoreView::paintEvent(QPaintEvent*)
         p.setFont(font);
         p.setPen(Qt::black);
 
-        QMap<int, CADrawableBarline*> dBarlineMap = computeBarlinePositions(false);
-
-        if (!dBarlineMap.isEmpty()) {
-            int curBarlineNumber;
-            for (curBarlineNumber = dBarlineMap.firstKey(); curBarlineNumber <= dBarlineMap.lastKey() && dBarlineMap[curBarlineNumber]->xPos() < _worldX; curBarlineNumber++)
-                ;
-
-            for (; curBarlineNumber <= dBarlineMap.lastKey() && dBarlineMap[curBarlineNumber]->xPos() > _worldX && dBarlineMap[curBarlineNumber]->xPos() + dBarlineMap[curBarlineNumber]->width() < _worldX + _worldW;
-                 curBarlineNumber++) {
-                CADrawableBarline* curDBarline = dBarlineMap[curBarlineNumber];
-                if (dBarlineMap.contains(curBarlineNumber + 1)) { // don't draw the last bar number
-                    double center = qRound((curDBarline->xPos() - _worldX) * _zoom);
-                    p.drawText(center - 1, RULER_HEIGHT - 2, QString::number(curBarlineNumber));
-                }
+        // first barline right of the left border, see updateTimeIndex()
+        const QVector<CADrawableBarline*>& barIndex = _sheetLayout->barIndex();
+        QVector<CADrawableBarline*>::const_iterator it = std::upper_bound(barIndex.constBegin(), barIndex.constEnd(), _worldX, [](double x, const CADrawableBarline* b) { return x < b->xPos(); });
+        for (; it != barIndex.constEnd() && (*it)->xPos() + (*it)->width() < _worldX + _worldW; it++) {
+            if (it + 1 != barIndex.constEnd()) { // don't draw the last bar number
+                double center = qRound(((*it)->xPos() - _worldX) * _zoom);
+                p.drawText(center - 1, RULER_HEIGHT - 2, QString::number(_sheetLayout->firstBarNumber() + static_cast<int>(it - barIndex.constBegin())));
             }
         }
 
@@ -1084,7 +1086,7 @@ void CAScoreView::paintEvent(QPaintEvent*)
 
     // draw note checker errors
     {
-        QList<CADrawableNoteCheckerError*> dnceList = _drawableNCEList.findInRange(_worldX, _worldY, _worldW, _worldH);
+        QList<CADrawableNoteCheckerError*> dnceList = _sheetLayout->drawableNCEList().findInRange(_worldX, _worldY, _worldW, _worldH);
         for (int i = 0; i < dnceList.size(); i++) {
             CADrawSettings c = {
                 _zoom,
@@ -1099,7 +1101,137 @@ void CAScoreView::paintEvent(QPaintEvent*)
         }
     }
 
-    // draw selection regions
+    // draw the overlay on top of the score
+    paintOverlay(&p);
+    _overlayRect = overlayRect();
+
+    gettimeofday(&timeEnd2, nullptr);
+
+    //	std::cout << "painting tiles took " << timeEnd.tv_sec-timeStart.tv_sec+(timeEnd.tv_usec-timeStart.tv_usec)/1000000.0 << "s." << std::endl;
+    //	std::cout << "painting helpers took " << timeEnd2.tv_sec-timeEnd.tv_sec+(timeEnd2.tv_usec-timeEnd.tv_usec)/1000000.0 << "s." << std::endl;
+
+    // flush the oldWorld coordinates as they're needed for the first repaint only
+    _oldWorldX = _worldX;
+    _oldWorldY = _worldY;
+    _oldWorldW = _worldW;
+    _oldWorldH = _worldH;
+
+    if (_repaintArea) {
+        delete _repaintArea;
+        _repaintArea = nullptr;
+    }
+}
+
+/*!
+	Paints the contexts and music elements in the given world area using the tile cache.
+	Tiles whose contents changed since the last paint are rendered in parallel in the background
+	and painted on one of the next repaints.
+
+	\sa CATileCache
+*/
+void CAScoreView::paintTiles(QPainter* p, double x, double y, double w, double h)
+{
+    const int ts = CATileCache::TILE_SIZE;
+    const double margin = TILE_MARGIN; // elements slightly outside the tile may overlap it with their glyphs
+    const bool antialiasing = CACanorus::settings()->antiAliasing();
+    if (_zoom <= 0)
+        return;
+
+    if (CADrawable::reducedDetailZoom() != CACanorus::settings()->reducedDetailZoom() || CADrawable::outlineDetailZoom() != CACanorus::settings()->outlineDetailZoom()) {
+        CATileCache::cancelAll(); // the thresholds are read by the tile workers
+        CADrawable::setDetailZoomLevels(CACanorus::settings()->reducedDetailZoom(), CACanorus::settings()->outlineDetailZoom());
+    }
+
+    _tileCache->setZoom(_zoom);
+    _tileCache->collect();
+
+    QList<QPoint> tiles;
+    int tx1 = qFloor(x * _zoom / ts), tx2 = qFloor((x + w) * _zoom / ts);
+    int ty1 = qFloor(y * _zoom / ts), ty2 = qFloor((y + h) * _zoom / ts);
+    for (int ty = ty1; ty <= ty2; ty++) {
+        for (int tx = tx1; tx <= tx2; tx++) {
+            double tileX = tx * ts / _zoom, tileY = ty * ts / _zoom, tileW = ts / _zoom;
+            QList<CATileCache::CATileItem> items;
+
+            QList<CADrawableContext*> cList = _sheetLayout->drawableCList().findInRange(tileX - margin, tileY - margin, tileW + 2 * margin, tileW + 2 * margin);
+            for (int i = 0; i < cList.size(); i++) {
+                CADrawSettings s = {
+                    _zoom,
+                    qRound((cList[i]->xPos() - tileX) * _zoom),
+                    qRound((cList[i]->yPos() - tileY) * _zoom),
+                    ts, ts,
+                    ((_currentContext == cList[i]) ? selectedContextColor() : foregroundColor()),
+                    tileX,
+                    tileY
+                };
+                CATileCache::CATileItem item = { cList[i], s, false };
+                items << item;
+            }
+
+            QList<CADrawableMusElement*> mList = _sheetLayout->drawableMList().findInRange(tileX - margin, tileY - margin, tileW + 2 * margin, tileW + 2 * margin);
+            for (int i = 0; i < mList.size(); i++) {
+                CADrawSettings s = {
+                    _zoom,
+                    qRound((mList[i]->xPos() - tileX) * _zoom),
+                    qRound((mList[i]->yPos() - tileY) * _zoom),
+                    ts, ts,
+                    drawableMElementColor(mList[i]),
+                    tileX,
+                    tileY
+                };
+                CATileCache::CATileItem item = { mList[i], s, antialiasing };
+                items << item;
+            }
+
+            QPoint tile(tx, ty);
+            uint signature = CATileCache::signature(items, _backgroundColor);
+            if (!_tileCache->contains(tile, signature))
+                _tileCache->schedule(tile, signature, items);
+            tiles << tile;
+        }
+    }
+
+    _tileCache->render(devicePixelRatioF(), _backgroundColor);
+
+    // tiles being rendered are painted from their old image, if any, and updated when finished
+    int originX = qRound(_worldX * _zoom), originY = qRound(_worldY * _zoom);
+    for (int i = 0; i < tiles.size(); i++) {
+        QImage image = _tileCache->image(tiles[i]);
+        if (!image.isNull()) {
+            p->drawImage(tiles[i].x() * ts - originX, tiles[i].y() * ts - originY, image);
+        }
+    }
+
+    if (w >= _worldW && h >= _worldH) { // don't drop the visible tiles when only a part of the view is painted
+        _tileCache->trim(tiles);
+    }
+}
+
+/*!
+	Invalidates the overlay area painted last time and the area the overlay covers now. Call
+	it instead of repaint() when only the shadow notes, the selection regions or the playback
+	cursor changed. The score underneath is painted out of the tile cache.
+
+	\sa paintOverlay()
+*/
+void CAScoreView::updateOverlay()
+{
+    QRect dirty = _overlayRect | overlayRect();
+    if (!dirty.isEmpty()) {
+        update(dirty);
+    }
+}
+
+/*!
+	Paints the elements drawn over the score: the selection regions, the scale handles of the
+	selected elements, the shadow notes and the playback cursor. These are not part of the
+	cached tiles, so they can change without rendering the score again.
+
+	\sa updateOverlay(), overlayRect()
+*/
+void CAScoreView::paintOverlay(QPainter* p)
+{
+    // selection regions
     for (int i = 0; i < selectionRegionList().size(); i++) {
         CADrawSettings c = {
             _zoom,
@@ -1111,10 +1243,31 @@ void CAScoreView::paintEvent(QPaintEvent*)
             _worldX,
             _worldY
         };
-        drawSelectionRegion(&p, c);
+        drawSelectionRegion(p, c);
+    }
+
+    // scale handles of the selected elements
+    for (int i = 0; i < _selection.size(); i++) {
+        if (_selection[i]->isHScalable() || _selection[i]->isVScalable()) {
+            CADrawSettings c = {
+                _zoom,
+                qRound((_selection[i]->xPos() - _worldX) * _zoom),
+                qRound((_selection[i]->yPos() - _worldY) * _zoom),
+                drawableWidth(), drawableHeight(),
+                foregroundColor(),
+                _worldX,
+                _worldY
+            };
+            if (_selection[i]->isHScalable()) {
+                _selection[i]->drawHScaleHandles(p, c);
+            }
+            if (_selection[i]->isVScalable()) {
+                _selection[i]->drawVScaleHandles(p, c);
+            }
+        }
     }
 
-    // draw shadow note
+    // shadow notes
     if (_shadowNoteVisible) {
         for (int i = 0; i < _shadowDrawableNote.size(); i++) {
             if (CACanorus::settings()->shadowNotesInOtherStaffs() || _shadowDrawableNote[i]->drawableContext() == currentContext()) {
@@ -1128,41 +1281,171 @@ void CAScoreView::paintEvent(QPaintEvent*)
                     _worldY
                 };
 
-                _shadowDrawableNote[i]->draw(&p, s);
+                _shadowDrawableNote[i]->draw(p, s);
 
                 if (_drawShadowNoteAccs) {
                     CADrawableAccidental acc(_shadowNoteAccs, nullptr, nullptr, 0, _shadowDrawableNote[i]->yCenter());
                     s.x -= qRound((acc.width() + 2) * _zoom);
                     s.y = qRound((acc.yPos() - _worldY) * _zoom);
-                    acc.draw(&p, s);
+                    acc.draw(p, s);
                 }
             }
         }
 
-        // draw note name
+        // note name
         if (_shadowNote.size()) {
             QFont font("FreeSans");
             font.setPixelSize(20);
-            p.setFont(font);
-            p.setPen(disabledElementsColor());
-            p.drawText(qRound((_xCursor - _worldX + 10) * _zoom), qRound((_yCursor - _worldY - 10) * _zoom), CANote::generateNoteName(_shadowNote[0]->diatonicPitch().noteName(), _shadowNoteAccs));
+            p->setFont(font);
+            p->setPen(disabledElementsColor());
+            p->drawText(qRound((_xCursor - _worldX + 10) * _zoom), qRound((_yCursor - _worldY - 10) * _zoom), CANote::generateNoteName(_shadowNote[0]->diatonicPitch().noteName(), _shadowNoteAccs));
         }
     }
 
-    gettimeofday(&timeEnd2, nullptr);
+    paintPlaybackCursor(p);
+}
 
-    //	std::cout << "finding elements to draw took " << timeEnd.tv_sec-timeStart.tv_sec+(timeEnd.tv_usec-timeStart.tv_usec)/1000000.0 << "s." << std::endl;
-    //	std::cout << "painting " << mList.size() << " elements took " << timeEnd2.tv_sec-timeEnd.tv_sec+(timeEnd2.tv_usec-timeEnd.tv_usec)/1000000.0 << "s." << std::endl;
+/*!
+	Returns the widget area covered by the overlay.
 
-    // flush the oldWorld coordinates as they're needed for the first repaint only
-    _oldWorldX = _worldX;
-    _oldWorldY = _worldY;
-    _oldWorldW = _worldW;
-    _oldWorldH = _worldH;
+	\sa paintOverlay()
+*/
+QRect CAScoreView::overlayRect()
+{
+    QRect rect;
+    for (int i = 0; i < selectionRegionList().size(); i++) {
+        const QRect& r = selectionRegionList().at(i);
+        rect |= QRect(qRound((r.x() - _worldX) * _zoom), qRound((r.y() - _worldY) * _zoom), qCeil(r.width() * _zoom), qCeil(r.height() * _zoom)).adjusted(-1, -1, 1, 1);
+    }
 
-    if (_repaintArea) {
-        delete _repaintArea;
-        _repaintArea = nullptr;
+    int handles = qCeil(CADrawable::SCALE_HANDLES_SIZE * _zoom) + 2;
+    for (int i = 0; i < _selection.size(); i++) {
+        if (_selection[i]->isHScalable() || _selection[i]->isVScalable()) {
+            rect |= QRect(qRound((_selection[i]->xPos() - _worldX) * _zoom), qRound((_selection[i]->yPos() - _worldY) * _zoom), qCeil(_selection[i]->width() * _zoom), qCeil(_selection[i]->height() * _zoom)).adjusted(-handles, -handles, handles, handles);
+        }
+    }
+
+    if (_shadowNoteVisible) {
+        for (int i = 0; i < _shadowDrawableNote.size(); i++) {
+            CADrawableNote* d = _shadowDrawableNote[i];
+            int accsWidth = 0;
+            if (_drawShadowNoteAccs) {
+                CADrawableAccidental acc(_shadowNoteAccs, nullptr, nullptr, 0, d->yCenter());
+                accsWidth = qCeil((acc.width() + 2) * _zoom);
+            }
+            rect |= QRect(qRound((d->xPos() - _worldX - d->width() / 2) * _zoom), qRound((d->yPos() - _worldY) * _zoom), qCeil(d->width() * _zoom), qCeil(d->height() * _zoom)).adjusted(-accsWidth - 2, -qCeil(d->height() * _zoom) - 2, 2, qCeil(d->height() * _zoom) + 2); // accidentals may be higher than the notehead
+        }
+
+        if (_shadowNote.size()) {
+            QFont font("FreeSans");
+            font.setPixelSize(20);
+            QString name = CANote::generateNoteName(_shadowNote[0]->diatonicPitch().noteName(), _shadowNoteAccs);
+            rect |= QFontMetrics(font).boundingRect(name).translated(qRound((_xCursor - _worldX + 10) * _zoom), qRound((_yCursor - _worldY - 10) * _zoom)).adjusted(-2, -2, 2, 2);
+        }
+    }
+
+    return rect | playbackCursorRect();
+}
+
+/*!
+	Sets the music elements currently being played to \a elts. They are painted over the tiles
+	in the selection color and a cursor line is drawn at the leftmost one. The selection and the
+	tile cache are not affected and only the area of the old and new cursor is repainted.
+
+	\sa paintPlaybackCursor()
+*/
+void CAScoreView::setPlayingElements(const QList<CAMusElement*>& elts)
+{
+    _playingElements = elts;
+    updateOverlay();
+}
+
+/*!
+	Paints the playing elements and the playback cursor line.
+
+	\sa setPlayingElements()
+*/
+void CAScoreView::paintPlaybackCursor(QPainter* p)
+{
+    double cursorX = -1;
+    p->setRenderHint(QPainter::Antialiasing, CACanorus::settings()->antiAliasing());
+    for (int i = 0; i < _playingElements.size(); i++) {
+        QList<CADrawable*> l = _sheetLayout->mapDrawable().values(_playingElements[i]);
+        for (int j = 0; j < l.size(); j++) {
+            CADrawSettings s = {
+                _zoom,
+                qRound((l[j]->xPos() - _worldX) * _zoom),
+                qRound((l[j]->yPos() - _worldY) * _zoom),
+                drawableWidth(), drawableHeight(),
+                selectionColor(),
+                _worldX,
+                _worldY
+            };
+            l[j]->draw(p, s);
+
+            if (cursorX < 0 || l[j]->xPos() < cursorX) {
+                cursorX = l[j]->xPos();
+            }
+        }
+    }
+
+    if (cursorX >= 0) {
+        QColor c = selectionColor();
+        c.setAlpha(96);
+        p->setPen(QPen(c, 2));
+        int x = qRound((cursorX - _worldX) * _zoom);
+        p->drawLine(x, 0, x, height());
+    }
+}
+
+/*!
+	Returns the widget area covered by the playing elements and the playback cursor.
+*/
+QRect CAScoreView::playbackCursorRect()
+{
+    QRect rect;
+    for (int i = 0; i < _playingElements.size(); i++) {
+        QList<CADrawable*> l = _sheetLayout->mapDrawable().values(_playingElements[i]);
+        for (int j = 0; j < l.size(); j++) {
+            int x = qRound((l[j]->xPos() - _worldX) * _zoom);
+            rect |= QRect(x, qRound((l[j]->yPos() - _worldY) * _zoom), qCeil(l[j]->width() * _zoom), qCeil(l[j]->height() * _zoom)).adjusted(-4, -4, 4, 4);
+            rect |= QRect(x - 2, 0, 4, height()); // cursor line
+        }
+    }
+
+    return rect;
+}
+
+/*!
+	Returns the color the drawable music element \a elt should be painted with based on the
+	selection, the selected voice and the element's own properties.
+
+	The selection and the voice are read from the view's state of the element (see
+	drawableState()), the element's own properties from its state bits.
+*/
+QColor CAScoreView::drawableMElementColor(CADrawableMusElement* drawableElt)
+{
+    CAMusElement* elt = drawableElt->musElement();
+    int state = drawableState(drawableElt);
+
+    if (state & Selected) {
+        return selectionColor();
+    } else if (!(state & Disabled)) {
+        if (drawableElt->hasState(CADrawableMusElement::Hidden) && (state & ActiveVoice)) {
+            return hiddenElementsColor();
+        } else if (drawableElt->hasState(CADrawableMusElement::Hidden) || drawableElt->hasState(CADrawableMusElement::Invisible)) {
+            return QColor(0, 0, 0, 0); // transparent color
+        } else if (elt && elt->color().isValid()) {
+            return elt->color(); // set elements color, if defined
+        } else {
+            return foregroundColor(); // set default color for foreground elements
+        }
+    } else {
+        if (drawableElt->hasState(CADrawableMusElement::Hidden)) {
+            return QColor(0, 0, 0, 0); // transparent color
+        } else {
+            return disabledElementsColor();
+        }
     }
 }
 
@@ -1246,7 +1529,7 @@ void CAScoreView::checkScrollBars()
     bool change = false;
     _holdRepaint = true; // disable repaint until the scrollbar values are set
     _checkScrollBarsDeadLock = true; // disable any further method calls until the method is over
-    if ((((getMaxXExtended(_drawableMList) > getMaxXExtended(_drawableCList)) ? getMaxXExtended(_drawableMList) : getMaxXExtended(_drawableCList)) - worldWidth() > 0) || (_hScrollBar->value() != 0)) { //if scrollbar is needed
+    if ((((getMaxXExtended(_sheetLayout->drawableMList()) > getMaxXExtended(_sheetLayout->drawableCList())) ? getMaxXExtended(_sheetLayout->drawableMList()) : getMaxXExtended(_sheetLayout->drawableCList())) - worldWidth() > 0) || (_hScrollBar->value() != 0)) { //if scrollbar is needed
         if (!_hScrollBar->isVisible()) {
             _hScrollBar->show();
             change = true;
@@ -1257,7 +1540,7 @@ void CAScoreView::checkScrollBars()
         change = true;
     }
 
-    if ((((getMaxYExtended(_drawableMList) > getMaxYExtended(_drawableCList)) ? getMaxYExtended(_drawableMList) : getMaxYExtended(_drawableCList)) - worldHeight() > 0) || (_vScrollBar->value() != 0)) { //if scrollbar is needed
+    if ((((getMaxYExtended(_sheetLayout->drawableMList()) > getMaxYExtended(_sheetLayout->drawableCList())) ? getMaxYExtended(_sheetLayout->drawableMList()) : getMaxYExtended(_sheetLayout->drawableCList())) - worldHeight() > 0) || (_vScrollBar->value() != 0)) { //if scrollbar is needed
         if (!_vScrollBar->isVisible()) {
             _vScrollBar->show();
             change = true;
@@ -1575,17 +1858,113 @@ CADrawableMusElement* CAScoreView::selectDownMusElement()
 */
 void CAScoreView::addToSelection(CADrawableMusElement* elt, bool triggerSignal)
 {
-    int i;
-    for (i = 0; i < _selection.size() && _selection[i]->xPos() < elt->xPos(); i++)
-        ;
-
-    if (elt->isSelectable())
-        _selection.insert(i, elt);
+    if (elt->isSelectable() && !isSelected(elt)) {
+        QList<CADrawableMusElement*>::iterator it = std::lower_bound(_selection.begin(), _selection.end(), elt->xPos(), [](const CADrawableMusElement* e, double x) { return e->xPos() < x; });
+        _selection.insert(it, elt);
+        setSelectedState(elt, true);
+    }
 
     if (triggerSignal)
         emit selectionChanged();
 }
 
+/*!
+	Removes all the elements from the selection without emitting selectionChanged().
+
+	\sa clearSelection()
+*/
+void CAScoreView::resetSelection()
+{
+    for (int i = 0; i < _selection.size(); i++) {
+        setSelectedState(_selection[i], false);
+    }
+    _selection.clear();
+}
+
+/*!
+	Sets the voice \a voice as the selected one. Elements of other voices in its staff are
+	painted disabled and only the elements of the selected voice can be selected.
+*/
+void CAScoreView::setSelectedVoice(CAVoice* voice)
+{
+    _selectedVoice = voice;
+    updateDrawableStates(0);
+}
+
+/*!
+	Returns the CADrawableViewState flags of the drawable music element \a elt in this view.
+	The states of the elements which are not in the layout (eg. shadow notes) are computed.
+*/
+int CAScoreView::drawableState(CADrawableMusElement* elt)
+{
+    int idx = elt->layoutIndex();
+    if (idx >= 0 && idx < _drawableStates.size()) {
+        return _drawableStates[idx];
+    }
+
+    int state = voiceState(elt);
+    if (_selection.contains(elt)) {
+        state |= Selected;
+    }
+    return state;
+}
+
+/*!
+	Computes the ActiveVoice and Disabled flags of the drawable music element \a d based on the
+	selected voice.
+*/
+int CAScoreView::voiceState(CADrawableMusElement* d)
+{
+    CAMusElement* elt = d->musElement();
+    CAVoice* voice = (elt && elt->isPlayable()) ? static_cast<CAPlayable*>(elt)->voice() : nullptr;
+
+    int state = 0;
+    if (voice && voice == selectedVoice()) {
+        state |= ActiveVoice;
+    }
+    if (selectedVoice()) {
+        if (elt ? (elt->isPlayable() && voice != selectedVoice() && elt->context() == selectedVoice()->staff()) : (d->drawableContext()->context() != selectedVoice()->staff())) {
+            state |= Disabled;
+        }
+    }
+
+    return state;
+}
+
+/*!
+	Sets or clears the Selected flag of the drawable music element \a elt.
+*/
+void CAScoreView::setSelectedState(CADrawableMusElement* elt, bool selected)
+{
+    int idx = elt->layoutIndex();
+    if (idx >= _drawableStates.size()) {
+        updateDrawableStates(_drawableStates.size()); // element added after the last sync
+    }
+    if (idx < 0 || idx >= _drawableStates.size()) {
+        return;
+    }
+
+    _drawableStates[idx] = selected ? (_drawableStates[idx] | Selected) : (_drawableStates[idx] & ~Selected);
+}
+
+/*!
+	Resizes the states to the elements of the shared layout and updates the voice flags of the
+	elements starting at the layout index \a from. The Selected flags are kept.
+	Called when the layout changed and when the selected voice changes.
+*/
+void CAScoreView::updateDrawableStates(int from)
+{
+    if (!_sheetLayout) {
+        return;
+    }
+
+    const QList<CADrawableMusElement*>& order = _sheetLayout->drawableMOrder();
+    _drawableStates.resize(order.size());
+    for (int i = from; i < order.size(); i++) {
+        _drawableStates[i] = (_drawableStates[i] & Selected) | voiceState(order[i]);
+    }
+}
+
 /*!
 	Adds the given list of drawable music elements \a list to the current selection.
 */
@@ -1605,7 +1984,7 @@ void CAScoreView::addToSelection(const QList<CADrawableMusElement*> list, bool s
 */
 CADrawableMusElement* CAScoreView::addToSelection(CAMusElement* elt)
 {
-    QList<CADrawable*> l = _mapDrawable.values(elt);
+    QList<CADrawable*> l = _sheetLayout->mapDrawable().values(elt);
     for (int i = 0; i < l.size(); i++) {
         addToSelection(static_cast<CADrawableMusElement*>(l[i]));
     }
@@ -1620,7 +1999,7 @@ CADrawableMusElement* CAScoreView::addToSelection(CAMusElement* elt)
 void CAScoreView::addToSelection(const QList<CAMusElement*> elts)
 {
     for (int i = 0; i < elts.size(); i++) {
-        QList<CADrawable*> l = _mapDrawable.values(elts[i]);
+        QList<CADrawable*> l = _sheetLayout->mapDrawable().values(elts[i]);
         for (int j = 0; j < l.size(); j++) {
             addToSelection(static_cast<CADrawableMusElement*>(l[j]), false);
         }
@@ -1637,7 +2016,7 @@ void CAScoreView::selectAll()
 {
     clearSelection();
 
-    QList<CADrawableMusElement*> elts = _drawableMList.list();
+    QList<CADrawableMusElement*> elts = _sheetLayout->drawableMList().list();
     for (int i = 0; i < elts.size(); i++)
         addToSelection(elts[i], false);
 
@@ -1689,10 +2068,12 @@ void CAScoreView::selectAllCurContext()
 */
 void CAScoreView::invertSelection()
 {
-    QList<CADrawableMusElement*> oldSelection = selection();
+    QSet<CADrawableMusElement*> oldSelection;
+    for (int i = 0; i < _selection.size(); i++)
+        oldSelection.insert(_selection[i]);
     clearSelection();
 
-    QList<CADrawableMusElement*> elts = _drawableMList.list();
+    QList<CADrawableMusElement*> elts = _sheetLayout->drawableMList().list();
     for (int i = 0; i < elts.size(); i++)
         if (!oldSelection.contains(elts[i]))
             addToSelection(elts[i], false);
@@ -1711,7 +2092,7 @@ CADrawableMusElement* CAScoreView::findMElement(CAMusElement* elt)
         return nullptr;
     }
 
-    QList<CADrawable*> hits = _mapDrawable.values(elt);
+    QList<CADrawable*> hits = _sheetLayout->mapDrawable().values(elt);
     if (hits.size()) {
         return static_cast<CADrawableMusElement*>(hits[0]);
     }
@@ -1729,7 +2110,7 @@ CADrawableContext* CAScoreView::findCElement(CAContext* context)
         return nullptr;
     }
 
-    QList<CADrawable*> hits = _mapDrawable.values(context);
+    QList<CADrawable*> hits = _sheetLayout->mapDrawable().values(context);
     if (hits.size()) {
         return static_cast<CADrawableContext*>(hits[0]);
     }
@@ -1846,41 +2227,120 @@ double CAScoreView::getMaxYExtended(CAKDTree<T>& v)
 */
 QList<CADrawableContext*> CAScoreView::findContextsInRegion(QRect& region)
 {
-    return _drawableCList.findInRange(region);
+    return _sheetLayout->drawableCList().findInRange(region);
+}
+
+/*!
+	Builds the index of the times and X coordinates of the placed noteheads, rests and
+	barlines, and the index of the bar numbers. Called by the layout engine once the elements
+	are placed.
+
+	For each time, the index holds the leftmost notehead or rest starting at that time or the
+	barline, if no playable element starts there. The X coordinates are made non-decreasing,
+	so the index is a monotonic piecewise-linear map between the time and the X coordinate.
+	coordsToTime(), timeToCoords() and the ruler do a binary search over it instead of looking
+	up the elements in each voice.
+*/
+void CAScoreView::updateTimeIndex()
+{
+    QMap<int, double> playableX;
+    QMap<int, double> barlineX;
+    int endTime = -1;
+    double endX = 0;
+    for (int i = 0; i < _sheetLayout->drawableMOrder().size(); i++) {
+        CADrawableMusElement* d = _sheetLayout->drawableMOrder()[i];
+        if (!d->musElement()) {
+            continue;
+        }
+
+        int time = d->musElement()->timeStart();
+        switch (d->drawableMusElementType()) {
+        case CADrawableMusElement::DrawableNote:
+        case CADrawableMusElement::DrawableRest:
+            if (!playableX.contains(time) || d->xPos() < playableX[time]) {
+                playableX[time] = d->xPos();
+            }
+            if (d->musElement()->timeEnd() > endTime || (d->musElement()->timeEnd() == endTime && d->xPos() + d->width() > endX)) {
+                endTime = d->musElement()->timeEnd();
+                endX = d->xPos() + d->width();
+            }
+            break;
+        case CADrawableMusElement::DrawableBarline:
+            if (!barlineX.contains(time) || d->xPos() < barlineX[time]) {
+                barlineX[time] = d->xPos();
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    // the end of the last note, if the score isn't finished with a barline
+    if (endTime >= 0 && !barlineX.contains(endTime)) {
+        barlineX[endTime] = endX;
+    }
+    for (QMap<int, double>::const_iterator it = barlineX.constBegin(); it != barlineX.constEnd(); it++) {
+        if (!playableX.contains(it.key())) {
+            playableX[it.key()] = it.value();
+        }
+    }
+
+    QVector<int>& times = _sheetLayout->timeIndexTimes();
+    QVector<double>& xs = _sheetLayout->timeIndexX();
+    times.clear();
+    xs.clear();
+    times.reserve(playableX.size());
+    xs.reserve(playableX.size());
+    for (QMap<int, double>::const_iterator it = playableX.constBegin(); it != playableX.constEnd(); it++) {
+        times << it.key();
+        xs << (xs.isEmpty() ? it.value() : qMax(it.value(), xs.last()));
+    }
+
+    // bar numbers of the staff with most barlines, dotted barlines are not counted
+    QMap<int, CADrawableBarline*> bars = computeBarlinePositions(true);
+    QVector<CADrawableBarline*>& barIndex = _sheetLayout->barIndex();
+    barIndex.clear();
+    _sheetLayout->setFirstBarNumber(0);
+    for (QMap<int, CADrawableBarline*>::const_iterator it = bars.constBegin(); it != bars.constEnd(); it++) {
+        if (it.value()->barline()->barlineType() != CABarline::Dotted) {
+            barIndex << it.value();
+        }
+    }
+    if (!barIndex.isEmpty()) {
+        CADrawableStaff* dStaff = static_cast<CADrawableStaff*>(barIndex[0]->drawableContext());
+        CADrawableTimeSignature* firstDTimeSig = (dStaff->drawableTimeSignatureList().size() ? dStaff->drawableTimeSignatureList()[0] : nullptr);
+        _sheetLayout->setFirstBarNumber((firstDTimeSig && barIndex[0]->barline()->timeStart() < firstDTimeSig->timeSignature()->barDuration()) ? 1 : 2); // pickup measure in the beginning
+    }
 }
 
 /*!
 	Returns Canorus time for the given X coordinate \a x.
 
 	Returns 0, if no contexts are present.
+
+	\sa updateTimeIndex()
 */
 int CAScoreView::coordsToTime(double x)
 {
-    CADrawableMusElement* d1 = nearestLeftElement(x, 0);
-    if (selection().contains(d1)) {
-        CADrawableMusElement* newD1 = nearestLeftElement(d1->xPos(), 0);
-        d1 = newD1;
+    const QVector<int>& times = _sheetLayout->timeIndexTimes();
+    const QVector<double>& xs = _sheetLayout->timeIndexX();
+    if (xs.isEmpty()) {
+        return 0;
     }
 
-    CADrawableMusElement* d2 = nearestRightElement(x, 0);
-    if (selection().contains(d2)) {
-        CADrawableMusElement* newD2 = nearestRightElement(d2->xPos() + d2->width(), 0);
-        d2 = newD2;
+    int i = static_cast<int>(std::upper_bound(xs.constBegin(), xs.constEnd(), x) - xs.constBegin());
+    if (i == 0) {
+        return times.first();
+    } else if (i == xs.size()) {
+        return times.last();
     }
 
-    if (d1 && d2 && d1->musElement() && d2->musElement()) {
-        int delta = (d2->xPos() - d1->xPos());
-        if (!delta)
-            delta = 1;
-        return qRound(d1->musElement()->timeStart() + (d2->musElement()->timeStart() - d1->musElement()->timeStart()) * ((x - d1->xPos()) / delta));
-    } else if (d1 && d1->musElement())
-        return (d1->musElement()->timeEnd());
-    else
-        return 0;
+    double delta = xs[i] - xs[i - 1];
+    return qRound(times[i - 1] + (times[i] - times[i - 1]) * ((x - xs[i - 1]) / (delta ? delta : 1)));
 }
 
 /*!
- * Helper function for timeToCoords() when doing the binary search over elements.
+ * Helper function for binary searches over the music elements by their time.
  * 
  * \sa timeMusElementLessThan
  */
@@ -1890,7 +2350,7 @@ bool CAScoreView::musElementTimeLessThan(const CAMusElement* a, const int b)
 }
 
 /*!
- * Helper function for timeToCoords() when doing the binary search over elements.
+ * Helper function for binary searches over the music elements by their time.
  * 
  * \sa musElementTimeLessThan
  */
@@ -1901,85 +2361,42 @@ bool CAScoreView::timeMusElementLessThan(const int a, const CAMusElement* b)
 
 /*!
 	Simple Version of \sa timeToCoords( time ):
-	Returns the X coordinate for the given Canorus \a time.
+	Returns the X coordinate of the nearest indexed time left of or at the given Canorus \a time.
 	Returns -1, if such a time doesn't exist in the score.
 */
 double CAScoreView::timeToCoordsSimpleVersion(int time)
 {
-    CADrawableMusElement* leftElt = nullptr;
-
-    QList<CAVoice*> voiceList = _sheet->voiceList();
-    for (int i = 0; i < voiceList.size(); i++) {
-        // get the element still smaller or equal, but nearest to time
-        QList<CAMusElement*>::const_iterator it = std::lower_bound(voiceList[i]->musElementList().constBegin(), voiceList[i]->musElementList().constEnd(), time, CAScoreView::musElementTimeLessThan);
-        if (it != voiceList[i]->musElementList().constEnd()) {
-            if (_mapDrawable.contains(*it)) {
-                CADrawableMusElement* dElt = static_cast<CADrawableMusElement*>(_mapDrawable.values(*it).last());
-                if (leftElt && leftElt->xPos() < dElt->xPos()) {
-                    leftElt = dElt;
-                }
-            } else {
-                std::cerr << "ERROR: Drawable instance of musElement " << (*it) << " doesn't exist in _mapDrawable!" << std::endl;
-            }
-        }
-    }
-
-    return leftElt ? (leftElt->xPos()) : (-1);
+    const QVector<int>& times = _sheetLayout->timeIndexTimes();
+    const QVector<double>& xs = _sheetLayout->timeIndexX();
+    int i = static_cast<int>(std::upper_bound(times.constBegin(), times.constEnd(), time) - times.constBegin());
+    return i ? xs[i - 1] : -1;
 }
 
 /*!
 	Returns the X coordinate for the given Canorus \a time.
 	Returns -1, if such a time doesn't exist in the score.
+
+	\sa updateTimeIndex()
 */
 double CAScoreView::timeToCoords(int time)
 {
-    CADrawableMusElement* leftElt = nullptr;
-    CADrawableMusElement* rightElt = nullptr;
-
-    QList<CAVoice*> voiceList = _sheet->voiceList();
-    for (int i = 0; i < voiceList.size(); i++) {
-        // get the element still smaller or equal, but nearest to time
-        QList<CAMusElement*>::const_iterator it = std::lower_bound(voiceList[i]->musElementList().constBegin(), voiceList[i]->musElementList().constEnd(), time, CAScoreView::musElementTimeLessThan);
-        if (it != voiceList[i]->musElementList().constEnd()) {
-            if (_mapDrawable.contains(*it)) {
-                CADrawableMusElement* dElt = static_cast<CADrawableMusElement*>(_mapDrawable.values(*it).last());
-                if (!leftElt || leftElt->xPos() < dElt->xPos()) {
-                    leftElt = dElt;
-                }
-            } else {
-                std::cerr << "ERROR: Drawable instance of musElement " << (*it) << " doesn't exist in _mapDrawable!" << std::endl;
-            }
-        }
-
-        // and for the right element
-        it = std::upper_bound(voiceList[i]->musElementList().constBegin(), voiceList[i]->musElementList().constEnd(), time, CAScoreView::timeMusElementLessThan);
-        if (it != voiceList[i]->musElementList().constEnd()) {
-            if (_mapDrawable.contains(*it)) {
-                CADrawableMusElement* dElt = static_cast<CADrawableMusElement*>(_mapDrawable.values(*it).first());
-                if (!rightElt || rightElt->xPos() > dElt->xPos()) {
-                    rightElt = dElt;
-                }
-            } else {
-                std::cerr << "ERROR: Drawable instance of musElement " << (*it) << " doesn't exist in _mapDrawable!" << std::endl;
-            }
-        }
+    const QVector<int>& times = _sheetLayout->timeIndexTimes();
+    const QVector<double>& xs = _sheetLayout->timeIndexX();
+    if (times.isEmpty() || time < times.first() || time > times.last()) {
+        return -1;
     }
 
-    // get the relative position between the nearest left and the nearest right elements
-    if (leftElt && rightElt && leftElt->musElement() && rightElt->musElement()) {
-        int delta = (rightElt->musElement()->timeStart() - leftElt->musElement()->timeStart());
-        if (!delta)
-            delta = 1;
-        // Note Reinhard: Fixed conversion to double
-        // I assume that division by delta should result in double value
-        return leftElt->xPos() + (rightElt->xPos() - leftElt->xPos()) * static_cast<double>(time - leftElt->musElement()->timeStart() / static_cast<double>(delta));
-    } else {
-        return -1;
+    int i = static_cast<int>(std::lower_bound(times.constBegin(), times.constEnd(), time) - times.constBegin());
+    if (times[i] == time) {
+        return xs[i];
     }
+
+    return xs[i - 1] + (xs[i] - xs[i - 1]) * static_cast<double>(time - times[i - 1]) / (times[i] - times[i - 1]);
 }
 
 void CAScoreView::setShadowNoteLength(CAPlayableLength l)
 {
+    _shadowNoteLength = l;
     for (int i = 0; i < _shadowNote.size(); i++) {
         _shadowNote[i]->setPlayableLength(l);
     }
@@ -1994,9 +2411,11 @@ void CAScoreView::setShadowNoteLength(CAPlayableLength l)
 QList<CAMusElement*> CAScoreView::musElementSelection()
 {
     QList<CAMusElement*> res;
+    QSet<CAMusElement*> added;
 
     for (int i = 0; i < _selection.size(); i++) {
-        if (!res.contains(_selection[i]->musElement())) {
+        if (!added.contains(_selection[i]->musElement())) {
+            added.insert(_selection[i]->musElement());
             res << _selection[i]->musElement();
         }
     }
@@ -2004,6 +2423,39 @@ QList<CAMusElement*> CAScoreView::musElementSelection()
     return res;
 }
 
+/*!
+	Returns a list of contexts containing the currently selected music elements.
+	The contexts of the notes connected by slurs to the selected notes are included as well,
+	because the slurs are removed together with the selected notes.
+ */
+QList<CAContext*> CAScoreView::selectionContexts()
+{
+    QList<CAMusElement*> elts;
+    for (int i = 0; i < _selection.size(); i++) {
+        CAMusElement* elt = _selection[i]->musElement();
+        elts << elt;
+
+        if (elt->musElementType() == CAMusElement::Note) {
+            CANote* note = static_cast<CANote*>(elt);
+            CASlur* slurs[] = { note->tieStart(), note->tieEnd(), note->slurStart(), note->slurEnd(), note->phrasingSlurStart(), note->phrasingSlurEnd() };
+            for (CASlur* slur : slurs) {
+                if (slur) {
+                    elts << slur->noteStart() << slur->noteEnd();
+                }
+            }
+        }
+    }
+
+    QList<CAContext*> res;
+    for (int i = 0; i < elts.size(); i++) {
+        if (elts[i] && elts[i]->context() && !res.contains(elts[i]->context())) {
+            res << elts[i]->context();
+        }
+    }
+
+    return res;
+}
+
 /*!
 	\fn CASheet *CAScoreView::sheet()
 	Returns the pointer to the view's sheet it represents.
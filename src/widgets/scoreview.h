@@ -14,9 +14,13 @@
 #include <QMultiMap>
 #include <QPen>
 #include <QRect>
+#include <QSet>
 #include <QTimer>
+#include <QVector>
 
 #include "layout/kdtree.h"
+#include "layout/layoutengine.h"
+#include "layout/sheetlayout.h"
 #include "score/note.h"
 #include "widgets/view.h"
 
@@ -37,6 +41,7 @@ class CASheet;
 class CAStaff;
 class CALyricsContext;
 class CADrawableNoteCheckerError;
+class CATileCache;
 
 class CATextEdit : public QLineEdit {
     Q_OBJECT
@@ -71,22 +76,38 @@ public:
     CAScoreView* clone();
     CAScoreView* clone(QWidget* parent);
     inline CASheet* sheet() { return _sheet; }
-    inline void setSheet(CASheet* sheet) { _sheet = sheet; }
+    void setSheet(CASheet* sheet);
 
     ////////////////////////////////////////////
     // Addition, removal of drawable elements //
     ////////////////////////////////////////////
     void addMElement(CADrawableMusElement* elt, bool select = false);
     void addCElement(CADrawableContext* elt, bool select = false);
-    void addDrawableNoteCheckerError(CADrawableNoteCheckerError* dnce);
-
-    void importElements(CAKDTree<CADrawableMusElement*>* drawableMList, CAKDTree<CADrawableContext*>* drawableCList);
+    inline void addDrawableNoteCheckerError(CADrawableNoteCheckerError* dnce) { _sheetLayout->addDrawableNoteCheckerError(dnce); }
+    inline bool hasDrawableNoteCheckerErrors() { return _sheetLayout->drawableNCEList().size(); }
+    inline QList<CADrawableMusElement*> takeMElements(int from) { return _sheetLayout->takeMElements(from); }
+    inline int drawableMElementCount() { return _sheetLayout->drawableMOrder().size(); }
+
+    ///////////////////////////////////
+    // Layout state for the engraver //
+    ///////////////////////////////////
+    inline CASheetLayout* sheetLayout() { return _sheetLayout; }
+    inline CATileCache* tileCache() { return _tileCache; }
+    inline QList<CALayoutCheckpoint>& layoutCheckpoints() { return _sheetLayout->layoutCheckpoints(); }
+    inline const QList<void*>& layoutStreamOwners() { return _sheetLayout->layoutStreamOwners(); }
+    inline void setLayoutStreamOwners(const QList<void*>& owners) { _sheetLayout->setLayoutStreamOwners(owners); }
+    inline const QList<CADrawableMusElement*>& layoutScalableElts() { return _sheetLayout->layoutScalableElts(); }
+    inline void setLayoutScalableElts(const QList<CADrawableMusElement*>& elts) { _sheetLayout->setLayoutScalableElts(elts); }
+    void aboutToClearLayout();
+    void aboutToTakeMElements(const QSet<CADrawableMusElement*>& taken, double minX);
+    void syncWithLayout();
 
     ///////////////
     // Selection //
     ///////////////
     inline const QList<CADrawableMusElement*>& selection() { return _selection; }
     QList<CAMusElement*> musElementSelection();
+    QList<CAContext*> selectionContexts();
     QList<CADrawableMusElement*> musElementsAt(double x, double y);
     CADrawableContext* selectCElement(double x, double y);
     CADrawableMusElement* selectMElement(CAMusElement* elt);
@@ -103,12 +124,13 @@ public:
     void invertSelection();
     inline void clearSelection()
     {
-        _selection.clear();
+        resetSelection();
         emit selectionChanged();
     }
     // Note Reinhard: This code does not make sense
     inline bool removeFromSelection(CADrawableMusElement* elt)
     {
+        setSelectedState(elt, false);
         return _selection.removeAll(elt);
         emit selectionChanged();
     }
@@ -140,6 +162,7 @@ public:
     CADrawableMusElement* nearestLeftElement(double x, double y, CAVoice* voice);
     CADrawableMusElement* nearestRightElement(double x, double y, CADrawableContext* context = nullptr);
     CADrawableMusElement* nearestRightElement(double x, double y, CAVoice* voice);
+    void updateTimeIndex();
     int coordsToTime(double x);
     double timeToCoords(int time);
     double timeToCoordsSimpleVersion(int time);
@@ -169,6 +192,7 @@ public:
     // Scene appearance, properties and actions //
     //////////////////////////////////////////////
     void rebuild();
+    void rebuild(int timeStart, int timeEnd = -1);
     void setMouseTracking(bool); // reimplemented!
     inline int drawableWidth() { return _canvas->width(); }
     inline int drawableHeight() { return _canvas->height(); }
@@ -222,6 +246,8 @@ public:
 
     inline bool playing() { return _playing; }
     inline void setPlaying(bool playing) { _playing = playing; }
+    void setPlayingElements(const QList<CAMusElement*>& elts);
+    inline const QList<CAMusElement*>& playingElements() { return _playingElements; }
 
     inline void setRepaintArea(QRect* area) { _repaintArea = area; }
     inline void clearRepaintArea()
@@ -232,7 +258,7 @@ public:
     }
 
     inline CAVoice* selectedVoice() { return _selectedVoice; }
-    inline void setSelectedVoice(CAVoice* selectedVoice) { _selectedVoice = selectedVoice; }
+    void setSelectedVoice(CAVoice* selectedVoice);
 
     inline bool shadowNoteVisible() { return _shadowNoteVisible; }
     inline void setShadowNoteVisible(bool visible)
@@ -261,6 +287,7 @@ public:
     void setNoteName(QString n) { _noteName = n; }
 
     void updateHelpers(); // method for updating shadow notes, syllable edits and other post-engrave elements coordinates and sizes when zoom level is changed etc.
+    void updateOverlay();
 
 private slots:
     void mousePressEvent(QMouseEvent* e);
@@ -294,9 +321,29 @@ protected:
 
 private:
     void initScoreView(CASheet* s);
-    inline void clearMElements() { _drawableMList.clear(true); }
-    inline void clearCElements() { _drawableCList.clear(true); }
-    inline bool isSelected(CADrawableMusElement* elt) { return (_selection.contains(elt)); }
+    inline bool layoutNeeded() { return !_sheetLayout->isUpToDate() || _layoutGeneration == _sheetLayout->generation(); }
+    void detachFromLayout();
+    /*!
+		State of a drawable music element in this view. Drawable elements are shared by all the
+		views of the sheet, so each view keeps their states in _drawableStates.
+	*/
+    enum CADrawableViewState {
+        Selected = 0x01, // part of the view's selection
+        ActiveVoice = 0x02, // belongs to the selected voice
+        Disabled = 0x04 // belongs to another voice in the staff of the selected voice
+    };
+    int drawableState(CADrawableMusElement* elt);
+    int voiceState(CADrawableMusElement* elt);
+    void setSelectedState(CADrawableMusElement* elt, bool selected);
+    void updateDrawableStates(int from);
+    inline bool isSelected(CADrawableMusElement* elt) { return drawableState(elt) & Selected; }
+    void resetSelection();
+    void paintTiles(QPainter* p, double x, double y, double w, double h);
+    void paintOverlay(QPainter* p);
+    void paintPlaybackCursor(QPainter* p);
+    QRect overlayRect();
+    QRect playbackCursorRect();
+    QColor drawableMElementColor(CADrawableMusElement* elt);
 
     //////////////////
     // Core Widgets //
@@ -308,13 +355,15 @@ private:
     ////////////////////////
     // General properties //
     ////////////////////////
-    CAKDTree<CADrawableMusElement*> _drawableMList; // The list of music elements stored in a tree for faster lookup and other operations. Every view has its own list of drawable elements and drawable objects themselves!
-    CAKDTree<CADrawableContext*> _drawableCList; // The list of context drawable elements (staffs, lyrics etc.). Every view has its own list of drawable elements and drawable objects themselves!
-    CAKDTree<CADrawableNoteCheckerError*> _drawableNCEList; // The list of drawable note checker errors
-    QMultiMap<void*, CADrawable*> _mapDrawable; // Mapping of all music elements/contexts in the score -> drawable elements on canvas
+    CASheetLayout* _sheetLayout; // Drawable elements of the sheet shared with the other views of the same sheet
+    int _layoutGeneration; // Generation of the shared layout at the last rebuild of this view, see rebuild()
+    bool _layoutDetached; // The layout changed since the view was synchronized with it, see syncWithLayout()
+    QList<CAMusElement*> _detachedSelection; // Selection to be restored after the layout changed
+    int _detachedContextIdx; // Index of the current context to be restored after the layout changed
     CASheet* _sheet; // Pointer to the CASheet which the view represents.
 
-    QList<CADrawableMusElement*> _selection; // The set of elements being selected.
+    QList<CADrawableMusElement*> _selection; // The set of elements being selected ordered by X.
+    QVector<quint8> _drawableStates; // CADrawableViewState flags of the layout's drawable music elements indexed by CADrawableMusElement::layoutIndex()
     CADrawableContext* _currentContext; // The pointer to the currently active context (staff, lyrics).
 
     static const int RIGHT_EXTRA_SPACE; // Extra space at the right end to insert new music
@@ -346,6 +395,7 @@ private:
     bool _drawShadowNoteAccs; // Draw shadow note accs?
     QList<CANote*> _shadowNote; // List of all shadow notes - one shadow note per drawable staff
     QList<CADrawableNote*> _shadowDrawableNote; // List of drawable shadow notes
+    CAPlayableLength _shadowNoteLength; // Length of the shadow notes kept when they are recreated after the layout changed
 
     // QLineEdit for editing or creating a lyrics syllable
     CATextEdit* _textEdit;
@@ -372,6 +422,8 @@ private:
     bool _grabTabKey; // Pass the tab key to keyPressEvent() or treat it like the next item key
     bool _drawBorder; // Should the border be drawn or not.
     QRect* _repaintArea; // Area to be repainted on paintEvent().
+    CATileCache* _tileCache; // Rasterized tiles of the contexts and music elements
+    static const int TILE_MARGIN; // World units around a tile whose elements are painted onto it as well
     QPen _borderPen; // Pen which the border is drawn by.
     QColor _backgroundColor; // Color which the background is filled.
     QColor _foregroundColor; // Color which the music elements are painted.
@@ -405,6 +457,8 @@ private:
     /////////////////////////
     double _oldWorldX, _oldWorldY, _oldWorldW, _oldWorldH; // Old coordinates used before the repaint. This is needed so only the new part of the view gets repainted when panning.
     bool _playing; // Set to on, when in Playback mode
+    QList<CAMusElement*> _playingElements; // Elements highlighted by the playback cursor
+    QRect _overlayRect; // Widget area covered by the overlay at the last paint, see updateOverlay()
     QTimer* _clickTimer; // Used for measuring doubleClick and tripleClick
     int _numberOfClicks; // Used for measuring doubleClick and tripleClick
 
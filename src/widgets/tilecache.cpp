@@ -0,0 +1,341 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#include <QMutexLocker>
+#include <QObject>
+#include <QPainter>
+#include <QRunnable>
+#include <QtMath>
+
+#include "widgets/tilecache.h"
+
+/*!
+	\class CATileCache
+	\brief Cache of rasterized score view tiles
+
+	The score view's world is cut into square tiles of TILE_SIZE pixels at the current zoom level.
+	Each tile is rendered once into a QImage and blitted by CAScoreView::paintEvent() afterwards,
+	so scrolling only needs to render the tiles which newly became visible.
+
+	Every tile remembers the signature of the drawables it was painted from (their pointers,
+	positions, sizes, colors and the level of detail). The score view computes the signature of
+	each visible tile on every repaint and only tiles whose signature changed (eg. an element was
+	selected or moved) are rendered again. Changes which don't alter the signature (eg. a drawable
+	was recreated at the same address) must be signalled by invalidate() or invalidateRight().
+
+	Tiles scheduled by schedule() are rendered in parallel by a thread pool when render() is
+	called. render() doesn't wait for them: until a tile is rendered, image() returns its
+	previous (stale) image or a null image for a tile which was never rendered. When a worker
+	finishes a tile, the receiver widget gets a queued update() and the next paint collects the
+	rendered tiles by collect().
+
+	The workers only read the drawables, the music elements they point to and CAGlyphCache
+	(which is guarded by a mutex). draw() uses local QFont and QPainter objects only, which Qt
+	allows outside of the GUI thread when painting onto a QImage. The GUI thread must not change
+	the drawables or the document while tiles are being rendered, so:
+	- the score view calls cancel() when its sheet layout is about to delete or move drawables,
+	- CAUndo calls cancelAll() before each change of a document is made and before undo/redo,
+	- CAMainWin calls cancelAll() before an element is resized by dragging its handle,
+	- the level of detail thresholds are only changed after cancelAll().
+	cancel() drops the tiles not started yet and waits for the running ones. No new tiles are
+	started until the next paint, which happens after the change on the GUI thread is finished.
+
+	\sa CAScoreView, CAGlyphCache
+*/
+
+/*!
+	Tile width and height in pixels.
+*/
+const int CATileCache::TILE_SIZE = 256;
+
+/*!
+	Maximum number of tiles kept in the cache. When exceeded, tiles which are not visible are
+	dropped.
+*/
+const int CATileCache::MAX_TILES = 256;
+
+QList<CATileCache*> CATileCache::_caches;
+
+class CATileRenderer : public QRunnable {
+public:
+    CATileRenderer(CATileCache* cache, QSharedPointer<CATileCache::CATileJob> job, const QColor& background)
+        : _cache(cache)
+        , _job(job)
+        , _background(background)
+    {
+        setAutoDelete(true);
+    }
+
+    void run()
+    {
+        CATileCache::paintTile(&_job->image, _job->items, _background);
+        _cache->finished(_job);
+    }
+
+private:
+    CATileCache* _cache;
+    QSharedPointer<CATileCache::CATileJob> _job;
+    QColor _background;
+};
+
+/*!
+	Creates an empty tile cache. The \a receiver widget is updated each time the workers
+	finish rendering a tile.
+*/
+CATileCache::CATileCache(QObject* receiver)
+    : _receiver(receiver)
+    , _generation(0)
+    , _zoom(0)
+{
+    _caches << this;
+}
+
+CATileCache::~CATileCache()
+{
+    cancel();
+    _caches.removeAll(this);
+}
+
+/*!
+	Sets the zoom level the tiles are rendered at. Changing the zoom level drops all the tiles.
+*/
+void CATileCache::setZoom(double zoom)
+{
+    if (zoom != _zoom) {
+        clear();
+        _zoom = zoom;
+    }
+}
+
+/*!
+	Removes all the tiles.
+*/
+void CATileCache::clear()
+{
+    _pool.clear();
+    _pending.clear();
+    _generation++;
+    _tiles.clear();
+}
+
+/*!
+	Marks all the tiles to be rendered again. Their images are kept until then.
+*/
+void CATileCache::invalidate()
+{
+    _pending.clear();
+    _generation++;
+    for (QHash<quint64, CATile>::iterator it = _tiles.begin(); it != _tiles.end(); ++it) {
+        it.value().valid = false;
+    }
+}
+
+/*!
+	Marks the tiles containing the world area right of the world coordinate \a x to be
+	rendered again.
+*/
+void CATileCache::invalidateRight(double x)
+{
+    int firstTile = qFloor(x * _zoom / TILE_SIZE);
+    _pending.clear(); // tiles left of x are rendered again, if still needed
+    _generation++;
+    for (QHash<quint64, CATile>::iterator it = _tiles.begin(); it != _tiles.end(); ++it) {
+        if (static_cast<qint32>(it.key() >> 32) >= firstTile) {
+            it.value().valid = false;
+        }
+    }
+}
+
+/*!
+	Drops the tiles which weren't started yet and waits for the workers to finish the running
+	ones. Call it before the drawables painted by this cache are changed or deleted.
+
+	\sa cancelAll()
+*/
+void CATileCache::cancel()
+{
+    _pool.clear();
+    _pool.waitForDone();
+    _jobs.clear();
+    _pending.clear();
+    _generation++;
+
+    QMutexLocker locker(&_finishedMutex);
+    _finished.clear();
+}
+
+/*!
+	Cancels rendering in all the tile caches. Call it before changing a document, which may be
+	shown by any score view.
+
+	\sa cancel()
+*/
+void CATileCache::cancelAll()
+{
+    for (int i = 0; i < _caches.size(); i++) {
+        _caches[i]->cancel();
+    }
+}
+
+/*!
+	Waits until the workers finish all the started tiles. The tiles are taken over by the next
+	collect(), eg. to paint a complete frame.
+*/
+void CATileCache::waitForDone()
+{
+    _pool.waitForDone();
+}
+
+/*!
+	Computes the signature of the tile painted from the given \a items on the \a background.
+*/
+uint CATileCache::signature(const QList<CATileItem>& items, const QColor& background)
+{
+    uint sig = qHash(background.rgba());
+    if (!items.isEmpty()) {
+        sig = sig * 31 + CADrawable::detailLevel(items[0].settings.z); // the same zoom level for the whole tile
+    }
+    for (int i = 0; i < items.size(); i++) {
+        const CATileItem& item = items[i];
+        sig = sig * 31 + qHash(reinterpret_cast<quintptr>(item.drawable));
+        sig = sig * 31 + qHash(item.settings.x);
+        sig = sig * 31 + qHash(item.settings.y);
+        sig = sig * 31 + qHash(qRound(item.drawable->width() * item.settings.z));
+        sig = sig * 31 + qHash(qRound(item.drawable->height() * item.settings.z));
+        sig = sig * 31 + qHash(item.settings.color.rgba());
+        sig = sig * 31 + (item.antialiasing ? 1 : 0);
+    }
+
+    return sig;
+}
+
+/*!
+	Returns True, if the \a tile was rendered with the given \a signature and wasn't invalidated
+	since.
+*/
+bool CATileCache::contains(const QPoint& tile, uint signature) const
+{
+    QHash<quint64, CATile>::const_iterator it = _tiles.constFind(key(tile));
+    return (it != _tiles.constEnd() && it.value().valid && it.value().signature == signature);
+}
+
+/*!
+	Schedules the \a tile to be painted from the given \a items on the next render().
+	Does nothing, if the tile is already being rendered with the same \a signature.
+*/
+void CATileCache::schedule(const QPoint& tile, uint signature, const QList<CATileItem>& items)
+{
+    QHash<quint64, uint>::const_iterator it = _pending.constFind(key(tile));
+    if (it != _pending.constEnd() && it.value() == signature) {
+        return;
+    }
+
+    QSharedPointer<CATileJob> job(new CATileJob);
+    job->tile = tile;
+    job->signature = signature;
+    job->generation = _generation;
+    job->items = items;
+    _jobs << job;
+    _pending[key(tile)] = signature;
+}
+
+/*!
+	Starts rendering the scheduled tiles in the thread pool and returns immediately.
+	The rendered tiles are taken over by collect().
+*/
+void CATileCache::render(qreal devicePixelRatio, const QColor& background)
+{
+    int size = qCeil(TILE_SIZE * devicePixelRatio);
+    for (int i = 0; i < _jobs.size(); i++) {
+        _jobs[i]->image = QImage(size, size, QImage::Format_ARGB32_Premultiplied);
+        _jobs[i]->image.setDevicePixelRatio(devicePixelRatio);
+        _pool.start(new CATileRenderer(this, _jobs[i], background));
+    }
+    _jobs.clear();
+}
+
+/*!
+	Called by the worker thread when the \a job is rendered. Queues the tile for collect() and
+	updates the receiver widget.
+*/
+void CATileCache::finished(QSharedPointer<CATileJob> job)
+{
+    {
+        QMutexLocker locker(&_finishedMutex);
+        _finished << job;
+    }
+    QMetaObject::invokeMethod(_receiver, "update", Qt::QueuedConnection);
+}
+
+/*!
+	Replaces the images of the tiles rendered by the workers since the last call.
+	Tiles started before the last clear() or invalidation and tiles rendered again since are
+	dropped.
+*/
+void CATileCache::collect()
+{
+    QList<QSharedPointer<CATileJob>> finished;
+    {
+        QMutexLocker locker(&_finishedMutex);
+        finished.swap(_finished);
+    }
+
+    for (int i = 0; i < finished.size(); i++) {
+        const CATileJob& job = *finished[i];
+        quint64 k = key(job.tile);
+        if (job.generation != _generation || !_pending.contains(k) || _pending[k] != job.signature) {
+            continue;
+        }
+
+        _pending.remove(k);
+        CATile t = { job.image, job.signature, true };
+        _tiles.insert(k, t);
+    }
+}
+
+/*!
+	Returns the rendered image of the \a tile or a null image, if the tile wasn't rendered yet.
+*/
+QImage CATileCache::image(const QPoint& tile) const
+{
+    return _tiles.value(key(tile)).image;
+}
+
+/*!
+	Drops all the tiles except the ones in \a keep, if the cache grew over MAX_TILES.
+*/
+void CATileCache::trim(const QList<QPoint>& keep)
+{
+    if (_tiles.size() <= MAX_TILES) {
+        return;
+    }
+
+    QHash<quint64, CATile> kept;
+    for (int i = 0; i < keep.size(); i++) {
+        QHash<quint64, CATile>::const_iterator it = _tiles.constFind(key(keep[i]));
+        if (it != _tiles.constEnd()) {
+            kept.insert(it.key(), it.value());
+        }
+    }
+    _tiles = kept;
+}
+
+/*!
+	Fills the \a image with the \a background color and paints the \a items onto it.
+	This function is called from the worker threads.
+*/
+void CATileCache::paintTile(QImage* image, const QList<CATileItem>& items, const QColor& background)
+{
+    image->fill(background);
+
+    QPainter p(image);
+    for (int i = 0; i < items.size(); i++) {
+        const CATileItem& item = items[i];
+        p.setRenderHint(QPainter::Antialiasing, item.antialiasing);
+        item.drawable->draw(&p, item.settings);
+    }
+}
@@ -0,0 +1,99 @@
+/*!
+	Copyright (c) 2026, Matevž Jekovec, Canorus development team
+	All Rights Reserved. See AUTHORS for a complete list of authors.
+
+	Licensed under the GNU GENERAL PUBLIC LICENSE. See COPYING for details.
+*/
+
+#ifndef TILECACHE_H_
+#define TILECACHE_H_
+
+#include <QColor>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QPoint>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+#include "layout/drawable.h"
+
+class QObject;
+
+class CATileCache {
+public:
+    /*!
+		A single drawable to be painted onto the tile with the given settings.
+		The settings are relative to the tile's top-left corner.
+	*/
+    struct CATileItem {
+        CADrawable* drawable;
+        CADrawSettings settings;
+        bool antialiasing;
+    };
+
+    CATileCache(QObject* receiver);
+    ~CATileCache();
+
+    static const int TILE_SIZE;
+    static const int MAX_TILES;
+
+    void setZoom(double zoom);
+    inline double zoom() { return _zoom; }
+
+    void clear();
+    void invalidate();
+    void invalidateRight(double x);
+    void cancel();
+    static void cancelAll();
+    void waitForDone();
+
+    static uint signature(const QList<CATileItem>& items, const QColor& background);
+    bool contains(const QPoint& tile, uint signature) const;
+    void schedule(const QPoint& tile, uint signature, const QList<CATileItem>& items);
+    void render(qreal devicePixelRatio, const QColor& background);
+    void collect();
+    QImage image(const QPoint& tile) const;
+
+    void trim(const QList<QPoint>& keep);
+
+    static void paintTile(QImage* image, const QList<CATileItem>& items, const QColor& background);
+
+private:
+    struct CATile {
+        QImage image;
+        uint signature;
+        bool valid;
+    };
+
+    struct CATileJob {
+        QPoint tile;
+        uint signature;
+        int generation;
+        QList<CATileItem> items;
+        QImage image;
+    };
+
+    friend class CATileRenderer;
+    void finished(QSharedPointer<CATileJob> job);
+
+    static inline quint64 key(const QPoint& tile)
+    {
+        return (static_cast<quint64>(static_cast<quint32>(tile.x())) << 32) | static_cast<quint32>(tile.y());
+    }
+
+    QHash<quint64, CATile> _tiles;
+    QList<QSharedPointer<CATileJob>> _jobs; // Tiles scheduled for the next render()
+    QHash<quint64, uint> _pending; // Signatures of the tiles being rendered by the pool
+    QList<QSharedPointer<CATileJob>> _finished; // Tiles rendered by the pool, not collected yet
+    QMutex _finishedMutex;
+    QThreadPool _pool;
+    QObject* _receiver; // Updated when a tile is rendered
+    int _generation; // Jobs started before the last clear() or invalidation are dropped
+    double _zoom;
+
+    static QList<CATileCache*> _caches;
+};
+
+#endif /* TILECACHE_H_ */